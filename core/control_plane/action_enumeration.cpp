@@ -0,0 +1,58 @@
+#include "backends/p4tools/modules/flay/core/control_plane/action_enumeration.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace P4::P4Tools::Flay {
+
+const cstring ActionEnumeration::kNoAction = cstring("*NONE*");
+
+ActionEnumeration::ActionEnumeration(std::vector<cstring> actionNames) {
+    std::sort(actionNames.begin(), actionNames.end());
+    actionNames.erase(std::unique(actionNames.begin(), actionNames.end()), actionNames.end());
+    _actionNames.reserve(actionNames.size() + 1);
+    _actionNames.push_back(kNoAction);
+    for (auto actionName : actionNames) {
+        if (actionName != kNoAction) {
+            _actionNames.push_back(actionName);
+        }
+    }
+    for (size_t ordinal = 0; ordinal < _actionNames.size(); ++ordinal) {
+        _ordinals.emplace(_actionNames[ordinal], ordinal);
+    }
+    // The width of the largest ordinal, but at least one bit.
+    int width = 1;
+    while ((static_cast<size_t>(1) << width) < _actionNames.size()) {
+        ++width;
+    }
+    _type = IR::Type_Bits::get(width);
+}
+
+const IR::Type_Bits *ActionEnumeration::type() const { return _type; }
+
+size_t ActionEnumeration::size() const { return _actionNames.size(); }
+
+std::optional<size_t> ActionEnumeration::ordinal(cstring actionName) const {
+    auto it = _ordinals.find(actionName);
+    if (it == _ordinals.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+const IR::Constant *ActionEnumeration::literal(cstring actionName) const {
+    auto actionOrdinal = ordinal(actionName);
+    if (!actionOrdinal.has_value()) {
+        return nullptr;
+    }
+    return IR::Constant::get(_type, actionOrdinal.value());
+}
+
+std::optional<cstring> ActionEnumeration::actionName(size_t ordinal) const {
+    if (ordinal >= _actionNames.size()) {
+        return std::nullopt;
+    }
+    return _actionNames[ordinal];
+}
+
+}  // namespace P4::P4Tools::Flay
@@ -0,0 +1,59 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_ACTION_ENUMERATION_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_ACTION_ENUMERATION_H_
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "ir/ir.h"
+#include "lib/cstring.h"
+
+namespace P4::P4Tools::Flay {
+
+/// Assigns every action of a table an ordinal, so the action choice, the default action, and
+/// action_run of the table are encoded as small bit vectors instead of strings. Comparisons of
+/// bit vectors stay in the bit-vector fragment of Z3, comparisons of strings do not.
+///
+/// Ordinal 0 denotes that no action is configured. The actions follow in ascending order of their
+/// control-plane name. The enumeration only depends on the set of names, so the interpreter, which
+/// reads the actions from the program, and the control plane, which reads them from the P4Info,
+/// agree on it without sharing state.
+class ActionEnumeration {
+    /// The action names, indexed by ordinal.
+    std::vector<cstring> _actionNames;
+
+    /// The ordinals, keyed by action name.
+    std::map<cstring, size_t> _ordinals;
+
+    /// The type of the ordinals. Wide enough to hold the largest ordinal.
+    const IR::Type_Bits *_type;
+
+ public:
+    /// The name of ordinal 0, which denotes that no action is configured.
+    static const cstring kNoAction;
+
+    /// Enumerate the actions @p actionNames. Duplicates are enumerated once.
+    explicit ActionEnumeration(std::vector<cstring> actionNames);
+
+    /// @returns the type of the ordinals.
+    [[nodiscard]] const IR::Type_Bits *type() const;
+
+    /// @returns the number of ordinals, including kNoAction.
+    [[nodiscard]] size_t size() const;
+
+    /// @returns the ordinal of @p actionName, or std::nullopt if the table has no such action.
+    [[nodiscard]] std::optional<size_t> ordinal(cstring actionName) const;
+
+    /// @returns the ordinal of @p actionName as constant, or nullptr if the table has no such
+    /// action.
+    [[nodiscard]] const IR::Constant *literal(cstring actionName) const;
+
+    /// @returns the name of the action with ordinal @p ordinal, or std::nullopt if there is no such
+    /// ordinal.
+    [[nodiscard]] std::optional<cstring> actionName(size_t ordinal) const;
+};
+
+}  // namespace P4::P4Tools::Flay
+
+#endif /* BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_ACTION_ENUMERATION_H_ */
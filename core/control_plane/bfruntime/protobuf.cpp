@@ -6,11 +6,15 @@
 #include <cstdio>
 #include <cstdlib>
 #include <optional>
+#include <utility>
 
 #include "backends/p4tools/common/control_plane/symbolic_variables.h"
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_item.h"
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
+#include "backends/p4tools/modules/flay/core/control_plane/p4info_index.h"
+#include "backends/p4tools/modules/flay/core/control_plane/protobuf_constants.h"
 #include "backends/p4tools/modules/flay/core/control_plane/protobuf_utils.h"
+#include "backends/p4tools/modules/flay/core/control_plane/table_relevance_index.h"
 #include "control-plane/p4RuntimeArchHandler.h"
 #include "control-plane/p4infoApi.h"
 #include "ir/irutils.h"
@@ -22,53 +26,51 @@ namespace {
 /// Convert a BFRuntime FieldMatch into the appropriate symbolic constraint
 /// assignments.
 /// @param symbolSet tracks the symbols used in this conversion.
-std::optional<ControlPlaneAssignmentSet> produceTableMatch(
-    const bfrt_proto::KeyField &field, cstring tableName,
-    const p4::config::v1::MatchField &matchField, SymbolSet &symbolSet) {
+std::optional<ControlPlaneAssignmentSet> produceTableMatch(const bfrt_proto::KeyField &field,
+                                                           const MatchFieldDescriptor &matchField,
+                                                           SymbolSet &symbolSet) {
     ControlPlaneAssignmentSet tableKeySet;
-    const auto *keyType = IR::Type_Bits::get(matchField.bitwidth());
-    const auto *keySymbol = ControlPlaneState::getTableKey(tableName, matchField.name(), keyType);
+    const auto *keyType = matchField.keyType;
+    const auto *keySymbol = matchField.keySymbol;
     symbolSet.emplace(*keySymbol);
     switch (field.match_type_case()) {
         case bfrt_proto::KeyField::kExact: {
-            auto value = Protobuf::stringToBigInt(field.exact().value());
-            tableKeySet.emplace(*keySymbol, *IR::Constant::get(keyType, value));
+            const auto *value = Protobuf::stringToConstant(field.exact().value(), keyType);
+            tableKeySet.emplace(*keySymbol, *value);
             return tableKeySet;
         }
         case bfrt_proto::KeyField::kLpm: {
-            const auto *lpmPrefixSymbol =
-                ControlPlaneState::getTableMatchLpmPrefix(tableName, matchField.name(), keyType);
+            const auto *lpmPrefixSymbol = matchField.lpmPrefixSymbol;
             symbolSet.emplace(*lpmPrefixSymbol);
-            auto value = Protobuf::stringToBigInt(field.lpm().value());
-            int prefix = field.lpm().prefix_len();
-            tableKeySet.emplace(*keySymbol, *IR::Constant::get(keyType, value));
-            tableKeySet.emplace(*lpmPrefixSymbol, *IR::Constant::get(keyType, prefix));
+            const auto *value = Protobuf::stringToConstant(field.lpm().value(), keyType);
+            auto prefix = static_cast<uint64_t>(field.lpm().prefix_len());
+            tableKeySet.emplace(*keySymbol, *value);
+            tableKeySet.emplace(*lpmPrefixSymbol, *Protobuf::uint64ToConstant(prefix, keyType));
             return tableKeySet;
         }
         case bfrt_proto::KeyField::kTernary: {
-            const auto *maskSymbol =
-                ControlPlaneState::getTableTernaryMask(tableName, matchField.name(), keyType);
+            const auto *maskSymbol = matchField.maskSymbol;
             symbolSet.emplace(*maskSymbol);
-            auto value = Protobuf::stringToBigInt(field.ternary().value());
-            auto mask = Protobuf::stringToBigInt(field.ternary().mask());
-            tableKeySet.emplace(*keySymbol, *IR::Constant::get(keyType, value));
-            tableKeySet.emplace(*maskSymbol, *IR::Constant::get(keyType, mask));
+            const auto *value = Protobuf::stringToConstant(field.ternary().value(), keyType);
+            const auto *mask = Protobuf::stringToConstant(field.ternary().mask(), keyType);
+            tableKeySet.emplace(*keySymbol, *value);
+            tableKeySet.emplace(*maskSymbol, *mask);
             return tableKeySet;
         }
         case bfrt_proto::KeyField::kRange: {
-            const auto &[rangeMinSymbol, rangeMaxSymbol] =
-                Bmv2ControlPlaneState::getTableRange(tableName, matchField.name(), keyType);
+            const auto *rangeMinSymbol = matchField.rangeMinSymbol;
+            const auto *rangeMaxSymbol = matchField.rangeMaxSymbol;
             symbolSet.emplace(*rangeMinSymbol);
             symbolSet.emplace(*rangeMaxSymbol);
-            auto low = Protobuf::stringToBigInt(field.range().low());
-            auto high = Protobuf::stringToBigInt(field.range().high());
-            tableKeySet.emplace(*rangeMinSymbol, *IR::Constant::get(keyType, low));
-            tableKeySet.emplace(*rangeMaxSymbol, *IR::Constant::get(keyType, high));
+            const auto *low = Protobuf::stringToConstant(field.range().low(), keyType);
+            const auto *high = Protobuf::stringToConstant(field.range().high(), keyType);
+            tableKeySet.emplace(*rangeMinSymbol, *low);
+            tableKeySet.emplace(*rangeMaxSymbol, *high);
             return tableKeySet;
         }
         case bfrt_proto::KeyField::kOptional: {
-            auto value = Protobuf::stringToBigInt(field.optional().value());
-            tableKeySet.emplace(*keySymbol, *IR::Constant::get(keyType, value));
+            const auto *value = Protobuf::stringToConstant(field.optional().value(), keyType);
+            tableKeySet.emplace(*keySymbol, *value);
             return tableKeySet;
         }
         default:
@@ -81,27 +83,23 @@ std::optional<ControlPlaneAssignmentSet> produceTableMatch(
 /// message.
 /// @param symbolSet tracks the symbols used in this conversion.
 std::optional<ControlPlaneAssignmentSet> produceTableMatchForMissingField(
-    cstring tableName, const p4::config::v1::MatchField &matchField, SymbolSet &symbolSet) {
+    const MatchFieldDescriptor &matchField, SymbolSet &symbolSet) {
     ControlPlaneAssignmentSet tableKeySet;
-    const auto *keyType = IR::Type_Bits::get(matchField.bitwidth());
-    const auto *keySymbol = ControlPlaneState::getTableKey(tableName, matchField.name(), keyType);
+    const auto *keyType = matchField.keyType;
+    const auto *keySymbol = matchField.keySymbol;
     symbolSet.emplace(*keySymbol);
-    switch (matchField.match_type()) {
+    switch (matchField.matchField->match_type()) {
         /// We can convert missing ternary and optional fields to 0.
         case p4::config::v1::MatchField::TERNARY:
         case p4::config::v1::MatchField::OPTIONAL: {
-            const auto *keySymbol =
-                ControlPlaneState::getTableKey(tableName, matchField.name(), keyType);
-            const auto *maskSymbol =
-                ControlPlaneState::getTableTernaryMask(tableName, matchField.name(), keyType);
-            symbolSet.emplace(*keySymbol);
+            const auto *maskSymbol = matchField.maskSymbol;
             symbolSet.emplace(*maskSymbol);
-            tableKeySet.emplace(*keySymbol, *IR::Constant::get(keyType, 0));
-            tableKeySet.emplace(*maskSymbol, *IR::Constant::get(keyType, 0));
+            tableKeySet.emplace(*keySymbol, *Protobuf::uint64ToConstant(0, keyType));
+            tableKeySet.emplace(*maskSymbol, *Protobuf::uint64ToConstant(0, keyType));
             return tableKeySet;
         }
         default:
-            error("Unsupported match type %1%.", matchField.DebugString());
+            error("Unsupported match type %1%.", matchField.matchField->DebugString());
     }
     return std::nullopt;
 }
@@ -109,129 +107,127 @@ std::optional<ControlPlaneAssignmentSet> produceTableMatchForMissingField(
 /// Convert a BFRuntime TableAction into the appropriate symbolic constraint
 /// assignments. If @param isDefaultAction is true, then the constraints generated are
 /// specialized towards overriding a default action in a table.
-std::optional<ControlPlaneAssignmentSet> convertTableAction(const bfrt_proto::TableData &tblAction,
-                                                            cstring tableName,
-                                                            const p4::config::v1::Action &p4Action,
-                                                            SymbolSet &symbolSet,
-                                                            bool isDefaultAction) {
+std::optional<ControlPlaneAssignmentSet> convertTableAction(
+    const bfrt_proto::TableData &tblAction, const TableDescriptor &table,
+    const TableActionDescriptor &p4Action, SymbolSet &symbolSet, bool isDefaultAction) {
     const IR::SymbolicVariable *tableActionID =
-        isDefaultAction ? ControlPlaneState::getDefaultActionVariable(tableName)
-                        : ControlPlaneState::getTableActionChoice(tableName);
+        isDefaultAction ? table.defaultActionSymbol : table.actionChoiceSymbol;
     symbolSet.emplace(*tableActionID);
-    auto actionName = p4Action.preamble().name();
-    const auto *actionAssignment = IR::StringLiteral::get(actionName);
+    const auto &actionName = p4Action.action->preamble().name();
     ControlPlaneAssignmentSet tableActionAssignmentSet;
-    tableActionAssignmentSet.emplace(*tableActionID, *actionAssignment);
-    if (tblAction.fields().size() != p4Action.params().size()) {
+    tableActionAssignmentSet.emplace(*tableActionID, *p4Action.choiceLiteral);
+    if (tblAction.fields().size() != p4Action.action->params().size()) {
         return tableActionAssignmentSet;
     }
-    RETURN_IF_FALSE_WITH_MESSAGE(tblAction.fields().size() == p4Action.params().size(),
-                                 std::nullopt,
-                                 error("Action configuration \"%1%\" and target action \"%2%\" "
-                                       "have parameters of different number.",
-                                       p4Action.ShortDebugString(), tblAction.ShortDebugString()));
-    std::map<uint32_t, const p4::config::v1::Action_Param *> paramMap;
-    for (const auto &param : p4Action.params()) {
-        paramMap.emplace(param.id(), &param);
-    }
     for (const auto &paramConfig : tblAction.fields()) {
-        auto paramIt = paramMap.find(paramConfig.field_id());
+        auto paramIt = p4Action.params.find(paramConfig.field_id());
         RETURN_IF_FALSE_WITH_MESSAGE(
-            paramIt != paramMap.end(), std::nullopt,
+            paramIt != p4Action.params.end(), std::nullopt,
             error("Parameter %1% of action %2% not found.", paramConfig.DebugString(), actionName));
-        const auto *paramType = IR::Type_Bits::get(paramIt->second->bitwidth());
-        auto paramName = paramIt->second->name();
-        const auto *actionArg =
-            ControlPlaneState::getTableActionArgument(tableName, actionName, paramName, paramType);
-        symbolSet.emplace(*actionArg);
+        const auto &param = paramIt->second;
+        symbolSet.emplace(*param.argumentSymbol);
         RETURN_IF_FALSE_WITH_MESSAGE(paramConfig.has_stream(), std::nullopt,
                                      error("Parameter %1% of action %2% is not a stream value.",
                                            paramConfig.DebugString(), actionName));
-        const auto *actionVal =
-            IR::Constant::get(paramType, Protobuf::stringToBigInt(paramConfig.stream()));
-        tableActionAssignmentSet.emplace(*actionArg, *actionVal);
+        const auto *actionVal = Protobuf::stringToConstant(paramConfig.stream(), param.type);
+        tableActionAssignmentSet.emplace(*param.argumentSymbol, *actionVal);
     }
     return tableActionAssignmentSet;
 }
 
-/// Convert a BFRuntime TableEntry into a TableMatchEntry.
+/// Convert the action @p tblAction of an entry of @p table into symbolic constraint assignments.
+/// Actions which the table does not reference in the P4Info are resolved on demand.
+std::optional<ControlPlaneAssignmentSet> convertTableAction(
+    const bfrt_proto::TableData &tblAction, const TableDescriptor &table,
+    const P4InfoIndex &p4InfoIndex, const bfrt_proto::TableEntry &tableEntry,
+    SymbolSet &symbolSet, bool isDefaultAction) {
+    auto actionId = tblAction.action_id();
+    if (const auto *p4Action = table.findAction(actionId)) {
+        return convertTableAction(tblAction, table, *p4Action, symbolSet, isDefaultAction);
+    }
+    const auto *p4Action = p4InfoIndex.findAction(actionId);
+    RETURN_IF_FALSE_WITH_MESSAGE(p4Action != nullptr, std::nullopt,
+                                 error("Action ID %1% from table entry `%2%` not found in the "
+                                       "P4Info.",
+                                       actionId, tableEntry.ShortDebugString()));
+    auto actionDescriptor = TableActionDescriptor::create(table.name, *p4Action);
+    return convertTableAction(tblAction, table, actionDescriptor, symbolSet, isDefaultAction);
+}
+
+/// Convert the matches of @p tableEntry into symbolic constraint assignments. Fields are
+/// considered in P4Info order and only the first occurrence of a field counts.
 /// Returns std::nullopt if the conversion fails.
 /// @param symbolSet tracks the symbols used in this conversion.
-std::optional<TableMatchEntry *> produceTableEntry(cstring tableName,
-                                                   P4::ControlPlaneAPI::p4rt_id_t tblId,
-                                                   const p4::config::v1::P4Info &p4Info,
-                                                   const bfrt_proto::TableEntry &tableEntry,
-                                                   SymbolSet &symbolSet) {
-    RETURN_IF_FALSE_WITH_MESSAGE(tableEntry.has_data(), std::nullopt,
-                                 error("Table entry %1% has no action.", tableEntry.DebugString()));
-
-    const auto &tableAction = tableEntry.data();
-    auto actionId = tableAction.action_id();
-    ASSIGN_OR_RETURN_WITH_MESSAGE(
-        auto &p4Action, P4::ControlPlaneAPI::findP4RuntimeAction(p4Info, actionId), std::nullopt,
-        error("Action ID %1% from table entry `%2%` not found in the P4Info.", actionId,
-              tableEntry.ShortDebugString()));
-    ASSIGN_OR_RETURN(const auto &tableActionAssignmentSet,
-                     convertTableAction(tableAction, tableName, p4Action, symbolSet, false),
-                     std::nullopt);
-    ASSIGN_OR_RETURN_WITH_MESSAGE(
-        auto &p4InfoTable, P4::ControlPlaneAPI::findP4RuntimeTable(p4Info, tblId), std::nullopt,
-        error("Table ID %1% not found in the P4Info.", actionId));
-
+std::optional<ControlPlaneAssignmentSet> produceTableMatches(
+    const TableDescriptor &table, const bfrt_proto::TableEntry &tableEntry, SymbolSet &symbolSet) {
     RETURN_IF_FALSE_WITH_MESSAGE(
-        tableEntry.key().fields_size() <= p4InfoTable.match_fields().size(), std::nullopt,
+        static_cast<size_t>(tableEntry.key().fields_size()) <= table.matchFields.size(),
+        std::nullopt,
         error("Table entry %1% has %2% matches, but P4Info has %3%.", tableEntry.DebugString(),
-              tableEntry.key().fields_size(), p4InfoTable.match_fields().size()));
-    // Use this map to look up which match fields are present in the control plane entry.
-    // TODO: Cache this somehow?
-    auto matchMap = std::map<uint32_t, bfrt_proto::KeyField>();
+              tableEntry.key().fields_size(), table.matchFields.size()));
+    // Look up which match fields are present in the control plane entry, in P4Info order.
+    std::vector<const bfrt_proto::KeyField *> presentFields(table.matchFields.size(), nullptr);
     for (const auto &matchField : tableEntry.key().fields()) {
-        matchMap.emplace(matchField.field_id(), matchField);
+        auto position = table.findMatchFieldPosition(matchField.field_id());
+        if (position.has_value() && presentFields[position.value()] == nullptr) {
+            presentFields[position.value()] = &matchField;
+        }
     }
 
     ControlPlaneAssignmentSet tableKeySet;
-    for (const auto &p4InfoMatchField : p4InfoTable.match_fields()) {
-        auto matchFieldIt = matchMap.find(p4InfoMatchField.id());
+    for (size_t fieldIdx = 0; fieldIdx < table.matchFields.size(); fieldIdx++) {
+        const auto &p4InfoMatchField = table.matchFields[fieldIdx];
         std::optional<ControlPlaneAssignmentSet> matchSetOpt;
         // If we are missing a match entry, create the dummy entry for supported fields.
-        if (matchFieldIt == matchMap.end()) {
-            matchSetOpt = produceTableMatchForMissingField(tableName, p4InfoMatchField, symbolSet);
+        if (presentFields[fieldIdx] == nullptr) {
+            matchSetOpt = produceTableMatchForMissingField(p4InfoMatchField, symbolSet);
         } else {
-            matchSetOpt =
-                produceTableMatch(matchFieldIt->second, tableName, p4InfoMatchField, symbolSet);
+            matchSetOpt = produceTableMatch(*presentFields[fieldIdx], p4InfoMatchField, symbolSet);
         }
         ASSIGN_OR_RETURN(auto matchSet, matchSetOpt, std::nullopt);
         tableKeySet.insert(matchSet.begin(), matchSet.end());
     }
+    return tableKeySet;
+}
+
+/// Convert a BFRuntime TableEntry into a TableMatchEntry.
+/// Returns std::nullopt if the conversion fails.
+/// @param symbolSet tracks the symbols used in this conversion.
+std::optional<TableMatchEntry *> produceTableEntry(const TableDescriptor &table,
+                                                   const P4InfoIndex &p4InfoIndex,
+                                                   const bfrt_proto::TableEntry &tableEntry,
+                                                   SymbolSet &symbolSet) {
+    RETURN_IF_FALSE_WITH_MESSAGE(tableEntry.has_data(), std::nullopt,
+                                 error("Table entry %1% has no action.", tableEntry.DebugString()));
+
+    ASSIGN_OR_RETURN(const auto &tableActionAssignmentSet,
+                     convertTableAction(tableEntry.data(), table, p4InfoIndex, tableEntry,
+                                        symbolSet, false),
+                     std::nullopt);
+
+    ASSIGN_OR_RETURN(auto tableKeySet, produceTableMatches(table, tableEntry, symbolSet),
+                     std::nullopt);
     return new TableMatchEntry(tableActionAssignmentSet, 0, tableKeySet);
 }
 
 /// Convert a BFRuntime TableEntry into the appropriate symbolic constraint
 /// assignments.
 /// @param symbolSet tracks the symbols used in this conversion.
-int updateTableEntry(const p4::config::v1::P4Info &p4Info, const p4::config::v1::Table &p4Table,
+int updateTableEntry(const P4InfoIndex &p4InfoIndex, const TableDescriptor &table,
                      const bfrt_proto::TableEntry &tableEntry,
                      TableConfiguration &tableConfiguration,
                      const ::bfrt_proto::Update_Type &updateType, SymbolSet &symbolSet) {
     if (tableEntry.is_default_entry()) {
-        const auto &defaultAction = tableEntry.data();
-        ASSIGN_OR_RETURN_WITH_MESSAGE(
-            auto &p4Action,
-            P4::ControlPlaneAPI::findP4RuntimeAction(p4Info, defaultAction.action_id()),
-            EXIT_FAILURE,
-            error("Action ID %1% from default table entry `%2%` not found in the P4Info.",
-                  defaultAction.action_id(), tableEntry.ShortDebugString()));
-        ASSIGN_OR_RETURN(
-            auto defaultActionExpr,
-            convertTableAction(defaultAction, p4Table.preamble().name(), p4Action, symbolSet, true),
-            EXIT_FAILURE);
+        ASSIGN_OR_RETURN(auto defaultActionExpr,
+                         convertTableAction(tableEntry.data(), table, p4InfoIndex, tableEntry,
+                                            symbolSet, true),
+                         EXIT_FAILURE);
         tableConfiguration.setDefaultTableAction(TableDefaultAction(defaultActionExpr));
     }
 
     RETURN_IF_FALSE_WITH_MESSAGE(
-        !p4Table.is_const_table(), EXIT_FAILURE,
-        error("Trying to insert an entry into table '%1%', which is a const table.",
-              p4Table.preamble().name()));
+        !table.table->is_const_table(), EXIT_FAILURE,
+        error("Trying to insert an entry into table '%1%', which is a const table.", table.name));
 
     // Consider a delete message without an action a wild card delete.
     if (updateType == bfrt_proto::Update::DELETE && !tableEntry.has_data()) {
@@ -240,9 +236,7 @@ int updateTableEntry(const p4::config::v1::P4Info &p4Info, const p4::config::v1:
     }
 
     ASSIGN_OR_RETURN(auto *tableMatchEntry,
-                     produceTableEntry(p4Table.preamble().name(), p4Table.preamble().id(), p4Info,
-                                       tableEntry, symbolSet),
-                     EXIT_FAILURE);
+                     produceTableEntry(table, p4InfoIndex, tableEntry, symbolSet), EXIT_FAILURE);
 
     if (updateType == bfrt_proto::Update::MODIFY) {
         tableConfiguration.addTableEntry(*tableMatchEntry, true);
@@ -262,11 +256,58 @@ int updateTableEntry(const p4::config::v1::P4Info &p4Info, const p4::config::v1:
     return EXIT_SUCCESS;
 }
 
-int updateTableEntry(const p4::config::v1::P4Info &p4Info, const p4::config::v1::Table &p4Table,
+/// Record an update of a table which can not influence the program in @p relevanceIndex, without
+/// converting it into IR.
+int recordIrrelevantTableEntry(const TableDescriptor &table,
+                               const bfrt_proto::TableEntry &tableEntry,
+                               const ::bfrt_proto::Update_Type &updateType,
+                               TableRelevanceIndex &relevanceIndex) {
+    auto tblId = tableEntry.table_id();
+    printFeature("flay_protobuf", 4, "Table %1% is not referenced by the program, skipping.",
+                 table.name);
+    if (tableEntry.is_default_entry()) {
+        relevanceIndex.setDefaultAction(tblId);
+    }
+
+    RETURN_IF_FALSE_WITH_MESSAGE(
+        !table.table->is_const_table(), EXIT_FAILURE,
+        error("Trying to insert an entry into table '%1%', which is a const table.", table.name));
+
+    // Consider a delete message without an action a wild card delete.
+    if (updateType == bfrt_proto::Update::DELETE && !tableEntry.has_data()) {
+        relevanceIndex.clearEntries(tblId);
+        return EXIT_SUCCESS;
+    }
+
+    // Identify the entry by the same key as the TableMatchEntry the conversion would produce.
+    SymbolSet symbolSet;
+    ASSIGN_OR_RETURN(auto matches, produceTableMatches(table, tableEntry, symbolSet),
+                     EXIT_FAILURE);
+    auto matchKey = TableMatchEntry::computeMatchKey(matches, 0);
+    if (updateType == bfrt_proto::Update::MODIFY) {
+        relevanceIndex.modifyEntry(tblId, std::move(matchKey));
+    } else if (updateType == bfrt_proto::Update::INSERT) {
+        RETURN_IF_FALSE_WITH_MESSAGE(
+            relevanceIndex.insertEntry(tblId, std::move(matchKey)) == EXIT_SUCCESS, EXIT_FAILURE,
+            error("Table entry \"%1%\" already exists.", tableEntry.ShortDebugString()));
+    } else if (updateType == bfrt_proto::Update::DELETE) {
+        RETURN_IF_FALSE_WITH_MESSAGE(relevanceIndex.deleteEntry(tblId, matchKey) == EXIT_SUCCESS,
+                                     EXIT_FAILURE,
+                                     error("Table entry %1% not found and can not be deleted.",
+                                           tableEntry.ShortDebugString()));
+    } else {
+        error("Unsupported update type %1%.", updateType);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int updateTableEntry(const P4InfoIndex &p4InfoIndex, const TableDescriptor &table,
                      const bfrt_proto::TableEntry &tableEntry,
                      ControlPlaneConstraints &controlPlaneConstraints,
-                     const ::bfrt_proto::Update_Type &updateType, SymbolSet &symbolSet) {
-    cstring tableName = p4Table.preamble().name();
+                     const ::bfrt_proto::Update_Type &updateType, SymbolSet &symbolSet,
+                     TableRelevanceIndex *relevanceIndex) {
+    cstring tableName = table.name;
 
     auto it = controlPlaneConstraints.find(tableName);
     RETURN_IF_FALSE_WITH_MESSAGE(
@@ -279,15 +320,19 @@ int updateTableEntry(const p4::config::v1::P4Info &p4Info, const p4::config::v1:
         auto &tableResult, it->second.get().to<TableConfiguration>(), EXIT_FAILURE,
         error("Configuration result is not a TableConfiguration.", tableName));
 
-    if (p4Table.implementation_id() != 0) {
+    if (table.table->implementation_id() != 0) {
         warning(
             "Insertions of entries into tables with custom implementation is not supported yet "
             "(Table '%1%') is not implemented.",
-            p4Table.preamble().name());
+            tableName);
         return EXIT_SUCCESS;
     }
 
-    return updateTableEntry(p4Info, p4Table, tableEntry, tableResult, updateType, symbolSet);
+    if (relevanceIndex != nullptr && !relevanceIndex->isRelevant(tableEntry.table_id())) {
+        return recordIrrelevantTableEntry(table, tableEntry, updateType, *relevanceIndex);
+    }
+
+    return updateTableEntry(p4InfoIndex, table, tableEntry, tableResult, updateType, symbolSet);
 }
 
 std::optional<cstring> getActionProfileName(const p4::config::v1::P4Info &p4Info,
@@ -330,7 +375,7 @@ std::optional<cstring> getActionSelectorName(const p4::config::v1::P4Info &p4Inf
 }
 
 int configureActionProfile(const bfrt_proto::TableEntry &tableEntry,
-                           const ActionProfile &actionProfile, const p4::config::v1::P4Info &p4Info,
+                           const ActionProfile &actionProfile, const P4InfoIndex &p4InfoIndex,
                            ControlPlaneConstraints &controlPlaneConstraints,
                            const ::bfrt_proto::Update_Type &updateType, SymbolSet &symbolSet) {
     // Iterate over each associated table and insert the respective action into the table.
@@ -346,11 +391,11 @@ int configureActionProfile(const bfrt_proto::TableEntry &tableEntry,
                                       EXIT_FAILURE,
                                       error("Configuration result %1% is not a TableConfiguration.",
                                             associatedTableReference));
-        ASSIGN_OR_RETURN_WITH_MESSAGE(
-            auto &p4InfoTable,
-            P4::ControlPlaneAPI::findP4RuntimeTable(p4Info, associatedTableReference), EXIT_FAILURE,
+        const auto *table = p4InfoIndex.findTable(associatedTableReference);
+        RETURN_IF_FALSE_WITH_MESSAGE(
+            table != nullptr, EXIT_FAILURE,
             error("Table name %1% not found in the P4Info.", associatedTableReference));
-        RETURN_IF_FALSE(updateTableEntry(p4Info, p4InfoTable, tableEntry, tableResult, updateType,
+        RETURN_IF_FALSE(updateTableEntry(p4InfoIndex, *table, tableEntry, tableResult, updateType,
                                          symbolSet) == EXIT_SUCCESS,
                         EXIT_FAILURE);
     }
@@ -359,7 +404,7 @@ int configureActionProfile(const bfrt_proto::TableEntry &tableEntry,
 
 int configureActionSelector(const bfrt_proto::TableEntry & /*tableEntry*/,
                             ActionSelector & /*selector*/,
-                            const p4::config::v1::P4Info & /*p4Info*/,
+                            const P4InfoIndex & /*p4InfoIndex*/,
                             ControlPlaneConstraints & /*controlPlaneConstraints*/,
                             const ::bfrt_proto::Update_Type & /*updateType*/,
                             SymbolSet & /*symbolSet*/) {
@@ -370,21 +415,23 @@ int configureActionSelector(const bfrt_proto::TableEntry & /*tableEntry*/,
 }  // namespace
 
 int updateControlPlaneConstraintsWithEntityMessage(const bfrt_proto::Entity &entity,
-                                                   const p4::config::v1::P4Info &p4Info,
+                                                   const P4InfoIndex &p4InfoIndex,
                                                    ControlPlaneConstraints &controlPlaneConstraints,
                                                    const ::bfrt_proto::Update_Type &updateType,
-                                                   SymbolSet &symbolSet) {
+                                                   SymbolSet &symbolSet,
+                                                   TableRelevanceIndex *relevanceIndex) {
     if (entity.has_table_entry()) {
         auto tableId = entity.table_entry().table_id();
-        const auto *p4Table = P4::ControlPlaneAPI::findP4RuntimeTable(p4Info, tableId);
-        if (p4Table != nullptr) {
-            RETURN_IF_FALSE(
-                updateTableEntry(p4Info, *p4Table, entity.table_entry(), controlPlaneConstraints,
-                                 updateType, symbolSet) == EXIT_SUCCESS,
-                EXIT_FAILURE)
+        const auto *table = p4InfoIndex.findTable(tableId);
+        if (table != nullptr) {
+            RETURN_IF_FALSE(updateTableEntry(p4InfoIndex, *table, entity.table_entry(),
+                                             controlPlaneConstraints, updateType, symbolSet,
+                                             relevanceIndex) == EXIT_SUCCESS,
+                            EXIT_FAILURE)
             return EXIT_SUCCESS;
         }
         // In BFRuntime, table entries could also configure an action profile or selector.
+        const auto &p4Info = p4InfoIndex.p4Info();
         auto actionProfileNameOpt = getActionProfileName(p4Info, entity.table_entry());
         if (actionProfileNameOpt.has_value()) {
             auto it = controlPlaneConstraints.find(actionProfileNameOpt.value());
@@ -399,7 +446,7 @@ int updateControlPlaneConstraintsWithEntityMessage(const bfrt_proto::Entity &ent
                 error("Configuration result %1% is not an action profile.",
                       actionProfileNameOpt.value()));
 
-            return configureActionProfile(entity.table_entry(), actionProfile, p4Info,
+            return configureActionProfile(entity.table_entry(), actionProfile, p4InfoIndex,
                                           controlPlaneConstraints, updateType, symbolSet);
         }
         auto actionSelectorNameOpt = getActionSelectorName(p4Info, entity.table_entry());
@@ -416,7 +463,7 @@ int updateControlPlaneConstraintsWithEntityMessage(const bfrt_proto::Entity &ent
                 error("Configuration result %1% is not an action selector.",
                       actionSelectorNameOpt.value()));
 
-            return configureActionSelector(entity.table_entry(), actionSelector, p4Info,
+            return configureActionSelector(entity.table_entry(), actionSelector, p4InfoIndex,
                                            controlPlaneConstraints, updateType, symbolSet);
         }
     }
@@ -425,11 +472,12 @@ int updateControlPlaneConstraintsWithEntityMessage(const bfrt_proto::Entity &ent
 }
 
 int updateControlPlaneConstraints(const bfruntime::flaytests::Config &protoControlPlaneConfig,
-                                  const p4::config::v1::P4Info &p4Info,
+                                  const P4InfoIndex &p4InfoIndex,
                                   ControlPlaneConstraints &controlPlaneConstraints,
                                   SymbolSet &symbolSet) {
     for (const auto &entity : protoControlPlaneConfig.entities()) {
-        if (updateControlPlaneConstraintsWithEntityMessage(entity, p4Info, controlPlaneConstraints,
+        if (updateControlPlaneConstraintsWithEntityMessage(entity, p4InfoIndex,
+                                                           controlPlaneConstraints,
                                                            bfrt_proto::Update::MODIFY,
                                                            symbolSet) != EXIT_SUCCESS) {
             return EXIT_FAILURE;
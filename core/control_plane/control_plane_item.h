@@ -1,6 +1,7 @@
 #ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_CONTROL_PLANE_ITEM_H_
 #define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_CONTROL_PLANE_ITEM_H_
 
+#include <cstdint>
 #include <map>
 
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_assignment.h"
@@ -18,6 +19,11 @@ class ControlPlaneItem : public ICastable {
 
     /// Get the control plane assignments produced by the control plane item.
     [[nodiscard]] virtual ControlPlaneAssignmentSet computeControlPlaneAssignments() const = 0;
+
+    /// @returns the approximate number of bytes held by this item. Does not include the memory of
+    /// IR nodes or Z3 expressions, which are accounted for separately. Items which hold a
+    /// significant amount of state should override this.
+    [[nodiscard]] virtual uint64_t estimateMemoryUsage() const { return sizeof(ControlPlaneItem); }
 };
 
 class Z3ControlPlaneItem : public ControlPlaneItem {
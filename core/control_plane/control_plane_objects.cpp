@@ -1,11 +1,18 @@
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <iterator>
+#include <string_view>
 #include <utility>
+#include <variant>
 
 #include "backends/p4tools/common/control_plane/symbolic_variables.h"
 #include "backends/p4tools/common/lib/variables.h"
+#include "backends/p4tools/modules/flay/core/control_plane/shadow_detection.h"
 #include "backends/p4tools/modules/flay/core/control_plane/substitute_variable.h"
+#include "backends/p4tools/modules/flay/core/lib/memory_usage.h"
+#include "backends/p4tools/modules/flay/core/lib/return_macros.h"
 #include "backends/p4tools/modules/flay/core/lib/simplify_expression.h"
 #include "backends/p4tools/modules/flay/core/lib/z3_cache.h"
 #include "ir/irutils.h"
@@ -18,8 +25,19 @@ const IR::SymbolicVariable *getParserValueSetConfigured(cstring parserValueSetNa
                                                "pvs_configured_" + parserValueSetName);
 }
 
-const IR::SymbolicVariable *getDefaultActionVariable(cstring tableName) {
-    return new IR::SymbolicVariable(IR::Type_String::get(), tableName + "_default_action");
+namespace {
+
+/// @returns the label of the action choice of @p tableName.
+cstring actionChoiceLabel(cstring tableName) { return tableName + "_action_choice"; }
+
+}  // namespace
+
+const IR::SymbolicVariable *getActionChoiceVariable(cstring tableName, const IR::Type_Bits *type) {
+    return ToolsVariables::getSymbolicVariable(type, actionChoiceLabel(tableName));
+}
+
+const IR::SymbolicVariable *getDefaultActionVariable(cstring tableName, const IR::Type_Bits *type) {
+    return ToolsVariables::getSymbolicVariable(type, tableName + "_default_action");
 }
 
 }  // namespace P4::P4Tools::ControlPlaneState
@@ -107,12 +125,15 @@ namespace {
 const IR::Expression *createLpmKey(const IR::SymbolicVariable *variable,
                                    const IR::SymbolicVariable *prefixVar,
                                    const IR::Expression *keyExpression) {
-    // The maxReturn is the maximum vale for the given bit width. This value is
-    // shifted by the mask variable to create a mask (and with that, a prefix).
+    // The maxReturn is the maximum vale for the given bit width. The prefix variable holds the
+    // prefix length of the control plane, so the value is shifted by the number of bits after the
+    // prefix to create a mask. A prefix length of zero shifts out all bits and matches any value.
     const auto *keyType = variable->type;
     auto keyWidth = keyType->width_bits();
     auto maxReturn = IR::getMaxBvVal(keyWidth);
-    const IR::Expression *lpmMask = new IR::Shl(IR::Constant::get(keyType, maxReturn), prefixVar);
+    const IR::Expression *lpmMask =
+        new IR::Shl(IR::Constant::get(keyType, maxReturn),
+                    new IR::Sub(IR::Constant::get(keyType, keyWidth), prefixVar));
     return new IR::Equ(new IR::BAnd(keyExpression, lpmMask), new IR::BAnd(variable, lpmMask));
 }
 
@@ -219,11 +240,51 @@ std::optional<z3::expr> RangeTableMatchKey::computeZ3ControlPlaneConstraint() co
 TableMatchEntry
 **************************************************************************************************/
 
+namespace {
+
+/// Append the magnitude of @p value to @p packedValue.
+void packMagnitude(const big_int &value, std::string &packedValue) {
+    boost::multiprecision::export_bits(boost::multiprecision::abs(value),
+                                       std::back_inserter(packedValue), 8);
+}
+
+/// Pack @p value into a byte string, which does not depend on the width of its type.
+std::string packConstantValue(const big_int &value) {
+    std::string packedValue(1, value < 0 ? '-' : '+');
+    packMagnitude(value, packedValue);
+    return packedValue;
+}
+
+/// Pack the value of a control-plane assignment into a canonical byte string.
+std::string packValue(const IR::Expression &value) {
+    std::string packedValue;
+    if (const auto *constant = value.to<IR::Constant>()) {
+        packedValue.push_back(constant->value < 0 ? '-' : '+');
+        auto width = static_cast<uint32_t>(constant->type->width_bits());
+        packedValue.append(reinterpret_cast<const char *>(&width), sizeof(width));
+        packMagnitude(constant->value, packedValue);
+    } else if (const auto *boolLiteral = value.to<IR::BoolLiteral>()) {
+        packedValue.push_back('b');
+        packedValue.push_back(boolLiteral->value ? '1' : '0');
+    } else if (const auto *stringLiteral = value.to<IR::StringLiteral>()) {
+        packedValue.push_back('s');
+        packedValue.append(stringLiteral->value.string_view());
+    } else {
+        // Assignments are normally literals. Anything else is keyed by its printed form.
+        packedValue.push_back('e');
+        packedValue.append(value.toString().string_view());
+    }
+    return packedValue;
+}
+
+}  // namespace
+
 TableMatchEntry::TableMatchEntry(ControlPlaneAssignmentSet actionAssignment, int32_t priority,
                                  ControlPlaneAssignmentSet matches)
     : _actionAssignment(std::move(actionAssignment)),
       _priority(priority),
-      _matches(std::move(matches)) {
+      _matches(std::move(matches)),
+      _matchKey(computeMatchKey(_matches, priority)) {
     for (const auto &assignment : _matches) {
         _z3Matches.add(assignment.first, Z3Cache::set(&assignment.second.get()));
     }
@@ -232,8 +293,51 @@ TableMatchEntry::TableMatchEntry(ControlPlaneAssignmentSet actionAssignment, int
     }
 }
 
+std::string TableMatchEntry::computeMatchKey(const ControlPlaneAssignmentSet &matches,
+                                             int32_t priority) {
+    // Every field is prefixed with its length, so distinct sequences of fields can not produce the
+    // same key.
+    auto appendField = [](std::string &key, std::string_view field) {
+        auto length = static_cast<uint32_t>(field.size());
+        key.append(reinterpret_cast<const char *>(&length), sizeof(length));
+        key.append(field);
+    };
+    std::vector<std::pair<std::string_view, std::string>> packedMatches;
+    packedMatches.reserve(matches.size());
+    for (const auto &[symbol, assignment] : matches) {
+        packedMatches.emplace_back(symbol.get().label.string_view(), packValue(assignment.get()));
+    }
+    std::sort(packedMatches.begin(), packedMatches.end());
+
+    std::string matchKey;
+    matchKey.append(reinterpret_cast<const char *>(&priority), sizeof(priority));
+    for (const auto &[label, packedValue] : packedMatches) {
+        appendField(matchKey, label);
+        appendField(matchKey, packedValue);
+    }
+    return matchKey;
+}
+
 int32_t TableMatchEntry::priority() const { return _priority; }
 
+const std::string &TableMatchEntry::matchKey() const { return _matchKey; }
+
+std::string_view TableMatchEntry::matchValuesKey() const {
+    return std::string_view(_matchKey).substr(sizeof(_priority));
+}
+
+const ControlPlaneAssignmentSet &TableMatchEntry::matches() const { return _matches; }
+
+const IR::Constant *TableMatchEntry::actionChoice(cstring tableName) const {
+    auto label = ControlPlaneState::actionChoiceLabel(tableName);
+    for (const auto &[symbol, assignment] : _actionAssignment) {
+        if (symbol.get().label == label) {
+            return assignment.get().to<IR::Constant>();
+        }
+    }
+    return nullptr;
+}
+
 ControlPlaneAssignmentSet TableMatchEntry::actionAssignment() const { return _actionAssignment; }
 
 Z3ControlPlaneAssignmentSet TableMatchEntry::z3ActionAssignment() const {
@@ -254,6 +358,14 @@ Z3ControlPlaneAssignmentSet TableMatchEntry::computeZ3ControlPlaneAssignments()
     return _z3Matches;
 }
 
+uint64_t TableMatchEntry::estimateMemoryUsage() const {
+    return sizeof(*this) + _matchKey.capacity() +
+           MemoryUsage::estimateContainerMemory(_actionAssignment) +
+           MemoryUsage::estimateContainerMemory(_matches) +
+           MemoryUsage::estimateNodeMemory(_z3ActionAssignment.size() + _z3Matches.size(),
+                                           sizeof(const IR::SymbolicVariable *) + sizeof(z3::expr));
+}
+
 /**************************************************************************************************
 TableDefaultAction
 **************************************************************************************************/
@@ -280,6 +392,12 @@ Z3ControlPlaneAssignmentSet TableDefaultAction::computeZ3ControlPlaneAssignments
     return _z3ActionAssignment;
 }
 
+uint64_t TableDefaultAction::estimateMemoryUsage() const {
+    return sizeof(*this) + MemoryUsage::estimateContainerMemory(_actionAssignment) +
+           MemoryUsage::estimateNodeMemory(_z3ActionAssignment.size(),
+                                           sizeof(const IR::SymbolicVariable *) + sizeof(z3::expr));
+}
+
 /**************************************************************************************************
 WildCardMatchEntry
 **************************************************************************************************/
@@ -293,10 +411,518 @@ Z3ControlPlaneAssignmentSet WildCardMatchEntry::computeZ3ControlPlaneAssignments
     return {};
 }
 
+/**************************************************************************************************
+TableEntrySet
+**************************************************************************************************/
+
+namespace {
+
+/// Look up the constant assigned to @p symbol by @p matches.
+/// @returns nullptr if @p symbol is not assigned, or std::nullopt if its value is not a constant.
+std::optional<const IR::Constant *> findMatchConstant(const ControlPlaneAssignmentSet &matches,
+                                                      const IR::SymbolicVariable &symbol) {
+    auto it = matches.find(symbol);
+    if (it == matches.end()) {
+        return nullptr;
+    }
+    const auto *constant = it->second.get().to<IR::Constant>();
+    if (constant == nullptr) {
+        return std::nullopt;
+    }
+    return constant;
+}
+
+/// Look up the constants assigned to @p first and @p second by @p matches.
+/// @returns std::nullopt unless both are constants or both are omitted, in which case the pair is
+/// nullptr.
+std::optional<std::pair<const IR::Constant *, const IR::Constant *>> findMatchConstants(
+    const ControlPlaneAssignmentSet &matches, const IR::SymbolicVariable &first,
+    const IR::SymbolicVariable &second) {
+    auto firstValue = findMatchConstant(matches, first);
+    auto secondValue = findMatchConstant(matches, second);
+    if (!firstValue.has_value() || !secondValue.has_value() ||
+        (firstValue.value() == nullptr) != (secondValue.value() == nullptr)) {
+        return std::nullopt;
+    }
+    return std::make_pair(firstValue.value(), secondValue.value());
+}
+
+}  // namespace
+
+const IR::Type_Bits *fieldMatchKeyType(const TableMatchKey &key) {
+    const IR::Expression *keyExpression = nullptr;
+    if (const auto *exactKey = key.to<ExactTableMatchKey>()) {
+        keyExpression = exactKey->keyExpression();
+    } else if (const auto *lpmKey = key.to<LpmTableMatchKey>()) {
+        keyExpression = lpmKey->keyExpression();
+    } else if (const auto *ternaryKey = key.to<TernaryTableMatchKey>()) {
+        keyExpression = ternaryKey->keyExpression();
+    } else if (const auto *rangeKey = key.to<RangeTableMatchKey>()) {
+        keyExpression = rangeKey->keyExpression();
+    }
+    if (keyExpression == nullptr) {
+        return nullptr;
+    }
+    // Masks and bounds are interpreted as unsigned values.
+    const auto *keyType = keyExpression->type->to<IR::Type_Bits>();
+    if (keyType == nullptr || keyType->isSigned) {
+        return nullptr;
+    }
+    return keyType;
+}
+
+std::optional<FieldMatch> computeFieldMatch(const TableMatchKey &key,
+                                            const ControlPlaneAssignmentSet &matches) {
+    const auto *keyType = fieldMatchKeyType(key);
+    if (keyType == nullptr) {
+        return std::nullopt;
+    }
+    auto keyWidth = keyType->width_bits();
+    auto maxValue = IR::getMaxBvVal(keyWidth);
+    if (const auto *exactKey = key.to<ExactTableMatchKey>()) {
+        auto value = findMatchConstant(matches, *exactKey->variable());
+        if (!value.has_value() || value.value() == nullptr) {
+            return std::nullopt;
+        }
+        return FieldMatch::masked(value.value()->value, maxValue);
+    }
+    if (const auto *lpmKey = key.to<LpmTableMatchKey>()) {
+        ASSIGN_OR_RETURN(auto constants,
+                         findMatchConstants(matches, *lpmKey->variable(), *lpmKey->prefix()),
+                         std::nullopt);
+        auto [value, prefix] = constants;
+        // P4Runtime omits fields which match every value.
+        if (value == nullptr) {
+            return FieldMatch::masked(0, 0);
+        }
+        // Mirror the mask of the LPM key, which shifts the all-ones value by the number of bits
+        // after the prefix.
+        big_int mask = 0;
+        if (prefix->value <= keyWidth) {
+            auto suffixWidth = static_cast<unsigned>(keyWidth - prefix->value);
+            mask = (maxValue << suffixWidth) & maxValue;
+        }
+        return FieldMatch::masked(value->value, mask);
+    }
+    if (const auto *ternaryKey = key.to<TernaryTableMatchKey>()) {
+        ASSIGN_OR_RETURN(auto constants,
+                         findMatchConstants(matches, *ternaryKey->variable(), *ternaryKey->mask()),
+                         std::nullopt);
+        auto [value, mask] = constants;
+        if (value == nullptr) {
+            return FieldMatch::masked(0, 0);
+        }
+        return FieldMatch::masked(value->value, mask->value);
+    }
+    const auto *rangeKey = key.checkedTo<RangeTableMatchKey>();
+    ASSIGN_OR_RETURN(auto constants,
+                     findMatchConstants(matches, *rangeKey->minKey(), *rangeKey->maxKey()),
+                     std::nullopt);
+    auto [low, high] = constants;
+    if (low == nullptr) {
+        return FieldMatch::interval(0, maxValue);
+    }
+    // The range key requires the low bound to be strictly smaller than the high bound.
+    if (low->value >= high->value) {
+        return FieldMatch::interval(1, 0);
+    }
+    return FieldMatch::interval(low->value, high->value);
+}
+
+bool TableEntrySet::insert(TableMatchEntry &tableMatchEntry) {
+    auto inserted =
+        _entries
+            .try_emplace(tableMatchEntry.matchKey(),
+                         IndexedEntry{tableMatchEntry, _nextInsertionIndex++,
+                                      computePrefixLength(tableMatchEntry)})
+            .second;
+    if (inserted && _indexedField != nullptr) {
+        addToFieldIndex(tableMatchEntry);
+    }
+    if (inserted && _indexedKey != nullptr) {
+        addToKeyIndex(tableMatchEntry);
+    }
+    return inserted;
+}
+
+void TableEntrySet::addToFieldIndex(const TableMatchEntry &tableMatchEntry) {
+    const auto &matches = tableMatchEntry.matches();
+    auto it = matches.find(*_indexedField);
+    const auto *constant = it == matches.end() ? nullptr : it->second.get().to<IR::Constant>();
+    if (constant == nullptr) {
+        _unindexedEntries.insert(tableMatchEntry.matchKey());
+        return;
+    }
+    _fieldIndex[packConstantValue(constant->value)].insert(tableMatchEntry.matchKey());
+}
+
+void TableEntrySet::removeFromFieldIndex(const TableMatchEntry &tableMatchEntry) {
+    const auto &matches = tableMatchEntry.matches();
+    auto it = matches.find(*_indexedField);
+    const auto *constant = it == matches.end() ? nullptr : it->second.get().to<IR::Constant>();
+    if (constant == nullptr) {
+        _unindexedEntries.erase(tableMatchEntry.matchKey());
+        return;
+    }
+    auto indexIt = _fieldIndex.find(packConstantValue(constant->value));
+    if (indexIt == _fieldIndex.end()) {
+        return;
+    }
+    indexIt->second.erase(tableMatchEntry.matchKey());
+    if (indexIt->second.empty()) {
+        _fieldIndex.erase(indexIt);
+    }
+}
+
+void TableEntrySet::addToKeyIndex(const TableMatchEntry &tableMatchEntry) {
+    auto fieldMatch = computeFieldMatch(*_indexedKey, tableMatchEntry.matches());
+    auto isIndexed =
+        fieldMatch.has_value() &&
+        std::visit([&](auto &index) { return index.insert(&tableMatchEntry, fieldMatch.value()); },
+                   _keyIndex.value());
+    if (!isIndexed) {
+        _unindexedKeyEntries.insert(tableMatchEntry.matchKey());
+    }
+}
+
+void TableEntrySet::removeFromKeyIndex(const TableMatchEntry &tableMatchEntry) {
+    if (_unindexedKeyEntries.erase(tableMatchEntry.matchKey()) > 0) {
+        return;
+    }
+    auto fieldMatch = computeFieldMatch(*_indexedKey, tableMatchEntry.matches());
+    if (fieldMatch.has_value()) {
+        std::visit([&](auto &index) { index.erase(&tableMatchEntry, fieldMatch.value()); },
+                   _keyIndex.value());
+    }
+}
+
+TableMatchEntry *TableEntrySet::find(const TableMatchEntry &tableMatchEntry) const {
+    auto it = _entries.find(tableMatchEntry.matchKey());
+    if (it == _entries.end()) {
+        return nullptr;
+    }
+    return &it->second.entry.get();
+}
+
+size_t TableEntrySet::erase(const TableMatchEntry &tableMatchEntry) {
+    auto it = _entries.find(tableMatchEntry.matchKey());
+    if (it == _entries.end()) {
+        return 0;
+    }
+    if (_indexedField != nullptr) {
+        removeFromFieldIndex(it->second.entry.get());
+    }
+    if (_indexedKey != nullptr) {
+        removeFromKeyIndex(it->second.entry.get());
+    }
+    _entries.erase(it);
+    return 1;
+}
+
+void TableEntrySet::clear() {
+    _entries.clear();
+    _fieldIndex.clear();
+    _unindexedEntries.clear();
+    if (_keyIndex.has_value()) {
+        std::visit([](auto &index) { index.clear(); }, _keyIndex.value());
+    }
+    _unindexedKeyEntries.clear();
+}
+
+size_t TableEntrySet::size() const { return _entries.size(); }
+
+bool TableEntrySet::empty() const { return _entries.empty(); }
+
+std::vector<std::reference_wrapper<TableMatchEntry>> TableEntrySet::orderedEntries() const {
+    std::vector<const IndexedEntry *> indexedEntries;
+    indexedEntries.reserve(_entries.size());
+    for (const auto &[matchKey, indexedEntry] : _entries) {
+        indexedEntries.push_back(&indexedEntry);
+    }
+    return sortByPrecedence(std::move(indexedEntries));
+}
+
+void TableEntrySet::indexField(const IR::SymbolicVariable *field) {
+    if (field == _indexedField || (field != nullptr && _indexedField != nullptr &&
+                                   field->equiv(*_indexedField))) {
+        return;
+    }
+    _indexedField = field;
+    _fieldIndex.clear();
+    _unindexedEntries.clear();
+    if (_indexedField == nullptr) {
+        return;
+    }
+    for (const auto &[matchKey, indexedEntry] : _entries) {
+        addToFieldIndex(indexedEntry.entry.get());
+    }
+}
+
+const IR::SymbolicVariable *TableEntrySet::indexedField() const { return _indexedField; }
+
+std::vector<std::reference_wrapper<TableMatchEntry>> TableEntrySet::orderedEntriesMatching(
+    const big_int &value) const {
+    BUG_CHECK(_indexedField != nullptr, "Table entries are not indexed.");
+    std::vector<const IndexedEntry *> indexedEntries;
+    auto collect = [this, &indexedEntries](const absl::flat_hash_set<std::string> &matchKeys) {
+        for (const auto &matchKey : matchKeys) {
+            indexedEntries.push_back(&_entries.at(matchKey));
+        }
+    };
+    auto it = _fieldIndex.find(packConstantValue(value));
+    if (it != _fieldIndex.end()) {
+        collect(it->second);
+    }
+    collect(_unindexedEntries);
+    return sortByPrecedence(std::move(indexedEntries));
+}
+
+int TableEntrySet::computePrefixLength(const TableMatchEntry &tableMatchEntry) const {
+    if (_prefixKey == nullptr) {
+        return 0;
+    }
+    auto fieldMatch = computeFieldMatch(*_prefixKey, tableMatchEntry.matches());
+    if (!fieldMatch.has_value()) {
+        return 0;
+    }
+    // The mask of an LPM match is a contiguous prefix, so its length is the number of set bits.
+    int prefixLength = 0;
+    for (auto mask = fieldMatch.value().mask; mask != 0; mask &= mask - 1) {
+        ++prefixLength;
+    }
+    return prefixLength;
+}
+
+void TableEntrySet::orderByPrefix(const TableMatchKey *key) {
+    if (key == _prefixKey) {
+        return;
+    }
+    BUG_CHECK(key == nullptr || key->is<LpmTableMatchKey>(), "Key %1% is not an LPM key.",
+              key->name());
+    _prefixKey = key;
+    for (auto &[matchKey, indexedEntry] : _entries) {
+        indexedEntry.prefixLength = computePrefixLength(indexedEntry.entry.get());
+    }
+}
+
+void TableEntrySet::indexKey(const TableMatchKey *key) {
+    if (key == _indexedKey) {
+        return;
+    }
+    _indexedKey = key;
+    _keyIndex.reset();
+    _unindexedKeyEntries.clear();
+    if (_indexedKey == nullptr) {
+        return;
+    }
+    if (_indexedKey->is<LpmTableMatchKey>()) {
+        _keyIndex.emplace(LpmTrie(fieldMatchKeyType(*_indexedKey)->width_bits()));
+    } else if (_indexedKey->is<RangeTableMatchKey>()) {
+        _keyIndex.emplace(IntervalTree());
+    } else {
+        BUG_CHECK(_indexedKey->is<TernaryTableMatchKey>(), "Key %1% can not be indexed.",
+                  _indexedKey->name());
+        _keyIndex.emplace(TernaryMaskIndex());
+    }
+    for (const auto &[matchKey, indexedEntry] : _entries) {
+        addToKeyIndex(indexedEntry.entry.get());
+    }
+}
+
+const TableMatchKey *TableEntrySet::indexedKey() const { return _indexedKey; }
+
+std::vector<std::reference_wrapper<TableMatchEntry>> TableEntrySet::orderKeyIndexEntries(
+    const std::vector<const TableMatchEntry *> &keyIndexEntries) const {
+    std::vector<const IndexedEntry *> indexedEntries;
+    indexedEntries.reserve(keyIndexEntries.size() + _unindexedKeyEntries.size());
+    for (const auto *entry : keyIndexEntries) {
+        indexedEntries.push_back(&_entries.at(entry->matchKey()));
+    }
+    for (const auto &matchKey : _unindexedKeyEntries) {
+        indexedEntries.push_back(&_entries.at(matchKey));
+    }
+    return sortByPrecedence(std::move(indexedEntries));
+}
+
+std::vector<std::reference_wrapper<TableMatchEntry>> TableEntrySet::orderedEntriesMatchingKey(
+    const big_int &value) const {
+    BUG_CHECK(_indexedKey != nullptr, "Table entries are not indexed by a key.");
+    return orderKeyIndexEntries(
+        std::visit([&value](const auto &index) { return index.matching(value); },
+                   _keyIndex.value()));
+}
+
+std::vector<std::reference_wrapper<TableMatchEntry>> TableEntrySet::orderedEntriesCoveringKey(
+    const TableMatchEntry &tableMatchEntry) const {
+    BUG_CHECK(_indexedKey != nullptr, "Table entries are not indexed by a key.");
+    auto fieldMatch = computeFieldMatch(*_indexedKey, tableMatchEntry.matches());
+    // Without a match to compare with, any entry may cover this one.
+    if (!fieldMatch.has_value()) {
+        return orderedEntries();
+    }
+    return orderKeyIndexEntries(std::visit(
+        [&fieldMatch](const auto &index) { return index.covering(fieldMatch.value()); },
+        _keyIndex.value()));
+}
+
+bool TableEntrySet::precedes(const TableMatchEntry &left, const TableMatchEntry &right) const {
+    if (left.priority() != right.priority()) {
+        return left.priority() < right.priority();
+    }
+    const auto &leftEntry = _entries.at(left.matchKey());
+    const auto &rightEntry = _entries.at(right.matchKey());
+    if (leftEntry.prefixLength != rightEntry.prefixLength) {
+        return leftEntry.prefixLength < rightEntry.prefixLength;
+    }
+    return leftEntry.insertionIndex < rightEntry.insertionIndex;
+}
+
+std::vector<std::reference_wrapper<TableMatchEntry>> TableEntrySet::sortByPrecedence(
+    std::vector<const IndexedEntry *> indexedEntries) {
+    std::sort(indexedEntries.begin(), indexedEntries.end(),
+              [](const IndexedEntry *left, const IndexedEntry *right) {
+                  auto leftPriority = left->entry.get().priority();
+                  auto rightPriority = right->entry.get().priority();
+                  if (leftPriority != rightPriority) {
+                      return leftPriority < rightPriority;
+                  }
+                  if (left->prefixLength != right->prefixLength) {
+                      return left->prefixLength < right->prefixLength;
+                  }
+                  return left->insertionIndex < right->insertionIndex;
+              });
+    std::vector<std::reference_wrapper<TableMatchEntry>> orderedEntries;
+    orderedEntries.reserve(indexedEntries.size());
+    for (const auto *indexedEntry : indexedEntries) {
+        orderedEntries.emplace_back(indexedEntry->entry);
+    }
+    return orderedEntries;
+}
+
+uint64_t TableEntrySet::estimateMemoryUsage() const {
+    auto bytes = MemoryUsage::estimateContainerMemory(_entries) +
+                 MemoryUsage::estimateContainerMemory(_fieldIndex) +
+                 MemoryUsage::estimateContainerMemory(_unindexedEntries) +
+                 MemoryUsage::estimateContainerMemory(_unindexedKeyEntries);
+    if (_keyIndex.has_value()) {
+        bytes += std::visit([](const auto &index) { return index.estimateMemoryUsage(); },
+                            _keyIndex.value());
+    }
+    for (const auto &[matchKey, indexedEntry] : _entries) {
+        bytes += matchKey.capacity();
+    }
+    for (const auto &[value, matchKeys] : _fieldIndex) {
+        bytes += value.capacity() + MemoryUsage::estimateContainerMemory(matchKeys);
+        for (const auto &matchKey : matchKeys) {
+            bytes += matchKey.capacity();
+        }
+    }
+    for (const auto &matchKey : _unindexedEntries) {
+        bytes += matchKey.capacity();
+    }
+    for (const auto &matchKey : _unindexedKeyEntries) {
+        bytes += matchKey.capacity();
+    }
+    return bytes;
+}
+
 /**************************************************************************************************
 TableConfiguration
 **************************************************************************************************/
 
+namespace {
+
+/// @returns the data-plane expression matched by @p key if the entries of the key can be
+/// summarized as ranges of values. Otherwise, returns nullptr.
+const IR::Expression *rangeKeyExpression(const TableMatchKey &key) {
+    if (const auto *exactKey = key.to<ExactTableMatchKey>()) {
+        return exactKey->keyExpression();
+    }
+    if (const auto *lpmKey = key.to<LpmTableMatchKey>()) {
+        return lpmKey->keyExpression();
+    }
+    if (const auto *rangeKey = key.to<RangeTableMatchKey>()) {
+        return rangeKey->keyExpression();
+    }
+    return nullptr;
+}
+
+/// Build a balanced disjunction of the conditions in [begin, end). Keeps the depth of the
+/// expression logarithmic in the number of conditions.
+const IR::Expression *buildDisjunction(const std::vector<const IR::Expression *> &conditions,
+                                       size_t begin, size_t end) {
+    if (begin == end) {
+        return IR::BoolLiteral::get(false);
+    }
+    if (end - begin == 1) {
+        return conditions[begin];
+    }
+    auto middle = begin + (end - begin) / 2;
+    return new IR::LOr(buildDisjunction(conditions, begin, middle),
+                       buildDisjunction(conditions, middle, end));
+}
+
+/// Conditional assignments of a set of variables, keyed by variable. Each variable is assigned
+/// the value of its last case whose condition holds.
+using SelectionCases =
+    ordered_map<std::reference_wrapper<const IR::SymbolicVariable>,
+                std::vector<std::pair<const IR::Expression *, const IR::Expression *>>,
+                IR::IsSemanticallyLessComparator>;
+
+/// Build the selection of the cases in [from, to). The selection falls back to @p fallback if no
+/// condition holds. Without a fallback, one of the conditions is assumed to hold.
+/// @returns the selection and the disjunction of the conditions of the cases.
+std::pair<const IR::Expression *, const IR::Expression *> buildSelection(
+    const std::vector<std::pair<const IR::Expression *, const IR::Expression *>> &cases,
+    size_t from, size_t to, const IR::Expression *fallback) {
+    if (to - from == 1) {
+        const auto &[condition, assignment] = cases[from];
+        return {fallback != nullptr ? new IR::Mux(condition, assignment, fallback) : assignment,
+                condition};
+    }
+    // Later cases take precedence. If a case of the upper half matches, the lower half is not
+    // relevant. Otherwise, the lower half is, including the fallback.
+    auto middle = from + (to - from) / 2;
+    auto [upperSelection, upperCondition] = buildSelection(cases, middle, to, nullptr);
+    auto [lowerSelection, lowerCondition] = buildSelection(cases, from, middle, fallback);
+    return {new IR::Mux(upperCondition, upperSelection, lowerSelection),
+            new IR::LOr(lowerCondition, upperCondition)};
+}
+
+/// Merges the selections in @p cases into @p assignments. See
+/// Z3ControlPlaneAssignmentSet::mergeSelections.
+void mergeSelections(ControlPlaneAssignmentSet &assignments, const SelectionCases &cases) {
+    for (const auto &[variable, variableCases] : cases) {
+        if (variableCases.empty()) {
+            continue;
+        }
+        auto it = assignments.find(variable);
+        const auto *fallback =
+            it == assignments.end() ? variableCases.front().second : &it->second.get();
+        const auto *selection =
+            buildSelection(variableCases, 0, variableCases.size(), fallback).first;
+        if (it == assignments.end()) {
+            assignments.emplace(variable, *selection);
+        } else {
+            it->second = *selection;
+        }
+    }
+}
+
+}  // namespace
+
+std::string_view tableEncodingName(TableEncoding encoding) {
+    switch (encoding) {
+        case TableEncoding::kPerEntry:
+            return "per_entry";
+        case TableEncoding::kSummarized:
+            return "summarized";
+        case TableEncoding::kActionSet:
+            return "action_set";
+    }
+    return "unknown";
+}
+
 const IR::Expression *TableConfiguration::buildKeyMatches(const KeyMap &keyMap) {
     if (keyMap.empty()) {
         return IR::BoolLiteral::get(false);
@@ -325,7 +951,422 @@ TableConfiguration::TableConfiguration(cstring tableName, TableDefaultAction def
                                        TableEntrySet tableEntries)
     : _tableName(tableName),
       _defaultTableAction(std::move(defaultTableAction)),
-      _tableEntries(std::move(tableEntries)) {}
+      _tableEntries(std::move(tableEntries)) {
+    _tableEntries.forEach(
+        [this](const TableMatchEntry &tableEntry) { retainAction(tableEntry); });
+}
+
+bool TableConfiguration::retainAction(const TableMatchEntry &tableMatchEntry) {
+    const auto *actionChoice = tableMatchEntry.actionChoice(_tableName);
+    if (actionChoice == nullptr) {
+        return true;
+    }
+    return _actionReferenceCounts[actionChoice->value]++ == 0;
+}
+
+bool TableConfiguration::releaseAction(const TableMatchEntry &tableMatchEntry) {
+    const auto *actionChoice = tableMatchEntry.actionChoice(_tableName);
+    if (actionChoice == nullptr) {
+        return true;
+    }
+    auto it = _actionReferenceCounts.find(actionChoice->value);
+    if (it == _actionReferenceCounts.end()) {
+        return true;
+    }
+    if (--it->second == 0) {
+        _actionReferenceCounts.erase(it);
+        return true;
+    }
+    return false;
+}
+
+bool TableConfiguration::sizeChangesSummary(size_t sizeBefore) const {
+    auto sizeAfter = _tableEntries.size();
+    // Assume the shadowed entries stay the same. If they do not, consumeSummaryChange notices.
+    auto shadowedCount = _shadowedEntries.has_value() ? _shadowedEntries.value().size()
+                                                      : _previousShadowedEntries.size();
+    auto activeCount = [shadowedCount](size_t size) {
+        return size - std::min(size, shadowedCount);
+    };
+    return (sizeBefore > 0) != (sizeAfter > 0) ||
+           encodingFor(activeCount(sizeBefore)) != encodingFor(activeCount(sizeAfter));
+}
+
+const TableMatchKey *TableConfiguration::rangeSummaryKey() const {
+    if (_tableKeys.size() != 1) {
+        return nullptr;
+    }
+    const auto *keyExpression = rangeKeyExpression(*_tableKeys.front());
+    if (keyExpression == nullptr) {
+        return nullptr;
+    }
+    // Ranges are ordered as unsigned values.
+    const auto *keyType = keyExpression->type->to<IR::Type_Bits>();
+    if (keyType == nullptr || keyType->isSigned) {
+        return nullptr;
+    }
+    return _tableKeys.front();
+}
+
+std::optional<std::vector<TableConfiguration::KeyRange>> TableConfiguration::computeKeyRanges(
+    const TableMatchKey &key,
+    const std::vector<std::reference_wrapper<TableMatchEntry>> &orderedEntries) {
+    auto keyWidth = rangeKeyExpression(key)->type->width_bits();
+    auto maxValue = IR::getMaxBvVal(keyWidth);
+
+    // Every entry matches a contiguous range of values. An entry becomes active at the low bound
+    // of its range and inactive after the high bound.
+    struct Bound {
+        big_int point;
+        size_t precedence;
+        bool isStart;
+    };
+    std::vector<Bound> bounds;
+    bounds.reserve(2 * orderedEntries.size());
+    for (size_t precedence = 0; precedence < orderedEntries.size(); ++precedence) {
+        ASSIGN_OR_RETURN(auto fieldMatch,
+                         computeFieldMatch(key, orderedEntries[precedence].get().matches()),
+                         std::nullopt);
+        big_int low = fieldMatch.low;
+        big_int high = fieldMatch.high;
+        if (!fieldMatch.isInterval) {
+            // Exact and LPM masks are prefixes, so the matched values are contiguous.
+            low = fieldMatch.value;
+            high = low | (maxValue ^ fieldMatch.mask);
+        } else if (low > high) {
+            continue;
+        }
+        bounds.push_back({low, precedence, true});
+        bounds.push_back({high + 1, precedence, false});
+    }
+    std::sort(bounds.begin(), bounds.end(),
+              [](const Bound &left, const Bound &right) { return left.point < right.point; });
+
+    // Sweep over the bounds. Between two consecutive bounds, the active entry with the highest
+    // precedence wins the lookup.
+    std::vector<KeyRange> keyRanges;
+    std::set<size_t> activeEntries;
+    for (size_t idx = 0; idx < bounds.size();) {
+        const auto &point = bounds[idx].point;
+        for (; idx < bounds.size() && bounds[idx].point == point; ++idx) {
+            if (bounds[idx].isStart) {
+                activeEntries.insert(bounds[idx].precedence);
+            } else {
+                activeEntries.erase(bounds[idx].precedence);
+            }
+        }
+        if (activeEntries.empty() || idx == bounds.size()) {
+            continue;
+        }
+        const auto *winner = &orderedEntries[*activeEntries.rbegin()].get();
+        big_int high = bounds[idx].point - 1;
+        if (!keyRanges.empty() && keyRanges.back().entry == winner &&
+            keyRanges.back().high + 1 == point) {
+            keyRanges.back().high = high;
+        } else {
+            keyRanges.push_back({point, high, winner});
+        }
+    }
+    return keyRanges;
+}
+
+std::optional<TableConfiguration::TableSummary> TableConfiguration::summarizeEntries(
+    const std::vector<std::reference_wrapper<TableMatchEntry>> &orderedEntries) const {
+    TableSummary summary;
+    // Maps a variable and a value to the position of its group in the summary.
+    absl::flat_hash_map<std::string, size_t> groupPositions;
+    auto forEachGroup = [&summary, &groupPositions](const TableMatchEntry &entry,
+                                                    const auto &function) {
+        for (const auto &[variable, value] : entry.actionAssignment()) {
+            auto groupKey = std::string(variable.get().label.string_view());
+            groupKey.push_back('\0');
+            groupKey += packValue(value.get());
+            auto &groups = summary[variable];
+            auto [it, inserted] = groupPositions.try_emplace(groupKey, groups.size());
+            if (inserted) {
+                groups.push_back(AssignmentGroup{&value.get(), {}, {}});
+            }
+            function(groups[it->second]);
+        }
+    };
+
+    if (const auto *key = rangeSummaryKey()) {
+        ASSIGN_OR_RETURN(auto keyRanges, computeKeyRanges(*key, orderedEntries), std::nullopt);
+        for (const auto &keyRange : keyRanges) {
+            forEachGroup(*keyRange.entry, [&keyRange](AssignmentGroup &group) {
+                // Ranges are visited in ascending order, so adjacent ranges of a group are joined.
+                if (!group.keyRanges.empty() && group.keyRanges.back().second + 1 == keyRange.low) {
+                    group.keyRanges.back().second = keyRange.high;
+                } else {
+                    group.keyRanges.emplace_back(keyRange.low, keyRange.high);
+                }
+            });
+        }
+        return summary;
+    }
+
+    // Otherwise, all keys are exact matches. Entries which match different values are disjoint.
+    // Among entries which match the same values, the one with the highest precedence wins.
+    absl::flat_hash_map<std::string_view, const TableMatchEntry *> winners;
+    for (const auto &entry : orderedEntries) {
+        for (const auto *key : _tableKeys) {
+            const auto &matches = entry.get().matches();
+            if (matches.find(*key->checkedTo<ExactTableMatchKey>()->variable()) == matches.end()) {
+                return std::nullopt;
+            }
+        }
+        winners[entry.get().matchValuesKey()] = &entry.get();
+    }
+    for (const auto &entry : orderedEntries) {
+        const auto *tableMatchEntry = &entry.get();
+        if (winners.at(tableMatchEntry->matchValuesKey()) == tableMatchEntry) {
+            forEachGroup(*tableMatchEntry, [tableMatchEntry](AssignmentGroup &group) {
+                group.entries.push_back(tableMatchEntry);
+            });
+        }
+    }
+    return summary;
+}
+
+const IR::Expression *TableConfiguration::computeGroupCondition(
+    const AssignmentGroup &group, const TableMatchKey *rangeKey) const {
+    std::vector<const IR::Expression *> conditions;
+    if (rangeKey != nullptr) {
+        const auto *keyExpression = rangeKeyExpression(*rangeKey);
+        const auto *keyType = keyExpression->type->checkedTo<IR::Type_Bits>();
+        for (const auto &[low, high] : group.keyRanges) {
+            const auto *lowConstant = IR::Constant::get(keyType, low);
+            if (low == high) {
+                conditions.push_back(new IR::Equ(keyExpression, lowConstant));
+                continue;
+            }
+            conditions.push_back(
+                new IR::LAnd(new IR::Leq(lowConstant, keyExpression),
+                             new IR::Leq(keyExpression, IR::Constant::get(keyType, high))));
+        }
+    }
+    for (const auto *entry : group.entries) {
+        conditions.push_back(_tableKeyMatch->apply(SubstituteSymbolicVariable(entry->matches())));
+    }
+    return buildDisjunction(conditions, 0, conditions.size());
+}
+
+std::optional<z3::expr> TableConfiguration::computeZ3GroupCondition(
+    const AssignmentGroup &group, const TableMatchKey *rangeKey) {
+    z3::expr_vector conditions(Z3Cache::context());
+    if (rangeKey != nullptr) {
+        const auto *keyExpression = rangeKeyExpression(*rangeKey);
+        const auto *keyType = keyExpression->type->checkedTo<IR::Type_Bits>();
+        auto z3Key = Z3Cache::set(keyExpression);
+        for (const auto &[low, high] : group.keyRanges) {
+            auto z3Low = Z3Cache::set(IR::Constant::get(keyType, low));
+            if (low == high) {
+                conditions.push_back(z3Key == z3Low);
+                continue;
+            }
+            auto z3High = Z3Cache::set(IR::Constant::get(keyType, high));
+            conditions.push_back(z3::uge(z3Key, z3Low) && z3::ule(z3Key, z3High));
+        }
+    }
+    for (const auto *entry : group.entries) {
+        ASSIGN_OR_RETURN(auto condition, entry->_z3Condition(), std::nullopt);
+        conditions.push_back(condition);
+    }
+    return z3::mk_or(conditions);
+}
+
+std::vector<std::reference_wrapper<TableMatchEntry>> TableConfiguration::activeEntries() const {
+    auto entries = _constantKeys.empty() ? _tableEntries.orderedEntries()
+                                         : entriesMatchingConstantKeys();
+    const auto &shadowedEntries = this->shadowedEntries();
+    if (!shadowedEntries.empty()) {
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                     [&shadowedEntries](const auto &tableEntry) {
+                                         return shadowedEntries.contains(
+                                             tableEntry.get().matchKey());
+                                     }),
+                      entries.end());
+    }
+    return entries;
+}
+
+std::vector<std::reference_wrapper<TableMatchEntry>>
+TableConfiguration::entriesMatchingConstantKeys() const {
+    // Exact keys come first, so prefer their index over the key index.
+    auto lookupKey = std::find_if(
+        _constantKeys.begin(), _constantKeys.end(), [this](const auto &constantKey) {
+            return constantKey.first->template is<ExactTableMatchKey>() ||
+                   constantKey.first == _tableEntries.indexedKey();
+        });
+    std::vector<std::reference_wrapper<TableMatchEntry>> entries;
+    if (lookupKey == _constantKeys.end()) {
+        entries = _tableEntries.orderedEntries();
+    } else if (lookupKey->first->is<ExactTableMatchKey>()) {
+        entries = _tableEntries.orderedEntriesMatching(lookupKey->second->value);
+    } else {
+        entries = _tableEntries.orderedEntriesMatchingKey(lookupKey->second->value);
+    }
+    auto matchesConstantKeys = [this, &lookupKey](const TableMatchEntry &tableEntry) {
+        for (auto it = _constantKeys.begin(); it != _constantKeys.end(); ++it) {
+            if (it == lookupKey) {
+                continue;
+            }
+            auto fieldMatch = computeFieldMatch(*it->first, tableEntry.matches());
+            // Keep entries whose match we can not decide.
+            if (fieldMatch.has_value() && !fieldMatch.value().contains(it->second->value)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [&matchesConstantKeys](const auto &tableEntry) {
+                                     return !matchesConstantKeys(tableEntry.get());
+                                 }),
+                  entries.end());
+    return entries;
+}
+
+size_t TableConfiguration::activeEntryCount() const {
+    return _constantKeys.empty() ? _tableEntries.size() - shadowedEntries().size()
+                                 : activeEntries().size();
+}
+
+const absl::flat_hash_set<std::string> &TableConfiguration::shadowedEntries() const {
+    if (!_shadowedEntries.has_value()) {
+        _shadowedEntries = computeShadowedEntries();
+        _shadowedEntriesChanged |= _shadowedEntries.value() != _previousShadowedEntries;
+    }
+    return _shadowedEntries.value();
+}
+
+absl::flat_hash_set<std::string> TableConfiguration::computeShadowedEntries() const {
+    absl::flat_hash_set<std::string> shadowedEntries;
+    if (!_canShadowEntries || _tableEntries.size() < 2) {
+        return shadowedEntries;
+    }
+    std::vector<int> fieldWidths;
+    for (const auto *key : _tableKeys) {
+        fieldWidths.push_back(fieldMatchKeyType(*key)->width_bits());
+    }
+    ShadowDetector shadowDetector(fieldWidths);
+    std::vector<const TableMatchEntry *> detectedEntries;
+    std::vector<FieldMatch> fieldMatches;
+    auto orderedEntries = _tableEntries.orderedEntries();
+    // The detector expects the entries in descending order of precedence. Entries of an LPM table
+    // with the same priority are ordered by prefix length, so a shorter prefix never shadows a
+    // longer one.
+    for (auto it = orderedEntries.rbegin(); it != orderedEntries.rend(); ++it) {
+        fieldMatches.clear();
+        for (const auto *key : _tableKeys) {
+            auto fieldMatch = computeFieldMatch(*key, it->get().matches());
+            if (!fieldMatch.has_value()) {
+                break;
+            }
+            fieldMatches.push_back(fieldMatch.value());
+        }
+        // An entry whose match is not constant neither shadows nor is shadowed.
+        if (fieldMatches.size() != _tableKeys.size()) {
+            continue;
+        }
+        shadowDetector.append(fieldMatches);
+        detectedEntries.push_back(&it->get());
+    }
+    auto isShadowed = shadowDetector.findShadowedEntries();
+    for (size_t idx = 0; idx < detectedEntries.size(); ++idx) {
+        if (isShadowed[idx]) {
+            shadowedEntries.insert(detectedEntries[idx]->matchKey());
+        }
+    }
+    return shadowedEntries;
+}
+
+void TableConfiguration::invalidateShadowedEntries() {
+    if (_shadowedEntries.has_value()) {
+        _previousShadowedEntries = std::move(_shadowedEntries.value());
+        _shadowedEntries.reset();
+    }
+}
+
+TableEncoding TableConfiguration::encodingFor(size_t entryCount) const {
+    if (entryCount <= _entryBudget) {
+        return TableEncoding::kPerEntry;
+    }
+    if (_canSummarizeEntries && entryCount <= _summaryBudget) {
+        return TableEncoding::kSummarized;
+    }
+    return TableEncoding::kActionSet;
+}
+
+ControlPlaneAssignmentSet TableConfiguration::computeActionSetAssignments(
+    const std::vector<std::reference_wrapper<TableMatchEntry>> &entries) const {
+    auto assignments = _defaultTableAction.computeControlPlaneAssignments();
+    assignments.emplace(*ControlPlaneState::getTableActive(_tableName),
+                        *IR::BoolLiteral::get(_tableEntries.size() > 0));
+    auto choiceLabel = ControlPlaneState::actionChoiceLabel(_tableName);
+
+    // Collect the distinct values of every action argument, including the value of the default
+    // action. We only need to know whether there is more than one.
+    ordered_map<std::reference_wrapper<const IR::SymbolicVariable>,
+                std::vector<const IR::Expression *>, IR::IsSemanticallyLessComparator>
+        argumentValues;
+    auto addArgumentValue = [&argumentValues](const IR::SymbolicVariable &variable,
+                                              const IR::Expression &value) {
+        auto &values = argumentValues[variable];
+        if (values.size() < 2 &&
+            std::none_of(values.begin(), values.end(),
+                         [&value](const IR::Expression *other) { return other->equiv(value); })) {
+            values.push_back(&value);
+        }
+    };
+    for (const auto &[variable, value] : assignments) {
+        if (variable.get().label != choiceLabel) {
+            addArgumentValue(variable, value);
+        }
+    }
+    // The action choices of the entries, keyed by ordinal.
+    std::map<big_int, const IR::Constant *> actionChoices;
+    for (const auto &tableEntry : entries) {
+        for (const auto &[variable, value] : tableEntry.get().actionAssignment()) {
+            if (variable.get().label != choiceLabel) {
+                addArgumentValue(variable, value);
+            }
+        }
+        if (const auto *actionChoice = tableEntry.get().actionChoice(_tableName)) {
+            actionChoices.emplace(actionChoice->value, actionChoice);
+        }
+    }
+    for (const auto &[variable, values] : argumentValues) {
+        const auto &symbol = variable.get();
+        const IR::Expression *value = values.front();
+        if (values.size() > 1) {
+            value = ToolsVariables::getSymbolicVariable(symbol.type, symbol.label + "*");
+        }
+        auto it = assignments.find(variable);
+        if (it == assignments.end()) {
+            assignments.emplace(variable, *value);
+        } else {
+            it->second = *value;
+        }
+    }
+    if (actionChoices.empty()) {
+        return assignments;
+    }
+
+    // The action choice is a wildcard, restricted to the actions of the entries and the action of
+    // the default, if it is set.
+    const auto *choiceType = actionChoices.begin()->second->type->checkedTo<IR::Type_Bits>();
+    const auto *actionChoice = ControlPlaneState::getActionChoiceVariable(_tableName, choiceType);
+    const auto *choiceWildcard =
+        ToolsVariables::getSymbolicVariable(choiceType, actionChoice->label + "*");
+    SelectionCases cases;
+    auto &choiceCases = cases[*actionChoice];
+    for (const auto &[ordinal, actionLiteral] : actionChoices) {
+        choiceCases.emplace_back(new IR::Equ(choiceWildcard, actionLiteral), actionLiteral);
+    }
+    mergeSelections(assignments, cases);
+    return assignments;
+}
 
 bool TableConfiguration::operator<(const ControlPlaneItem &other) const {
     return typeid(*this) == typeid(other) ? _tableName < other.as<TableConfiguration>()._tableName
@@ -333,32 +1374,235 @@ bool TableConfiguration::operator<(const ControlPlaneItem &other) const {
 }
 
 void TableConfiguration::setTableKeyMatch(const KeyMap &tableKeyMap) {
+    auto encodingBefore = encoding();
+    _tableKeys = tableKeyMap;
+    _constantKeys.clear();
+    _tableEntries.indexField(nullptr);
+    // Index the first key which an exact lookup can not serve.
+    auto indexedKey = std::find_if(
+        tableKeyMap.begin(), tableKeyMap.end(), [](const TableMatchKey *key) {
+            return !key->is<ExactTableMatchKey>() && fieldMatchKeyType(*key) != nullptr;
+        });
+    _tableEntries.indexKey(indexedKey == tableKeyMap.end() ? nullptr : *indexedKey);
+    // Entries of the same priority are ordered by the longest prefix of the LPM key.
+    auto prefixKey = std::find_if(
+        tableKeyMap.begin(), tableKeyMap.end(), [](const TableMatchKey *key) {
+            return key->is<LpmTableMatchKey>() && fieldMatchKeyType(*key) != nullptr;
+        });
+    _tableEntries.orderByPrefix(prefixKey == tableKeyMap.end() ? nullptr : *prefixKey);
+    _canShadowEntries =
+        std::all_of(tableKeyMap.begin(), tableKeyMap.end(),
+                    [](const TableMatchKey *key) {
+                        return fieldMatchKeyType(*key) != nullptr &&
+                               !key->is<RangeTableMatchKey>();
+                    }) &&
+        std::any_of(tableKeyMap.begin(), tableKeyMap.end(), [](const TableMatchKey *key) {
+            return key->is<LpmTableMatchKey>() || key->is<TernaryTableMatchKey>();
+        });
+    invalidateShadowedEntries();
+    _canSummarizeEntries =
+        rangeSummaryKey() != nullptr ||
+        (!tableKeyMap.empty() &&
+         std::all_of(tableKeyMap.begin(), tableKeyMap.end(),
+                     [](const TableMatchKey *key) { return key->is<ExactTableMatchKey>(); }));
+    _summaryChanged |= encodingBefore != encoding();
+    _hasDisjointKeys = !tableKeyMap.empty();
+    _keyWidth = 0;
+    _keySymbols.clear();
+    for (const auto *key : tableKeyMap) {
+        const auto *exactKey = key->to<ExactTableMatchKey>();
+        if (exactKey == nullptr || exactKey->keyExpression()->is<IR::Literal>() ||
+            !exactKey->keyExpression()->type->is<IR::Type_Bits>()) {
+            _hasDisjointKeys = false;
+            continue;
+        }
+        _keyWidth += exactKey->keyExpression()->type->width_bits();
+        SymbolCollector symbolCollector;
+        exactKey->keyExpression()->apply(symbolCollector);
+        const auto &keySymbols = symbolCollector.collectedSymbols();
+        // Only a key which is a symbol of its own takes every value of its type. Casts, masks,
+        // slices or a symbol matched by several keys restrict the values the keys can take, so
+        // fewer entries than the key width suggests may cover all of them.
+        const auto *keySymbol = exactKey->keyExpression()->to<IR::SymbolicVariable>();
+        _hasDisjointKeys &=
+            keySymbol != nullptr && _keySymbols.find(*keySymbol) == _keySymbols.end();
+        _keySymbols.insert(keySymbols.begin(), keySymbols.end());
+    }
     _tableKeyMatch = SimplifyExpression::simplify(buildKeyMatches(tableKeyMap));
     // When we set the table key match, we also need to recompute the match of all table entries.
     auto z3TableKeyMatch = Z3Cache::set(_tableKeyMatch);
-    for (const auto &tableMatchEntry : _tableEntries) {
-        tableMatchEntry.get().setZ3Condition(z3TableKeyMatch);
-    }
+    _tableEntries.forEach([&z3TableKeyMatch](TableMatchEntry &tableMatchEntry) {
+        tableMatchEntry.setZ3Condition(z3TableKeyMatch);
+    });
 }
 
 int TableConfiguration::addTableEntry(TableMatchEntry &tableMatchEntry, bool replace) {
+    auto sizeBefore = _tableEntries.size();
+    invalidateShadowedEntries();
+    bool summaryChanged = false;
     if (replace) {
-        _tableEntries.erase(tableMatchEntry);
+        const auto *existingEntry = _tableEntries.find(tableMatchEntry);
+        if (existingEntry != nullptr) {
+            summaryChanged |= releaseAction(*existingEntry);
+            _tableEntries.erase(tableMatchEntry);
+        }
     }
     tableMatchEntry.setZ3Condition(Z3Cache::set(_tableKeyMatch));
-    return _tableEntries.emplace(tableMatchEntry).second ? EXIT_SUCCESS : EXIT_FAILURE;
+    auto inserted = _tableEntries.insert(tableMatchEntry);
+    if (inserted) {
+        // Replacing an entry with one executing the same action leaves the summary untouched.
+        summaryChanged = retainAction(tableMatchEntry) || summaryChanged;
+    }
+    _summaryChanged |= summaryChanged || sizeChangesSummary(sizeBefore);
+    return inserted ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 size_t TableConfiguration::deleteTableEntry(TableMatchEntry &tableMatchEntry) {
-    return _tableEntries.erase(tableMatchEntry);
+    const auto *existingEntry = _tableEntries.find(tableMatchEntry);
+    if (existingEntry == nullptr) {
+        return 0;
+    }
+    auto sizeBefore = _tableEntries.size();
+    invalidateShadowedEntries();
+    bool summaryChanged = releaseAction(*existingEntry);
+    _tableEntries.erase(tableMatchEntry);
+    _summaryChanged |= summaryChanged || sizeChangesSummary(sizeBefore);
+    return 1;
 }
 
-void TableConfiguration::clearTableEntries() { _tableEntries.clear(); }
+void TableConfiguration::clearTableEntries() {
+    _summaryChanged |= !_tableEntries.empty();
+    _tableEntries.clear();
+    _actionReferenceCounts.clear();
+    invalidateShadowedEntries();
+}
 
 void TableConfiguration::setDefaultTableAction(TableDefaultAction defaultTableAction) {
+    _summaryChanged |=
+        _defaultTableAction < defaultTableAction || defaultTableAction < _defaultTableAction;
     _defaultTableAction = std::move(defaultTableAction);
 }
 
+bool TableConfiguration::consumeSummaryChange() {
+    // Entries which become shadowed or are no longer shadowed change the reachability of their
+    // actions, even if the installed actions stay the same.
+    static_cast<void>(shadowedEntries());
+    auto summaryChanged = _summaryChanged || _shadowedEntriesChanged;
+    _summaryChanged = false;
+    _shadowedEntriesChanged = false;
+    return summaryChanged;
+}
+
+bool TableConfiguration::isDeterminedByActionSummary() const {
+    // Removing an entry which matches the constant keys may change the reachability of its action,
+    // even if other entries of the action remain.
+    if (!_constantKeys.empty()) {
+        return false;
+    }
+    // The action-set encoding ignores the keys entirely.
+    if (!_tableEntries.empty() && encoding() == TableEncoding::kActionSet) {
+        return true;
+    }
+    if (!_hasDisjointKeys) {
+        return false;
+    }
+    // The entries must leave at least one key value unmatched, otherwise the last entry in the
+    // chain of conditions can never be selected.
+    if (_keyWidth >= 64) {
+        return true;
+    }
+    return _tableEntries.size() + 1 < (uint64_t{1} << static_cast<unsigned>(_keyWidth));
+}
+
+bool TableConfiguration::setConstantKeys(
+    const std::map<cstring, const IR::Constant *> &constantKeys) {
+    std::vector<std::pair<const TableMatchKey *, const IR::Constant *>> newConstantKeys;
+    for (const auto *key : _tableKeys) {
+        if (fieldMatchKeyType(*key) == nullptr) {
+            continue;
+        }
+        auto it = constantKeys.find(key->name());
+        if (it != constantKeys.end()) {
+            newConstantKeys.emplace_back(key, it->second);
+        }
+    }
+    std::stable_partition(newConstantKeys.begin(), newConstantKeys.end(),
+                          [](const auto &constantKey) {
+                              return constantKey.first->template is<ExactTableMatchKey>();
+                          });
+    auto isUnchanged = std::equal(
+        newConstantKeys.begin(), newConstantKeys.end(), _constantKeys.begin(), _constantKeys.end(),
+        [](const auto &left, const auto &right) {
+            return left.first == right.first && left.second->value == right.second->value;
+        });
+    if (isUnchanged) {
+        return false;
+    }
+    _constantKeys = std::move(newConstantKeys);
+    const auto *exactKey = _constantKeys.empty()
+                               ? nullptr
+                               : _constantKeys.front().first->to<ExactTableMatchKey>();
+    _tableEntries.indexField(exactKey == nullptr ? nullptr : exactKey->variable());
+    _summaryChanged = true;
+    return true;
+}
+
+const TableMatchEntry *TableConfiguration::findShadowingEntry(
+    const TableMatchEntry &tableMatchEntry) const {
+    std::vector<std::optional<FieldMatch>> fieldMatches;
+    fieldMatches.reserve(_tableKeys.size());
+    for (const auto *key : _tableKeys) {
+        fieldMatches.push_back(computeFieldMatch(*key, tableMatchEntry.matches()));
+        if (!fieldMatches.back().has_value()) {
+            return nullptr;
+        }
+    }
+    auto candidates = _tableEntries.indexedKey() != nullptr
+                          ? _tableEntries.orderedEntriesCoveringKey(tableMatchEntry)
+                          : _tableEntries.orderedEntries();
+    // Look at the candidates with the highest precedence first.
+    for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+        const auto &candidate = it->get();
+        if (!_tableEntries.precedes(tableMatchEntry, candidate)) {
+            break;
+        }
+        bool coversEntry = true;
+        for (size_t idx = 0; idx < _tableKeys.size() && coversEntry; ++idx) {
+            auto candidateMatch = computeFieldMatch(*_tableKeys[idx], candidate.matches());
+            coversEntry = candidateMatch.has_value() &&
+                          candidateMatch.value().covers(fieldMatches[idx].value());
+        }
+        if (coversEntry) {
+            return &candidate;
+        }
+    }
+    return nullptr;
+}
+
+size_t TableConfiguration::shadowedEntryCount() const { return shadowedEntries().size(); }
+
+const SymbolSet &TableConfiguration::keySymbols() const { return _keySymbols; }
+
+const TableEntrySet &TableConfiguration::tableEntries() const { return _tableEntries; }
+
+void TableConfiguration::setEntryBudget(size_t entryBudget) {
+    auto encodingBefore = encoding();
+    _entryBudget = entryBudget;
+    _summaryChanged |= encodingBefore != encoding();
+}
+
+size_t TableConfiguration::entryBudget() const { return _entryBudget; }
+
+void TableConfiguration::setSummaryBudget(size_t summaryBudget) {
+    auto encodingBefore = encoding();
+    _summaryBudget = summaryBudget;
+    _summaryChanged |= encodingBefore != encoding();
+}
+
+size_t TableConfiguration::summaryBudget() const { return _summaryBudget; }
+
+TableEncoding TableConfiguration::encoding() const { return encodingFor(activeEntryCount()); }
+
 ControlPlaneAssignmentSet TableConfiguration::computeControlPlaneAssignments() const {
     auto assignments = _defaultTableAction.computeControlPlaneAssignments();
     assignments.emplace(*ControlPlaneState::getTableActive(_tableName),
@@ -367,36 +1611,39 @@ ControlPlaneAssignmentSet TableConfiguration::computeControlPlaneAssignments() c
         return assignments;
     }
 
-    // If we have more than kMaxEntriesPerTable entries we give up.
-    // Set the entries symbolic and assume they can be executed freely.
-    if (_tableEntries.size() > kMaxEntriesPerTable) {
-        for (const auto &[symbol, assignment] : assignments) {
-            const auto *symbolicVar =
-                ToolsVariables::getSymbolicVariable(symbol.get().type, symbol.get().label + "*");
-            auto it = assignments.find(symbol);
-            if (it == assignments.end()) {
-                assignments.emplace(symbol, *symbolicVar);
-            } else {
-                it->second = *symbolicVar;
+    // Entries which do not match the constant keys can not be hit.
+    // If the entries exceed the budget, try to summarize them. If we can not summarize the
+    // entries, only keep track of the actions they execute.
+    auto entries = activeEntries();
+    auto encoding = encodingFor(entries.size());
+    auto summary =
+        encoding == TableEncoding::kSummarized ? summarizeEntries(entries) : std::nullopt;
+    if (encoding != TableEncoding::kPerEntry && !summary.has_value()) {
+        return computeActionSetAssignments(entries);
+    }
+    if (summary.has_value()) {
+        const auto *rangeKey = rangeSummaryKey();
+        SelectionCases cases;
+        for (const auto &[variable, groups] : summary.value()) {
+            auto &variableCases = cases[variable];
+            for (const auto &group : groups) {
+                variableCases.emplace_back(computeGroupCondition(group, rangeKey), group.value);
             }
         }
+        mergeSelections(assignments, cases);
         return assignments;
     }
 
-    for (const auto &tableEntry : _tableEntries) {
+    SelectionCases cases;
+    for (const auto &tableEntry : entries) {
         const auto &actionAssignments = tableEntry.get().actionAssignment();
-        const auto keyAssignments = tableEntry.get().computeControlPlaneAssignments();
-        const auto *constraint = _tableKeyMatch->apply(SubstituteSymbolicVariable(keyAssignments));
-
+        const auto *constraint =
+            _tableKeyMatch->apply(SubstituteSymbolicVariable(tableEntry.get().matches()));
         for (const auto &[variable, assignment] : actionAssignments) {
-            auto it = assignments.find(variable);
-            if (it != assignments.end()) {
-                it->second = *new IR::Mux(constraint, &assignment.get(), &it->second.get());
-            } else {
-                assignments.insert({variable, assignment});
-            }
+            cases[variable].emplace_back(constraint, &assignment.get());
         }
     }
+    mergeSelections(assignments, cases);
     return assignments;
 }
 
@@ -408,11 +1655,17 @@ Z3ControlPlaneAssignmentSet TableConfiguration::computeZ3ControlPlaneAssignments
         return assignments;
     }
 
-    // If we have more than kMaxEntriesPerTable entries we give up.
-    // Set the entries symbolic and assume they can be executed freely.
-    if (_tableEntries.size() > kMaxEntriesPerTable) {
-        assignments.setAllSymbolic();
-        return assignments;
+    // Entries which do not match the constant keys can not be hit.
+    // If the entries exceed the budget, try to summarize them. If we can not summarize the
+    // entries, only keep track of the actions they execute.
+    auto entries = activeEntries();
+    auto encoding = encodingFor(entries.size());
+    auto summary =
+        encoding == TableEncoding::kSummarized ? summarizeEntries(entries) : std::nullopt;
+    if (encoding != TableEncoding::kPerEntry && !summary.has_value()) {
+        Z3ControlPlaneAssignmentSet actionSetAssignments;
+        actionSetAssignments.merge(computeActionSetAssignments(entries));
+        return actionSetAssignments;
     }
 
     Util::ScopedTimer timer("computeZ3ControlPlaneAssignments");
@@ -421,18 +1674,47 @@ Z3ControlPlaneAssignmentSet TableConfiguration::computeZ3ControlPlaneAssignments
         error("Failed to get Z3 table key match");
         return assignments;
     }
-    for (const auto &tableEntry : _tableEntries) {
-        auto constraint = tableEntry.get()._z3Condition();
-        if (!constraint.has_value()) {
-            return assignments;
+    Z3ControlPlaneAssignmentSet::SelectionCases cases;
+    if (summary.has_value()) {
+        const auto *rangeKey = rangeSummaryKey();
+        for (const auto &[variable, groups] : summary.value()) {
+            auto &variableCases = cases[variable];
+            for (const auto &group : groups) {
+                auto condition = computeZ3GroupCondition(group, rangeKey);
+                if (!condition.has_value()) {
+                    return assignments;
+                }
+                variableCases.emplace_back(condition.value(), Z3Cache::set(group.value));
+            }
+        }
+    } else {
+        for (const auto &tableEntry : entries) {
+            auto constraint = tableEntry.get()._z3Condition();
+            if (!constraint.has_value()) {
+                return assignments;
+            }
+            tableEntry.get().z3ActionAssignment().appendSelectionCases(constraint.value(), cases);
         }
-        assignments.mergeConditionally(
-            tableEntry.get().computeZ3ControlPlaneAssignments().substitute(constraint.value()),
-            tableEntry.get().z3ActionAssignment());
     }
+    assignments.mergeSelections(cases);
     return assignments;
 }
 
+uint64_t TableConfiguration::estimateMemoryUsage() const {
+    // The default action is stored inline and already part of sizeof(*this).
+    auto bytes = sizeof(*this) + _defaultTableAction.estimateMemoryUsage() -
+                 sizeof(_defaultTableAction) +
+                 _tableEntries.estimateMemoryUsage() +
+                 MemoryUsage::estimateContainerMemory(_previousShadowedEntries);
+    if (_shadowedEntries.has_value()) {
+        bytes += MemoryUsage::estimateContainerMemory(_shadowedEntries.value());
+    }
+    _tableEntries.forEach([&bytes](const TableMatchEntry &tableEntry) {
+        bytes += tableEntry.estimateMemoryUsage();
+    });
+    return bytes;
+}
+
 /**************************************************************************************************
 ParserValueSet
 **************************************************************************************************/
@@ -3,13 +3,23 @@
 
 #include <cstdint>
 #include <functional>
+#include <map>
 #include <optional>
 #include <set>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_item.h"
+#include "backends/p4tools/modules/flay/core/control_plane/symbols.h"
+#include "backends/p4tools/modules/flay/core/control_plane/table_key_index.h"
 #include "ir/ir.h"
 #include "ir/irutils.h"
+#include "lib/big_int.h"
 
 namespace P4::P4Tools::ControlPlaneState {
 
@@ -17,19 +27,27 @@ namespace P4::P4Tools::ControlPlaneState {
 /// been configured by the control plane.
 const IR::SymbolicVariable *getParserValueSetConfigured(cstring parserValueSetName);
 
-/// @returns the symbolic string variable that represents the default action that is active for a
-/// particular table.
-const IR::SymbolicVariable *getDefaultActionVariable(cstring tableName);
+/// @returns the symbolic variable that represents the action chosen by an entry of a particular
+/// table. Actions are encoded as ordinals of type @p type, see ActionEnumeration.
+const IR::SymbolicVariable *getActionChoiceVariable(cstring tableName, const IR::Type_Bits *type);
+
+/// @returns the symbolic variable that represents the default action that is active for a
+/// particular table. Actions are encoded as ordinals of type @p type, see ActionEnumeration.
+const IR::SymbolicVariable *getDefaultActionVariable(cstring tableName, const IR::Type_Bits *type);
 
 }  // namespace P4::P4Tools::ControlPlaneState
 
 namespace P4::P4Tools::Flay {
 
-/// How many entries per table we can support before we fall back to making the entire table
-/// configuration symbolic.
-/// TODO: Consider making this an option?
+/// The default number of entries up to which each entry of a table is encoded individually.
+/// Larger tables are summarized or, if their keys do not permit it, reduced to their set of
+/// installed actions. Can be overridden per table with --table-entry-budget.
 constexpr size_t kMaxEntriesPerTable = 50;
 
+/// The default number of entries up to which the entries of a table are summarized. Larger tables
+/// are reduced to their set of installed actions.
+constexpr size_t kMaxSummarizedEntriesPerTable = 10000;
+
 /**************************************************************************************************
 TableMatchKeys
 **************************************************************************************************/
@@ -264,7 +282,16 @@ class TableMatchEntry : public Z3ControlPlaneItem {
     /// The condition of this entry. Can only be set by the parent table configuration.
     std::optional<z3::expr> _condition;
 
+    /// The canonical encoding of the match and priority of this entry. Two entries are the same
+    /// table entry if and only if their match keys are equal.
+    std::string _matchKey;
+
  public:
+    /// Pack the values of @p matches and @p priority into a canonical byte string. The priority
+    /// comes first. Assignments are ordered by the label of their symbol, so the key does not
+    /// depend on the order in which the match fields were added.
+    static std::string computeMatchKey(const ControlPlaneAssignmentSet &matches, int32_t priority);
+
     explicit TableMatchEntry(ControlPlaneAssignmentSet actionAssignment, int32_t priority,
                              ControlPlaneAssignmentSet matches);
 
@@ -277,6 +304,19 @@ class TableMatchEntry : public Z3ControlPlaneItem {
     /// @returns the priority of this entry.
     [[nodiscard]] int32_t priority() const;
 
+    /// @returns the canonical encoding of the match and priority of this entry.
+    [[nodiscard]] const std::string &matchKey() const;
+
+    /// @returns the canonical encoding of the match of this entry, without the priority.
+    [[nodiscard]] std::string_view matchValuesKey() const;
+
+    /// @returns the key values assigned by this entry.
+    [[nodiscard]] const ControlPlaneAssignmentSet &matches() const;
+
+    /// @returns the ordinal of the action executed by this entry of table @p tableName, or nullptr
+    /// if the action assignment does not select an action.
+    [[nodiscard]] const IR::Constant *actionChoice(cstring tableName) const;
+
     /// @returns the condition to execute this entry. Set by the parent table.
     std::optional<z3::expr> _z3Condition() const {
         if (_condition.has_value()) {
@@ -292,6 +332,7 @@ class TableMatchEntry : public Z3ControlPlaneItem {
 
     [[nodiscard]] ControlPlaneAssignmentSet computeControlPlaneAssignments() const override;
     [[nodiscard]] Z3ControlPlaneAssignmentSet computeZ3ControlPlaneAssignments() const override;
+    [[nodiscard]] uint64_t estimateMemoryUsage() const override;
 
     DECLARE_TYPEINFO(TableMatchEntry);
 };
@@ -314,6 +355,7 @@ class TableDefaultAction : public Z3ControlPlaneItem {
 
     [[nodiscard]] ControlPlaneAssignmentSet computeControlPlaneAssignments() const override;
     [[nodiscard]] Z3ControlPlaneAssignmentSet computeZ3ControlPlaneAssignments() const override;
+    [[nodiscard]] uint64_t estimateMemoryUsage() const override;
 
     DECLARE_TYPEINFO(TableDefaultAction);
 };
@@ -338,11 +380,184 @@ class WildCardMatchEntry : public TableMatchEntry {
 TableConfiguration
 **************************************************************************************************/
 
-/// The active set of table entries. Sorted by type.
-using TableEntrySet = std::set<std::reference_wrapper<TableMatchEntry>, std::less<TableMatchEntry>>;
+/// @returns the type of the values matched by @p key if its matches can be described as a
+/// FieldMatch. Only exact, LPM, ternary and range keys on unsigned bit vectors qualify. Otherwise,
+/// returns nullptr.
+const IR::Type_Bits *fieldMatchKeyType(const TableMatchKey &key);
+
+/// @returns the values of @p key matched by an entry with @p matches, or std::nullopt if the
+/// match can not be described as a FieldMatch. Fields which are omitted from @p matches match
+/// every value, except for exact keys.
+std::optional<FieldMatch> computeFieldMatch(const TableMatchKey &key,
+                                            const ControlPlaneAssignmentSet &matches);
+
+/// The active set of table entries. Entries are hashed by their canonical match key, which makes
+/// lookups for modifications and deletions independent of the number of entries. The order of the
+/// entries only matters when the table is encoded, see orderedEntries.
+class TableEntrySet {
+    /// An entry together with the position at which it was inserted and the length of its prefix
+    /// of the LPM key.
+    struct IndexedEntry {
+        std::reference_wrapper<TableMatchEntry> entry;
+        uint64_t insertionIndex;
+        int prefixLength;
+    };
+
+    /// The entries, keyed by their match key.
+    absl::flat_hash_map<std::string, IndexedEntry> _entries;
+
+    /// The insertion index of the next entry.
+    uint64_t _nextInsertionIndex = 0;
+
+    /// The key field whose values are indexed, or nullptr if no field is indexed.
+    const IR::SymbolicVariable *_indexedField = nullptr;
+
+    /// The match keys of the entries, keyed by the packed constant they assign to the indexed
+    /// field.
+    absl::flat_hash_map<std::string, absl::flat_hash_set<std::string>> _fieldIndex;
+
+    /// The match keys of the entries which do not assign a constant to the indexed field.
+    absl::flat_hash_set<std::string> _unindexedEntries;
+
+    /// Add @p tableMatchEntry to the index of _indexedField.
+    void addToFieldIndex(const TableMatchEntry &tableMatchEntry);
+
+    /// Remove @p tableMatchEntry from the index of _indexedField.
+    void removeFromFieldIndex(const TableMatchEntry &tableMatchEntry);
+
+    /// The LPM key which orders entries of the same priority, or nullptr if there is none.
+    const TableMatchKey *_prefixKey = nullptr;
+
+    /// @returns the number of bits of _prefixKey fixed by @p tableMatchEntry. Zero if there is no
+    /// prefix key or the match is not constant.
+    [[nodiscard]] int computePrefixLength(const TableMatchEntry &tableMatchEntry) const;
+
+    /// The LPM, range or ternary key whose matches are indexed, or nullptr if no key is indexed.
+    const TableMatchKey *_indexedKey = nullptr;
+
+    /// The index over the matches of _indexedKey. A trie for LPM keys, an interval tree for range
+    /// keys, and buckets of masks for ternary keys. Set if and only if a key is indexed.
+    std::optional<FieldMatchIndex> _keyIndex;
+
+    /// The match keys of the entries whose match of _indexedKey could not be indexed.
+    absl::flat_hash_set<std::string> _unindexedKeyEntries;
+
+    /// Add @p tableMatchEntry to the index of _indexedKey.
+    void addToKeyIndex(const TableMatchEntry &tableMatchEntry);
+
+    /// Remove @p tableMatchEntry from the index of _indexedKey.
+    void removeFromKeyIndex(const TableMatchEntry &tableMatchEntry);
+
+    /// @returns @p keyIndexEntries and the entries which are not in the key index, in ascending
+    /// order of precedence.
+    [[nodiscard]] std::vector<std::reference_wrapper<TableMatchEntry>> orderKeyIndexEntries(
+        const std::vector<const TableMatchEntry *> &keyIndexEntries) const;
+
+    /// @returns @p indexedEntries in ascending order of precedence.
+    static std::vector<std::reference_wrapper<TableMatchEntry>> sortByPrecedence(
+        std::vector<const IndexedEntry *> indexedEntries);
+
+ public:
+    /// Insert @p tableMatchEntry.
+    /// @returns false if an entry with the same match key already exists.
+    bool insert(TableMatchEntry &tableMatchEntry);
+
+    /// @returns the entry with the same match key as @p tableMatchEntry, or nullptr if there is
+    /// no such entry.
+    [[nodiscard]] TableMatchEntry *find(const TableMatchEntry &tableMatchEntry) const;
+
+    /// Remove the entry with the same match key as @p tableMatchEntry.
+    /// @returns the number of removed entries.
+    size_t erase(const TableMatchEntry &tableMatchEntry);
+
+    /// Remove all entries.
+    void clear();
+
+    /// @returns the number of entries.
+    [[nodiscard]] size_t size() const;
+
+    /// @returns true if there are no entries.
+    [[nodiscard]] bool empty() const;
+
+    /// Invoke @p function on every entry, in no particular order.
+    template <typename Function>
+    void forEach(Function &&function) const {
+        for (const auto &[matchKey, indexedEntry] : _entries) {
+            function(indexedEntry.entry.get());
+        }
+    }
+
+    /// @returns the entries in ascending order of precedence: by priority, then by the length of
+    /// their prefix of the LPM key, and by insertion for the remaining ties. When entries overlap,
+    /// the last matching entry wins.
+    [[nodiscard]] std::vector<std::reference_wrapper<TableMatchEntry>> orderedEntries() const;
+
+    /// Index the entries by the constant they assign to @p field, which must be a key of an exact
+    /// match. Passing nullptr drops the index.
+    void indexField(const IR::SymbolicVariable *field);
+
+    /// @returns the indexed field, or nullptr if no field is indexed.
+    [[nodiscard]] const IR::SymbolicVariable *indexedField() const;
+
+    /// @returns the entries which assign @p value to the indexed field, and the entries which do
+    /// not assign a constant to it, in ascending order of precedence. Requires an indexed field.
+    [[nodiscard]] std::vector<std::reference_wrapper<TableMatchEntry>> orderedEntriesMatching(
+        const big_int &value) const;
+
+    /// Order entries of the same priority by the length of their prefix of @p key, which must be
+    /// an LPM key accepted by fieldMatchKeyType. The longest prefix takes precedence. Passing
+    /// nullptr orders them by insertion only.
+    void orderByPrefix(const TableMatchKey *key);
+
+    /// Index the entries by the values they match on @p key, which must be an LPM, range or
+    /// ternary key accepted by fieldMatchKeyType. Passing nullptr drops the index.
+    void indexKey(const TableMatchKey *key);
+
+    /// @returns the indexed key, or nullptr if no key is indexed.
+    [[nodiscard]] const TableMatchKey *indexedKey() const;
+
+    /// @returns the entries whose match of the indexed key contains @p value, and the entries
+    /// whose match could not be indexed, in ascending order of precedence. Requires an indexed
+    /// key.
+    [[nodiscard]] std::vector<std::reference_wrapper<TableMatchEntry>> orderedEntriesMatchingKey(
+        const big_int &value) const;
+
+    /// @returns the entries whose match of the indexed key contains every value matched by
+    /// @p tableMatchEntry, and the entries whose match could not be indexed, in ascending order of
+    /// precedence. Requires an indexed key.
+    [[nodiscard]] std::vector<std::reference_wrapper<TableMatchEntry>> orderedEntriesCoveringKey(
+        const TableMatchEntry &tableMatchEntry) const;
+
+    /// @returns true if @p right takes precedence over @p left when both match. Both entries
+    /// must be part of the set.
+    [[nodiscard]] bool precedes(const TableMatchEntry &left, const TableMatchEntry &right) const;
+
+    /// @returns an estimate of the memory held by the set, excluding the entries themselves.
+    [[nodiscard]] uint64_t estimateMemoryUsage() const;
+};
 
 using KeyMap = std::vector<const TableMatchKey *>;
 
+/// How the entries of a table are encoded into control-plane assignments.
+enum class TableEncoding {
+    /// Every entry contributes its own condition.
+    kPerEntry,
+    /// Entries are grouped by the values they assign and the keys of each group are summarized.
+    /// A table with a single key is split into ranges, so its encoding grows with the number of
+    /// ranges a lookup can tell apart. A table with several exact keys still contributes the
+    /// condition of every winning entry.
+    kSummarized,
+    /// Only the installed actions and the action arguments which are the same for every entry are
+    /// tracked. The keys of the table are unconstrained.
+    kActionSet,
+};
+
+/// @returns the name of @p encoding, as used in statistics.
+std::string_view tableEncodingName(TableEncoding encoding);
+
+/// The number of tables using each encoding, keyed by the name of the encoding.
+using TableEncodingCounts = std::map<std::string_view, size_t>;
+
 /// Concrete configuration of a control plane table. May contain arbitrary many table match
 /// entries.
 class TableConfiguration : public Z3ControlPlaneItem {
@@ -358,6 +573,147 @@ class TableConfiguration : public Z3ControlPlaneItem {
     /// The match key expression for the table . This is derived from the data-plane analysis.
     const IR::Expression *_tableKeyMatch = IR::BoolLiteral::get(false);
 
+    /// The number of entries executing each action, keyed by the ordinal of the action.
+    std::map<big_int, size_t> _actionReferenceCounts;
+
+    /// Whether the action summary of the table changed since the last call to
+    /// consumeSummaryChange. The summary consists of the set of installed actions, the default
+    /// action, whether the table is active, and how the entries of the table are encoded.
+    bool _summaryChanged = true;
+
+    /// Whether all keys are exact matches on distinct, bare symbolic variables. Entries of such a
+    /// table are disjoint and can not match every packet as long as they do not enumerate the key
+    /// space.
+    bool _hasDisjointKeys = false;
+
+    /// The total width of the keys of the table. Only meaningful if _hasDisjointKeys is set.
+    int _keyWidth = 0;
+
+    /// The symbols of the data-plane expressions the table matches on.
+    SymbolSet _keySymbols;
+
+    /// The number of entries up to which every entry is encoded individually.
+    size_t _entryBudget = kMaxEntriesPerTable;
+
+    /// The number of entries up to which the entries are summarized.
+    size_t _summaryBudget = kMaxSummarizedEntriesPerTable;
+
+    /// Keys which are known to be constant under the current configuration, together with their
+    /// value. Only entries which match these values can be hit. Exact keys come first.
+    std::vector<std::pair<const TableMatchKey *, const IR::Constant *>> _constantKeys;
+
+    /// The keys of the table. Set with the table key match.
+    KeyMap _tableKeys;
+
+    /// Whether the keys of the table permit summarizing its entries.
+    bool _canSummarizeEntries = false;
+
+    /// Whether entries of the table can shadow each other. Holds if some key is an LPM or ternary
+    /// key and the matches of all keys are described by a value and a mask.
+    bool _canShadowEntries = false;
+
+    /// The match keys of the entries which are shadowed by an entry of higher precedence.
+    /// Computed on demand and reset whenever the entries or keys of the table change.
+    mutable std::optional<absl::flat_hash_set<std::string>> _shadowedEntries;
+
+    /// The shadowed entries when they were last computed.
+    mutable absl::flat_hash_set<std::string> _previousShadowedEntries;
+
+    /// Whether the shadowed entries changed since the last call to consumeSummaryChange.
+    mutable bool _shadowedEntriesChanged = false;
+
+    /// A contiguous range of values of the key of a single-key table, which is matched by the same
+    /// entry.
+    struct KeyRange {
+        big_int low;
+        big_int high;
+        const TableMatchEntry *entry;
+    };
+
+    /// A value assigned to a variable by a summarized table, together with the key ranges or
+    /// entries which select it. Single-key tables use the ranges, multi-key tables the entries.
+    struct AssignmentGroup {
+        const IR::Expression *value;
+        std::vector<std::pair<big_int, big_int>> keyRanges;
+        std::vector<const TableMatchEntry *> entries;
+    };
+
+    /// The assignment groups of a summarized table, keyed by the assigned variable.
+    using TableSummary =
+        ordered_map<std::reference_wrapper<const IR::SymbolicVariable>,
+                    std::vector<AssignmentGroup>, IR::IsSemanticallyLessComparator>;
+
+    /// @returns the entries which can be hit given the constant keys and which are not shadowed,
+    /// in ascending order of precedence.
+    [[nodiscard]] std::vector<std::reference_wrapper<TableMatchEntry>> activeEntries() const;
+
+    /// @returns the entries which match the constant keys, in ascending order of precedence.
+    /// Entries are looked up in the index of the first constant exact key, or in the key index of
+    /// the entries, and filtered by the other constant keys.
+    [[nodiscard]] std::vector<std::reference_wrapper<TableMatchEntry>>
+    entriesMatchingConstantKeys() const;
+
+    /// @returns the number of entries which can be hit given the constant keys.
+    [[nodiscard]] size_t activeEntryCount() const;
+
+    /// @returns the match keys of the shadowed entries. Computes them if the entries changed.
+    [[nodiscard]] const absl::flat_hash_set<std::string> &shadowedEntries() const;
+
+    /// @returns the match keys of the entries which are shadowed by an entry of higher precedence.
+    /// Entries whose matches are not constant are never considered shadowed.
+    [[nodiscard]] absl::flat_hash_set<std::string> computeShadowedEntries() const;
+
+    /// Forget the shadowed entries, so they are recomputed on the next access.
+    void invalidateShadowedEntries();
+
+    /// @returns the key of the table if it is the only key and its entries can be summarized as
+    /// ranges of values. Otherwise, returns nullptr.
+    [[nodiscard]] const TableMatchKey *rangeSummaryKey() const;
+
+    /// Split the values of @p key into ranges, each matched by the entry of @p orderedEntries which
+    /// wins the lookup.
+    /// @returns std::nullopt if an entry does not assign constant values to the key.
+    [[nodiscard]] static std::optional<std::vector<KeyRange>> computeKeyRanges(
+        const TableMatchKey &key,
+        const std::vector<std::reference_wrapper<TableMatchEntry>> &orderedEntries);
+
+    /// Group the entries of @p orderedEntries which win a lookup by the values they assign.
+    /// @returns std::nullopt if the entries can not be summarized.
+    [[nodiscard]] std::optional<TableSummary> summarizeEntries(
+        const std::vector<std::reference_wrapper<TableMatchEntry>> &orderedEntries) const;
+
+    /// @returns the condition under which the table assigns the value of @p group.
+    /// @p rangeKey is the result of rangeSummaryKey.
+    [[nodiscard]] const IR::Expression *computeGroupCondition(
+        const AssignmentGroup &group, const TableMatchKey *rangeKey) const;
+
+    /// @returns the condition under which the table assigns the value of @p group in Z3 form,
+    /// or std::nullopt if the condition of an entry has not been set.
+    [[nodiscard]] static std::optional<z3::expr> computeZ3GroupCondition(
+        const AssignmentGroup &group, const TableMatchKey *rangeKey);
+
+    /// @returns the encoding of the table if it had @p entryCount entries.
+    [[nodiscard]] TableEncoding encodingFor(size_t entryCount) const;
+
+    /// @returns the assignments of the table in the action-set encoding of @p entries. The action
+    /// choice selects any of the actions of the entries or the default action, independent of the
+    /// key. An action argument keeps its value if every entry assigns the same value, otherwise it
+    /// is a wildcard.
+    [[nodiscard]] ControlPlaneAssignmentSet computeActionSetAssignments(
+        const std::vector<std::reference_wrapper<TableMatchEntry>> &entries) const;
+
+    /// Count @p tableMatchEntry towards its action.
+    /// @returns true if the action was not installed before.
+    bool retainAction(const TableMatchEntry &tableMatchEntry);
+
+    /// Stop counting @p tableMatchEntry towards its action.
+    /// @returns true if the action is no longer installed.
+    bool releaseAction(const TableMatchEntry &tableMatchEntry);
+
+    /// @returns true if changing the number of entries from @p sizeBefore to the current number
+    /// changes whether the table is active or how its entries are encoded.
+    [[nodiscard]] bool sizeChangesSummary(size_t sizeBefore) const;
+
     /// Second-order sorting function for table entries. Sorts entries by priority.
     class CompareTableMatch {
      public:
@@ -388,8 +744,59 @@ class TableConfiguration : public Z3ControlPlaneItem {
     /// Set the default action for this table.
     void setDefaultTableAction(TableDefaultAction defaultTableAction);
 
+    /// @returns true if the action summary of the table changed since the last call, and resets
+    /// the change.
+    bool consumeSummaryChange();
+
+    /// @returns true if the reachability of the actions of the table is determined by its action
+    /// summary alone. This holds if every key is an exact match on a distinct symbolic variable of
+    /// its own and the entries can not cover the key space.
+    /// Callers still have to ensure that the key symbols and action arguments of the table do not
+    /// appear in any other condition.
+    [[nodiscard]] bool isDeterminedByActionSummary() const;
+
+    /// Restrict the table to the entries which match the constant values of its keys. Only keys
+    /// accepted by fieldMatchKeyType are considered. @p constantKeys maps the name of a key to its
+    /// value. Keys which are not mentioned are not constant.
+    /// @returns true if the constant keys of the table changed.
+    bool setConstantKeys(const std::map<cstring, const IR::Constant *> &constantKeys);
+
+    /// @returns an entry which takes precedence over @p tableMatchEntry and matches every packet
+    /// @p tableMatchEntry matches, or nullptr if there is no such entry. Such an entry shadows
+    /// @p tableMatchEntry, which can never be hit. Entries whose matches can not be described as
+    /// a FieldMatch are never considered shadowed. @p tableMatchEntry must be an entry of the
+    /// table.
+    [[nodiscard]] const TableMatchEntry *findShadowingEntry(
+        const TableMatchEntry &tableMatchEntry) const;
+
+    /// @returns the number of entries which can never be hit, since they are shadowed by an entry
+    /// of higher precedence. Only LPM and ternary tables are checked for shadowed entries.
+    [[nodiscard]] size_t shadowedEntryCount() const;
+
+    /// @returns the symbols of the data-plane expressions the table matches on.
+    [[nodiscard]] const SymbolSet &keySymbols() const;
+
+    /// @returns the entries of the table.
+    [[nodiscard]] const TableEntrySet &tableEntries() const;
+
+    /// Set the number of entries up to which every entry is encoded individually.
+    void setEntryBudget(size_t entryBudget);
+
+    /// @returns the number of entries up to which every entry is encoded individually.
+    [[nodiscard]] size_t entryBudget() const;
+
+    /// Set the number of entries up to which the entries are summarized.
+    void setSummaryBudget(size_t summaryBudget);
+
+    /// @returns the number of entries up to which the entries are summarized.
+    [[nodiscard]] size_t summaryBudget() const;
+
+    /// @returns how the entries of the table are currently encoded.
+    [[nodiscard]] TableEncoding encoding() const;
+
     [[nodiscard]] ControlPlaneAssignmentSet computeControlPlaneAssignments() const override;
     [[nodiscard]] Z3ControlPlaneAssignmentSet computeZ3ControlPlaneAssignments() const override;
+    [[nodiscard]] uint64_t estimateMemoryUsage() const override;
 
     DECLARE_TYPEINFO(TableConfiguration);
 };
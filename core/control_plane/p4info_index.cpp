@@ -0,0 +1,117 @@
+#include "backends/p4tools/modules/flay/core/control_plane/p4info_index.h"
+
+#include <utility>
+
+#include "backends/p4tools/common/control_plane/symbolic_variables.h"
+#include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
+
+namespace P4::P4Tools::Flay {
+
+TableActionDescriptor TableActionDescriptor::create(cstring tableName,
+                                                    const ActionEnumeration &actionEnumeration,
+                                                    const p4::config::v1::Action &action) {
+    const auto &actionName = action.preamble().name();
+    TableActionDescriptor descriptor{&action, actionEnumeration.literal(actionName), {}};
+    for (const auto &param : action.params()) {
+        const auto *paramType = IR::Type_Bits::get(param.bitwidth());
+        const auto *argumentSymbol = ControlPlaneState::getTableActionArgument(
+            tableName, actionName, param.name(), paramType);
+        descriptor.params.emplace(param.id(),
+                                  ActionParamDescriptor{&param, paramType, argumentSymbol});
+    }
+    return descriptor;
+}
+
+std::optional<size_t> TableDescriptor::findMatchFieldPosition(uint32_t fieldId) const {
+    auto it = matchFieldPositions.find(fieldId);
+    if (it == matchFieldPositions.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+const TableActionDescriptor *TableDescriptor::findAction(uint32_t actionId) const {
+    auto it = actions.find(actionId);
+    if (it == actions.end()) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+P4InfoIndex::P4InfoIndex(const p4::config::v1::P4Info &p4Info) : _p4Info(&p4Info) {
+    for (const auto &action : p4Info.actions()) {
+        _actions.emplace(action.preamble().id(), &action);
+    }
+    for (const auto &table : p4Info.tables()) {
+        cstring tableName = table.preamble().name();
+        std::vector<cstring> actionNames;
+        for (const auto &actionRef : table.action_refs()) {
+            if (const auto *action = findAction(actionRef.id())) {
+                actionNames.emplace_back(action->preamble().name());
+            }
+        }
+        ActionEnumeration actionEnumeration(std::move(actionNames));
+        const auto *choiceType = actionEnumeration.type();
+        TableDescriptor descriptor{
+            &table,
+            tableName,
+            {},
+            {},
+            actionEnumeration,
+            ControlPlaneState::getActionChoiceVariable(tableName, choiceType),
+            ControlPlaneState::getDefaultActionVariable(tableName, choiceType),
+            {}};
+        for (const auto &matchField : table.match_fields()) {
+            const auto *keyType = IR::Type_Bits::get(matchField.bitwidth());
+            const auto &fieldName = matchField.name();
+            auto [rangeMinSymbol, rangeMaxSymbol] =
+                Bmv2ControlPlaneState::getTableRange(tableName, fieldName, keyType);
+            descriptor.matchFieldPositions.emplace(matchField.id(),
+                                                   descriptor.matchFields.size());
+            descriptor.matchFields.push_back(MatchFieldDescriptor{
+                &matchField, keyType,
+                ControlPlaneState::getTableKey(tableName, fieldName, keyType),
+                ControlPlaneState::getTableMatchLpmPrefix(tableName, fieldName, keyType),
+                ControlPlaneState::getTableTernaryMask(tableName, fieldName, keyType),
+                rangeMinSymbol, rangeMaxSymbol});
+        }
+        for (const auto &actionRef : table.action_refs()) {
+            const auto *action = findAction(actionRef.id());
+            if (action != nullptr) {
+                descriptor.actions.emplace(actionRef.id(),
+                                           TableActionDescriptor::create(
+                                               tableName, descriptor.actionEnumeration, *action));
+            }
+        }
+        _tableIds.emplace(tableName, table.preamble().id());
+        _tables.emplace(table.preamble().id(), std::move(descriptor));
+    }
+}
+
+const p4::config::v1::P4Info &P4InfoIndex::p4Info() const { return *_p4Info; }
+
+const TableDescriptor *P4InfoIndex::findTable(uint32_t tableId) const {
+    auto it = _tables.find(tableId);
+    if (it == _tables.end()) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+const TableDescriptor *P4InfoIndex::findTable(cstring tableName) const {
+    auto it = _tableIds.find(tableName);
+    if (it == _tableIds.end()) {
+        return nullptr;
+    }
+    return findTable(it->second);
+}
+
+const p4::config::v1::Action *P4InfoIndex::findAction(uint32_t actionId) const {
+    auto it = _actions.find(actionId);
+    if (it == _actions.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+}  // namespace P4::P4Tools::Flay
@@ -0,0 +1,146 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_P4INFO_INDEX_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_P4INFO_INDEX_H_
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "backends/p4tools/modules/flay/core/control_plane/action_enumeration.h"
+#include "ir/ir.h"
+#include "lib/cstring.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wpedantic"
+#include "p4/config/v1/p4info.pb.h"
+#pragma GCC diagnostic pop
+
+namespace P4::P4Tools::Flay {
+
+/// The resolved layout of a single match field of a table. All symbolic variables a control-plane
+/// message may assign for this field are created up front, independent of the match kind.
+struct MatchFieldDescriptor {
+    /// The P4Info description of the match field.
+    const p4::config::v1::MatchField *matchField;
+
+    /// The type of the key.
+    const IR::Type_Bits *keyType;
+
+    /// The symbolic variable of the key value.
+    const IR::SymbolicVariable *keySymbol;
+
+    /// The symbolic variable of the LPM prefix length.
+    const IR::SymbolicVariable *lpmPrefixSymbol;
+
+    /// The symbolic variable of the ternary mask.
+    const IR::SymbolicVariable *maskSymbol;
+
+    /// The symbolic variables of the lower and upper bound of a range match.
+    const IR::SymbolicVariable *rangeMinSymbol;
+    const IR::SymbolicVariable *rangeMaxSymbol;
+};
+
+/// The resolved parameter of an action invoked by a particular table.
+struct ActionParamDescriptor {
+    /// The P4Info description of the parameter.
+    const p4::config::v1::Action_Param *param;
+
+    /// The type of the parameter.
+    const IR::Type_Bits *type;
+
+    /// The symbolic variable of the argument of this parameter in the table.
+    const IR::SymbolicVariable *argumentSymbol;
+};
+
+/// An action as it is invoked by a particular table.
+struct TableActionDescriptor {
+    /// The P4Info description of the action.
+    const p4::config::v1::Action *action;
+
+    /// The ordinal of the action in the table, which is assigned to the action choice of the
+    /// table.
+    const IR::Constant *choiceLiteral;
+
+    /// The parameters of the action, keyed by parameter id.
+    std::unordered_map<uint32_t, ActionParamDescriptor> params;
+
+    /// Resolve @p action as it is invoked by the table @p tableName, whose actions are enumerated
+    /// by @p actionEnumeration.
+    static TableActionDescriptor create(cstring tableName,
+                                        const ActionEnumeration &actionEnumeration,
+                                        const p4::config::v1::Action &action);
+};
+
+/// A table with its resolved match-field layout, actions, and symbolic variables.
+struct TableDescriptor {
+    /// The P4Info description of the table.
+    const p4::config::v1::Table *table;
+
+    /// The control-plane name of the table.
+    cstring name;
+
+    /// The match fields of the table, in P4Info order.
+    std::vector<MatchFieldDescriptor> matchFields;
+
+    /// Maps the id of a match field to its position in matchFields.
+    std::unordered_map<uint32_t, size_t> matchFieldPositions;
+
+    /// The ordinals of the actions referenced by the table.
+    ActionEnumeration actionEnumeration;
+
+    /// The symbolic variable of the action choice of a table entry.
+    const IR::SymbolicVariable *actionChoiceSymbol;
+
+    /// The symbolic variable of the default action of the table.
+    const IR::SymbolicVariable *defaultActionSymbol;
+
+    /// The actions referenced by the table, keyed by action id.
+    std::unordered_map<uint32_t, TableActionDescriptor> actions;
+
+    /// @returns the position of match field @p fieldId in matchFields, or std::nullopt if the
+    /// table has no such field.
+    [[nodiscard]] std::optional<size_t> findMatchFieldPosition(uint32_t fieldId) const;
+
+    /// @returns the action @p actionId as it is invoked by this table, or nullptr if the table
+    /// does not reference the action.
+    [[nodiscard]] const TableActionDescriptor *findAction(uint32_t actionId) const;
+};
+
+/// An immutable index over a P4Info description. Replaces the linear scans of
+/// P4::ControlPlaneAPI::findP4RuntimeTable and findP4RuntimeAction with hash lookups and interns
+/// the symbolic variables of every table, so converting a control-plane update does not have to
+/// re-resolve them. Built once per program and shared by the P4Runtime and BfRuntime converters.
+class P4InfoIndex {
+    /// The indexed P4Info. Must outlive the index.
+    const p4::config::v1::P4Info *_p4Info;
+
+    /// Tables keyed by their id.
+    std::unordered_map<uint32_t, TableDescriptor> _tables;
+
+    /// Table ids keyed by table name.
+    std::unordered_map<cstring, uint32_t> _tableIds;
+
+    /// Actions keyed by their id.
+    std::unordered_map<uint32_t, const p4::config::v1::Action *> _actions;
+
+ public:
+    explicit P4InfoIndex(const p4::config::v1::P4Info &p4Info);
+
+    /// @returns the indexed P4Info.
+    [[nodiscard]] const p4::config::v1::P4Info &p4Info() const;
+
+    /// @returns the table with id @p tableId, or nullptr if there is no such table.
+    [[nodiscard]] const TableDescriptor *findTable(uint32_t tableId) const;
+
+    /// @returns the table with control-plane name @p tableName, or nullptr if there is no such
+    /// table.
+    [[nodiscard]] const TableDescriptor *findTable(cstring tableName) const;
+
+    /// @returns the action with id @p actionId, or nullptr if there is no such action.
+    [[nodiscard]] const p4::config::v1::Action *findAction(uint32_t actionId) const;
+};
+
+}  // namespace P4::P4Tools::Flay
+
+#endif /* BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_P4INFO_INDEX_H_ */
@@ -6,13 +6,16 @@
 #include <cstdio>
 #include <cstdlib>
 #include <optional>
+#include <utility>
 
 #include "backends/p4tools/common/control_plane/symbolic_variables.h"
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_item.h"
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
+#include "backends/p4tools/modules/flay/core/control_plane/p4info_index.h"
+#include "backends/p4tools/modules/flay/core/control_plane/protobuf_constants.h"
 #include "backends/p4tools/modules/flay/core/control_plane/protobuf_utils.h"
+#include "backends/p4tools/modules/flay/core/control_plane/table_relevance_index.h"
 #include "control-plane/p4RuntimeArchHandler.h"
-#include "control-plane/p4infoApi.h"
 #include "ir/irutils.h"
 
 #pragma GCC diagnostic push
@@ -29,53 +32,51 @@ namespace {
 /// Convert a P4Runtime FieldMatch into the appropriate symbolic constraint
 /// assignments.
 /// @param symbolSet tracks the symbols used in this conversion.
-std::optional<ControlPlaneAssignmentSet> produceTableMatch(
-    const p4::v1::FieldMatch &field, cstring tableName,
-    const p4::config::v1::MatchField &matchField, SymbolSet &symbolSet) {
+std::optional<ControlPlaneAssignmentSet> produceTableMatch(const p4::v1::FieldMatch &field,
+                                                           const MatchFieldDescriptor &matchField,
+                                                           SymbolSet &symbolSet) {
     ControlPlaneAssignmentSet tableKeySet;
-    const auto *keyType = IR::Type_Bits::get(matchField.bitwidth());
-    const auto *keySymbol = ControlPlaneState::getTableKey(tableName, matchField.name(), keyType);
+    const auto *keyType = matchField.keyType;
+    const auto *keySymbol = matchField.keySymbol;
     symbolSet.emplace(*keySymbol);
     switch (field.field_match_type_case()) {
         case p4::v1::FieldMatch::kExact: {
-            auto value = Protobuf::stringToBigInt(field.exact().value());
-            tableKeySet.emplace(*keySymbol, *IR::Constant::get(keyType, value));
+            const auto *value = Protobuf::stringToConstant(field.exact().value(), keyType);
+            tableKeySet.emplace(*keySymbol, *value);
             return tableKeySet;
         }
         case p4::v1::FieldMatch::kLpm: {
-            const auto *lpmPrefixSymbol =
-                ControlPlaneState::getTableMatchLpmPrefix(tableName, matchField.name(), keyType);
+            const auto *lpmPrefixSymbol = matchField.lpmPrefixSymbol;
             symbolSet.emplace(*lpmPrefixSymbol);
-            auto value = Protobuf::stringToBigInt(field.lpm().value());
-            int prefix = field.lpm().prefix_len();
-            tableKeySet.emplace(*keySymbol, *IR::Constant::get(keyType, value));
-            tableKeySet.emplace(*lpmPrefixSymbol, *IR::Constant::get(keyType, prefix));
+            const auto *value = Protobuf::stringToConstant(field.lpm().value(), keyType);
+            auto prefix = static_cast<uint64_t>(field.lpm().prefix_len());
+            tableKeySet.emplace(*keySymbol, *value);
+            tableKeySet.emplace(*lpmPrefixSymbol, *Protobuf::uint64ToConstant(prefix, keyType));
             return tableKeySet;
         }
         case p4::v1::FieldMatch::kTernary: {
-            const auto *maskSymbol =
-                ControlPlaneState::getTableTernaryMask(tableName, matchField.name(), keyType);
+            const auto *maskSymbol = matchField.maskSymbol;
             symbolSet.emplace(*maskSymbol);
-            auto value = Protobuf::stringToBigInt(field.ternary().value());
-            auto mask = Protobuf::stringToBigInt(field.ternary().mask());
-            tableKeySet.emplace(*keySymbol, *IR::Constant::get(keyType, value));
-            tableKeySet.emplace(*maskSymbol, *IR::Constant::get(keyType, mask));
+            const auto *value = Protobuf::stringToConstant(field.ternary().value(), keyType);
+            const auto *mask = Protobuf::stringToConstant(field.ternary().mask(), keyType);
+            tableKeySet.emplace(*keySymbol, *value);
+            tableKeySet.emplace(*maskSymbol, *mask);
             return tableKeySet;
         }
         case p4::v1::FieldMatch::kRange: {
-            const auto &[rangeMinSymbol, rangeMaxSymbol] =
-                Bmv2ControlPlaneState::getTableRange(tableName, matchField.name(), keyType);
+            const auto *rangeMinSymbol = matchField.rangeMinSymbol;
+            const auto *rangeMaxSymbol = matchField.rangeMaxSymbol;
             symbolSet.emplace(*rangeMinSymbol);
             symbolSet.emplace(*rangeMaxSymbol);
-            auto low = Protobuf::stringToBigInt(field.range().low());
-            auto high = Protobuf::stringToBigInt(field.range().high());
-            tableKeySet.emplace(*rangeMinSymbol, *IR::Constant::get(keyType, low));
-            tableKeySet.emplace(*rangeMaxSymbol, *IR::Constant::get(keyType, high));
+            const auto *low = Protobuf::stringToConstant(field.range().low(), keyType);
+            const auto *high = Protobuf::stringToConstant(field.range().high(), keyType);
+            tableKeySet.emplace(*rangeMinSymbol, *low);
+            tableKeySet.emplace(*rangeMaxSymbol, *high);
             return tableKeySet;
         }
         case p4::v1::FieldMatch::kOptional: {
-            auto value = Protobuf::stringToBigInt(field.optional().value());
-            tableKeySet.emplace(*keySymbol, *IR::Constant::get(keyType, value));
+            const auto *value = Protobuf::stringToConstant(field.optional().value(), keyType);
+            tableKeySet.emplace(*keySymbol, *value);
             return tableKeySet;
         }
         default:
@@ -88,27 +89,23 @@ std::optional<ControlPlaneAssignmentSet> produceTableMatch(
 /// message.
 /// @param symbolSet tracks the symbols used in this conversion.
 std::optional<ControlPlaneAssignmentSet> produceTableMatchForMissingField(
-    cstring tableName, const p4::config::v1::MatchField &matchField, SymbolSet &symbolSet) {
+    const MatchFieldDescriptor &matchField, SymbolSet &symbolSet) {
     ControlPlaneAssignmentSet tableKeySet;
-    const auto *keyType = IR::Type_Bits::get(matchField.bitwidth());
-    const auto *keySymbol = ControlPlaneState::getTableKey(tableName, matchField.name(), keyType);
+    const auto *keyType = matchField.keyType;
+    const auto *keySymbol = matchField.keySymbol;
     symbolSet.emplace(*keySymbol);
-    switch (matchField.match_type()) {
+    switch (matchField.matchField->match_type()) {
         /// We can convert missing ternary and optional fields to 0.
         case p4::config::v1::MatchField::TERNARY:
         case p4::config::v1::MatchField::OPTIONAL: {
-            const auto *keySymbol =
-                ControlPlaneState::getTableKey(tableName, matchField.name(), keyType);
-            const auto *maskSymbol =
-                ControlPlaneState::getTableTernaryMask(tableName, matchField.name(), keyType);
-            symbolSet.emplace(*keySymbol);
+            const auto *maskSymbol = matchField.maskSymbol;
             symbolSet.emplace(*maskSymbol);
-            tableKeySet.emplace(*keySymbol, *IR::Constant::get(keyType, 0));
-            tableKeySet.emplace(*maskSymbol, *IR::Constant::get(keyType, 0));
+            tableKeySet.emplace(*keySymbol, *Protobuf::uint64ToConstant(0, keyType));
+            tableKeySet.emplace(*maskSymbol, *Protobuf::uint64ToConstant(0, keyType));
             return tableKeySet;
         }
         default:
-            error("Unsupported match type %1%.", matchField.DebugString());
+            error("Unsupported match type %1%.", matchField.matchField->DebugString());
     }
     return std::nullopt;
 }
@@ -116,111 +113,159 @@ std::optional<ControlPlaneAssignmentSet> produceTableMatchForMissingField(
 /// Convert a P4Runtime TableAction into the appropriate symbolic constraint
 /// assignments. If @param isDefaultAction is true, then the constraints generated are
 /// specialized towards overriding a default action in a table.
-std::optional<ControlPlaneAssignmentSet> convertTableAction(const p4::v1::Action &tblAction,
-                                                            cstring tableName,
-                                                            const p4::config::v1::Action &p4Action,
-                                                            SymbolSet &symbolSet,
-                                                            bool isDefaultAction) {
+std::optional<ControlPlaneAssignmentSet> convertTableAction(
+    const p4::v1::Action &tblAction, const TableDescriptor &table,
+    const TableActionDescriptor &p4Action, SymbolSet &symbolSet, bool isDefaultAction) {
     const IR::SymbolicVariable *tableActionID =
-        isDefaultAction ? ControlPlaneState::getDefaultActionVariable(tableName)
-                        : ControlPlaneState::getTableActionChoice(tableName);
+        isDefaultAction ? table.defaultActionSymbol : table.actionChoiceSymbol;
     symbolSet.emplace(*tableActionID);
-    auto actionName = p4Action.preamble().name();
-    const auto *actionAssignment = IR::StringLiteral::get(actionName);
+    const auto &actionName = p4Action.action->preamble().name();
     ControlPlaneAssignmentSet tableActionAssignmentSet;
-    tableActionAssignmentSet.emplace(*tableActionID, *actionAssignment);
-    if (tblAction.params().size() != p4Action.params().size()) {
+    tableActionAssignmentSet.emplace(*tableActionID, *p4Action.choiceLiteral);
+    if (tblAction.params().size() != p4Action.action->params().size()) {
         return tableActionAssignmentSet;
     }
-    RETURN_IF_FALSE_WITH_MESSAGE(tblAction.params().size() == p4Action.params().size(),
-                                 std::nullopt,
-                                 error("Action configuration \"%1%\" and target action \"%2%\" "
-                                       "have parameters of different number.",
-                                       p4Action.ShortDebugString(), tblAction.ShortDebugString()));
-    std::map<uint32_t, const p4::config::v1::Action_Param *> paramMap;
-    for (const auto &param : p4Action.params()) {
-        paramMap.emplace(param.id(), &param);
-    }
     for (const auto &paramConfig : tblAction.params()) {
-        auto paramIt = paramMap.find(paramConfig.param_id());
+        auto paramIt = p4Action.params.find(paramConfig.param_id());
         RETURN_IF_FALSE_WITH_MESSAGE(
-            paramIt != paramMap.end(), std::nullopt,
+            paramIt != p4Action.params.end(), std::nullopt,
             error("Parameter %1% of action %2% not found.", paramConfig.DebugString(), actionName));
-        const auto *paramType = IR::Type_Bits::get(paramIt->second->bitwidth());
-        auto paramName = paramIt->second->name();
-        const auto *actionArg =
-            ControlPlaneState::getTableActionArgument(tableName, actionName, paramName, paramType);
-        symbolSet.emplace(*actionArg);
-        const auto *actionVal =
-            IR::Constant::get(paramType, Protobuf::stringToBigInt(paramConfig.value()));
-        tableActionAssignmentSet.emplace(*actionArg, *actionVal);
+        const auto &param = paramIt->second;
+        symbolSet.emplace(*param.argumentSymbol);
+        const auto *actionVal = Protobuf::stringToConstant(paramConfig.value(), param.type);
+        tableActionAssignmentSet.emplace(*param.argumentSymbol, *actionVal);
     }
     return tableActionAssignmentSet;
 }
 
-/// Convert a P4Runtime TableEntry into a TableMatchEntry.
+/// Convert the action @p tblAction of an entry of @p table into symbolic constraint assignments.
+/// Actions which the table does not reference in the P4Info are resolved on demand.
+std::optional<ControlPlaneAssignmentSet> convertTableAction(const p4::v1::Action &tblAction,
+                                                            const TableDescriptor &table,
+                                                            const P4InfoIndex &p4InfoIndex,
+                                                            SymbolSet &symbolSet,
+                                                            bool isDefaultAction) {
+    auto actionId = tblAction.action_id();
+    if (const auto *p4Action = table.findAction(actionId)) {
+        return convertTableAction(tblAction, table, *p4Action, symbolSet, isDefaultAction);
+    }
+    const auto *p4Action = p4InfoIndex.findAction(actionId);
+    RETURN_IF_FALSE_WITH_MESSAGE(p4Action != nullptr, std::nullopt,
+                                 error("Action ID %1% not found in the P4Info.", actionId));
+    auto actionDescriptor = TableActionDescriptor::create(table.name, *p4Action);
+    return convertTableAction(tblAction, table, actionDescriptor, symbolSet, isDefaultAction);
+}
+
+/// Convert the matches of @p tableEntry into symbolic constraint assignments. Fields are
+/// considered in P4Info order and only the first occurrence of a field counts.
 /// Returns std::nullopt if the conversion fails.
 /// @param symbolSet tracks the symbols used in this conversion.
-std::optional<TableMatchEntry *> produceTableEntry(cstring tableName,
-                                                   P4::ControlPlaneAPI::p4rt_id_t tblId,
-                                                   const p4::config::v1::P4Info &p4Info,
-                                                   const p4::v1::TableEntry &tableEntry,
-                                                   SymbolSet &symbolSet) {
-    RETURN_IF_FALSE_WITH_MESSAGE(tableEntry.action().has_action(), std::nullopt,
-                                 error("Table entry %1% has no action.", tableEntry.DebugString()));
-
-    auto tableAction = tableEntry.action().action();
-    auto actionId = tableAction.action_id();
-    ASSIGN_OR_RETURN_WITH_MESSAGE(
-        auto &p4Action, P4::ControlPlaneAPI::findP4RuntimeAction(p4Info, actionId), std::nullopt,
-        error("Action ID %1% not found in the P4Info.", actionId));
-    ASSIGN_OR_RETURN(const auto &tableActionAssignmentSet,
-                     convertTableAction(tableAction, tableName, p4Action, symbolSet, false),
-                     std::nullopt);
-    ControlPlaneAssignmentSet tableKeySet;
-    ASSIGN_OR_RETURN_WITH_MESSAGE(
-        auto &p4InfoTable, P4::ControlPlaneAPI::findP4RuntimeTable(p4Info, tblId), std::nullopt,
-        error("Table ID %1% not found in the P4Info.", actionId));
-
+std::optional<ControlPlaneAssignmentSet> produceTableMatches(
+    const TableDescriptor &table, const p4::v1::TableEntry &tableEntry, SymbolSet &symbolSet) {
     RETURN_IF_FALSE_WITH_MESSAGE(
-        tableEntry.match().size() <= p4InfoTable.match_fields().size(), std::nullopt,
+        static_cast<size_t>(tableEntry.match().size()) <= table.matchFields.size(), std::nullopt,
         error("Table entry %1% has %2% matches, but P4Info has %3%.", tableEntry.DebugString(),
-              tableEntry.match().size(), p4InfoTable.match_fields().size()));
-    // Use this map to look up which match fields are present in the control plane entry.
-    // TODO: Cache this somehow?
-    auto matchMap = std::map<uint32_t, p4::v1::FieldMatch>();
+              tableEntry.match().size(), table.matchFields.size()));
+    // Look up which match fields are present in the control plane entry, in P4Info order.
+    std::vector<const p4::v1::FieldMatch *> presentFields(table.matchFields.size(), nullptr);
     for (const auto &matchField : tableEntry.match()) {
-        matchMap.emplace(matchField.field_id(), matchField);
+        auto position = table.findMatchFieldPosition(matchField.field_id());
+        if (position.has_value() && presentFields[position.value()] == nullptr) {
+            presentFields[position.value()] = &matchField;
+        }
     }
 
-    for (const auto &p4InfoMatchField : p4InfoTable.match_fields()) {
-        auto matchFieldIt = matchMap.find(p4InfoMatchField.id());
+    ControlPlaneAssignmentSet tableKeySet;
+    for (size_t fieldIdx = 0; fieldIdx < table.matchFields.size(); fieldIdx++) {
+        const auto &p4InfoMatchField = table.matchFields[fieldIdx];
         std::optional<ControlPlaneAssignmentSet> matchSetOpt;
         // If we are missing a match entry, create the dummy entry for supported fields.
-        if (matchFieldIt == matchMap.end()) {
-            matchSetOpt = produceTableMatchForMissingField(tableName, p4InfoMatchField, symbolSet);
+        if (presentFields[fieldIdx] == nullptr) {
+            matchSetOpt = produceTableMatchForMissingField(p4InfoMatchField, symbolSet);
         } else {
-            matchSetOpt =
-                produceTableMatch(matchFieldIt->second, tableName, p4InfoMatchField, symbolSet);
+            matchSetOpt = produceTableMatch(*presentFields[fieldIdx], p4InfoMatchField, symbolSet);
         }
         ASSIGN_OR_RETURN(auto matchSet, matchSetOpt, std::nullopt);
         tableKeySet.insert(matchSet.begin(), matchSet.end());
     }
+    return tableKeySet;
+}
+
+/// Convert a P4Runtime TableEntry into a TableMatchEntry.
+/// Returns std::nullopt if the conversion fails.
+/// @param symbolSet tracks the symbols used in this conversion.
+std::optional<TableMatchEntry *> produceTableEntry(const TableDescriptor &table,
+                                                   const P4InfoIndex &p4InfoIndex,
+                                                   const p4::v1::TableEntry &tableEntry,
+                                                   SymbolSet &symbolSet) {
+    RETURN_IF_FALSE_WITH_MESSAGE(tableEntry.action().has_action(), std::nullopt,
+                                 error("Table entry %1% has no action.", tableEntry.DebugString()));
+
+    ASSIGN_OR_RETURN(const auto &tableActionAssignmentSet,
+                     convertTableAction(tableEntry.action().action(), table, p4InfoIndex,
+                                        symbolSet, false),
+                     std::nullopt);
+
+    ASSIGN_OR_RETURN(auto tableKeySet, produceTableMatches(table, tableEntry, symbolSet),
+                     std::nullopt);
 
     return new TableMatchEntry(tableActionAssignmentSet, tableEntry.priority(), tableKeySet);
 }
 
+/// Record an update of a table which can not influence the program in @p relevanceIndex, without
+/// converting it into IR.
+int recordIrrelevantTableEntry(const TableDescriptor &table, const p4::v1::TableEntry &tableEntry,
+                               const ::p4::v1::Update_Type &updateType,
+                               TableRelevanceIndex &relevanceIndex) {
+    auto tblId = tableEntry.table_id();
+    printFeature("flay_protobuf", 4, "Table %1% is not referenced by the program, skipping.",
+                 table.name);
+    if (tableEntry.is_default_action()) {
+        relevanceIndex.setDefaultAction(tblId);
+    }
+
+    RETURN_IF_FALSE_WITH_MESSAGE(
+        !table.table->is_const_table(), EXIT_FAILURE,
+        error("Trying to insert an entry into table '%1%', which is a const table.", table.name));
+
+    // Identify the entry by the same key as the TableMatchEntry the conversion would produce.
+    SymbolSet symbolSet;
+    ASSIGN_OR_RETURN(auto matches, produceTableMatches(table, tableEntry, symbolSet),
+                     EXIT_FAILURE);
+    auto matchKey = TableMatchEntry::computeMatchKey(matches, tableEntry.priority());
+    if (updateType == p4::v1::Update::MODIFY) {
+        relevanceIndex.modifyEntry(tblId, std::move(matchKey));
+    } else if (updateType == p4::v1::Update::INSERT) {
+        RETURN_IF_FALSE_WITH_MESSAGE(
+            relevanceIndex.insertEntry(tblId, std::move(matchKey)) == EXIT_SUCCESS, EXIT_FAILURE,
+            error("Table entry \"%1%\" already exists.", tableEntry.ShortDebugString()));
+    } else if (updateType == p4::v1::Update::DELETE) {
+        RETURN_IF_FALSE_WITH_MESSAGE(relevanceIndex.deleteEntry(tblId, matchKey) == EXIT_SUCCESS,
+                                     EXIT_FAILURE,
+                                     error("Table entry %1% not found and can not be deleted.",
+                                           tableEntry.ShortDebugString()));
+    } else {
+        error("Unsupported update type %1%.", updateType);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
 /// Convert a P4Runtime TableEntry into the appropriate symbolic constraint
 /// assignments.
 /// @param symbolSet tracks the symbols used in this conversion.
-int updateTableEntry(const p4::config::v1::P4Info &p4Info, const p4::v1::TableEntry &tableEntry,
+int updateTableEntry(const P4InfoIndex &p4InfoIndex, const p4::v1::TableEntry &tableEntry,
                      ControlPlaneConstraints &controlPlaneConstraints,
-                     const ::p4::v1::Update_Type &updateType, SymbolSet &symbolSet) {
+                     const ::p4::v1::Update_Type &updateType, SymbolSet &symbolSet,
+                     TableRelevanceIndex *relevanceIndex) {
     auto tblId = tableEntry.table_id();
-    ASSIGN_OR_RETURN_WITH_MESSAGE(
-        auto &p4Table, P4::ControlPlaneAPI::findP4RuntimeTable(p4Info, tblId), EXIT_FAILURE,
-        error("Table ID %1% not found in the P4Info.", tblId));
-    cstring tableName = p4Table.preamble().name();
+    const auto *table = p4InfoIndex.findTable(tblId);
+    RETURN_IF_FALSE_WITH_MESSAGE(table != nullptr, EXIT_FAILURE,
+                                 error("Table ID %1% not found in the P4Info.", tblId));
+    if (relevanceIndex != nullptr && !relevanceIndex->isRelevant(tblId)) {
+        return recordIrrelevantTableEntry(*table, tableEntry, updateType, *relevanceIndex);
+    }
+    cstring tableName = table->name;
 
     auto it = controlPlaneConstraints.find(tableName);
     RETURN_IF_FALSE_WITH_MESSAGE(
@@ -234,25 +279,19 @@ int updateTableEntry(const p4::config::v1::P4Info &p4Info, const p4::v1::TableEn
         error("Configuration result is not a TableConfiguration.", tableName));
 
     if (tableEntry.is_default_action()) {
-        auto defaultAction = tableEntry.action().action();
-        ASSIGN_OR_RETURN_WITH_MESSAGE(
-            auto &p4Action,
-            P4::ControlPlaneAPI::findP4RuntimeAction(p4Info, defaultAction.action_id()),
-            EXIT_FAILURE,
-            error("Action ID %1% not found in the P4Info.", defaultAction.action_id()));
         ASSIGN_OR_RETURN(auto defaultActionExpr,
-                         convertTableAction(defaultAction, tableName, p4Action, symbolSet, true),
+                         convertTableAction(tableEntry.action().action(), *table, p4InfoIndex,
+                                            symbolSet, true),
                          EXIT_FAILURE);
         tableResult.setDefaultTableAction(TableDefaultAction(defaultActionExpr));
     }
 
     RETURN_IF_FALSE_WITH_MESSAGE(
-        !p4Table.is_const_table(), EXIT_FAILURE,
+        !table->table->is_const_table(), EXIT_FAILURE,
         error("Trying to insert an entry into table '%1%', which is a const table.", tableName));
 
     ASSIGN_OR_RETURN(auto *tableMatchEntry,
-                     produceTableEntry(tableName, tblId, p4Info, tableEntry, symbolSet),
-                     EXIT_FAILURE);
+                     produceTableEntry(*table, p4InfoIndex, tableEntry, symbolSet), EXIT_FAILURE);
 
     if (updateType == p4::v1::Update::MODIFY) {
         tableResult.addTableEntry(*tableMatchEntry, true);
@@ -276,13 +315,15 @@ int updateTableEntry(const p4::config::v1::P4Info &p4Info, const p4::v1::TableEn
 }  // namespace
 
 int updateControlPlaneConstraintsWithEntityMessage(const p4::v1::Entity &entity,
-                                                   const p4::config::v1::P4Info &p4Info,
+                                                   const P4InfoIndex &p4InfoIndex,
                                                    ControlPlaneConstraints &controlPlaneConstraints,
                                                    const ::p4::v1::Update_Type &updateType,
-                                                   SymbolSet &symbolSet) {
+                                                   SymbolSet &symbolSet,
+                                                   TableRelevanceIndex *relevanceIndex) {
     if (entity.has_table_entry()) {
-        RETURN_IF_FALSE(updateTableEntry(p4Info, entity.table_entry(), controlPlaneConstraints,
-                                         updateType, symbolSet) == EXIT_SUCCESS,
+        RETURN_IF_FALSE(updateTableEntry(p4InfoIndex, entity.table_entry(),
+                                         controlPlaneConstraints, updateType, symbolSet,
+                                         relevanceIndex) == EXIT_SUCCESS,
                         EXIT_FAILURE)
     } else {
         error("Unsupported control plane entry %1%.", entity.DebugString().c_str());
@@ -292,11 +333,12 @@ int updateControlPlaneConstraintsWithEntityMessage(const p4::v1::Entity &entity,
 }
 
 int updateControlPlaneConstraints(const ::p4runtime::flaytests::Config &protoControlPlaneConfig,
-                                  const p4::config::v1::P4Info &p4Info,
+                                  const P4InfoIndex &p4InfoIndex,
                                   ControlPlaneConstraints &controlPlaneConstraints,
                                   SymbolSet &symbolSet) {
     for (const auto &entity : protoControlPlaneConfig.entities()) {
-        if (updateControlPlaneConstraintsWithEntityMessage(entity, p4Info, controlPlaneConstraints,
+        if (updateControlPlaneConstraintsWithEntityMessage(entity, p4InfoIndex,
+                                                           controlPlaneConstraints,
                                                            p4::v1::Update::MODIFY,
                                                            symbolSet) != EXIT_SUCCESS) {
             return EXIT_FAILURE;
@@ -13,7 +13,9 @@
 #pragma GCC diagnostic pop
 
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_item.h"
+#include "backends/p4tools/modules/flay/core/control_plane/p4info_index.h"
 #include "backends/p4tools/modules/flay/core/control_plane/symbols.h"
+#include "backends/p4tools/modules/flay/core/control_plane/table_relevance_index.h"
 
 /// Parses a Protobuf text message file and converts the instructions contained
 /// within into P4C-IR nodes. These IR-nodes are structured to represent a
@@ -23,19 +25,22 @@ namespace P4::P4Tools::Flay::P4Runtime {
 
 /// Convert a Protobuf P4Runtime entity object into a set of IR-based
 /// control-plane constraints. Use the
+/// @param p4InfoIndex to look up the tables and actions referenced by the entity.
 /// @param symbolSet tracks the symbols used in this conversion.
+/// @param relevanceIndex, if set, is used to skip the conversion of updates to tables which can
+/// not influence the program. These updates leave @p symbolSet untouched.
 [[nodiscard]] int updateControlPlaneConstraintsWithEntityMessage(
-    const p4::v1::Entity &entity, const p4::config::v1::P4Info &p4Info,
+    const p4::v1::Entity &entity, const P4InfoIndex &p4InfoIndex,
     ControlPlaneConstraints &controlPlaneConstraints, const ::p4::v1::Update_Type &updateType,
-    SymbolSet &symbolSet);
+    SymbolSet &symbolSet, TableRelevanceIndex *relevanceIndex = nullptr);
 
 /// Convert a Protobuf Config object into a set of IR-based control-plane
 /// constraints. Use the
-/// @param irToIdMap to lookup the nodes associated with P4Runtime Ids.
+/// @param p4InfoIndex to look up the tables and actions referenced by the entities.
 /// @param symbolSet tracks the symbols used in this conversion.
 [[nodiscard]] int updateControlPlaneConstraints(
     const ::p4runtime::flaytests::Config &protoControlPlaneConfig,
-    const p4::config::v1::P4Info &p4Info, ControlPlaneConstraints &controlPlaneConstraints,
+    const P4InfoIndex &p4InfoIndex, ControlPlaneConstraints &controlPlaneConstraints,
     SymbolSet &symbolSet);
 
 }  // namespace P4::P4Tools::Flay::P4Runtime
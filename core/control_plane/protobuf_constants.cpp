@@ -0,0 +1,56 @@
+#include "backends/p4tools/modules/flay/core/control_plane/protobuf_constants.h"
+
+#include "backends/p4tools/modules/flay/core/control_plane/protobuf_utils.h"
+
+namespace P4::P4Tools::Flay {
+
+const IR::Constant *ConstantInterner::get(const IR::Type_Bits *type, uint64_t value) {
+    auto &interner = getInstance();
+    auto it = interner.find({type, value});
+    if (it != interner.end()) {
+        return it->second;
+    }
+    if (interner.flat_hash_map::size() >= kMaxConstants) {
+        interner.flat_hash_map::clear();
+    }
+    const auto *constant = IR::Constant::get(type, big_int(value));
+    interner.emplace(std::make_pair(type, value), constant);
+    return constant;
+}
+
+namespace Protobuf {
+
+namespace {
+
+/// @returns true if @p value can be represented by @p type without truncation.
+bool fitsInto(uint64_t value, const IR::Type_Bits *type) {
+    if (type->isSigned || type->width_bits() <= 0) {
+        return false;
+    }
+    if (type->width_bits() >= 64) {
+        return true;
+    }
+    return (value >> static_cast<unsigned>(type->width_bits())) == 0;
+}
+
+}  // namespace
+
+const IR::Constant *uint64ToConstant(uint64_t value, const IR::Type_Bits *type) {
+    if (fitsInto(value, type)) {
+        return ConstantInterner::get(type, value);
+    }
+    // Preserve the diagnostics of IR::Constant for values which do not fit.
+    return IR::Constant::get(type, big_int(value));
+}
+
+const IR::Constant *stringToConstant(const std::string &valueString, const IR::Type_Bits *type) {
+    auto value = stringToUint64(valueString);
+    if (value.has_value()) {
+        return uint64ToConstant(value.value(), type);
+    }
+    return IR::Constant::get(type, stringToBigInt(valueString));
+}
+
+}  // namespace Protobuf
+
+}  // namespace P4::P4Tools::Flay
@@ -0,0 +1,72 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_PROTOBUF_CONSTANTS_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_PROTOBUF_CONSTANTS_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "ir/ir.h"
+
+namespace P4::P4Tools::Flay {
+
+/// Interns constants of unsigned bit types whose value fits into 64 bits. Control-plane updates
+/// assign the same key and argument values over and over, so handing out a shared constant avoids
+/// an allocation per assignment.
+class ConstantInterner
+    : protected absl::flat_hash_map<std::pair<const IR::Type_Bits *, uint64_t>,
+                                    const IR::Constant *> {
+    /// Once this many constants are interned, the table is reset. Bounds the memory held by
+    /// constants which are no longer referenced by any table entry.
+    static constexpr size_t kMaxConstants = 1UL << 20;
+
+    ConstantInterner() = default;
+
+    /// The interner is a singleton instance.
+    static ConstantInterner &getInstance() {
+        static ConstantInterner CONSTANT_INTERNER;
+        return CONSTANT_INTERNER;
+    }
+
+ public:
+    /// @returns the constant of @p type with @p value. @p type must be interned itself, which is
+    /// the case for all types created with IR::Type_Bits::get.
+    static const IR::Constant *get(const IR::Type_Bits *type, uint64_t value);
+
+    /// Return the number of interned constants.
+    static size_t size() { return getInstance().flat_hash_map::size(); }
+
+    /// Forget all interned constants.
+    static void clear() { getInstance().flat_hash_map::clear(); }
+};
+
+namespace Protobuf {
+
+/// Decode a big-endian Protobuf byte string into a machine integer.
+/// @returns std::nullopt if the value does not fit into 64 bits.
+inline std::optional<uint64_t> stringToUint64(const std::string &valueString) {
+    uint64_t value = 0;
+    for (auto byte : valueString) {
+        // Leading zero bytes are allowed in any number.
+        if ((value >> 56U) != 0) {
+            return std::nullopt;
+        }
+        value = (value << 8U) | static_cast<uint8_t>(byte);
+    }
+    return value;
+}
+
+/// Convert a Protobuf byte string into a constant of @p type. Values of at most 64 bits which fit
+/// into @p type are decoded without big-integer arithmetic and interned. All other values take
+/// the general path through IR::Constant::get.
+const IR::Constant *stringToConstant(const std::string &valueString, const IR::Type_Bits *type);
+
+/// Convert @p value into a constant of @p type. Interned like stringToConstant.
+const IR::Constant *uint64ToConstant(uint64_t value, const IR::Type_Bits *type);
+
+}  // namespace Protobuf
+
+}  // namespace P4::P4Tools::Flay
+
+#endif /* BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_PROTOBUF_CONSTANTS_H_ */
@@ -2,11 +2,24 @@
 #define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_PROTOBUF_UTILS_H_
 
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <google/protobuf/io/zero_copy_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/text_format.h>
+#include <google/protobuf/util/delimited_message_util.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <filesystem>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "backends/p4tools/common/lib/logging.h"
 #include "backends/p4tools/modules/flay/core/lib/return_macros.h"
@@ -25,6 +38,130 @@ inline big_int stringToBigInt(const std::string &valueString) {
     return value;
 }
 
+/// The serialization formats of Protobuf files we can ingest.
+enum class ProtobufFormat {
+    /// A single message in text format (.txtpb).
+    kText,
+    /// A single message in binary wire format (.binpb, .pb).
+    kBinary,
+    /// A stream of length-delimited messages in binary wire format (.binpbs).
+    kDelimited,
+};
+
+/// @returns the Protobuf format implied by the extension of @p file, or std::nullopt if the
+/// extension is not known.
+inline std::optional<ProtobufFormat> formatFromExtension(const std::filesystem::path &file) {
+    auto extension = file.extension();
+    if (extension == ".txtpb") {
+        return ProtobufFormat::kText;
+    }
+    if (extension == ".binpb" || extension == ".pb") {
+        return ProtobufFormat::kBinary;
+    }
+    if (extension == ".binpbs") {
+        return ProtobufFormat::kDelimited;
+    }
+    return std::nullopt;
+}
+
+/// A read-only memory mapping of a file. Binary Protobuf messages are parsed directly from the
+/// mapping, which avoids copying the file contents into a separate buffer.
+class MappedFile {
+    /// The start of the mapping. Null if the file is empty or could not be mapped.
+    void *_data = nullptr;
+
+    /// The size of the mapped file in bytes.
+    size_t _size = 0;
+
+    /// Whether the file was opened and mapped successfully.
+    bool _isValid = false;
+
+ public:
+    explicit MappedFile(const std::filesystem::path &inputFile) {
+        int fd = open(inputFile.c_str(), O_RDONLY);  // NOLINT, we are forced to use open here.
+        if (fd < 0) {
+            return;
+        }
+        struct stat fileStat {};
+        if (fstat(fd, &fileStat) != 0) {
+            close(fd);
+            return;
+        }
+        _size = static_cast<size_t>(fileStat.st_size);
+        if (_size > 0) {
+            _data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (_data == MAP_FAILED) {
+                _data = nullptr;
+                close(fd);
+                return;
+            }
+            // We read the file front to back exactly once.
+            madvise(_data, _size, MADV_SEQUENTIAL);
+        }
+        // The mapping stays valid after the descriptor is closed.
+        close(fd);
+        _isValid = true;
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&) = delete;
+    MappedFile &operator=(MappedFile &&) = delete;
+    ~MappedFile() {
+        if (_data != nullptr) {
+            munmap(_data, _size);
+        }
+    }
+
+    /// @returns false if the file could not be opened or mapped.
+    [[nodiscard]] bool isValid() const { return _isValid; }
+
+    /// @returns the start of the mapped file contents.
+    [[nodiscard]] const void *data() const { return _data; }
+
+    /// @returns the size of the mapped file in bytes.
+    [[nodiscard]] size_t size() const { return _size; }
+};
+
+/// A zero-copy input stream over a memory-mapped file. Unlike ArrayInputStream, supports files
+/// larger than 2 GiB by handing out the mapping in blocks.
+class MappedInputStream : public google::protobuf::io::ZeroCopyInputStream {
+    /// The maximum size of a single block returned by Next.
+    static constexpr size_t kMaxBlockSize = 1UL << 30;
+
+    /// The underlying mapped file.
+    const MappedFile &_mappedFile;
+
+    /// The current read position.
+    size_t _position = 0;
+
+ public:
+    explicit MappedInputStream(const MappedFile &mappedFile) : _mappedFile(mappedFile) {}
+
+    bool Next(const void **data, int *size) override {
+        if (_position >= _mappedFile.size()) {
+            return false;
+        }
+        auto blockSize = std::min(kMaxBlockSize, _mappedFile.size() - _position);
+        *data = static_cast<const char *>(_mappedFile.data()) + _position;
+        *size = static_cast<int>(blockSize);
+        _position += blockSize;
+        return true;
+    }
+
+    void BackUp(int count) override { _position -= static_cast<size_t>(count); }
+
+    bool Skip(int count) override {
+        if (_position + static_cast<size_t>(count) > _mappedFile.size()) {
+            _position = _mappedFile.size();
+            return false;
+        }
+        _position += static_cast<size_t>(count);
+        return true;
+    }
+
+    [[nodiscard]] int64_t ByteCount() const override { return static_cast<int64_t>(_position); }
+};
+
 /// Deserialize a .proto file into a P4Runtime-compliant Protobuf object.
 template <class T>
 [[nodiscard]] static std::optional<T> deserializeObjectFromFile(
@@ -36,10 +173,9 @@ template <class T>
                   O_RDONLY);  // NOLINT, we are forced to use open here.
     RETURN_IF_FALSE_WITH_MESSAGE(fd > 0, std::nullopt,
                                  error("Failed to open file %1%", inputFile.c_str()));
-    google::protobuf::io::ZeroCopyInputStream *input =
-        new google::protobuf::io::FileInputStream(fd);
+    google::protobuf::io::FileInputStream input(fd);
 
-    RETURN_IF_FALSE_WITH_MESSAGE(google::protobuf::TextFormat::Parse(input, &protoObject),
+    RETURN_IF_FALSE_WITH_MESSAGE(google::protobuf::TextFormat::Parse(&input, &protoObject),
                                  std::nullopt,
                                  error("Failed to parse configuration \"%1%\" for file %2%",
                                        protoObject.ShortDebugString(), inputFile.c_str()));
@@ -50,6 +186,173 @@ template <class T>
     return protoObject;
 }
 
+/// Deserialize a file containing a single message in binary wire format into a Protobuf object.
+template <class T>
+[[nodiscard]] static std::optional<T> deserializeBinaryObjectFromFile(
+    const std::filesystem::path &inputFile) {
+    MappedFile mappedFile(inputFile);
+    RETURN_IF_FALSE_WITH_MESSAGE(mappedFile.isValid(), std::nullopt,
+                                 error("Failed to open file %1%", inputFile.c_str()));
+    MappedInputStream input(mappedFile);
+    T protoObject;
+    RETURN_IF_FALSE_WITH_MESSAGE(
+        protoObject.ParseFromZeroCopyStream(&input), std::nullopt,
+        error("Failed to parse binary configuration for file %1%", inputFile.c_str()));
+    printFeature("flay_protobuf", 4, "Parsed configuration: %1%", protoObject.DebugString());
+    return protoObject;
+}
+
+/// Parse length-delimited messages in binary wire format from @p input one by one and invoke
+/// @p callback with each message, until the stream ends. Neither reports errors nor logs, so it
+/// may run on threads other than the main thread. @returns EXIT_FAILURE if a message can not be
+/// parsed, in which case @p failure describes the problem, or if the callback does.
+/// @p streamName is only used for the description of the failure.
+template <class T>
+[[nodiscard]] static int parseDelimitedObjectsInStream(
+    google::protobuf::io::ZeroCopyInputStream &input, std::string_view streamName,
+    const std::function<int(T &&)> &callback, std::string &failure) {
+    // Messages are parsed with a fresh coded stream each, so the total size of the stream is not
+    // bounded by the 2 GiB limit of a single coded stream.
+    size_t messageIdx = 0;
+    while (true) {
+        T protoObject;
+        bool cleanEof = false;
+        if (!google::protobuf::util::ParseDelimitedFromZeroCopyStream(&protoObject, &input,
+                                                                      &cleanEof)) {
+            if (!cleanEof) {
+                failure = "Failed to parse message " + std::to_string(messageIdx) +
+                          " in delimited stream " + std::string(streamName);
+                return EXIT_FAILURE;
+            }
+            break;
+        }
+        RETURN_IF_FALSE(callback(std::move(protoObject)) == EXIT_SUCCESS, EXIT_FAILURE);
+        messageIdx++;
+    }
+    return EXIT_SUCCESS;
+}
+
+/// Parse the messages of @p inputFile in the given @p format and invoke @p callback with each
+/// message. Text and binary files hold a single message. Like parseDelimitedObjectsInStream,
+/// neither reports errors nor logs. @returns EXIT_FAILURE if the file can not be read or parsed,
+/// in which case @p failure describes the problem, or if the callback does.
+template <class T>
+[[nodiscard]] static int parseObjectsInFile(const std::filesystem::path &inputFile,
+                                            ProtobufFormat format,
+                                            const std::function<int(T &&)> &callback,
+                                            std::string &failure) {
+    if (format == ProtobufFormat::kText) {
+        int fd = open(inputFile.c_str(), O_RDONLY);  // NOLINT, we are forced to use open here.
+        if (fd < 0) {
+            failure = "Failed to open file " + inputFile.native();
+            return EXIT_FAILURE;
+        }
+        google::protobuf::io::FileInputStream input(fd);
+        input.SetCloseOnDelete(true);
+        T protoObject;
+        if (!google::protobuf::TextFormat::Parse(&input, &protoObject)) {
+            failure = "Failed to parse configuration for file " + inputFile.native();
+            return EXIT_FAILURE;
+        }
+        return callback(std::move(protoObject));
+    }
+    MappedFile mappedFile(inputFile);
+    if (!mappedFile.isValid()) {
+        failure = "Failed to open file " + inputFile.native();
+        return EXIT_FAILURE;
+    }
+    MappedInputStream input(mappedFile);
+    if (format == ProtobufFormat::kDelimited) {
+        return parseDelimitedObjectsInStream<T>(input, inputFile.native(), callback, failure);
+    }
+    T protoObject;
+    if (!protoObject.ParseFromZeroCopyStream(&input)) {
+        failure = "Failed to parse binary configuration for file " + inputFile.native();
+        return EXIT_FAILURE;
+    }
+    return callback(std::move(protoObject));
+}
+
+/// Deserialize length-delimited messages in binary wire format from @p input one by one and
+/// invoke @p callback with each message, until the stream ends. Stops early and returns
+/// EXIT_FAILURE if the callback does. Only one message is materialized at a time.
+/// @p streamName is only used for error messages.
+template <class T>
+[[nodiscard]] static int forEachDelimitedObjectInStream(
+    google::protobuf::io::ZeroCopyInputStream &input, std::string_view streamName,
+    const std::function<int(T &&)> &callback) {
+    std::string failure;
+    auto result = parseDelimitedObjectsInStream<T>(
+        input, streamName,
+        [&callback](T &&protoObject) {
+            printFeature("flay_protobuf", 4, "Parsed configuration: %1%",
+                         protoObject.DebugString());
+            return callback(std::move(protoObject));
+        },
+        failure);
+    RETURN_IF_FALSE_WITH_MESSAGE(failure.empty(), EXIT_FAILURE, error("%1%", failure));
+    return result;
+}
+
+/// Deserialize a file holding a stream of length-delimited messages in binary wire format one by
+/// one and invoke @p callback with each message. See forEachDelimitedObjectInStream.
+template <class T>
+[[nodiscard]] static int forEachDelimitedObjectInFile(const std::filesystem::path &inputFile,
+                                                      const std::function<int(T &&)> &callback) {
+    MappedFile mappedFile(inputFile);
+    RETURN_IF_FALSE_WITH_MESSAGE(mappedFile.isValid(), EXIT_FAILURE,
+                                 error("Failed to open file %1%", inputFile.c_str()));
+    MappedInputStream input(mappedFile);
+    return forEachDelimitedObjectInStream<T>(input, inputFile.native(), callback);
+}
+
+/// Deserialize a file in the given @p format into a list of Protobuf objects. Text and binary
+/// files always produce a single object.
+template <class T>
+[[nodiscard]] static std::optional<std::vector<T>> deserializeObjectsFromFile(
+    const std::filesystem::path &inputFile, ProtobufFormat format) {
+    std::vector<T> protoObjects;
+    switch (format) {
+        case ProtobufFormat::kText: {
+            ASSIGN_OR_RETURN(auto protoObject, deserializeObjectFromFile<T>(inputFile),
+                             std::nullopt);
+            protoObjects.emplace_back(std::move(protoObject));
+            break;
+        }
+        case ProtobufFormat::kBinary: {
+            ASSIGN_OR_RETURN(auto protoObject, deserializeBinaryObjectFromFile<T>(inputFile),
+                             std::nullopt);
+            protoObjects.emplace_back(std::move(protoObject));
+            break;
+        }
+        case ProtobufFormat::kDelimited: {
+            auto result = forEachDelimitedObjectInFile<T>(inputFile, [&protoObjects](T &&object) {
+                protoObjects.emplace_back(std::move(object));
+                return EXIT_SUCCESS;
+            });
+            RETURN_IF_FALSE(result == EXIT_SUCCESS, std::nullopt);
+            break;
+        }
+    }
+    return protoObjects;
+}
+
+/// Serialize @p protoObjects into @p outputFile as a stream of length-delimited messages.
+template <class T>
+[[nodiscard]] static int serializeDelimitedObjectsToFile(const std::vector<T> &protoObjects,
+                                                         const std::filesystem::path &outputFile) {
+    std::ofstream output(outputFile, std::ios::binary | std::ios::trunc);
+    RETURN_IF_FALSE_WITH_MESSAGE(output.is_open(), EXIT_FAILURE,
+                                 error("Failed to open file %1%", outputFile.c_str()));
+    google::protobuf::io::OstreamOutputStream outputStream(&output);
+    for (const auto &protoObject : protoObjects) {
+        RETURN_IF_FALSE_WITH_MESSAGE(
+            google::protobuf::util::SerializeDelimitedToZeroCopyStream(protoObject, &outputStream),
+            EXIT_FAILURE, error("Failed to serialize message to %1%", outputFile.c_str()));
+    }
+    return EXIT_SUCCESS;
+}
+
 }  // namespace P4::P4Tools::Flay::Protobuf
 
 #endif /* BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_PROTOBUF_UTILS_H_ */
@@ -0,0 +1,187 @@
+#include "backends/p4tools/modules/flay/core/control_plane/shadow_detection.h"
+
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FLAY_SHADOW_DETECTION_X86
+#endif
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "lib/exceptions.h"
+
+namespace P4::P4Tools::Flay {
+
+namespace {
+
+/// The number of bits of a packed word.
+constexpr int kWordWidth = 64;
+
+/// Set uncovered[g] |= groupMasks[g] & ~mask for all @p groupCount groups. A group mask is a
+/// subset of the mask of an entry if no bit remains uncovered in any word.
+void accumulateUncoveredBitsScalar(const uint64_t *groupMasks, size_t groupCount, uint64_t mask,
+                                   uint64_t *uncovered) {
+    auto inverted = ~mask;
+    for (size_t idx = 0; idx < groupCount; ++idx) {
+        uncovered[idx] |= groupMasks[idx] & inverted;
+    }
+}
+
+#ifdef FLAY_SHADOW_DETECTION_X86
+
+/// SSE2 variant of accumulateUncoveredBitsScalar, which compares two groups at once.
+__attribute__((target("sse2"))) void accumulateUncoveredBitsSse2(const uint64_t *groupMasks,
+                                                                 size_t groupCount, uint64_t mask,
+                                                                 uint64_t *uncovered) {
+    auto inverted = _mm_set1_epi64x(static_cast<int64_t>(~mask));
+    size_t idx = 0;
+    for (; idx + 2 <= groupCount; idx += 2) {
+        auto groupMask = _mm_loadu_si128(reinterpret_cast<const __m128i *>(groupMasks + idx));
+        auto *target = reinterpret_cast<__m128i *>(uncovered + idx);
+        _mm_storeu_si128(target, _mm_or_si128(_mm_loadu_si128(target),
+                                              _mm_and_si128(groupMask, inverted)));
+    }
+    accumulateUncoveredBitsScalar(groupMasks + idx, groupCount - idx, mask, uncovered + idx);
+}
+
+/// AVX2 variant of accumulateUncoveredBitsScalar, which compares four groups at once.
+__attribute__((target("avx2"))) void accumulateUncoveredBitsAvx2(const uint64_t *groupMasks,
+                                                                 size_t groupCount, uint64_t mask,
+                                                                 uint64_t *uncovered) {
+    auto inverted = _mm256_set1_epi64x(static_cast<int64_t>(~mask));
+    size_t idx = 0;
+    for (; idx + 4 <= groupCount; idx += 4) {
+        auto groupMask = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(groupMasks + idx));
+        auto *target = reinterpret_cast<__m256i *>(uncovered + idx);
+        _mm256_storeu_si256(target, _mm256_or_si256(_mm256_loadu_si256(target),
+                                                    _mm256_and_si256(groupMask, inverted)));
+    }
+    accumulateUncoveredBitsScalar(groupMasks + idx, groupCount - idx, mask, uncovered + idx);
+}
+
+#endif
+
+/// The signature of the accumulateUncoveredBits variants.
+using AccumulateUncoveredBits = void (*)(const uint64_t *, size_t, uint64_t, uint64_t *);
+
+/// @returns the variant of accumulateUncoveredBits for @p simdLevel.
+AccumulateUncoveredBits selectKernel(SimdLevel simdLevel) {
+    switch (simdLevel) {
+        case SimdLevel::kScalar:
+            return accumulateUncoveredBitsScalar;
+#ifdef FLAY_SHADOW_DETECTION_X86
+        case SimdLevel::kSse2:
+            return accumulateUncoveredBitsSse2;
+        case SimdLevel::kAvx2:
+            return accumulateUncoveredBitsAvx2;
+#endif
+        default:
+            BUG("Vector instructions are not supported on this platform.");
+    }
+}
+
+/// Entries which share a mask.
+struct MaskGroup {
+    /// The mask of the entries.
+    std::vector<uint64_t> mask;
+
+    /// The masked values of the entries.
+    absl::flat_hash_set<std::vector<uint64_t>> values;
+};
+
+}  // namespace
+
+ShadowDetector::ShadowDetector(const std::vector<int> &fieldWidths) {
+    for (auto fieldWidth : fieldWidths) {
+        auto wordCount = static_cast<size_t>((fieldWidth + kWordWidth - 1) / kWordWidth);
+        _fieldWordCounts.push_back(wordCount);
+        _wordCount += wordCount;
+    }
+}
+
+void ShadowDetector::append(const std::vector<FieldMatch> &fieldMatches) {
+    BUG_CHECK(fieldMatches.size() == _fieldWordCounts.size(),
+              "Expected %1% field matches, but got %2%.", _fieldWordCounts.size(),
+              fieldMatches.size());
+    static const big_int kWordMask = std::numeric_limits<uint64_t>::max();
+    for (size_t fieldIdx = 0; fieldIdx < fieldMatches.size(); ++fieldIdx) {
+        const auto &fieldMatch = fieldMatches[fieldIdx];
+        BUG_CHECK(!fieldMatch.isInterval, "Intervals can not be packed into masks.");
+        for (size_t wordIdx = 0; wordIdx < _fieldWordCounts[fieldIdx]; ++wordIdx) {
+            auto shift = static_cast<unsigned>(wordIdx * kWordWidth);
+            _values.push_back(static_cast<uint64_t>((fieldMatch.value >> shift) & kWordMask));
+            _masks.push_back(static_cast<uint64_t>((fieldMatch.mask >> shift) & kWordMask));
+        }
+    }
+}
+
+size_t ShadowDetector::size() const { return _wordCount == 0 ? 0 : _values.size() / _wordCount; }
+
+std::vector<bool> ShadowDetector::findShadowedEntries(SimdLevel simdLevel) const {
+    auto accumulateUncoveredBits = selectKernel(simdLevel);
+    auto entryCount = size();
+    std::vector<bool> shadowedEntries(entryCount, false);
+    std::vector<MaskGroup> groups;
+    absl::flat_hash_map<std::vector<uint64_t>, size_t> groupIds;
+    // The masks of all groups, stored word by word, so a word of all groups is contiguous.
+    std::vector<std::vector<uint64_t>> groupMaskWords(_wordCount);
+    std::vector<uint64_t> uncovered;
+    std::vector<uint64_t> lookupValue(_wordCount);
+    for (size_t entryIdx = 0; entryIdx < entryCount; ++entryIdx) {
+        const auto *values = _values.data() + entryIdx * _wordCount;
+        const auto *masks = _masks.data() + entryIdx * _wordCount;
+        uncovered.assign(groups.size(), 0);
+        for (size_t wordIdx = 0; wordIdx < _wordCount; ++wordIdx) {
+            accumulateUncoveredBits(groupMaskWords[wordIdx].data(), groups.size(), masks[wordIdx],
+                                    uncovered.data());
+        }
+        // Groups are only populated by entries of higher precedence.
+        for (size_t groupIdx = 0; groupIdx < groups.size(); ++groupIdx) {
+            if (uncovered[groupIdx] != 0) {
+                continue;
+            }
+            const auto &group = groups[groupIdx];
+            for (size_t wordIdx = 0; wordIdx < _wordCount; ++wordIdx) {
+                lookupValue[wordIdx] = values[wordIdx] & group.mask[wordIdx];
+            }
+            if (group.values.contains(lookupValue)) {
+                shadowedEntries[entryIdx] = true;
+                break;
+            }
+        }
+        // Whatever a shadowed entry covers is also covered by its shadowing entry.
+        if (shadowedEntries[entryIdx]) {
+            continue;
+        }
+        std::vector<uint64_t> mask(masks, masks + _wordCount);
+        auto [it, inserted] = groupIds.try_emplace(mask, groups.size());
+        if (inserted) {
+            for (size_t wordIdx = 0; wordIdx < _wordCount; ++wordIdx) {
+                groupMaskWords[wordIdx].push_back(mask[wordIdx]);
+            }
+            groups.push_back({std::move(mask), {}});
+        }
+        groups[it->second].values.emplace(values, values + _wordCount);
+    }
+    return shadowedEntries;
+}
+
+std::vector<bool> ShadowDetector::findShadowedEntries() const {
+    static const auto kSimdLevel = supportedSimdLevel();
+    return findShadowedEntries(kSimdLevel);
+}
+
+SimdLevel ShadowDetector::supportedSimdLevel() {
+#ifdef FLAY_SHADOW_DETECTION_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::kAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SimdLevel::kSse2;
+    }
+#endif
+    return SimdLevel::kScalar;
+}
+
+}  // namespace P4::P4Tools::Flay
@@ -0,0 +1,66 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_SHADOW_DETECTION_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_SHADOW_DETECTION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "backends/p4tools/modules/flay/core/control_plane/table_key_index.h"
+
+namespace P4::P4Tools::Flay {
+
+/// The vector instructions used to compare the masks of table entries.
+enum class SimdLevel {
+    kScalar,
+    kSse2,
+    kAvx2,
+};
+
+/// Finds the entries of a table which are shadowed, i.e., every packet they match is also matched
+/// by a single entry of higher precedence. Such entries can never be hit.
+///
+/// The value and mask of every entry are packed into 64-bit words. Entries are grouped by their
+/// mask, and the entries of a group are hashed by their value. An entry is shadowed if a group
+/// whose mask is a subset of the mask of the entry holds the value of the entry, restricted to the
+/// mask of the group. The subset tests against all groups are computed in batches with vector
+/// instructions, so the cost of an entry grows with the number of distinct masks rather than with
+/// the number of entries.
+class ShadowDetector {
+    /// The number of 64-bit words of each field.
+    std::vector<size_t> _fieldWordCounts;
+
+    /// The number of 64-bit words of an entry.
+    size_t _wordCount = 0;
+
+    /// The masked values of the entries, one run of _wordCount words per entry.
+    std::vector<uint64_t> _values;
+
+    /// The masks of the entries, one run of _wordCount words per entry.
+    std::vector<uint64_t> _masks;
+
+ public:
+    /// @p fieldWidths are the widths of the fields of an entry, in bits.
+    explicit ShadowDetector(const std::vector<int> &fieldWidths);
+
+    /// Append an entry with the masked matches @p fieldMatches, one per field. Entries must be
+    /// appended in descending order of precedence.
+    void append(const std::vector<FieldMatch> &fieldMatches);
+
+    /// @returns the number of appended entries.
+    [[nodiscard]] size_t size() const;
+
+    /// @returns whether each appended entry is shadowed by an entry appended before it. Uses the
+    /// vector instructions of @p simdLevel, which must be supported by the processor.
+    [[nodiscard]] std::vector<bool> findShadowedEntries(SimdLevel simdLevel) const;
+
+    /// @returns whether each appended entry is shadowed by an entry appended before it. Uses the
+    /// widest vector instructions supported by the processor.
+    [[nodiscard]] std::vector<bool> findShadowedEntries() const;
+
+    /// @returns the widest vector instructions supported by the processor.
+    [[nodiscard]] static SimdLevel supportedSimdLevel();
+};
+
+}  // namespace P4::P4Tools::Flay
+
+#endif /* BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_SHADOW_DETECTION_H_ */
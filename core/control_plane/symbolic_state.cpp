@@ -2,12 +2,15 @@
 
 #include <cstdint>
 #include <optional>
+#include <utility>
+#include <vector>
 
 #include "backends/p4tools/common/control_plane/symbolic_variables.h"
 #include "backends/p4tools/common/lib/constants.h"
 #include "backends/p4tools/common/lib/table_utils.h"
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
 #include "backends/p4tools/modules/flay/core/lib/return_macros.h"
+#include "backends/p4tools/modules/flay/options.h"
 #include "ir/irutils.h"
 #include "lib/error.h"
 
@@ -118,11 +121,35 @@ std::optional<ControlPlaneAssignmentSet> ControlPlaneStateInitializer::computeEn
     return keySet;
 }
 
+std::optional<ActionEnumeration> ControlPlaneStateInitializer::computeActionEnumeration(
+    const IR::P4Table &table) const {
+    std::vector<cstring> actionNames;
+    const auto *actionList = table.getActionList();
+    RETURN_IF_FALSE(actionList != nullptr, ActionEnumeration(actionNames));
+    for (const auto *action : actionList->actionList) {
+        const auto *actionExpression = action->expression;
+        if (const auto *actionCall = actionExpression->to<IR::MethodCallExpression>()) {
+            actionExpression = actionCall->method;
+        }
+        ASSIGN_OR_RETURN_WITH_MESSAGE(
+            const auto &methodName, actionExpression->to<IR::PathExpression>(), std::nullopt,
+            error("Action %1% in table %2% is not a path expression.", action, table));
+        ASSIGN_OR_RETURN_WITH_MESSAGE(
+            auto &decl, getDeclaration(methodName.path, false), std::nullopt,
+            error("Action reference %1% not found in the reference map.", methodName));
+        ASSIGN_OR_RETURN_WITH_MESSAGE(auto &actionDecl, decl.to<IR::P4Action>(), std::nullopt,
+                                      error("%1% is not a P4Action.", decl));
+        actionNames.push_back(actionDecl.controlPlaneName());
+    }
+    return ActionEnumeration(std::move(actionNames));
+}
+
 std::optional<TableEntrySet> ControlPlaneStateInitializer::initializeTableEntries(
     const IR::P4Table *table) {
     TableEntrySet initialTableEntries;
     const auto *entries = table->getEntries();
     RETURN_IF_FALSE(entries != nullptr, initialTableEntries);
+    ASSIGN_OR_RETURN(auto actionEnumeration, computeActionEnumeration(*table), std::nullopt);
 
     for (const auto *entry : entries->entries) {
         const auto *actionCallExpression = entry->getAction();
@@ -139,7 +166,8 @@ std::optional<TableEntrySet> ControlPlaneStateInitializer::initializeTableEntrie
             error("Action reference %1% not found in the reference map", methodName));
         ASSIGN_OR_RETURN_WITH_MESSAGE(auto &action, actionDecl.to<IR::P4Action>(), std::nullopt,
                                       error("%1% is not a P4Action.", actionDecl));
-        ASSIGN_OR_RETURN(auto actionConstraint, computeEntryAction(*table, action, actionCall),
+        ASSIGN_OR_RETURN(auto actionConstraint,
+                         computeEntryAction(*table, actionEnumeration, action, actionCall),
                          std::nullopt);
         ASSIGN_OR_RETURN(auto entryKeySet, computeEntryKeySet(*table, *entry), std::nullopt);
         std::optional<int32_t> entryPriority;
@@ -160,12 +188,16 @@ std::optional<TableEntrySet> ControlPlaneStateInitializer::initializeTableEntrie
 }
 
 std::optional<ControlPlaneAssignmentSet> ControlPlaneStateInitializer::computeEntryAction(
-    const IR::P4Table &table, const IR::P4Action &actionDecl,
-    const IR::MethodCallExpression &actionCall) {
+    const IR::P4Table &table, const ActionEnumeration &actionEnumeration,
+    const IR::P4Action &actionDecl, const IR::MethodCallExpression &actionCall) {
     ControlPlaneAssignmentSet actionConstraint;
 
-    actionConstraint.emplace(*ControlPlaneState::getTableActionChoice(table.controlPlaneName()),
-                             *IR::StringLiteral::get(actionDecl.controlPlaneName()));
+    ASSIGN_OR_RETURN_WITH_MESSAGE(
+        const auto &actionLiteral, actionEnumeration.literal(actionDecl.controlPlaneName()),
+        std::nullopt, error("Action %1% is not an action of table %2%.", actionDecl, table));
+    actionConstraint.emplace(*ControlPlaneState::getActionChoiceVariable(
+                                 table.controlPlaneName(), actionEnumeration.type()),
+                             actionLiteral);
     RETURN_IF_FALSE_WITH_MESSAGE(
         actionCall.arguments->size() == actionDecl.parameters->parameters.size(), std::nullopt,
         error("Entry call %1% in table %2% does not have the right number of arguments.",
@@ -200,11 +232,15 @@ ControlPlaneStateInitializer::computeDefaultActionConstraints(const IR::P4Table
     ASSIGN_OR_RETURN_WITH_MESSAGE(auto &actionDecl, decl.to<IR::P4Action>(), std::nullopt,
                                   error("Action reference %1% is not a P4Action.", methodName));
 
+    ASSIGN_OR_RETURN(auto actionEnumeration, computeActionEnumeration(*table), std::nullopt);
+    const auto *choiceType = actionEnumeration.type();
+    const auto *noActionLiteral = actionEnumeration.literal(ActionEnumeration::kNoAction);
+
     ControlPlaneAssignmentSet defaultActionConstraints;
-    defaultActionConstraints.emplace(*ControlPlaneState::getTableActionChoice(tableName),
-                                     *IR::StringLiteral::get(cstring("*NONE*")));
-    defaultActionConstraints.emplace(*ControlPlaneState::getDefaultActionVariable(tableName),
-                                     *IR::StringLiteral::get(cstring("*NONE*")));
+    defaultActionConstraints.emplace(
+        *ControlPlaneState::getActionChoiceVariable(tableName, choiceType), *noActionLiteral);
+    defaultActionConstraints.emplace(
+        *ControlPlaneState::getDefaultActionVariable(tableName, choiceType), *noActionLiteral);
     const auto *arguments = actionCall.arguments;
     const auto *parameters = actionDecl.parameters;
     RETURN_IF_FALSE_WITH_MESSAGE(arguments->size() == parameters->parameters.size(), std::nullopt,
@@ -232,9 +268,12 @@ bool ControlPlaneStateInitializer::preorder(const IR::P4Table *table) {
     ASSIGN_OR_RETURN(auto defaultActionConstraints, computeDefaultActionConstraints(table), false);
     ASSIGN_OR_RETURN(TableEntrySet initialTableEntries, initializeTableEntries(table), false);
 
-    _defaultConstraints.insert(
-        {tableName, *new TableConfiguration(tableName, TableDefaultAction(defaultActionConstraints),
-                                            initialTableEntries)});
+    auto *tableConfiguration = new TableConfiguration(
+        tableName, TableDefaultAction(defaultActionConstraints), initialTableEntries);
+    if (auto entryBudget = FlayOptions::get().tableEntryBudget(tableName.string_view())) {
+        tableConfiguration->setEntryBudget(entryBudget.value());
+    }
+    _defaultConstraints.insert({tableName, *tableConfiguration});
     return false;
 }
 
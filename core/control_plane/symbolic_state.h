@@ -1,6 +1,7 @@
 #ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_SYMBOLIC_STATE_H_
 #define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_SYMBOLIC_STATE_H_
 
+#include "backends/p4tools/modules/flay/core/control_plane/action_enumeration.h"
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_item.h"
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
 #include "frontends/common/resolveReferences/referenceMap.h"
@@ -31,10 +32,15 @@ class ControlPlaneStateInitializer : public Inspector, protected P4::ResolutionC
     /// @returns std::nullopt if an error occurs when doing this.
     std::optional<TableEntrySet> initializeTableEntries(const IR::P4Table *table);
 
-    /// Compute the constraints imposed by any entries defined for the table.
+    /// Compute the constraints imposed by any entries defined for the table. The actions of the
+    /// table are enumerated by @p actionEnumeration.
     static std::optional<ControlPlaneAssignmentSet> computeEntryAction(
-        const IR::P4Table &table, const IR::P4Action &actionDecl,
-        const IR::MethodCallExpression &actionCall);
+        const IR::P4Table &table, const ActionEnumeration &actionEnumeration,
+        const IR::P4Action &actionDecl, const IR::MethodCallExpression &actionCall);
+
+    /// Enumerate the actions of the action list of @p table.
+    /// @returns std::nullopt if an action can not be resolved.
+    std::optional<ActionEnumeration> computeActionEnumeration(const IR::P4Table &table) const;
 
     /// Compute the constraints imposed by the default action if the table is not configured.
     /// @returns std::nullopt if an error occurs.
@@ -0,0 +1,355 @@
+#include "backends/p4tools/modules/flay/core/control_plane/table_key_index.h"
+
+#include <algorithm>
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include "backends/p4tools/modules/flay/core/lib/memory_usage.h"
+
+namespace P4::P4Tools::Flay {
+
+namespace {
+
+/// Append @p source to @p target.
+void appendEntries(const std::vector<const TableMatchEntry *> &source,
+                   std::vector<const TableMatchEntry *> &target) {
+    target.insert(target.end(), source.begin(), source.end());
+}
+
+/// Remove @p entry from @p entries.
+void removeEntry(const TableMatchEntry *entry, std::vector<const TableMatchEntry *> &entries) {
+    entries.erase(std::remove(entries.begin(), entries.end(), entry), entries.end());
+}
+
+}  // namespace
+
+/**************************************************************************************************
+FieldMatch
+**************************************************************************************************/
+
+FieldMatch FieldMatch::masked(const big_int &value, const big_int &mask) {
+    return {false, value & mask, mask, 0, 0};
+}
+
+FieldMatch FieldMatch::interval(const big_int &low, const big_int &high) {
+    return {true, 0, 0, low, high};
+}
+
+bool FieldMatch::contains(const big_int &key) const {
+    if (isInterval) {
+        return low <= key && key <= high;
+    }
+    return (key & mask) == value;
+}
+
+bool FieldMatch::covers(const FieldMatch &other) const {
+    if (isInterval != other.isInterval) {
+        return false;
+    }
+    if (isInterval) {
+        return other.low > other.high || (low <= other.low && other.high <= high);
+    }
+    // Every bit we match on must be fixed by the other match, to the same value.
+    return (mask & other.mask) == mask && (other.value & mask) == value;
+}
+
+/**************************************************************************************************
+LpmTrie
+**************************************************************************************************/
+
+LpmTrie::LpmTrie(int width) : _width(width), _nodes(1) {}
+
+std::optional<int> LpmTrie::prefixLength(const big_int &mask) const {
+    int length = 0;
+    while (length < _width && bitAt(mask, length) != 0) {
+        ++length;
+    }
+    big_int prefixMask = ((big_int(1) << static_cast<unsigned>(length)) - 1)
+                         << static_cast<unsigned>(_width - length);
+    if (mask != prefixMask) {
+        return std::nullopt;
+    }
+    return length;
+}
+
+size_t LpmTrie::bitAt(const big_int &key, int depth) const {
+    return boost::multiprecision::bit_test(key, static_cast<unsigned>(_width - 1 - depth)) ? 1
+                                                                                            : 0;
+}
+
+std::optional<uint32_t> LpmTrie::findNode(const FieldMatch &match) const {
+    if (match.isInterval) {
+        return std::nullopt;
+    }
+    auto length = prefixLength(match.mask);
+    if (!length.has_value()) {
+        return std::nullopt;
+    }
+    uint32_t node = 0;
+    for (int depth = 0; depth < length.value(); ++depth) {
+        node = _nodes[node].children[bitAt(match.value, depth)];
+        if (node == 0) {
+            return std::nullopt;
+        }
+    }
+    return node;
+}
+
+bool LpmTrie::insert(const TableMatchEntry *entry, const FieldMatch &match) {
+    if (match.isInterval) {
+        return false;
+    }
+    auto length = prefixLength(match.mask);
+    if (!length.has_value()) {
+        return false;
+    }
+    uint32_t node = 0;
+    for (int depth = 0; depth < length.value(); ++depth) {
+        auto bit = bitAt(match.value, depth);
+        auto child = _nodes[node].children[bit];
+        if (child == 0) {
+            child = static_cast<uint32_t>(_nodes.size());
+            // Adding a node invalidates references into _nodes, so only use indices here.
+            _nodes.emplace_back();
+            _nodes[node].children[bit] = child;
+        }
+        node = child;
+    }
+    _nodes[node].entries.push_back(entry);
+    return true;
+}
+
+void LpmTrie::erase(const TableMatchEntry *entry, const FieldMatch &match) {
+    auto node = findNode(match);
+    if (node.has_value()) {
+        removeEntry(entry, _nodes[node.value()].entries);
+    }
+}
+
+void LpmTrie::clear() { _nodes.assign(1, Node{}); }
+
+std::vector<const TableMatchEntry *> LpmTrie::matching(const big_int &key) const {
+    std::vector<const TableMatchEntry *> entries;
+    uint32_t node = 0;
+    for (int depth = 0;; ++depth) {
+        appendEntries(_nodes[node].entries, entries);
+        if (depth == _width) {
+            break;
+        }
+        node = _nodes[node].children[bitAt(key, depth)];
+        if (node == 0) {
+            break;
+        }
+    }
+    return entries;
+}
+
+std::vector<const TableMatchEntry *> LpmTrie::covering(const FieldMatch &match) const {
+    std::vector<const TableMatchEntry *> entries;
+    if (match.isInterval) {
+        return entries;
+    }
+    // A prefix covers the match if the match fixes all bits of the prefix to the same values. So
+    // follow the match as long as it fixes the next bit.
+    uint32_t node = 0;
+    for (int depth = 0;; ++depth) {
+        appendEntries(_nodes[node].entries, entries);
+        if (depth == _width || bitAt(match.mask, depth) == 0) {
+            break;
+        }
+        node = _nodes[node].children[bitAt(match.value, depth)];
+        if (node == 0) {
+            break;
+        }
+    }
+    return entries;
+}
+
+uint64_t LpmTrie::estimateMemoryUsage() const {
+    uint64_t bytes = _nodes.capacity() * sizeof(Node);
+    for (const auto &node : _nodes) {
+        bytes += node.entries.capacity() * sizeof(const TableMatchEntry *);
+    }
+    return bytes;
+}
+
+/**************************************************************************************************
+IntervalTree
+**************************************************************************************************/
+
+void IntervalTree::rebuild() const {
+    if (!_isDirty) {
+        return;
+    }
+    _sortedIntervals.clear();
+    _sortedIntervals.reserve(_intervals.size());
+    for (const auto &[entry, bounds] : _intervals) {
+        _sortedIntervals.push_back({bounds.first, bounds.second, entry});
+    }
+    std::sort(_sortedIntervals.begin(), _sortedIntervals.end(),
+              [](const Interval &left, const Interval &right) { return left.low < right.low; });
+    _maxHigh.assign(_sortedIntervals.size(), 0);
+    computeMaxHigh(0, _sortedIntervals.size());
+    _isDirty = false;
+}
+
+void IntervalTree::computeMaxHigh(size_t from, size_t to) const {
+    if (from >= to) {
+        return;
+    }
+    auto middle = from + (to - from) / 2;
+    computeMaxHigh(from, middle);
+    computeMaxHigh(middle + 1, to);
+    auto maxHigh = _sortedIntervals[middle].high;
+    if (from < middle) {
+        maxHigh = std::max(maxHigh, _maxHigh[from + (middle - from) / 2]);
+    }
+    if (middle + 1 < to) {
+        maxHigh = std::max(maxHigh, _maxHigh[middle + 1 + (to - middle - 1) / 2]);
+    }
+    _maxHigh[middle] = maxHigh;
+}
+
+void IntervalTree::collectOverlapping(const big_int &low, const big_int &high, size_t from,
+                                      size_t to,
+                                      std::vector<const TableMatchEntry *> &entries) const {
+    if (from >= to) {
+        return;
+    }
+    auto middle = from + (to - from) / 2;
+    // No interval of this subtree reaches the query.
+    if (_maxHigh[middle] < low) {
+        return;
+    }
+    collectOverlapping(low, high, from, middle, entries);
+    const auto &interval = _sortedIntervals[middle];
+    // This interval and all intervals after it start beyond the query.
+    if (interval.low > high) {
+        return;
+    }
+    if (interval.high >= low) {
+        entries.push_back(interval.entry);
+    }
+    collectOverlapping(low, high, middle + 1, to, entries);
+}
+
+bool IntervalTree::insert(const TableMatchEntry *entry, const FieldMatch &match) {
+    if (!match.isInterval) {
+        return false;
+    }
+    // Empty intervals never match, so there is nothing to find them by.
+    if (match.low <= match.high) {
+        _intervals[entry] = {match.low, match.high};
+        _isDirty = true;
+    }
+    return true;
+}
+
+void IntervalTree::erase(const TableMatchEntry *entry, const FieldMatch & /*match*/) {
+    _isDirty |= _intervals.erase(entry) > 0;
+}
+
+void IntervalTree::clear() {
+    _intervals.clear();
+    _isDirty = true;
+}
+
+std::vector<const TableMatchEntry *> IntervalTree::matching(const big_int &key) const {
+    rebuild();
+    std::vector<const TableMatchEntry *> entries;
+    collectOverlapping(key, key, 0, _sortedIntervals.size(), entries);
+    return entries;
+}
+
+std::vector<const TableMatchEntry *> IntervalTree::covering(const FieldMatch &match) const {
+    if (!match.isInterval) {
+        return {};
+    }
+    auto entries = matching(match.low);
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [this, &match](const TableMatchEntry *entry) {
+                                     return _intervals.at(entry).second < match.high;
+                                 }),
+                  entries.end());
+    return entries;
+}
+
+uint64_t IntervalTree::estimateMemoryUsage() const {
+    return MemoryUsage::estimateContainerMemory(_intervals) +
+           _sortedIntervals.capacity() * sizeof(Interval) +
+           _maxHigh.capacity() * sizeof(big_int);
+}
+
+/**************************************************************************************************
+TernaryMaskIndex
+**************************************************************************************************/
+
+bool TernaryMaskIndex::insert(const TableMatchEntry *entry, const FieldMatch &match) {
+    if (match.isInterval) {
+        return false;
+    }
+    _buckets[match.mask][match.value].push_back(entry);
+    return true;
+}
+
+void TernaryMaskIndex::erase(const TableMatchEntry *entry, const FieldMatch &match) {
+    auto bucketIt = _buckets.find(match.mask);
+    if (bucketIt == _buckets.end()) {
+        return;
+    }
+    auto &values = bucketIt->second;
+    auto valueIt = values.find(match.value);
+    if (valueIt == values.end()) {
+        return;
+    }
+    removeEntry(entry, valueIt->second);
+    if (valueIt->second.empty()) {
+        values.erase(valueIt);
+    }
+    if (values.empty()) {
+        _buckets.erase(bucketIt);
+    }
+}
+
+void TernaryMaskIndex::clear() { _buckets.clear(); }
+
+std::vector<const TableMatchEntry *> TernaryMaskIndex::matching(const big_int &key) const {
+    std::vector<const TableMatchEntry *> entries;
+    for (const auto &[mask, values] : _buckets) {
+        auto it = values.find(key & mask);
+        if (it != values.end()) {
+            appendEntries(it->second, entries);
+        }
+    }
+    return entries;
+}
+
+std::vector<const TableMatchEntry *> TernaryMaskIndex::covering(const FieldMatch &match) const {
+    std::vector<const TableMatchEntry *> entries;
+    if (match.isInterval) {
+        return entries;
+    }
+    for (const auto &[mask, values] : _buckets) {
+        // The bucket can only cover the match if the match fixes all bits of its mask.
+        if ((mask & match.mask) != mask) {
+            continue;
+        }
+        auto it = values.find(match.value & mask);
+        if (it != values.end()) {
+            appendEntries(it->second, entries);
+        }
+    }
+    return entries;
+}
+
+uint64_t TernaryMaskIndex::estimateMemoryUsage() const {
+    auto bytes = MemoryUsage::estimateNestedContainerMemory(_buckets);
+    for (const auto &[mask, values] : _buckets) {
+        for (const auto &[value, entries] : values) {
+            bytes += entries.capacity() * sizeof(const TableMatchEntry *);
+        }
+    }
+    return bytes;
+}
+
+}  // namespace P4::P4Tools::Flay
@@ -0,0 +1,186 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_TABLE_KEY_INDEX_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_TABLE_KEY_INDEX_H_
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "lib/big_int.h"
+
+namespace P4::P4Tools::Flay {
+
+class TableMatchEntry;
+
+/// The values of a single key field which are matched by a table entry. Exact, LPM and ternary
+/// matches are described by a value and a mask, range matches by an interval.
+struct FieldMatch {
+    /// Whether the match is an interval. Otherwise, it is a value and a mask.
+    bool isInterval = false;
+
+    /// The value of a masked match. Only bits set in the mask are set in the value.
+    big_int value;
+
+    /// The mask of a masked match.
+    big_int mask;
+
+    /// The inclusive bounds of an interval. The interval is empty if low exceeds high.
+    big_int low;
+    big_int high;
+
+    /// @returns the match of all keys k for which k & @p mask == @p value & @p mask.
+    static FieldMatch masked(const big_int &value, const big_int &mask);
+
+    /// @returns the match of all keys between @p low and @p high, inclusive.
+    static FieldMatch interval(const big_int &low, const big_int &high);
+
+    /// @returns true if @p key is matched.
+    [[nodiscard]] bool contains(const big_int &key) const;
+
+    /// @returns true if every key matched by @p other is matched as well. Masked matches and
+    /// intervals are never compared and do not cover each other.
+    [[nodiscard]] bool covers(const FieldMatch &other) const;
+};
+
+/// A binary trie over the prefixes of LPM matches. Finds the entries whose prefix contains a key
+/// in time linear in the width of the key, independent of the number of entries.
+class LpmTrie {
+    /// A node of the trie. The root is the empty prefix. Index 0 denotes a missing child, since
+    /// the root is never a child.
+    struct Node {
+        std::array<uint32_t, 2> children{};
+        std::vector<const TableMatchEntry *> entries;
+    };
+
+    /// The width of the keys.
+    int _width;
+
+    /// The nodes of the trie. Nodes are not released when their entries are erased.
+    std::vector<Node> _nodes;
+
+    /// @returns the length of the prefix described by @p mask, or std::nullopt if the ones of
+    /// @p mask are not a prefix.
+    [[nodiscard]] std::optional<int> prefixLength(const big_int &mask) const;
+
+    /// @returns the bit of @p key at @p depth, counted from the most significant bit.
+    [[nodiscard]] size_t bitAt(const big_int &key, int depth) const;
+
+    /// @returns the node of the prefix of @p match, or std::nullopt if there is no such node.
+    [[nodiscard]] std::optional<uint32_t> findNode(const FieldMatch &match) const;
+
+ public:
+    explicit LpmTrie(int width);
+
+    /// Index @p entry under @p match.
+    /// @returns false if @p match is not a prefix, in which case @p entry is not indexed.
+    bool insert(const TableMatchEntry *entry, const FieldMatch &match);
+
+    /// Remove @p entry, which was indexed under @p match.
+    void erase(const TableMatchEntry *entry, const FieldMatch &match);
+
+    /// Remove all entries.
+    void clear();
+
+    /// @returns the entries whose prefix contains @p key, in no particular order.
+    [[nodiscard]] std::vector<const TableMatchEntry *> matching(const big_int &key) const;
+
+    /// @returns the entries whose prefix contains every key matched by @p match.
+    [[nodiscard]] std::vector<const TableMatchEntry *> covering(const FieldMatch &match) const;
+
+    /// @returns an estimate of the memory held by the trie.
+    [[nodiscard]] uint64_t estimateMemoryUsage() const;
+};
+
+/// An interval tree over the bounds of range matches. Finds the entries whose interval contains a
+/// key in O(log n + k) for k results. The tree is a sorted array with the largest upper bound of
+/// every subtree, which is rebuilt by the first query after a modification.
+class IntervalTree {
+    /// An indexed interval.
+    struct Interval {
+        big_int low;
+        big_int high;
+        const TableMatchEntry *entry;
+    };
+
+    /// The indexed intervals, keyed by entry.
+    absl::flat_hash_map<const TableMatchEntry *, std::pair<big_int, big_int>> _intervals;
+
+    /// The indexed intervals in ascending order of their lower bound.
+    mutable std::vector<Interval> _sortedIntervals;
+
+    /// The largest upper bound of the subtree rooted at each position of _sortedIntervals. The
+    /// subtree of [from, to) is rooted at its middle.
+    mutable std::vector<big_int> _maxHigh;
+
+    /// Whether the intervals changed since the tree was last built.
+    mutable bool _isDirty = false;
+
+    /// Build the tree from _intervals if it changed.
+    void rebuild() const;
+
+    /// Compute _maxHigh for the subtree of [from, to).
+    void computeMaxHigh(size_t from, size_t to) const;
+
+    /// Collect the entries of the subtree of [from, to) whose interval intersects [low, high].
+    void collectOverlapping(const big_int &low, const big_int &high, size_t from, size_t to,
+                            std::vector<const TableMatchEntry *> &entries) const;
+
+ public:
+    /// Index @p entry under @p match.
+    /// @returns false if @p match is not an interval, in which case @p entry is not indexed.
+    bool insert(const TableMatchEntry *entry, const FieldMatch &match);
+
+    /// Remove @p entry.
+    void erase(const TableMatchEntry *entry, const FieldMatch &match);
+
+    /// Remove all entries.
+    void clear();
+
+    /// @returns the entries whose interval contains @p key, in no particular order.
+    [[nodiscard]] std::vector<const TableMatchEntry *> matching(const big_int &key) const;
+
+    /// @returns the entries whose interval contains every key matched by @p match.
+    [[nodiscard]] std::vector<const TableMatchEntry *> covering(const FieldMatch &match) const;
+
+    /// @returns an estimate of the memory held by the tree.
+    [[nodiscard]] uint64_t estimateMemoryUsage() const;
+};
+
+/// Groups ternary matches by their mask. Within a group, entries are looked up by their value, so
+/// finding the entries which match a key takes one lookup per distinct mask. Controllers tend to
+/// install few distinct masks, even in large tables.
+class TernaryMaskIndex {
+    /// The entries of each mask, keyed by mask and value.
+    std::map<big_int, std::map<big_int, std::vector<const TableMatchEntry *>>> _buckets;
+
+ public:
+    /// Index @p entry under @p match.
+    /// @returns false if @p match is an interval, in which case @p entry is not indexed.
+    bool insert(const TableMatchEntry *entry, const FieldMatch &match);
+
+    /// Remove @p entry, which was indexed under @p match.
+    void erase(const TableMatchEntry *entry, const FieldMatch &match);
+
+    /// Remove all entries.
+    void clear();
+
+    /// @returns the entries which match @p key, in no particular order.
+    [[nodiscard]] std::vector<const TableMatchEntry *> matching(const big_int &key) const;
+
+    /// @returns the entries which match every key matched by @p match.
+    [[nodiscard]] std::vector<const TableMatchEntry *> covering(const FieldMatch &match) const;
+
+    /// @returns an estimate of the memory held by the index.
+    [[nodiscard]] uint64_t estimateMemoryUsage() const;
+};
+
+/// An index over the matches of a single LPM, range or ternary key.
+using FieldMatchIndex = std::variant<LpmTrie, IntervalTree, TernaryMaskIndex>;
+
+}  // namespace P4::P4Tools::Flay
+
+#endif /* BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_TABLE_KEY_INDEX_H_ */
@@ -0,0 +1,110 @@
+#include "backends/p4tools/modules/flay/core/control_plane/table_relevance_index.h"
+
+#include <cstdlib>
+#include <utility>
+
+#include "backends/p4tools/common/control_plane/symbolic_variables.h"
+#include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
+#include "backends/p4tools/modules/flay/core/lib/memory_usage.h"
+
+namespace P4::P4Tools::Flay {
+
+bool TableRelevanceIndex::referencesTable(const TableDescriptor &table,
+                                          const SymbolSet &referencedSymbols) {
+    auto isReferenced = [&referencedSymbols](const IR::SymbolicVariable *symbol) {
+        return referencedSymbols.find(*symbol) != referencedSymbols.end();
+    };
+    if (isReferenced(ControlPlaneState::getTableActive(table.name)) ||
+        isReferenced(table.actionChoiceSymbol) || isReferenced(table.defaultActionSymbol)) {
+        return true;
+    }
+    for (const auto &matchField : table.matchFields) {
+        if (isReferenced(matchField.keySymbol) || isReferenced(matchField.lpmPrefixSymbol) ||
+            isReferenced(matchField.maskSymbol) || isReferenced(matchField.rangeMinSymbol) ||
+            isReferenced(matchField.rangeMaxSymbol)) {
+            return true;
+        }
+    }
+    for (const auto &[actionId, action] : table.actions) {
+        for (const auto &[paramId, param] : action.params) {
+            if (isReferenced(param.argumentSymbol)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+TableRelevanceIndex::TableRelevanceIndex(const P4InfoIndex &p4InfoIndex,
+                                         const SymbolSet &referencedSymbols,
+                                         const ControlPlaneConstraints &controlPlaneConstraints) {
+    for (const auto &table : p4InfoIndex.p4Info().tables()) {
+        auto tableId = table.preamble().id();
+        const auto *tableDescriptor = p4InfoIndex.findTable(tableId);
+        // Be conservative with tables we can not resolve.
+        if (tableDescriptor == nullptr || referencesTable(*tableDescriptor, referencedSymbols)) {
+            _relevantTables.insert(tableId);
+            continue;
+        }
+        // Updates of the entries which are already installed, e.g., by the initial
+        // configuration, are only recorded here from now on.
+        auto it = controlPlaneConstraints.find(tableDescriptor->name);
+        if (it == controlPlaneConstraints.end()) {
+            continue;
+        }
+        if (const auto *tableConfiguration = it->second.get().to<TableConfiguration>()) {
+            tableConfiguration->tableEntries().forEach(
+                [this, tableId](const TableMatchEntry &tableMatchEntry) {
+                    _skippedEntries[tableId].emplace(tableMatchEntry.matchKey());
+                });
+        }
+    }
+}
+
+bool TableRelevanceIndex::isRelevant(uint32_t tableId) const {
+    return _relevantTables.find(tableId) != _relevantTables.end();
+}
+
+size_t TableRelevanceIndex::relevantTableCount() const { return _relevantTables.size(); }
+
+uint64_t TableRelevanceIndex::skippedUpdateCount() const { return _skippedUpdateCount; }
+
+int TableRelevanceIndex::insertEntry(uint32_t tableId, std::string matchKey) {
+    _skippedUpdateCount++;
+    return _skippedEntries[tableId].emplace(std::move(matchKey)).second ? EXIT_SUCCESS
+                                                                         : EXIT_FAILURE;
+}
+
+void TableRelevanceIndex::modifyEntry(uint32_t tableId, std::string matchKey) {
+    _skippedUpdateCount++;
+    _skippedEntries[tableId].emplace(std::move(matchKey));
+}
+
+int TableRelevanceIndex::deleteEntry(uint32_t tableId, const std::string &matchKey) {
+    _skippedUpdateCount++;
+    auto it = _skippedEntries.find(tableId);
+    if (it == _skippedEntries.end()) {
+        return EXIT_FAILURE;
+    }
+    return it->second.erase(matchKey) != 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void TableRelevanceIndex::clearEntries(uint32_t tableId) {
+    _skippedUpdateCount++;
+    _skippedEntries.erase(tableId);
+}
+
+void TableRelevanceIndex::setDefaultAction(uint32_t /*tableId*/) { _skippedUpdateCount++; }
+
+uint64_t TableRelevanceIndex::estimateMemoryUsage() const {
+    auto bytes = MemoryUsage::estimateContainerMemory(_relevantTables) +
+                 MemoryUsage::estimateNestedContainerMemory(_skippedEntries);
+    for (const auto &[tableId, matchKeys] : _skippedEntries) {
+        for (const auto &matchKey : matchKeys) {
+            bytes += matchKey.capacity();
+        }
+    }
+    return bytes;
+}
+
+}  // namespace P4::P4Tools::Flay
@@ -0,0 +1,73 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_TABLE_RELEVANCE_INDEX_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_TABLE_RELEVANCE_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "backends/p4tools/modules/flay/core/control_plane/control_plane_item.h"
+#include "backends/p4tools/modules/flay/core/control_plane/p4info_index.h"
+#include "backends/p4tools/modules/flay/core/control_plane/symbols.h"
+
+namespace P4::P4Tools::Flay {
+
+/// Records which tables can influence the specialization of the program. A table is relevant if
+/// any of its control-plane symbols appears in a reachability or substitution condition. Updates
+/// to all other tables can not change the program, so the converters skip the conversion of their
+/// actions and the update of the table configuration. Only the match keys of their entries are
+/// tracked here, which is enough to reject duplicate insertions and deletions of missing entries.
+class TableRelevanceIndex {
+    /// Ids of the tables whose symbols appear in at least one condition.
+    std::unordered_set<uint32_t> _relevantTables;
+
+    /// The match keys of the entries of irrelevant tables, keyed by table id. The keys are those of
+    /// TableMatchEntry::matchKey.
+    std::unordered_map<uint32_t, std::unordered_set<std::string>> _skippedEntries;
+
+    /// The number of updates which were recorded without conversion.
+    uint64_t _skippedUpdateCount = 0;
+
+    /// @returns true if any of the symbols of @p table is contained in @p referencedSymbols.
+    static bool referencesTable(const TableDescriptor &table, const SymbolSet &referencedSymbols);
+
+ public:
+    /// Index all tables of @p p4InfoIndex against the symbols used by the analysis maps. The
+    /// entries which @p controlPlaneConstraints already holds for irrelevant tables are tracked
+    /// from the start.
+    TableRelevanceIndex(const P4InfoIndex &p4InfoIndex, const SymbolSet &referencedSymbols,
+                        const ControlPlaneConstraints &controlPlaneConstraints);
+
+    /// @returns true if updates to table @p tableId may change the program.
+    [[nodiscard]] bool isRelevant(uint32_t tableId) const;
+
+    /// @returns the number of relevant tables.
+    [[nodiscard]] size_t relevantTableCount() const;
+
+    /// @returns the number of updates which were recorded without conversion.
+    [[nodiscard]] uint64_t skippedUpdateCount() const;
+
+    /// Record the insertion of an entry with @p matchKey into table @p tableId.
+    /// @returns EXIT_FAILURE if the entry already exists.
+    int insertEntry(uint32_t tableId, std::string matchKey);
+
+    /// Record the insertion or replacement of an entry with @p matchKey in table @p tableId.
+    void modifyEntry(uint32_t tableId, std::string matchKey);
+
+    /// Record the deletion of the entry with @p matchKey from table @p tableId.
+    /// @returns EXIT_FAILURE if the entry does not exist.
+    int deleteEntry(uint32_t tableId, const std::string &matchKey);
+
+    /// Record the deletion of all entries of table @p tableId.
+    void clearEntries(uint32_t tableId);
+
+    /// Record an update of the default action of table @p tableId.
+    void setDefaultAction(uint32_t tableId);
+
+    /// @returns the approximate number of bytes held by the index.
+    [[nodiscard]] uint64_t estimateMemoryUsage() const;
+};
+
+}  // namespace P4::P4Tools::Flay
+
+#endif /* BACKENDS_P4TOOLS_MODULES_FLAY_CORE_CONTROL_PLANE_TABLE_RELEVANCE_INDEX_H_ */
@@ -3,6 +3,10 @@
 
 #include <z3++.h>
 
+#include <optional>
+#include <utility>
+#include <vector>
+
 #include "backends/p4tools/common/lib/variables.h"
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_assignment.h"
 #include "backends/p4tools/modules/flay/core/lib/z3_cache.h"
@@ -14,6 +18,35 @@ namespace P4::P4Tools::Flay {
 class Z3ControlPlaneAssignmentSet
     : private ordered_map<std::reference_wrapper<const IR::SymbolicVariable>, z3::expr,
                           IR::IsSemanticallyLessComparator> {
+ public:
+    /// Conditional assignments of a set of variables, keyed by variable. Each variable is assigned
+    /// the value of its last case whose condition holds.
+    using SelectionCases =
+        ordered_map<std::reference_wrapper<const IR::SymbolicVariable>,
+                    std::vector<std::pair<z3::expr, z3::expr>>, IR::IsSemanticallyLessComparator>;
+
+ private:
+    /// Build the selection of the cases in [from, to). The selection falls back to @p fallback
+    /// if no condition holds. Without a fallback, one of the conditions is assumed to hold.
+    /// @returns the selection and the disjunction of the conditions of the cases.
+    static std::pair<z3::expr, z3::expr> buildSelection(
+        const std::vector<std::pair<z3::expr, z3::expr>> &cases, size_t from, size_t to,
+        const std::optional<z3::expr> &fallback) {
+        if (to - from == 1) {
+            const auto &[condition, assignment] = cases[from];
+            return {fallback.has_value() ? z3::ite(condition, assignment, fallback.value())
+                                         : assignment,
+                    condition};
+        }
+        // Later cases take precedence. If a case of the upper half matches, the lower half is not
+        // relevant. Otherwise, the lower half is, including the fallback.
+        auto middle = from + (to - from) / 2;
+        auto [upperSelection, upperCondition] = buildSelection(cases, middle, to, std::nullopt);
+        auto [lowerSelection, lowerCondition] = buildSelection(cases, from, middle, fallback);
+        return {z3::ite(upperCondition, upperSelection, lowerSelection),
+                lowerCondition || upperCondition};
+    }
+
  public:
     Z3ControlPlaneAssignmentSet() = default;
 
@@ -73,6 +106,17 @@ class Z3ControlPlaneAssignmentSet
                     IR::IsSemanticallyLessComparator>::clear();
     }
 
+    /// Append the variables of the set to @p substitutionVariables and their assignments to
+    /// @p substitutionAssignments, in the same order. Callers which substitute many expressions
+    /// under the same set should collect the vectors once.
+    void collectSubstitutions(z3::expr_vector &substitutionVariables,
+                              z3::expr_vector &substitutionAssignments) const {
+        for (const auto &match : *this) {
+            substitutionVariables.push_back(Z3Cache::set(&match.first.get()));
+            substitutionAssignments.push_back(match.second);
+        }
+    }
+
     /// Substitutes the given expression with the variables contained in the set.
     /// Use the context of the given expression to build the set.
     [[nodiscard]] z3::expr substitute(z3::expr &toSubstitute) const {
@@ -81,10 +125,7 @@ class Z3ControlPlaneAssignmentSet
         /// conflict.
         z3::expr_vector substitutionVariables(toSubstitute.ctx());
         z3::expr_vector substitutionAssignments(toSubstitute.ctx());
-        for (const auto &match : *this) {
-            substitutionVariables.push_back(Z3Cache::set(&match.first.get()));
-            substitutionAssignments.push_back(match.second);
-        }
+        collectSubstitutions(substitutionVariables, substitutionAssignments);
         return toSubstitute.substitute(substitutionVariables, substitutionAssignments).simplify();
     }
 
@@ -109,6 +150,35 @@ class Z3ControlPlaneAssignmentSet
         }
     }
 
+    /// Append the assignments of this set to @p cases, guarded by @p condition.
+    void appendSelectionCases(const z3::expr &condition, SelectionCases &cases) const {
+        for (const auto &match : *this) {
+            cases[match.first].emplace_back(condition, match.second);
+        }
+    }
+
+    /// Merges the selections in @p cases into this set. A variable which is already in the set
+    /// keeps its value if none of its conditions holds. Otherwise, its first case is used as
+    /// default, like in addConditionally. Equivalent to calling addConditionally for every case in
+    /// order, but the selection is built as a balanced tree and simplified once. The depth of the
+    /// result is logarithmic in the number of cases instead of linear.
+    void mergeSelections(const SelectionCases &cases) {
+        for (const auto &[var, variableCases] : cases) {
+            if (variableCases.empty()) {
+                continue;
+            }
+            auto it = find(var);
+            auto fallback = it == end() ? variableCases.front().second : it->second;
+            auto selection =
+                buildSelection(variableCases, 0, variableCases.size(), fallback).first.simplify();
+            if (it == end()) {
+                emplace(var, selection);
+            } else {
+                it->second = selection;
+            }
+        }
+    }
+
     /// Merges the other set into this one using the provided condition. Translate the expression in
     /// the other set into Z3.
     void mergeConditionally(const z3::expr &condition, const ControlPlaneAssignmentSet &other) {
@@ -2,9 +2,11 @@
 #define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_INTERPRETER_COMPILER_RESULT_H_
 
 #include <functional>
+#include <memory>
 
 #include "backends/p4tools/common/compiler/compiler_result.h"
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_item.h"
+#include "backends/p4tools/modules/flay/core/control_plane/p4info_index.h"
 #include "control-plane/p4RuntimeSerializer.h"
 
 namespace P4::P4Tools::Flay {
@@ -18,6 +20,9 @@ class FlayCompilerResult : public CompilerResult {
     /// The P4RuntimeAPI inferred from this particular  P4 program.
     P4::P4RuntimeAPI p4runtimeApi;
 
+    /// An index over the P4Info of the P4RuntimeAPI. Shared, since it is immutable.
+    std::shared_ptr<const P4InfoIndex> p4InfoIndex;
+
     /// The initial control plane state inferred from this particular P4 program.
     ControlPlaneConstraints defaultControlPlaneConstraints;
 
@@ -34,6 +39,9 @@ class FlayCompilerResult : public CompilerResult {
     /// @returns the P4RuntimeAPI inferred from this particular BMv2 V1Model P4 program.
     [[nodiscard]] const P4::P4RuntimeAPI &getP4RuntimeApi() const;
 
+    /// @returns the index over the P4Info of this particular P4 program.
+    [[nodiscard]] const P4InfoIndex &getP4InfoIndex() const;
+
     /// @returns the initial control plane state inferred from this particular P4 program.
     [[nodiscard]] const ControlPlaneConstraints &getDefaultControlPlaneConstraints() const;
 };
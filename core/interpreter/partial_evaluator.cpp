@@ -1,7 +1,11 @@
 #include "backends/p4tools/modules/flay/core/interpreter/partial_evaluator.h"
 
 #include <cstdlib>
+#include <map>
+#include <utility>
+#include <vector>
 
+#include "backends/p4tools/common/control_plane/symbolic_variables.h"
 #include "backends/p4tools/common/lib/logging.h"
 #include "backends/p4tools/modules/flay/core/control_plane/bfruntime/protobuf.h"
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_item.h"
@@ -10,6 +14,7 @@
 #include "backends/p4tools/modules/flay/core/interpreter/target.h"
 #include "backends/p4tools/modules/flay/core/lib/incremental_analysis.h"
 #include "backends/p4tools/modules/flay/core/lib/return_macros.h"
+#include "backends/p4tools/modules/flay/core/specialization/bdd/reachability_map.h"
 #include "backends/p4tools/modules/flay/core/specialization/passes/specializer.h"
 #include "backends/p4tools/modules/flay/core/specialization/z3/reachability_map.h"
 #include "backends/p4tools/modules/flay/core/specialization/z3/substitution_map.h"
@@ -46,14 +51,28 @@ std::string PartialEvaluationStatistics::toFormattedString() const {
 
 namespace {
 
-AbstractReachabilityMap *initializeReachabilityMap(ReachabilityMapType mapType,
-                                                   const NodeAnnotationMap &nodeAnnotationMap) {
+AbstractReachabilityMap *initializeReachabilityMap(const PartialEvaluationOptions &options,
+                                                   const NodeAnnotationMap &nodeAnnotationMap,
+                                                   const IR::P4Program &program) {
     printInfo("Creating the reachability map...");
+    auto mapType = options.mapType;
     AbstractReachabilityMap *initializedReachabilityMap = nullptr;
     if (mapType == ReachabilityMapType::kZ3Precomputed) {
-        initializedReachabilityMap = new Z3SolverReachabilityMap(nodeAnnotationMap);
+        initializedReachabilityMap = new Z3SolverReachabilityMap(
+            nodeAnnotationMap, program, options.solverBudgetMilliseconds);
+    } else if (mapType == ReachabilityMapType::kBdd) {
+        auto *bddReachabilityMap = new BddReachabilityMap(nodeAnnotationMap, program);
+        if (bddReachabilityMap->exceedsNodeBudget()) {
+            printInfo("The decision diagrams exceed %1% nodes, using the Z3 reachability map.",
+                      BddReachabilityMap::kMaxDiagramNodes);
+            delete bddReachabilityMap;
+            initializedReachabilityMap = new Z3SolverReachabilityMap(
+                nodeAnnotationMap, program, options.solverBudgetMilliseconds);
+        } else {
+            initializedReachabilityMap = bddReachabilityMap;
+        }
     } else {
-        initializedReachabilityMap = new IRReachabilityMap(nodeAnnotationMap);
+        initializedReachabilityMap = new IRReachabilityMap(nodeAnnotationMap, program);
     }
     return initializedReachabilityMap;
 }
@@ -62,7 +81,8 @@ AbstractSubstitutionMap *initializeSubstitutionMap(ReachabilityMapType mapType,
                                                    const NodeAnnotationMap &nodeAnnotationMap) {
     printInfo("Creating the substitution map...");
     AbstractSubstitutionMap *initializedSubstitutionMap = nullptr;
-    if (mapType == ReachabilityMapType::kZ3Precomputed) {
+    // The BDD reachability map decides its atoms with Z3 as well.
+    if (mapType == ReachabilityMapType::kZ3Precomputed || mapType == ReachabilityMapType::kBdd) {
         initializedSubstitutionMap = new Z3SolverSubstitutionMap(nodeAnnotationMap);
     } else {
         initializedSubstitutionMap = new IrSubstitutionMap(nodeAnnotationMap);
@@ -70,6 +90,21 @@ AbstractSubstitutionMap *initializeSubstitutionMap(ReachabilityMapType mapType,
     return initializedSubstitutionMap;
 }
 
+/// Collects the tables of a program.
+class TableCollector : public Inspector {
+    /// The collected tables.
+    std::vector<const IR::P4Table *> _tables;
+
+ public:
+    bool preorder(const IR::P4Table *table) override {
+        _tables.push_back(table);
+        return false;
+    }
+
+    /// @returns the collected tables.
+    [[nodiscard]] const std::vector<const IR::P4Table *> &tables() const { return _tables; }
+};
+
 }  // namespace
 
 AbstractReachabilityMap *PartialEvaluation::mutableReachabilityMap() { return _reachabilityMap; }
@@ -84,6 +119,170 @@ ControlPlaneConstraints &PartialEvaluation::mutableControlPlaneConstraints() {
     return _controlPlaneConstraints;
 }
 
+TableRelevanceIndex *PartialEvaluation::mutableTableRelevanceIndex() {
+    return _tableRelevanceIndex.has_value() ? &_tableRelevanceIndex.value() : nullptr;
+}
+
+void PartialEvaluation::computeSummarizedTables(const SymbolSet &referencedSymbols) {
+    // Count how many tables match on each data-plane symbol.
+    std::map<std::reference_wrapper<const IR::SymbolicVariable>, size_t,
+             IR::IsSemanticallyLessComparator>
+        keySymbolUses;
+    for (const auto &[name, controlPlaneItem] : _controlPlaneConstraints) {
+        if (const auto *tableConfiguration = controlPlaneItem.get().to<TableConfiguration>()) {
+            for (const auto &symbol : tableConfiguration->keySymbols()) {
+                keySymbolUses[symbol]++;
+            }
+        }
+    }
+    const auto &p4InfoIndex = flayCompilerResult().getP4InfoIndex();
+    for (const auto &[name, controlPlaneItem] : _controlPlaneConstraints) {
+        const auto *tableConfiguration = controlPlaneItem.get().to<TableConfiguration>();
+        const auto *table = p4InfoIndex.findTable(name);
+        if (tableConfiguration == nullptr || table == nullptr) {
+            continue;
+        }
+        bool isSummarized = true;
+        for (const auto &symbol : tableConfiguration->keySymbols()) {
+            isSummarized &= keySymbolUses[symbol] == 1 &&
+                            referencedSymbols.find(symbol) == referencedSymbols.end();
+        }
+        for (const auto &[actionId, action] : table->actions) {
+            for (const auto &[paramId, param] : action.params) {
+                isSummarized &=
+                    referencedSymbols.find(*param.argumentSymbol) == referencedSymbols.end();
+            }
+        }
+        if (isSummarized) {
+            _summarizedTables.insert(name);
+        }
+    }
+}
+
+void PartialEvaluation::collectConstantKeyCandidates(const IR::P4Program &program,
+                                                     const SubstitutionMap &substitutionMap) {
+    TableCollector tableCollector;
+    program.apply(tableCollector);
+    for (const auto *table : tableCollector.tables()) {
+        const auto *key = table->getKey();
+        if (key == nullptr) {
+            continue;
+        }
+        std::vector<std::pair<cstring, const IR::Expression *>> candidates;
+        for (const auto *keyField : key->keyElements) {
+            const auto *nameAnnot = keyField->getAnnotation(IR::Annotation::nameAnnotation);
+            const auto *keyExpression = keyField->expression;
+            // Only keys which the substitution map tracks can be proven constant.
+            if (nameAnnot == nullptr ||
+                !(keyExpression->is<IR::Member>() || keyExpression->is<IR::PathExpression>()) ||
+                !keyExpression->type->is<IR::Type_Bits>() ||
+                !keyExpression->getSourceInfo().isValid() ||
+                substitutionMap.find(keyExpression) == substitutionMap.end()) {
+                continue;
+            }
+            candidates.emplace_back(nameAnnot->getName(), keyExpression);
+        }
+        if (!candidates.empty()) {
+            _constantKeyCandidates[table->controlPlaneName()] = std::move(candidates);
+        }
+    }
+}
+
+SymbolSet PartialEvaluation::updateConstantTableKeys() {
+    SymbolSet changedSymbols;
+    const auto &p4InfoIndex = flayCompilerResult().getP4InfoIndex();
+    for (const auto &[tableName, candidates] : _constantKeyCandidates) {
+        auto it = _controlPlaneConstraints.find(tableName);
+        if (it == _controlPlaneConstraints.end()) {
+            continue;
+        }
+        auto *tableConfiguration = it->second.get().to<TableConfiguration>();
+        if (tableConfiguration == nullptr) {
+            continue;
+        }
+        std::map<cstring, const IR::Constant *> constantKeys;
+        for (const auto &[keyName, keyExpression] : candidates) {
+            auto literal = _substitutionMap->isExpressionConstant(keyExpression);
+            if (literal.has_value() && literal.value()->is<IR::Constant>()) {
+                constantKeys.emplace(keyName, literal.value()->checkedTo<IR::Constant>());
+            }
+        }
+        if (!tableConfiguration->setConstantKeys(constantKeys)) {
+            continue;
+        }
+        printInfo("Table %1% has %2% constant keys.", tableName, constantKeys.size());
+        // Pruning entries changes the action choice, the action arguments, and whether the table
+        // is hit at all.
+        changedSymbols.insert(*ControlPlaneState::getTableActive(tableName));
+        const auto *table = p4InfoIndex.findTable(tableName);
+        if (table == nullptr) {
+            continue;
+        }
+        changedSymbols.insert(*table->actionChoiceSymbol);
+        for (const auto &[actionId, action] : table->actions) {
+            for (const auto &[paramId, param] : action.params) {
+                changedSymbols.insert(*param.argumentSymbol);
+            }
+        }
+    }
+    return changedSymbols;
+}
+
+std::optional<bool> PartialEvaluation::propagateConstantTableKeys() {
+    bool hasChanged = false;
+    // Each round settles the keys of at least one more table in a chain of dependent tables.
+    for (size_t round = 0; round <= _constantKeyCandidates.size(); ++round) {
+        auto changedSymbols = updateConstantTableKeys();
+        if (changedSymbols.empty()) {
+            return hasChanged;
+        }
+        ASSIGN_OR_RETURN(auto reachabilityChanged,
+                         mutableReachabilityMap()->recomputeReachability(
+                             changedSymbols, controlPlaneConstraints()),
+                         std::nullopt);
+        ASSIGN_OR_RETURN(auto substitutionChanged,
+                         mutableSubstitutionMap()->recomputeSubstitution(
+                             changedSymbols, controlPlaneConstraints()),
+                         std::nullopt);
+        hasChanged = hasChanged || reachabilityChanged || substitutionChanged;
+    }
+    // The keys of tables which depend on each other did not settle. Pruning based on them may be
+    // unsound, so fall back to all entries.
+    warning("Constant table keys did not settle. Disabling entry pruning.");
+    for (const auto &[tableName, candidates] : _constantKeyCandidates) {
+        auto it = _controlPlaneConstraints.find(tableName);
+        if (it == _controlPlaneConstraints.end()) {
+            continue;
+        }
+        if (auto *tableConfiguration = it->second.get().to<TableConfiguration>()) {
+            tableConfiguration->setConstantKeys({});
+        }
+    }
+    _constantKeyCandidates.clear();
+    ASSIGN_OR_RETURN(auto reachabilityChanged, mutableReachabilityMap()->recomputeReachability(
+                                                   controlPlaneConstraints()),
+                     std::nullopt);
+    ASSIGN_OR_RETURN(auto substitutionChanged, mutableSubstitutionMap()->recomputeSubstitution(
+                                                   controlPlaneConstraints()),
+                     std::nullopt);
+    return hasChanged || reachabilityChanged || substitutionChanged;
+}
+
+bool PartialEvaluation::preservesActionSummary(cstring tableName) {
+    auto it = _controlPlaneConstraints.find(tableName);
+    if (it == _controlPlaneConstraints.end()) {
+        return false;
+    }
+    auto *tableConfiguration = it->second.get().to<TableConfiguration>();
+    if (tableConfiguration == nullptr) {
+        return false;
+    }
+    // Always consume the change, so the next update is judged on its own.
+    auto summaryChanged = tableConfiguration->consumeSummaryChange();
+    return !summaryChanged && _summarizedTables.find(tableName) != _summarizedTables.end() &&
+           tableConfiguration->isDeterminedByActionSummary();
+}
+
 std::optional<bool> PartialEvaluation::checkForSemanticsChange() {
     printInfo("Checking for change in program semantics...");
     Util::ScopedTimer timer("Check for semantics change");
@@ -98,7 +297,8 @@ std::optional<bool> PartialEvaluation::checkForSemanticsChange() {
     if (!substitutionResult.has_value()) {
         return std::nullopt;
     }
-    return reachabilityResult.value() || substitutionResult.value();
+    ASSIGN_OR_RETURN(auto constantKeysChanged, propagateConstantTableKeys(), std::nullopt);
+    return reachabilityResult.value() || substitutionResult.value() || constantKeysChanged;
 }
 
 std::optional<bool> PartialEvaluation::checkForSemanticsChange(const SymbolSet &symbolSet) {
@@ -115,7 +315,8 @@ std::optional<bool> PartialEvaluation::checkForSemanticsChange(const SymbolSet &
     if (!substitutionResult.has_value()) {
         return std::nullopt;
     }
-    return reachabilityResult.value() || substitutionResult.value();
+    ASSIGN_OR_RETURN(auto constantKeysChanged, propagateConstantTableKeys(), std::nullopt);
+    return reachabilityResult.value() || substitutionResult.value() || constantKeysChanged;
 }
 
 std::optional<const IR::P4Program *> PartialEvaluation::specializeProgram(
@@ -133,17 +334,30 @@ std::optional<const IR::P4Program *> PartialEvaluation::specializeProgram(
 std::optional<SymbolSet> PartialEvaluation::convertControlPlaneUpdate(
     const ControlPlaneUpdate &controlPlaneUpdate) {
     SymbolSet symbolSet;
+    // The table updated by a table entry message, if any.
+    const TableDescriptor *updatedTable = nullptr;
+    const auto &p4InfoIndex = flayCompilerResult().getP4InfoIndex();
     if (const auto *p4RuntimeUpdate = controlPlaneUpdate.to<P4RuntimeControlPlaneUpdate>()) {
+        if (p4RuntimeUpdate->update.entity().has_table_entry()) {
+            updatedTable =
+                p4InfoIndex.findTable(p4RuntimeUpdate->update.entity().table_entry().table_id());
+        }
         auto result = P4Runtime::updateControlPlaneConstraintsWithEntityMessage(
-            p4RuntimeUpdate->update.entity(), *flayCompilerResult().getP4RuntimeApi().p4Info,
-            _controlPlaneConstraints, p4RuntimeUpdate->update.type(), symbolSet);
+            p4RuntimeUpdate->update.entity(), flayCompilerResult().getP4InfoIndex(),
+            _controlPlaneConstraints, p4RuntimeUpdate->update.type(), symbolSet,
+            mutableTableRelevanceIndex());
         if (result != EXIT_SUCCESS) {
             return std::nullopt;
         }
     } else if (const auto *bfRuntimeUpdate = controlPlaneUpdate.to<BfRuntimeControlPlaneUpdate>()) {
+        if (bfRuntimeUpdate->update.entity().has_table_entry()) {
+            updatedTable =
+                p4InfoIndex.findTable(bfRuntimeUpdate->update.entity().table_entry().table_id());
+        }
         auto result = BfRuntime::updateControlPlaneConstraintsWithEntityMessage(
-            bfRuntimeUpdate->update.entity(), *flayCompilerResult().getP4RuntimeApi().p4Info,
-            _controlPlaneConstraints, bfRuntimeUpdate->update.type(), symbolSet);
+            bfRuntimeUpdate->update.entity(), flayCompilerResult().getP4InfoIndex(),
+            _controlPlaneConstraints, bfRuntimeUpdate->update.type(), symbolSet,
+            mutableTableRelevanceIndex());
         if (result != EXIT_SUCCESS) {
             return std::nullopt;
         }
@@ -151,6 +365,12 @@ std::optional<SymbolSet> PartialEvaluation::convertControlPlaneUpdate(
         error("Unknown control plane update type: %1%", typeid(controlPlaneUpdate).name());
         return std::nullopt;
     }
+    // Inserting or deleting an entry which keeps the set of installed actions intact can not
+    // change the program if the table is summarized. There is nothing to recompute.
+    if (updatedTable != nullptr && preservesActionSummary(updatedTable->name)) {
+        printInfo("Update to table %1% preserves its action summary.", updatedTable->name);
+        symbolSet.clear();
+    }
     return symbolSet;
 }
 
@@ -176,33 +396,59 @@ int PartialEvaluation::initialize() {
 
     printInfo("Starting data plane analysis...");
     Util::ScopedTimer timer("Data plane analysis");
-    const auto *pipelineSequence = programInfo().getPipelineSequence();
-    auto &stepper =
-        FlayTarget::getStepper(programInfo(), mutableControlPlaneConstraints(), executionState);
-    stepper.initializeState();
-    for (const auto *node : *pipelineSequence) {
-        node->apply(stepper);
+    {
+        ScopedMemoryPhase memoryPhase("analysis");
+        const auto *pipelineSequence = programInfo().getPipelineSequence();
+        auto &stepper =
+            FlayTarget::getStepper(programInfo(), mutableControlPlaneConstraints(), executionState);
+        stepper.initializeState();
+        for (const auto *node : *pipelineSequence) {
+            node->apply(stepper);
+        }
+        /// Substitute any placeholder variables encountered in the execution state.
+        printInfo("Substituting placeholder variables...");
+        executionState.substitutePlaceholders();
     }
-    /// Substitute any placeholder variables encountered in the execution state.
-    printInfo("Substituting placeholder variables...");
-    executionState.substitutePlaceholders();
 
     printInfo("Setting up analysis maps...");
-    _reachabilityMap = initializeReachabilityMap(_partialEvaluationOptions.get().mapType,
-                                                 executionState.nodeAnnotationMap());
+    ScopedMemoryPhase memoryPhase("map_construction");
+    _reachabilityMap = initializeReachabilityMap(_partialEvaluationOptions.get(),
+                                                 executionState.nodeAnnotationMap(),
+                                                 programInfo().getP4Program());
     _substitutionMap = initializeSubstitutionMap(_partialEvaluationOptions.get().mapType,
                                                  executionState.nodeAnnotationMap());
 
+    // Tables whose symbols appear in no condition can not influence the program.
+    SymbolSet referencedSymbols;
+    for (const auto &symbolMap : {executionState.nodeAnnotationMap().reachabilitySymbolMap(),
+                                  executionState.nodeAnnotationMap().expressionSymbolMap()}) {
+        for (const auto &[symbol, nodes] : symbolMap) {
+            referencedSymbols.insert(symbol);
+        }
+    }
+    _tableRelevanceIndex.emplace(flayCompilerResult().getP4InfoIndex(), referencedSymbols,
+                                 controlPlaneConstraints());
+    computeSummarizedTables(referencedSymbols);
+    collectConstantKeyCandidates(programInfo().getP4Program(),
+                                 executionState.nodeAnnotationMap().substitutionMap());
+    printInfo("%1% of %2% tables are referenced by the program.",
+              _tableRelevanceIndex->relevantTableCount(),
+              flayCompilerResult().getP4InfoIndex().p4Info().tables_size());
+
     printInfo("Precomputing reachability and substitution maps with initial constraints...");
     auto reachabilityResult = _reachabilityMap->recomputeReachability(controlPlaneConstraints());
     if (!reachabilityResult.has_value()) {
         return EXIT_FAILURE;
     }
+    printInfo("Skipped %1% reachability conditions below unreachable nodes, evaluated %2%.",
+              _reachabilityMap->hierarchy().skippedNodeCount(),
+              _reachabilityMap->hierarchy().evaluatedNodeCount());
     auto substitutionResult =
         mutableSubstitutionMap()->recomputeSubstitution(controlPlaneConstraints());
     if (!substitutionResult.has_value()) {
         return EXIT_FAILURE;
     }
+    RETURN_IF_FALSE(propagateConstantTableKeys().has_value(), EXIT_FAILURE);
     return EXIT_SUCCESS;
 }
 
@@ -210,4 +456,43 @@ int PartialEvaluation::initialize() {
     return new PartialEvaluationStatistics{_eliminatedNodes};
 }
 
+MemoryBreakdown PartialEvaluation::computeMemoryUsage() const {
+    MemoryBreakdown memoryUsage;
+    uint64_t constraintBytes = MemoryUsage::estimateContainerMemory(_controlPlaneConstraints);
+    for (const auto &[name, controlPlaneItem] : _controlPlaneConstraints) {
+        constraintBytes += controlPlaneItem.get().estimateMemoryUsage();
+    }
+    memoryUsage.emplace("control_plane_constraints", constraintBytes);
+    if (_reachabilityMap != nullptr) {
+        memoryUsage.emplace("reachability_map", _reachabilityMap->estimateMemoryUsage());
+    }
+    if (_substitutionMap != nullptr) {
+        memoryUsage.emplace("substitution_map", _substitutionMap->estimateMemoryUsage());
+    }
+    if (_tableRelevanceIndex.has_value()) {
+        memoryUsage.emplace("table_relevance_index", _tableRelevanceIndex->estimateMemoryUsage());
+    }
+    return memoryUsage;
+}
+
+TableEncodingCounts PartialEvaluation::computeTableEncodingCounts() const {
+    TableEncodingCounts tableEncodingCounts;
+    for (const auto &[name, controlPlaneItem] : _controlPlaneConstraints) {
+        if (const auto *tableConfiguration = controlPlaneItem.get().to<TableConfiguration>()) {
+            tableEncodingCounts[tableEncodingName(tableConfiguration->encoding())]++;
+        }
+    }
+    return tableEncodingCounts;
+}
+
+size_t PartialEvaluation::computeShadowedEntryCount() const {
+    size_t shadowedEntryCount = 0;
+    for (const auto &[name, controlPlaneItem] : _controlPlaneConstraints) {
+        if (const auto *tableConfiguration = controlPlaneItem.get().to<TableConfiguration>()) {
+            shadowedEntryCount += tableConfiguration->shadowedEntryCount();
+        }
+    }
+    return shadowedEntryCount;
+}
+
 }  // namespace P4::P4Tools::Flay
@@ -1,11 +1,17 @@
 #ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_INTERPRETER_PARTIAL_EVALUATOR_H_
 #define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_INTERPRETER_PARTIAL_EVALUATOR_H_
 
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
+#include <map>
 #include <optional>
+#include <set>
+#include <utility>
+#include <vector>
 
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_item.h"
+#include "backends/p4tools/modules/flay/core/control_plane/table_relevance_index.h"
 #include "backends/p4tools/modules/flay/core/interpreter/compiler_result.h"
 #include "backends/p4tools/modules/flay/core/interpreter/program_info.h"
 #include "backends/p4tools/modules/flay/core/lib/incremental_analysis.h"
@@ -17,11 +23,15 @@
 
 namespace P4::P4Tools::Flay {
 
-enum ReachabilityMapType { kZ3Precomputed, kDefault };
+enum ReachabilityMapType { kZ3Precomputed, kDefault, kBdd };
 
 struct PartialEvaluationOptions {
     /// The type of map to initialize.
     ReachabilityMapType mapType = ReachabilityMapType::kZ3Precomputed;
+
+    /// The time budget per node of the solver which checks the conditions that simplification
+    /// does not decide. Only used by the Z3 map. The solver is disabled if std::nullopt.
+    std::optional<uint64_t> solverBudgetMilliseconds = std::nullopt;
 };
 
 struct PartialEvaluationStatistics : public AnalysisStatistics {
@@ -56,6 +66,45 @@ class PartialEvaluation : public IncrementalAnalysis {
     /// The list of eliminated and optionally replaced nodes. Used for bookkeeping.
     std::vector<EliminatedReplacedPair> _eliminatedNodes;
 
+    /// Tracks which tables are referenced by the analysis maps. Updates to all other tables are
+    /// recorded without conversion. Set up once the maps have been created.
+    std::optional<TableRelevanceIndex> _tableRelevanceIndex;
+
+    /// @returns the table relevance index, or nullptr if it has not been set up yet.
+    TableRelevanceIndex *mutableTableRelevanceIndex();
+
+    /// Tables whose key symbols and action arguments appear in no condition and whose keys are
+    /// not shared with any other table. The reachability of the actions of these tables only
+    /// depends on their action summary, see TableConfiguration::isDeterminedByActionSummary.
+    std::set<cstring> _summarizedTables;
+
+    /// Collect the tables whose semantics are captured by their action summary.
+    void computeSummarizedTables(const SymbolSet &referencedSymbols);
+
+    /// The keys of each table which are program expressions the substitution map may prove
+    /// constant, keyed by table name. Each key is stored with its name. The table configuration
+    /// decides which kinds of keys it can prune entries by.
+    std::map<cstring, std::vector<std::pair<cstring, const IR::Expression *>>>
+        _constantKeyCandidates;
+
+    /// Collect the keys of the tables in @p program which appear in @p substitutionMap.
+    void collectConstantKeyCandidates(const IR::P4Program &program,
+                                      const SubstitutionMap &substitutionMap);
+
+    /// Pass the keys the substitution map proves constant on to the table configurations.
+    /// @returns the symbols of the tables whose constant keys changed.
+    SymbolSet updateConstantTableKeys();
+
+    /// Recompute the analysis maps for the tables whose constant keys changed until the constant
+    /// keys settle. The keys of a table may depend on the actions of another table.
+    /// @returns whether the maps changed or std::nullopt if the recomputation failed.
+    std::optional<bool> propagateConstantTableKeys();
+
+    /// @returns true if the last update of table @p tableName left its action summary unchanged
+    /// and the summary determines the semantics of the table. Resets the change tracking of the
+    /// table.
+    bool preservesActionSummary(cstring tableName);
+
     /// @returns a mutable reference reachability map.
     AbstractReachabilityMap *mutableReachabilityMap();
 
@@ -88,6 +137,12 @@ class PartialEvaluation : public IncrementalAnalysis {
 
     [[nodiscard]] PartialEvaluationStatistics *computeAnalysisStatistics() const override;
 
+    [[nodiscard]] MemoryBreakdown computeMemoryUsage() const override;
+
+    [[nodiscard]] TableEncodingCounts computeTableEncodingCounts() const override;
+
+    [[nodiscard]] size_t computeShadowedEntryCount() const override;
+
     DECLARE_TYPEINFO(PartialEvaluation);
 };
 
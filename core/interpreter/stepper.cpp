@@ -1,12 +1,15 @@
 #include "backends/p4tools/modules/flay/core/interpreter/stepper.h"
 
 #include <cstddef>
+#include <optional>
 #include <vector>
 
 #include "backends/p4tools/common/lib/arch_spec.h"
 #include "backends/p4tools/common/lib/variables.h"
+#include "backends/p4tools/modules/flay/core/control_plane/action_enumeration.h"
 #include "backends/p4tools/modules/flay/core/interpreter/expression_resolver.h"
 #include "backends/p4tools/modules/flay/core/interpreter/parser_stepper.h"
+#include "backends/p4tools/modules/flay/core/interpreter/table_executor.h"
 #include "backends/p4tools/modules/flay/core/interpreter/target.h"
 #include "backends/p4tools/modules/flay/core/lib/simplify_expression.h"
 #include "ir/id.h"
@@ -157,20 +160,28 @@ bool FlayStepper::preorder(const IR::IfStatement *ifStatement) {
 }
 
 bool FlayStepper::preorder(const IR::SwitchStatement *switchStatement) {
+    auto &executionState = getExecutionState();
     // Check whether this is a table switch-case first.
-    auto tableMode = false;
+    const IR::P4Table *switchTable = nullptr;
     if (const auto *member = switchStatement->expression->to<IR::Member>()) {
-        if (member->expr->is<IR::MethodCallExpression>() &&
-            member->member.name == IR::Type_Table::action_run) {
-            tableMode = true;
+        if (const auto *tableCall = member->expr->to<IR::MethodCallExpression>()) {
+            if (member->member.name == IR::Type_Table::action_run) {
+                switchTable = executionState.findTable(tableCall->method->checkedTo<IR::Member>());
+                BUG_CHECK(switchTable != nullptr, "Unable to find table of %1%.", tableCall);
+            }
         }
     }
 
-    auto &executionState = getExecutionState();
     // Resolve the switch match expression.
     auto &resolver = createExpressionResolver();
     const auto *switchExpr = resolver.computeResult(switchStatement->expression);
 
+    // All labels of a table switch are ordinals of the same enumeration of the table's actions.
+    std::optional<ActionEnumeration> actionEnumeration;
+    if (switchTable != nullptr) {
+        actionEnumeration = TableExecutor::computeActionEnumeration(*switchTable, executionState);
+    }
+
     const IR::Expression *cond = nullptr;
     std::vector<const IR::SwitchCase *> accumulatedSwitchCases;
     std::vector<std::reference_wrapper<const ExecutionState>> accumulatedStates;
@@ -181,10 +192,13 @@ bool FlayStepper::preorder(const IR::SwitchStatement *switchStatement) {
             break;
         }
         const auto *switchCaseLabel = switchCase->label;
-        // In table mode, we are actually comparing string expressions.
-        if (tableMode) {
+        // In table mode, we are actually comparing the ordinals of actions.
+        if (switchTable != nullptr) {
             const auto *path = switchCaseLabel->checkedTo<IR::PathExpression>();
-            switchCaseLabel = IR::StringLiteral::get(path->path->toString());
+            switchCaseLabel = TableExecutor::computeActionRunLabel(
+                *switchTable, executionState, actionEnumeration.value(), *path);
+            BUG_CHECK(switchCaseLabel != nullptr, "Action %1% is not an action of table %2%.", path,
+                      switchTable);
         }
         const auto *switchCaseEquality = new IR::Equ(switchExpr, switchCaseLabel);
         if (cond == nullptr) {
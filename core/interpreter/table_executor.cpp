@@ -2,6 +2,8 @@
 
 #include <cstddef>
 #include <cstdio>
+#include <utility>
+#include <vector>
 
 #include <boost/multiprecision/cpp_int.hpp>
 
@@ -162,11 +164,14 @@ void TableExecutor::processDefaultAction() const {
 
 void TableExecutor::processTableActionOptions(
     const TableUtils::TableProperties & /*tableProperties*/, const ExecutionState &referenceState,
-    ReturnProperties &tableReturnProperties) const {
+    const ActionEnumeration &actionEnumeration, ReturnProperties &tableReturnProperties) const {
     auto table = getP4Table();
     // auto tableActionList = TableUtils::buildTableActionList(table);
     auto &state = getExecutionState();
-    const auto *tableActionID = ControlPlaneState::getTableActionChoice(symbolicTablePrefix());
+    const auto *tableActionID =
+        ControlPlaneState::getActionChoiceVariable(symbolicTablePrefix(), actionEnumeration.type());
+    const auto *defaultActionID = ControlPlaneState::getDefaultActionVariable(
+        symbolicTablePrefix(), actionEnumeration.type());
     const auto *tableActive = ControlPlaneState::getTableActive(symbolicTablePrefix());
 
     const auto *actionList = table.getActionList();
@@ -179,7 +184,7 @@ void TableExecutor::processTableActionOptions(
         if (action->getAnnotation(IR::Annotation::defaultOnlyAnnotation) == nullptr) {
             const auto *actionType =
                 state.getP4Action(action->expression->checkedTo<IR::MethodCallExpression>());
-            const auto *actionLiteral = IR::StringLiteral::get(actionType->controlPlaneName());
+            const auto *actionLiteral = actionEnumeration.literal(actionType->controlPlaneName());
             tableReturnProperties.totalHitCondition = new IR::LOr(
                 tableReturnProperties.totalHitCondition, new IR::Equ(tableActionID, actionLiteral));
         }
@@ -190,7 +195,7 @@ void TableExecutor::processTableActionOptions(
     for (const auto *action : actionList->actionList) {
         const auto *actionType =
             state.getP4Action(action->expression->checkedTo<IR::MethodCallExpression>());
-        const auto *actionLiteral = IR::StringLiteral::get(actionType->controlPlaneName());
+        const auto *actionLiteral = actionEnumeration.literal(actionType->controlPlaneName());
 
         const IR::Expression *actionHitCondition = nullptr;
         /// Only actions not marked @defaultonly can be executed by the control plane.
@@ -207,10 +212,8 @@ void TableExecutor::processTableActionOptions(
             actionHitCondition = new IR::LOr(
                 actionHitCondition,
                 // We only match when the hitcondition is false.
-                new IR::LAnd(
-                    new IR::LNot(tableReturnProperties.totalHitCondition),
-                    new IR::Equ(ControlPlaneState::getDefaultActionVariable(symbolicTablePrefix()),
-                                actionLiteral)));
+                new IR::LAnd(new IR::LNot(tableReturnProperties.totalHitCondition),
+                             new IR::Equ(defaultActionID, actionLiteral)));
         }
         state.addReachabilityMapping(action, actionHitCondition);
         // We get the control plane name of the action we are calling.
@@ -224,13 +227,46 @@ void TableExecutor::processTableActionOptions(
         callAction(getProgramInfo(), controlPlaneConstraints(), actionState, actionType, arguments);
         // Finally, merge in the state of the action call.
         state.merge(actionState);
-        // We use action->controlPlaneName() here, NOT actionType. TODO: Clean this up?
+        // action_run is encoded by the ordinal of the action, like the action choice.
         tableReturnProperties.actionRun = SimplifyExpression::produceSimplifiedMux(
-            actionHitCondition, IR::StringLiteral::get(action->controlPlaneName()),
-            tableReturnProperties.actionRun);
+            actionHitCondition, actionLiteral, tableReturnProperties.actionRun);
     }
 }
 
+ActionEnumeration TableExecutor::computeActionEnumeration(const IR::P4Table &table,
+                                                          const ExecutionState &state) {
+    std::vector<cstring> actionNames;
+    const auto *actionList = table.getActionList();
+    if (actionList == nullptr) {
+        return ActionEnumeration(actionNames);
+    }
+    for (const auto *action : actionList->actionList) {
+        const auto *actionType =
+            state.getP4Action(action->expression->checkedTo<IR::MethodCallExpression>());
+        actionNames.push_back(actionType->controlPlaneName());
+    }
+    return ActionEnumeration(std::move(actionNames));
+}
+
+const IR::Constant *TableExecutor::computeActionRunLabel(const IR::P4Table &table,
+                                                         const ExecutionState &state,
+                                                         const ActionEnumeration &actionEnumeration,
+                                                         const IR::PathExpression &actionLabel) {
+    const auto *actionList = table.getActionList();
+    if (actionList == nullptr) {
+        return nullptr;
+    }
+    for (const auto *action : actionList->actionList) {
+        if (action->getName() != actionLabel.path->name) {
+            continue;
+        }
+        const auto *actionType =
+            state.getP4Action(action->expression->checkedTo<IR::MethodCallExpression>());
+        return actionEnumeration.literal(actionType->controlPlaneName());
+    }
+    return nullptr;
+}
+
 const IR::Expression *TableExecutor::processTable() {
     const auto &table = getP4Table();
     TableUtils::TableProperties properties;
@@ -243,9 +279,17 @@ const IR::Expression *TableExecutor::processTable() {
         tableKeyMap = computeHitCondition(*resolveKey(key));
     }
 
-    const auto *defaultActionPath = TableUtils::getDefaultActionName(table);
-    ReturnProperties tableReturnProperties{
-        IR::BoolLiteral::get(false), IR::StringLiteral::get(defaultActionPath->path->toString())};
+    const auto &state = getExecutionState();
+    // The action choice, the default action and action_run share one enumeration.
+    auto actionEnumeration = computeActionEnumeration(table, state);
+    const auto *defaultActionType =
+        state.getP4Action(table.getDefaultAction()->checkedTo<IR::MethodCallExpression>());
+    const auto *defaultActionLiteral =
+        actionEnumeration.literal(defaultActionType->controlPlaneName());
+    BUG_CHECK(defaultActionLiteral != nullptr,
+              "Default action %1% is not in the action list of table %2%.", defaultActionType,
+              table);
+    ReturnProperties tableReturnProperties{IR::BoolLiteral::get(false), defaultActionLiteral};
 
     const auto &referenceState = getExecutionState().clone();
 
@@ -253,7 +297,8 @@ const IR::Expression *TableExecutor::processTable() {
     processDefaultAction();
 
     // Execute all other possible action options. Get the combination of all possible hits.
-    processTableActionOptions(properties, referenceState, tableReturnProperties);
+    processTableActionOptions(properties, referenceState, actionEnumeration,
+                              tableReturnProperties);
     // Add the computed hit expression of the table to its control plane configuration.
     // We substitute this match later with concrete assignments.
     auto tableControlPlaneItem = controlPlaneConstraints().find(table.controlPlaneName());
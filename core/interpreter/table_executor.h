@@ -4,6 +4,7 @@
 #include <functional>
 
 #include "backends/p4tools/common/lib/table_utils.h"
+#include "backends/p4tools/modules/flay/core/control_plane/action_enumeration.h"
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
 #include "backends/p4tools/modules/flay/core/interpreter/execution_state.h"
 #include "backends/p4tools/modules/flay/core/interpreter/program_info.h"
@@ -41,9 +42,10 @@ class TableExecutor {
 
     /// Process all the possible actions in the table for which we could insert an entry.
     /// ReferenceState is the initial state of the table cloned before the default action was
-    /// executed.
+    /// executed. @p actionEnumeration is the enumeration of the actions of the table.
     void processTableActionOptions(const TableUtils::TableProperties &tableProperties,
                                    const ExecutionState &referenceState,
+                                   const ActionEnumeration &actionEnumeration,
                                    ReturnProperties &tableReturnProperties) const;
 
  protected:
@@ -80,6 +82,20 @@ class TableExecutor {
     /// Execute the table and @return the state after executing it (hit, action_run).
     const IR::Expression *processTable();
 
+    /// @returns the enumeration of the actions of @p table. The action choice, the default action,
+    /// and action_run of the table are encoded as ordinals of this enumeration.
+    static ActionEnumeration computeActionEnumeration(const IR::P4Table &table,
+                                                      const ExecutionState &state);
+
+    /// @returns the value of action_run of @p table if the table executed the action of the
+    /// switch label @p actionLabel, or nullptr if the table has no such action.
+    /// @p actionEnumeration must be the enumeration of the actions of @p table, which callers
+    /// compute once for all labels.
+    static const IR::Constant *computeActionRunLabel(const IR::P4Table &table,
+                                                     const ExecutionState &state,
+                                                     const ActionEnumeration &actionEnumeration,
+                                                     const IR::PathExpression &actionLabel);
+
     /// Helper function to call an action with arguments.
     static void callAction(const ProgramInfo &programInfo,
                            ControlPlaneConstraints &controlPlaneConstraints, ExecutionState &state,
@@ -110,43 +110,54 @@ std::optional<ControlPlaneConstraints> FlayTarget::computeControlPlaneConstraint
         return constraints;
     }
     auto confPath = options.controlPlaneConfig();
-    printInfo("Parsing initial control plane configuration...\n");
-    if (confPath.extension() == ".txtpb") {
+    printInfo("Parsing initial control plane configuration...");
+    auto format = Protobuf::formatFromExtension(confPath);
+    if (format.has_value()) {
         // By default we only support P4Runtime parsing.
         if (options.controlPlaneApi() == "P4RUNTIME") {
-            auto deserializedConfig =
-                Protobuf::deserializeObjectFromFile<p4::v1::WriteRequest>(confPath);
-            if (!deserializedConfig.has_value()) {
+            auto deserializedConfigs =
+                Protobuf::deserializeObjectsFromFile<p4::v1::WriteRequest>(confPath,
+                                                                           format.value());
+            if (!deserializedConfigs.has_value()) {
                 return std::nullopt;
             }
             SymbolSet symbolSet;
-            for (const auto &msg : deserializedConfig.value().updates()) {
-                if (P4Runtime::updateControlPlaneConstraintsWithEntityMessage(
-                        msg.entity(), *compilerResult.getP4RuntimeApi().p4Info, constraints,
-                        msg.type(), symbolSet) != EXIT_SUCCESS) {
-                    return std::nullopt;
+            size_t updateCount = 0;
+            for (const auto &deserializedConfig : deserializedConfigs.value()) {
+                for (const auto &msg : deserializedConfig.updates()) {
+                    if (P4Runtime::updateControlPlaneConstraintsWithEntityMessage(
+                            msg.entity(), compilerResult.getP4InfoIndex(), constraints,
+                            msg.type(), symbolSet) != EXIT_SUCCESS) {
+                        return std::nullopt;
+                    }
                 }
+                updateCount += deserializedConfig.updates().size();
             }
             printInfo("Parsed %1% control plane updates for the initial configuration.",
-                      deserializedConfig.value().updates().size());
+                      updateCount);
             return constraints;
         }
         if (options.controlPlaneApi() == "BFRUNTIME") {
-            auto deserializedConfig =
-                Protobuf::deserializeObjectFromFile<bfrt_proto::WriteRequest>(confPath);
-            if (!deserializedConfig.has_value()) {
+            auto deserializedConfigs =
+                Protobuf::deserializeObjectsFromFile<bfrt_proto::WriteRequest>(confPath,
+                                                                               format.value());
+            if (!deserializedConfigs.has_value()) {
                 return std::nullopt;
             }
             SymbolSet symbolSet;
-            for (const auto &msg : deserializedConfig.value().updates()) {
-                if (BfRuntime::updateControlPlaneConstraintsWithEntityMessage(
-                        msg.entity(), *compilerResult.getP4RuntimeApi().p4Info, constraints,
-                        msg.type(), symbolSet) != EXIT_SUCCESS) {
-                    return std::nullopt;
+            size_t updateCount = 0;
+            for (const auto &deserializedConfig : deserializedConfigs.value()) {
+                for (const auto &msg : deserializedConfig.updates()) {
+                    if (BfRuntime::updateControlPlaneConstraintsWithEntityMessage(
+                            msg.entity(), compilerResult.getP4InfoIndex(), constraints,
+                            msg.type(), symbolSet) != EXIT_SUCCESS) {
+                        return std::nullopt;
+                    }
                 }
+                updateCount += deserializedConfig.updates().size();
             }
             printInfo("Parsed %1% control plane updates for the initial configuration.",
-                      deserializedConfig.value().updates().size());
+                      updateCount);
             return constraints;
         }
     }
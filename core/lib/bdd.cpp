@@ -0,0 +1,121 @@
+#include "backends/p4tools/modules/flay/core/lib/bdd.h"
+
+#include <algorithm>
+
+namespace P4::P4Tools::Flay {
+
+BddManager::BddManager(size_t nodeBudget) : _nodeBudget(nodeBudget) {
+    _nodes.push_back({kConstantVariable, kFalse, kFalse});
+    _nodes.push_back({kConstantVariable, kTrue, kTrue});
+}
+
+BddManager::NodeId BddManager::makeNode(uint32_t variable, NodeId low, NodeId high) {
+    if (low == high) {
+        return low;
+    }
+    auto [it, inserted] =
+        _uniqueTable.try_emplace({variable, low, high}, static_cast<NodeId>(_nodes.size()));
+    if (inserted) {
+        _nodes.push_back({variable, low, high});
+    }
+    return it->second;
+}
+
+std::pair<BddManager::NodeId, BddManager::NodeId> BddManager::cofactors(NodeId node,
+                                                                        uint32_t variable) const {
+    const auto &bddNode = _nodes[node];
+    if (bddNode.variable != variable) {
+        return {node, node};
+    }
+    return {bddNode.low, bddNode.high};
+}
+
+uint32_t BddManager::createVariable() { return _variableCount++; }
+
+BddManager::NodeId BddManager::variable(uint32_t variable) {
+    return makeNode(variable, kFalse, kTrue);
+}
+
+BddManager::NodeId BddManager::ite(NodeId condition, NodeId thenNode, NodeId elseNode) {
+    if (condition == kTrue || thenNode == elseNode) {
+        return thenNode;
+    }
+    if (condition == kFalse) {
+        return elseNode;
+    }
+    if (thenNode == kTrue && elseNode == kFalse) {
+        return condition;
+    }
+    auto it = _iteCache.find({condition, thenNode, elseNode});
+    if (it != _iteCache.end()) {
+        return it->second;
+    }
+    // Unwind without creating nodes. The caller has to discard the result.
+    if (exceedsNodeBudget()) {
+        return kFalse;
+    }
+
+    // Split on the first variable of the three diagrams. The recursion may grow _nodes, so the
+    // nodes are not held by reference.
+    auto topVariable = std::min({_nodes[condition].variable, _nodes[thenNode].variable,
+                                 _nodes[elseNode].variable});
+    auto [conditionLow, conditionHigh] = cofactors(condition, topVariable);
+    auto [thenLow, thenHigh] = cofactors(thenNode, topVariable);
+    auto [elseLow, elseHigh] = cofactors(elseNode, topVariable);
+    auto low = ite(conditionLow, thenLow, elseLow);
+    auto high = ite(conditionHigh, thenHigh, elseHigh);
+    auto result = makeNode(topVariable, low, high);
+    _iteCache.emplace(std::make_tuple(condition, thenNode, elseNode), result);
+    return result;
+}
+
+BddManager::NodeId BddManager::conjunction(NodeId left, NodeId right) {
+    return ite(left, right, kFalse);
+}
+
+BddManager::NodeId BddManager::disjunction(NodeId left, NodeId right) {
+    return ite(left, kTrue, right);
+}
+
+BddManager::NodeId BddManager::negation(NodeId node) { return ite(node, kFalse, kTrue); }
+
+std::optional<bool> BddManager::evaluate(NodeId node, const Valuation &valuation,
+                                         EvaluationCache &cache) const {
+    if (node == kFalse || node == kTrue) {
+        return node == kTrue;
+    }
+    auto it = cache.find(node);
+    if (it != cache.end()) {
+        return it->second;
+    }
+    const auto &bddNode = _nodes[node];
+    std::optional<bool> result;
+    if (auto value = valuation(bddNode.variable)) {
+        result = evaluate(value.value() ? bddNode.high : bddNode.low, valuation, cache);
+    } else {
+        // The restricted diagram is constant only if both branches are the same constant. If the
+        // low branch is not constant, there is no need to look at the high branch.
+        auto lowResult = evaluate(bddNode.low, valuation, cache);
+        if (lowResult.has_value() &&
+            evaluate(bddNode.high, valuation, cache) == lowResult.value()) {
+            result = lowResult;
+        }
+    }
+    cache.emplace(node, result);
+    return result;
+}
+
+uint32_t BddManager::variableCount() const { return _variableCount; }
+
+size_t BddManager::size() const { return _nodes.size(); }
+
+bool BddManager::exceedsNodeBudget() const { return _nodes.size() > _nodeBudget; }
+
+uint64_t BddManager::estimateMemoryUsage() const {
+    // Swiss tables use one control byte per slot.
+    return _nodes.capacity() * sizeof(Node) +
+           _uniqueTable.capacity() * (sizeof(decltype(_uniqueTable)::value_type) + 1) +
+           _iteCache.capacity() * (sizeof(decltype(_iteCache)::value_type) + 1);
+}
+
+}  // namespace P4::P4Tools::Flay
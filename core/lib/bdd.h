@@ -0,0 +1,131 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_LIB_BDD_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_LIB_BDD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+
+namespace P4::P4Tools::Flay {
+
+/// A manager of reduced, ordered binary decision diagrams (BDDs). Variables are ordered by their
+/// index. All diagrams of a manager share their nodes and every boolean function has exactly one
+/// node, so two diagrams are equivalent if and only if they are the same node. In particular, a
+/// diagram is valid or unsatisfiable if and only if it is the true or false node.
+///
+/// Nodes are never freed. The manager is meant for a fixed set of functions which are built once
+/// and evaluated many times. Since diagrams can grow exponentially, the number of nodes can be
+/// bounded. Once the bound is exceeded, operations stop creating nodes and their results are
+/// meaningless, see exceedsNodeBudget.
+class BddManager {
+ public:
+    /// The index of a node of the manager.
+    using NodeId = uint32_t;
+
+    /// The node of the constant false function.
+    static constexpr NodeId kFalse = 0;
+
+    /// The node of the constant true function.
+    static constexpr NodeId kTrue = 1;
+
+    /// A partial assignment of the variables. Returns the value of a variable, or std::nullopt if
+    /// the variable is unassigned.
+    using Valuation = std::function<std::optional<bool>(uint32_t)>;
+
+    /// The evaluated nodes of a single valuation, see evaluate.
+    using EvaluationCache = absl::flat_hash_map<NodeId, std::optional<bool>>;
+
+ private:
+    /// An inner node. Constant nodes use kConstantVariable.
+    struct Node {
+        /// The variable tested by the node.
+        uint32_t variable;
+
+        /// The node if the variable is false.
+        NodeId low;
+
+        /// The node if the variable is true.
+        NodeId high;
+    };
+
+    /// The variable of the constant nodes, which is ordered after all other variables.
+    static constexpr uint32_t kConstantVariable = UINT32_MAX;
+
+    /// All nodes, indexed by their id.
+    std::vector<Node> _nodes;
+
+    /// The id of every inner node, keyed by its variable and children.
+    absl::flat_hash_map<std::tuple<uint32_t, NodeId, NodeId>, NodeId> _uniqueTable;
+
+    /// The results of ite, keyed by its arguments.
+    absl::flat_hash_map<std::tuple<NodeId, NodeId, NodeId>, NodeId> _iteCache;
+
+    /// The number of created variables.
+    uint32_t _variableCount = 0;
+
+    /// The maximum number of nodes.
+    size_t _nodeBudget;
+
+    /// @returns the node which tests @p variable, which must precede the variables of both
+    /// children. Reuses an existing node and skips the test if both children are the same.
+    NodeId makeNode(uint32_t variable, NodeId low, NodeId high);
+
+    /// @returns the low and high child of @p node with respect to @p variable. Both are the node
+    /// itself if it does not test the variable.
+    [[nodiscard]] std::pair<NodeId, NodeId> cofactors(NodeId node, uint32_t variable) const;
+
+ public:
+    explicit BddManager(size_t nodeBudget = std::numeric_limits<size_t>::max());
+
+    /// Create a new variable, which is ordered after all existing variables.
+    /// @returns the index of the variable.
+    uint32_t createVariable();
+
+    /// @returns the diagram of @p variable.
+    NodeId variable(uint32_t variable);
+
+    /// @returns the diagram of "if @p condition then @p thenNode else @p elseNode".
+    NodeId ite(NodeId condition, NodeId thenNode, NodeId elseNode);
+
+    /// @returns the conjunction of @p left and @p right.
+    NodeId conjunction(NodeId left, NodeId right);
+
+    /// @returns the disjunction of @p left and @p right.
+    NodeId disjunction(NodeId left, NodeId right);
+
+    /// @returns the negation of @p node.
+    NodeId negation(NodeId node);
+
+    /// Evaluate @p node under the partial assignment @p valuation. The result is true or false if
+    /// the diagram restricted to the assigned variables is constant, i.e., if the assigned
+    /// variables decide the function for all values of the unassigned variables. Only variables
+    /// on paths which are not decided yet are requested from the valuation.
+    /// @p cache memoizes the evaluated nodes and can be shared by all evaluations with the same
+    /// valuation.
+    /// @returns std::nullopt if the function still depends on unassigned variables.
+    [[nodiscard]] std::optional<bool> evaluate(NodeId node, const Valuation &valuation,
+                                               EvaluationCache &cache) const;
+
+    /// @returns the number of created variables.
+    [[nodiscard]] uint32_t variableCount() const;
+
+    /// @returns the number of nodes, including the two constant nodes.
+    [[nodiscard]] size_t size() const;
+
+    /// @returns true if the manager holds more nodes than its budget. All diagrams built since
+    /// then are invalid.
+    [[nodiscard]] bool exceedsNodeBudget() const;
+
+    /// @returns the approximate number of bytes held by the manager.
+    [[nodiscard]] uint64_t estimateMemoryUsage() const;
+};
+
+}  // namespace P4::P4Tools::Flay
+
+#endif  // BACKENDS_P4TOOLS_MODULES_FLAY_CORE_LIB_BDD_H_
@@ -0,0 +1,496 @@
+#include "backends/p4tools/modules/flay/core/lib/egraph.h"
+
+#include <functional>
+#include <string>
+
+#include "absl/container/flat_hash_set.h"
+#include "backends/p4tools/modules/flay/core/lib/expression_strength_reduction.h"
+#include "ir/compare.h"
+
+namespace P4::P4Tools {
+
+namespace {
+
+/// @returns @p left + @p right, or UINT64_MAX on overflow.
+uint64_t saturatingAdd(uint64_t left, uint64_t right) {
+    return left > UINT64_MAX - right ? UINT64_MAX : left + right;
+}
+
+/// @returns true if @p type is a bit vector of width zero.
+bool isZeroWidth(const IR::Type *type) {
+    const auto *bitType = type == nullptr ? nullptr : type->to<IR::Type_Bits>();
+    return bitType != nullptr && bitType->width_bits() == 0;
+}
+
+/// @returns true if @p type is known, i.e., not missing and not unknown.
+bool isKnownType(const IR::Type *type) {
+    return type != nullptr && !type->is<IR::Type_Unknown>();
+}
+
+}  // namespace
+
+/**************************************************************************************************
+Nodes and classes
+**************************************************************************************************/
+
+bool EGraph::ENodeLess::operator()(const ENode &left, const ENode &right) const {
+    if (left.children.empty() != right.children.empty()) {
+        return left.children.empty();
+    }
+    if (left.children.empty()) {
+        return IR::IsSemanticallyLessComparator()(left.expr, right.expr);
+    }
+    auto leftName = left.expr->node_type_name().string_view();
+    auto rightName = right.expr->node_type_name().string_view();
+    if (leftName != rightName) {
+        return leftName < rightName;
+    }
+    if (left.children != right.children) {
+        return left.children < right.children;
+    }
+    const auto *leftType = left.expr->type;
+    const auto *rightType = right.expr->type;
+    if (leftType == rightType || leftType == nullptr || rightType == nullptr) {
+        return leftType == nullptr && rightType != nullptr;
+    }
+    return IR::IsSemanticallyLessComparator()(leftType, rightType);
+}
+
+std::optional<std::vector<const IR::Expression *>> EGraph::operands(const IR::Expression *expr) {
+    if (expr->is<IR::LNot>() || expr->is<IR::Cmpl>() || expr->is<IR::Neg>() ||
+        expr->is<IR::UPlus>()) {
+        return std::vector<const IR::Expression *>{expr->to<IR::Operation_Unary>()->expr};
+    }
+    if (expr->is<IR::LAnd>() || expr->is<IR::LOr>() || expr->is<IR::Operation_Relation>() ||
+        expr->is<IR::BAnd>() || expr->is<IR::BOr>() || expr->is<IR::BXor>() ||
+        expr->is<IR::Add>() || expr->is<IR::Sub>() || expr->is<IR::Mul>() ||
+        expr->is<IR::Div>() || expr->is<IR::Mod>() || expr->is<IR::Shl>() ||
+        expr->is<IR::Shr>() || expr->is<IR::Concat>() || expr->is<IR::Mask>() ||
+        expr->is<IR::Range>()) {
+        const auto *binary = expr->to<IR::Operation_Binary>();
+        return std::vector<const IR::Expression *>{binary->left, binary->right};
+    }
+    if (const auto *mux = expr->to<IR::Mux>()) {
+        return std::vector<const IR::Expression *>{mux->e0, mux->e1, mux->e2};
+    }
+    return std::nullopt;
+}
+
+const IR::Expression *EGraph::withOperands(
+    const IR::Expression *expr, const std::vector<const IR::Expression *> &exprOperands) {
+    auto *clonedExpr = expr->clone();
+    if (auto *unary = clonedExpr->to<IR::Operation_Unary>()) {
+        unary->expr = exprOperands[0];
+    } else if (auto *binary = clonedExpr->to<IR::Operation_Binary>()) {
+        binary->left = exprOperands[0];
+        binary->right = exprOperands[1];
+    } else if (auto *ternary = clonedExpr->to<IR::Operation_Ternary>()) {
+        ternary->e0 = exprOperands[0];
+        ternary->e1 = exprOperands[1];
+        ternary->e2 = exprOperands[2];
+    }
+    return clonedExpr->to<IR::Expression>();
+}
+
+bool EGraph::isCommutative(const IR::Expression *expr) {
+    return expr->is<IR::LAnd>() || expr->is<IR::LOr>() || expr->is<IR::BAnd>() ||
+           expr->is<IR::BOr>() || expr->is<IR::BXor>() || expr->is<IR::Add>() ||
+           expr->is<IR::Mul>() || expr->is<IR::Equ>() || expr->is<IR::Neq>();
+}
+
+EGraph::EClassId EGraph::find(EClassId id) {
+    while (_unionFind[id] != id) {
+        _unionFind[id] = _unionFind[_unionFind[id]];
+        id = _unionFind[id];
+    }
+    return id;
+}
+
+EGraph::ENode EGraph::canonicalize(ENode node) {
+    for (auto &child : node.children) {
+        child = find(child);
+    }
+    return node;
+}
+
+EGraph::EClassId EGraph::add(ENode node) {
+    node = canonicalize(std::move(node));
+    auto it = _nodeClasses.find(node);
+    if (it != _nodeClasses.end()) {
+        return find(it->second);
+    }
+    auto id = static_cast<EClassId>(_classes.size());
+    _unionFind.push_back(id);
+    for (auto child : node.children) {
+        _classes[child].parents.emplace_back(node, id);
+    }
+    _classes.push_back(EClass{{node}, {}, node.expr->type});
+    _nodeClasses.emplace(std::move(node), id);
+    _nodeCount++;
+    return id;
+}
+
+EGraph::EClassId EGraph::addExpression(
+    const IR::Expression *expr, absl::flat_hash_map<const IR::Expression *, EClassId> &addedExprs) {
+    auto it = addedExprs.find(expr);
+    if (it != addedExprs.end()) {
+        return find(it->second);
+    }
+    std::vector<EClassId> children;
+    auto exprOperands = operands(expr);
+    if (exprOperands.has_value()) {
+        for (const auto *operand : exprOperands.value()) {
+            children.push_back(addExpression(operand, addedExprs));
+        }
+    }
+    auto id = add(ENode{expr, std::move(children)});
+    addedExprs.emplace(expr, id);
+    return id;
+}
+
+bool EGraph::merge(EClassId left, EClassId right) {
+    left = find(left);
+    right = find(right);
+    if (left == right) {
+        return false;
+    }
+    // Merge the smaller class into the larger one.
+    if (_classes[left].nodes.size() + _classes[left].parents.size() <
+        _classes[right].nodes.size() + _classes[right].parents.size()) {
+        std::swap(left, right);
+    }
+    _unionFind[right] = left;
+    auto &into = _classes[left];
+    auto &from = _classes[right];
+    into.nodes.insert(into.nodes.end(), from.nodes.begin(), from.nodes.end());
+    into.parents.insert(into.parents.end(), from.parents.begin(), from.parents.end());
+    if (!isKnownType(into.type)) {
+        into.type = from.type;
+    }
+    from.nodes = {};
+    from.parents = {};
+    _pendingClasses.push_back(left);
+    return true;
+}
+
+void EGraph::rebuild() {
+    while (!_pendingClasses.empty()) {
+        auto pendingClasses = std::move(_pendingClasses);
+        _pendingClasses.clear();
+        absl::flat_hash_set<EClassId> repairedClasses;
+        for (auto id : pendingClasses) {
+            id = find(id);
+            if (repairedClasses.insert(id).second) {
+                repair(id);
+            }
+        }
+    }
+}
+
+void EGraph::repair(EClassId id) {
+    auto parents = std::move(_classes[id].parents);
+    _classes[id].parents.clear();
+    for (auto &[node, parentId] : parents) {
+        _nodeClasses.erase(node);
+        node = canonicalize(std::move(node));
+        _nodeClasses.insert_or_assign(node, find(parentId));
+    }
+    // Parents which became equal are congruent, their classes are equivalent.
+    std::map<ENode, EClassId, ENodeLess> uniqueParents;
+    for (auto &[node, parentId] : parents) {
+        auto [it, inserted] = uniqueParents.emplace(canonicalize(node), find(parentId));
+        if (!inserted) {
+            merge(it->second, parentId);
+            it->second = find(parentId);
+        }
+    }
+    auto &eclass = _classes[find(id)];
+    for (auto &[node, parentId] : uniqueParents) {
+        eclass.parents.emplace_back(node, parentId);
+    }
+}
+
+/**************************************************************************************************
+Rules
+**************************************************************************************************/
+
+const IR::Constant *EGraph::constant(EClassId id) {
+    for (const auto &node : _classes[find(id)].nodes) {
+        if (const auto *constant = node.expr->to<IR::Constant>()) {
+            return constant;
+        }
+    }
+    return nullptr;
+}
+
+std::optional<bool> EGraph::boolValue(EClassId id) {
+    for (const auto &node : _classes[find(id)].nodes) {
+        if (const auto *boolLiteral = node.expr->to<IR::BoolLiteral>()) {
+            return boolLiteral->value;
+        }
+    }
+    return std::nullopt;
+}
+
+bool EGraph::isZero(EClassId id) {
+    if (isZeroWidth(_classes[find(id)].type)) {
+        return true;
+    }
+    const auto *constant = this->constant(id);
+    return constant != nullptr && constant->value == 0;
+}
+
+const IR::Expression *EGraph::placeholder(
+    EClassId id, absl::flat_hash_map<const IR::Expression *, EClassId> &addedExprs) {
+    id = find(id);
+    // Literals are matched by the rules, so a class with a literal is represented by it.
+    const IR::Expression *expr = nullptr;
+    for (const auto &node : _classes[id].nodes) {
+        if (node.expr->is<IR::Constant>() || node.expr->is<IR::BoolLiteral>()) {
+            expr = node.expr;
+            break;
+        }
+    }
+    if (expr == nullptr) {
+        auto it = _placeholders.find(id);
+        if (it == _placeholders.end()) {
+            const auto *type =
+                isKnownType(_classes[id].type) ? _classes[id].type : IR::Type_Unknown::get();
+            const auto *path = new IR::Path(IR::ID(cstring("__eclass_" + std::to_string(id))));
+            it = _placeholders.emplace(id, new IR::PathExpression(type, path)).first;
+        }
+        expr = it->second;
+    }
+    addedExprs.emplace(expr, id);
+    return expr;
+}
+
+std::vector<const IR::Expression *> EGraph::operandForms(
+    EClassId id, absl::flat_hash_map<const IR::Expression *, EClassId> &addedExprs) {
+    id = find(id);
+    std::vector<const IR::Expression *> forms = {placeholder(id, addedExprs)};
+    for (const auto &node : _classes[id].nodes) {
+        if (forms.size() > kMaxOperandForms) {
+            break;
+        }
+        // The rules only look into complements, negations, relations and shifts.
+        const auto *expr = node.expr;
+        if (node.children.empty() ||
+            !(expr->is<IR::Cmpl>() || expr->is<IR::LNot>() || expr->is<IR::Operation_Relation>() ||
+              expr->is<IR::Shl>() || expr->is<IR::Shr>())) {
+            continue;
+        }
+        std::vector<const IR::Expression *> nodeOperands;
+        for (auto child : node.children) {
+            nodeOperands.push_back(placeholder(child, addedExprs));
+        }
+        forms.push_back(withOperands(expr, nodeOperands));
+    }
+    return forms;
+}
+
+bool EGraph::applyStrengthReduction(EClassId id, const ENode &node) {
+    absl::flat_hash_map<const IR::Expression *, EClassId> addedExprs;
+    std::vector<std::vector<const IR::Expression *>> forms;
+    for (auto child : node.children) {
+        forms.push_back(operandForms(child, addedExprs));
+    }
+    ExpressionStrengthReduction strengthReduction;
+    bool changed = false;
+    std::vector<size_t> formIndices(forms.size(), 0);
+    while (true) {
+        std::vector<const IR::Expression *> exprOperands;
+        for (size_t idx = 0; idx < forms.size(); ++idx) {
+            exprOperands.push_back(forms[idx][formIndices[idx]]);
+        }
+        // An unchanged expression is found in the class of the node and adds nothing.
+        const auto *result = withOperands(node.expr, exprOperands)->apply(strengthReduction);
+        changed |= merge(id, addExpression(result->checkedTo<IR::Expression>(), addedExprs));
+        // Advance to the next combination of forms.
+        size_t idx = 0;
+        while (idx < formIndices.size() && ++formIndices[idx] == forms[idx].size()) {
+            formIndices[idx++] = 0;
+        }
+        if (idx == formIndices.size()) {
+            return changed;
+        }
+    }
+}
+
+bool EGraph::applyRules(EClassId id, const ENode &node) {
+    // Operations may add classes, so neither classes nor their nodes are held by reference.
+    const auto *expr = node.expr;
+    const auto &children = node.children;
+    bool changed = false;
+
+    if (isCommutative(expr)) {
+        changed |= merge(id, add(ENode{expr, {children[1], children[0]}}));
+    }
+
+    // The rules below are not part of ExpressionStrengthReduction.
+    if (expr->is<IR::LNot>()) {
+        auto value = boolValue(children[0]);
+        if (value.has_value()) {
+            changed |= merge(id, add(ENode{IR::BoolLiteral::get(!value.value(), expr->srcInfo)}));
+        }
+    } else if (expr->is<IR::LAnd>() || expr->is<IR::LOr>()) {
+        if (children[0] == children[1]) {
+            changed |= merge(id, children[0]);
+        }
+    } else if (expr->is<IR::Div>() || expr->is<IR::Mod>()) {
+        // Division by zero is an error, which is left to the other passes.
+        if (isZero(children[1])) {
+            return changed;
+        }
+    } else if (expr->is<IR::Mux>()) {
+        auto condValue = boolValue(children[0]);
+        if (condValue.has_value()) {
+            changed |= merge(id, condValue.value() ? children[1] : children[2]);
+        }
+    }
+    changed |= applyStrengthReduction(id, node);
+    return changed;
+}
+
+bool EGraph::saturate() {
+    for (size_t iteration = 0; iteration < kMaxIterations; ++iteration) {
+        // Rules add nodes, so they are applied to a snapshot of the nodes.
+        std::vector<std::pair<EClassId, ENode>> nodes;
+        for (EClassId id = 0; id < _classes.size(); ++id) {
+            if (find(id) != id) {
+                continue;
+            }
+            for (const auto &node : _classes[id].nodes) {
+                nodes.emplace_back(id, canonicalize(node));
+            }
+        }
+        auto nodeCount = _nodeCount;
+        bool changed = false;
+        for (const auto &[id, node] : nodes) {
+            if (node.children.empty()) {
+                continue;
+            }
+            changed |= applyRules(id, node);
+            if (_nodeCount > kMaxNodes) {
+                break;
+            }
+        }
+        rebuild();
+        if (!changed && nodeCount == _nodeCount) {
+            return true;
+        }
+        if (_nodeCount > kMaxNodes) {
+            return false;
+        }
+    }
+    return false;
+}
+
+/**************************************************************************************************
+Extraction
+**************************************************************************************************/
+
+std::pair<const IR::Expression *, uint64_t> EGraph::extract(EClassId root) {
+    // Compute the smallest size of every class until no size improves.
+    std::vector<uint64_t> costs(_classes.size(), UINT64_MAX);
+    std::vector<const ENode *> bestNodes(_classes.size(), nullptr);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (EClassId id = 0; id < _classes.size(); ++id) {
+            if (find(id) != id) {
+                continue;
+            }
+            for (const auto &node : _classes[id].nodes) {
+                uint64_t cost = 1;
+                for (auto child : node.children) {
+                    cost = saturatingAdd(cost, costs[find(child)]);
+                }
+                if (cost < costs[id]) {
+                    costs[id] = cost;
+                    bestNodes[id] = &node;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // Build the expression. Every class is built once, so shared classes are shared operands.
+    absl::flat_hash_map<EClassId, const IR::Expression *> builtExprs;
+    std::function<const IR::Expression *(EClassId)> build = [&](EClassId id) {
+        id = find(id);
+        auto it = builtExprs.find(id);
+        if (it != builtExprs.end()) {
+            return it->second;
+        }
+        const auto *node = bestNodes[id];
+        BUG_CHECK(node != nullptr, "E-graph class %1% has no finite expression.", id);
+        const IR::Expression *result = node->expr;
+        if (!node->children.empty()) {
+            std::vector<const IR::Expression *> builtOperands;
+            for (auto child : node->children) {
+                builtOperands.push_back(build(child));
+            }
+            // Reuse the original expression if its operands are unchanged.
+            if (operands(node->expr).value() != builtOperands) {
+                result = withOperands(node->expr, builtOperands);
+            }
+        }
+        builtExprs.emplace(id, result);
+        return result;
+    };
+    return {build(root), costs[find(root)]};
+}
+
+uint64_t EGraph::treeSize(const IR::Expression *expr) {
+    absl::flat_hash_map<const IR::Expression *, uint64_t> sizes;
+    std::function<uint64_t(const IR::Expression *)> size = [&](const IR::Expression *expr) {
+        auto it = sizes.find(expr);
+        if (it != sizes.end()) {
+            return it->second;
+        }
+        uint64_t result = 1;
+        auto exprOperands = operands(expr);
+        if (exprOperands.has_value()) {
+            for (const auto *operand : exprOperands.value()) {
+                result = saturatingAdd(result, size(operand));
+            }
+        }
+        sizes.emplace(expr, result);
+        return result;
+    };
+    return size(expr);
+}
+
+/**************************************************************************************************
+Simplification
+**************************************************************************************************/
+
+EGraphStatistics &EGraph::mutableStatistics() {
+    static EGraphStatistics STATISTICS;
+    return STATISTICS;
+}
+
+const EGraphStatistics &EGraph::statistics() { return mutableStatistics(); }
+
+const IR::Expression *EGraph::simplify(const IR::Expression *expr) {
+    EGraph egraph;
+    absl::flat_hash_map<const IR::Expression *, EClassId> addedExprs;
+    auto root = egraph.addExpression(expr, addedExprs);
+    auto saturated = egraph.saturate();
+    auto [result, resultSize] = egraph.extract(root);
+    auto inputSize = treeSize(expr);
+    if (resultSize >= inputSize) {
+        result = expr;
+        resultSize = inputSize;
+    }
+
+    auto &statistics = mutableStatistics();
+    statistics.expressionCount++;
+    statistics.saturatedCount += saturated ? 1 : 0;
+    statistics.inputNodeCount = saturatingAdd(statistics.inputNodeCount, inputSize);
+    statistics.outputNodeCount = saturatingAdd(statistics.outputNodeCount, resultSize);
+    return result;
+}
+
+}  // namespace P4::P4Tools
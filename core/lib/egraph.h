@@ -0,0 +1,193 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_LIB_EGRAPH_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_LIB_EGRAPH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "ir/ir.h"
+
+namespace P4::P4Tools {
+
+/// Statistics of the expressions simplified with an e-graph.
+struct EGraphStatistics {
+    /// The number of simplified expressions.
+    uint64_t expressionCount = 0;
+
+    /// The number of expressions whose e-graph was saturated within the bounds.
+    uint64_t saturatedCount = 0;
+
+    /// The total size of the simplified expressions, counted as trees.
+    uint64_t inputNodeCount = 0;
+
+    /// The total size of the results, counted as trees.
+    uint64_t outputNodeCount = 0;
+};
+
+/// An e-graph over P4 expressions, which simplifies expressions by equality saturation.
+///
+/// An e-graph represents many equivalent expressions at once. Its classes are sets of
+/// equivalent expressions and its nodes are operators whose operands are classes. The rewrite
+/// rules of ExpressionStrengthReduction, the logic rules of the Mux folding and commutativity are
+/// applied to all nodes until no rule adds anything new, or the bounds are exceeded. Since
+/// rewriting only adds equalities and never replaces a term, the result does not depend on the
+/// order of the rules and rules can build on each other's results. Finally, the smallest
+/// expression of the class of the input is extracted.
+///
+/// The rules of ExpressionStrengthReduction are not duplicated. The pass itself is applied to
+/// every node, instantiated with the forms of its operands the rules inspect, and its result is
+/// added to the class of the node.
+///
+/// Only the arithmetic, bitwise, logical and relational operators and Mux are rewritten. All
+/// other expressions, e.g., members, casts and slices, are treated as opaque leaves.
+class EGraph {
+ public:
+    /// The index of a class.
+    using EClassId = uint32_t;
+
+    /// The maximum number of rounds in which all rules are applied.
+    static constexpr size_t kMaxIterations = 8;
+
+    /// The maximum number of nodes. Saturation stops once there are more.
+    static constexpr size_t kMaxNodes = 1 << 14;
+
+    /// The maximum number of operators of an operand class which ExpressionStrengthReduction is
+    /// applied to.
+    static constexpr size_t kMaxOperandForms = 4;
+
+ private:
+    /// A node of the e-graph.
+    struct ENode {
+        /// For an operator, an expression of the operator and its type. Its operands are
+        /// ignored. For a leaf, the expression itself.
+        const IR::Expression *expr;
+
+        /// The classes of the operands. Empty for leaves.
+        std::vector<EClassId> children;
+    };
+
+    /// Orders nodes by operator, operands and type. Leaves are compared structurally.
+    struct ENodeLess {
+        bool operator()(const ENode &left, const ENode &right) const;
+    };
+
+    /// A class of equivalent expressions.
+    struct EClass {
+        /// The nodes of the class. Their operands may not be canonical.
+        std::vector<ENode> nodes;
+
+        /// The nodes which have this class as operand, with the class they belong to.
+        std::vector<std::pair<ENode, EClassId>> parents;
+
+        /// The type of the expressions of the class.
+        const IR::Type *type;
+    };
+
+    /// The union-find forest of the classes. A class is canonical if it is its own parent.
+    std::vector<EClassId> _unionFind;
+
+    /// All classes, indexed by their id. Only canonical classes have nodes.
+    std::vector<EClass> _classes;
+
+    /// The class of every node, which makes nodes unique.
+    std::map<ENode, EClassId, ENodeLess> _nodeClasses;
+
+    /// The classes whose parents have to be repaired after merges.
+    std::vector<EClassId> _pendingClasses;
+
+    /// The number of created nodes.
+    size_t _nodeCount = 0;
+
+    /// The leaves which stand for classes when ExpressionStrengthReduction is applied.
+    absl::flat_hash_map<EClassId, const IR::Expression *> _placeholders;
+
+    /// @returns the operands of @p expr if it is a rewritten operator, or std::nullopt if it is
+    /// a leaf.
+    static std::optional<std::vector<const IR::Expression *>> operands(
+        const IR::Expression *expr);
+
+    /// @returns a copy of the operator @p expr with the operands @p exprOperands.
+    static const IR::Expression *withOperands(
+        const IR::Expression *expr, const std::vector<const IR::Expression *> &exprOperands);
+
+    /// @returns true if the operands of @p expr can be swapped.
+    static bool isCommutative(const IR::Expression *expr);
+
+    /// @returns the canonical class of @p id.
+    EClassId find(EClassId id);
+
+    /// @returns @p node with canonical operands.
+    ENode canonicalize(ENode node);
+
+    /// @returns the class of @p node. Creates the node if it does not exist yet.
+    EClassId add(ENode node);
+
+    /// @returns the class of @p expr. Adds the expression and all of its operands.
+    EClassId addExpression(const IR::Expression *expr,
+                           absl::flat_hash_map<const IR::Expression *, EClassId> &addedExprs);
+
+    /// Merge the classes @p left and @p right. @returns true if they were distinct.
+    bool merge(EClassId left, EClassId right);
+
+    /// Restore the uniqueness of nodes after merges, merging classes which became congruent.
+    void rebuild();
+
+    /// Re-canonicalize the parents of @p id.
+    void repair(EClassId id);
+
+    /// @returns the constant in the class @p id, if any.
+    const IR::Constant *constant(EClassId id);
+
+    /// @returns the value of the boolean literal in the class @p id, if any.
+    std::optional<bool> boolValue(EClassId id);
+
+    /// @returns true if the class @p id is zero. Zero-width bit vectors are always zero.
+    bool isZero(EClassId id);
+
+    /// @returns the leaf which stands for the class @p id and records it in @p addedExprs.
+    const IR::Expression *placeholder(
+        EClassId id, absl::flat_hash_map<const IR::Expression *, EClassId> &addedExprs);
+
+    /// @returns the forms of the class @p id which ExpressionStrengthReduction may match: its
+    /// literal or placeholder, and the operators whose operands the rules inspect. Their operands
+    /// are placeholders, which are recorded in @p addedExprs.
+    std::vector<const IR::Expression *> operandForms(
+        EClassId id, absl::flat_hash_map<const IR::Expression *, EClassId> &addedExprs);
+
+    /// Apply ExpressionStrengthReduction to @p node of the class @p id, for every combination of
+    /// the forms of its operands. @returns true if the e-graph changed.
+    bool applyStrengthReduction(EClassId id, const ENode &node);
+
+    /// Apply all rules to @p node of the class @p id. @returns true if the e-graph changed.
+    bool applyRules(EClassId id, const ENode &node);
+
+    /// Apply all rules until nothing changes or the bounds are exceeded.
+    /// @returns true if the e-graph was saturated.
+    bool saturate();
+
+    /// @returns the smallest expression of the class @p root and its size.
+    std::pair<const IR::Expression *, uint64_t> extract(EClassId root);
+
+    /// @returns the statistics of all simplifications.
+    static EGraphStatistics &mutableStatistics();
+
+ public:
+    /// @returns the smallest expression equivalent to @p expr which could be found. Returns
+    /// @p expr itself if no smaller expression was found.
+    static const IR::Expression *simplify(const IR::Expression *expr);
+
+    /// @returns the size of @p expr counted as a tree, i.e., shared operands are counted every
+    /// time they are used. Nodes which are not rewritten count as one.
+    static uint64_t treeSize(const IR::Expression *expr);
+
+    /// @returns the statistics of all simplifications.
+    static const EGraphStatistics &statistics();
+};
+
+}  // namespace P4::P4Tools
+
+#endif /* BACKENDS_P4TOOLS_MODULES_FLAY_CORE_LIB_EGRAPH_H_ */
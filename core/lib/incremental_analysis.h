@@ -2,8 +2,10 @@
 #define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_LIB_INCREMENTAL_ANALYSIS_H_
 
 #include "backends/p4tools/common/lib/logging.h"
+#include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
 #include "backends/p4tools/modules/flay/core/control_plane/symbols.h"
 #include "backends/p4tools/modules/flay/core/interpreter/program_info.h"
+#include "backends/p4tools/modules/flay/core/lib/memory_usage.h"
 #include "backends/p4tools/modules/flay/core/lib/return_macros.h"
 #include "backends/p4tools/modules/flay/options.h"
 #include "lib/castable.h"
@@ -148,6 +150,17 @@ class IncrementalAnalysis : public ICastable {
     /// Return statistics of the analysis for bookkeeping.
     [[nodiscard]] virtual AnalysisStatistics *computeAnalysisStatistics() const = 0;
 
+    /// Return the approximate memory held by the data structures of the analysis, keyed by
+    /// subsystem.
+    [[nodiscard]] virtual MemoryBreakdown computeMemoryUsage() const { return {}; }
+
+    /// Return the number of tables tracked by the analysis which use each table encoding.
+    [[nodiscard]] virtual TableEncodingCounts computeTableEncodingCounts() const { return {}; }
+
+    /// Return the number of table entries tracked by the analysis which can never be hit, since
+    /// an entry of higher precedence shadows them.
+    [[nodiscard]] virtual size_t computeShadowedEntryCount() const { return 0; }
+
     DECLARE_TYPEINFO(IncrementalAnalysis);
 };
 
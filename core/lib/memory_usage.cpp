@@ -0,0 +1,156 @@
+#include "backends/p4tools/modules/flay/core/lib/memory_usage.h"
+
+#include <unistd.h>
+#include <z3.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "config.h"
+
+#if HAVE_LIBGC
+#include <gc/gc.h>
+#endif
+
+namespace P4::P4Tools::Flay {
+
+namespace MemoryUsage {
+
+namespace {
+
+/// @returns the value of @p field in /proc/self/status in bytes, or 0 if it is not available.
+uint64_t readProcStatusField(std::string_view field) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind(field, 0) != 0 || line.size() <= field.size() ||
+            line[field.size()] != ':') {
+            continue;
+        }
+        // Values are reported in kB.
+        return std::stoull(line.substr(field.size() + 1)) * 1024;
+    }
+    return 0;
+}
+
+}  // namespace
+
+uint64_t residentMemory() {
+    std::ifstream statm("/proc/self/statm");
+    uint64_t totalPages = 0;
+    uint64_t residentPages = 0;
+    if (!(statm >> totalPages >> residentPages)) {
+        return 0;
+    }
+    return residentPages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+uint64_t peakResidentMemory() { return readProcStatusField("VmHWM"); }
+
+bool resetPeakResidentMemory() {
+    // Writing 5 to clear_refs resets the peak resident set size (Linux 4.0+).
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    if (!clearRefs.is_open()) {
+        return false;
+    }
+    clearRefs << "5";
+    clearRefs.close();
+    return !clearRefs.fail();
+}
+
+std::optional<uint64_t> garbageCollectedMemory() {
+#if HAVE_LIBGC
+    return GC_get_heap_size() - GC_get_free_bytes();
+#else
+    return std::nullopt;
+#endif
+}
+
+uint64_t z3Memory() { return Z3_get_estimated_alloc_size(); }
+
+}  // namespace MemoryUsage
+
+void MemoryPhase::recordEntry(uint64_t entryIndex, uint64_t growth) {
+    if (growth > maxEntryGrowth || entryIndex == 0) {
+        maxEntryGrowth = growth;
+        maxEntryIndex = entryIndex;
+    }
+    static constexpr uint64_t kMebibyte = 1 << 20;
+    size_t bucket = 0;
+    for (auto mebibytes = growth / kMebibyte; mebibytes > 0 && bucket + 1 < entryHistogram.size();
+         mebibytes >>= 1) {
+        bucket++;
+    }
+    entryHistogram.at(bucket)++;
+}
+
+void MemoryProfiler::sampleOpenPhase() {
+    if (!_openPhase.has_value()) {
+        return;
+    }
+    auto &phase = _phases.at(_openPhase.value());
+    phase.residentAfter = MemoryUsage::residentMemory();
+    phase.peakResident = std::max(phase.peakResident, MemoryUsage::peakResidentMemory());
+}
+
+void MemoryProfiler::finishEntry() {
+    if (!_openPhase.has_value()) {
+        return;
+    }
+    auto &phase = _phases.at(_openPhase.value());
+    auto entryPeak = MemoryUsage::peakResidentMemory();
+    phase.residentAfter = MemoryUsage::residentMemory();
+    phase.peakResident = std::max(phase.peakResident, entryPeak);
+    phase.recordEntry(phase.count - 1,
+                      entryPeak > _entryResidentBefore ? entryPeak - _entryResidentBefore : 0);
+}
+
+void MemoryProfiler::startEntry() {
+    _entryResidentBefore = MemoryUsage::residentMemory();
+    MemoryUsage::resetPeakResidentMemory();
+}
+
+void MemoryProfiler::enterAggregatedPhase(const std::string &name) {
+    auto &profiler = getInstance();
+    if (profiler._openPhase.has_value()) {
+        auto &phase = profiler._phases.at(profiler._openPhase.value());
+        if (phase.name == name) {
+            profiler.finishEntry();
+            phase.count++;
+            profiler.startEntry();
+            return;
+        }
+        closeAggregatedPhase();
+    }
+    profiler.startEntry();
+    auto residentBefore = profiler._entryResidentBefore;
+    profiler._openPhase = profiler._phases.size();
+    profiler._phases.push_back({name, residentBefore, residentBefore, residentBefore});
+}
+
+void MemoryProfiler::closeAggregatedPhase() {
+    auto &profiler = getInstance();
+    profiler.finishEntry();
+    profiler._openPhase.reset();
+}
+
+const std::vector<MemoryPhase> &MemoryProfiler::phases() {
+    auto &profiler = getInstance();
+    profiler.sampleOpenPhase();
+    return profiler._phases;
+}
+
+ScopedMemoryPhase::ScopedMemoryPhase(std::string name)
+    : _name(std::move(name)), _residentBefore(MemoryUsage::residentMemory()) {
+    MemoryProfiler::closeAggregatedPhase();
+    MemoryUsage::resetPeakResidentMemory();
+}
+
+ScopedMemoryPhase::~ScopedMemoryPhase() {
+    MemoryProfiler::recordPhase({_name, _residentBefore, MemoryUsage::residentMemory(),
+                                 MemoryUsage::peakResidentMemory()});
+}
+
+}  // namespace P4::P4Tools::Flay
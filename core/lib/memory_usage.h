@@ -0,0 +1,174 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_LIB_MEMORY_USAGE_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_LIB_MEMORY_USAGE_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lib/ordered_map.h"
+
+namespace P4::P4Tools::Flay {
+
+/// Approximate memory usage of individual subsystems in bytes. The key is the subsystem name.
+using MemoryBreakdown = ordered_map<std::string, uint64_t>;
+
+/// Peak and resident memory recorded for a single phase of execution.
+struct MemoryPhase {
+    /// The number of buckets of the histogram of the entries of an aggregated phase.
+    static constexpr size_t kEntryHistogramBuckets = 16;
+
+    /// The name of the phase.
+    std::string name;
+    /// The resident set size when the phase started.
+    uint64_t residentBefore;
+    /// The resident set size when the phase ended.
+    uint64_t residentAfter;
+    /// The peak resident set size during the phase. If the peak could not be reset when the phase
+    /// started, this is the peak of the process up to the end of the phase.
+    uint64_t peakResident;
+    /// The number of times the phase was entered. Aggregated phases span many short calls.
+    uint64_t count = 1;
+    /// For aggregated phases, the largest growth of the peak resident set size over the resident
+    /// set size at the start of a single entry.
+    uint64_t maxEntryGrowth = 0;
+    /// The index of the entry with the largest growth.
+    uint64_t maxEntryIndex = 0;
+    /// For aggregated phases, the number of finished entries by the growth of the peak resident
+    /// set size during the entry. Bucket 0 counts growth below 1 MiB, bucket i growth below 2^i
+    /// MiB and the last bucket all larger growth.
+    std::array<uint64_t, kEntryHistogramBuckets> entryHistogram{};
+
+    /// Record a finished entry with index @p entryIndex whose peak resident set size exceeded the
+    /// resident set size at its start by @p growth bytes.
+    void recordEntry(uint64_t entryIndex, uint64_t growth);
+};
+
+namespace MemoryUsage {
+
+/// @returns the current resident set size of the process in bytes, or 0 if unknown.
+uint64_t residentMemory();
+
+/// @returns the peak resident set size of the process in bytes, or 0 if unknown.
+uint64_t peakResidentMemory();
+
+/// Reset the peak resident set size of the process to the current resident set size.
+/// @returns false if the platform does not support resetting the peak.
+bool resetPeakResidentMemory();
+
+/// @returns the bytes in use in the garbage-collected heap, which holds the IR and most other
+/// objects allocated with `new`. std::nullopt if P4C was built without libgc.
+std::optional<uint64_t> garbageCollectedMemory();
+
+/// @returns the estimated number of bytes allocated by Z3 across all contexts.
+uint64_t z3Memory();
+
+/// Approximate the memory used by a node-based container (std::map, std::set, ordered_map) with
+/// @p entryCount entries of @p entrySize bytes each.
+inline uint64_t estimateNodeMemory(size_t entryCount, size_t entrySize) {
+    // Each red-black tree node carries three pointers and a color in addition to the value.
+    static constexpr uint64_t kNodeOverhead = 4 * sizeof(void *);
+    return entryCount * (entrySize + kNodeOverhead);
+}
+
+/// Approximate the memory used by the nodes of @p container. Does not follow pointers.
+template <typename Container>
+uint64_t estimateContainerMemory(const Container &container) {
+    return estimateNodeMemory(container.size(), sizeof(typename Container::value_type));
+}
+
+/// Approximate the memory used by the nodes of @p map and the containers it maps to.
+template <typename Map>
+uint64_t estimateNestedContainerMemory(const Map &map) {
+    auto bytes = estimateContainerMemory(map);
+    for (const auto &[key, container] : map) {
+        bytes += estimateContainerMemory(container);
+    }
+    return bytes;
+}
+
+}  // namespace MemoryUsage
+
+/// Records peak resident memory per phase of execution. Singleton, since phases such as
+/// compilation happen before any service object exists.
+class MemoryProfiler {
+    /// The phases recorded so far, in order of completion.
+    std::vector<MemoryPhase> _phases;
+
+    /// The position of the aggregated phase in _phases which is still open, if any. Its resident
+    /// and peak memory are sampled when the phases are read or the phase is closed.
+    std::optional<size_t> _openPhase;
+
+    /// The resident set size when the current entry of the open aggregated phase started.
+    uint64_t _entryResidentBefore = 0;
+
+    MemoryProfiler() = default;
+
+    /// The profiler is a singleton instance.
+    static MemoryProfiler &getInstance() {
+        static MemoryProfiler MEMORY_PROFILER;
+        return MEMORY_PROFILER;
+    }
+
+    /// Sample the resident and peak memory of the open aggregated phase.
+    void sampleOpenPhase();
+
+    /// Sample the open aggregated phase and record its current entry as finished.
+    void finishEntry();
+
+    /// Start a new entry of the open aggregated phase, which resets the peak resident memory.
+    void startEntry();
+
+ public:
+    /// Record a completed phase.
+    static void recordPhase(MemoryPhase phase) {
+        getInstance()._phases.emplace_back(std::move(phase));
+    }
+
+    /// Enter the aggregated phase @p name. Consecutive entries of the same phase are recorded as a
+    /// single phase, which spans all of them, instead of a phase per entry. Every entry resets
+    /// the peak resident memory. The peak of each entry is kept in bounded form: the largest one
+    /// and a histogram of all of them. This bounds the profile of calls which are too frequent for
+    /// a phase of their own, e.g., control-plane updates, while a single expensive call still
+    /// stands out.
+    static void enterAggregatedPhase(const std::string &name);
+
+    /// Sample the open aggregated phase for the last time and close it.
+    static void closeAggregatedPhase();
+
+    /// @returns all phases recorded so far. An open aggregated phase is sampled first. Its
+    /// current entry is only included in the resident and peak memory of the phase, not in the
+    /// statistics of its entries.
+    static const std::vector<MemoryPhase> &phases();
+
+    /// Forget all recorded phases.
+    static void clear() {
+        getInstance()._phases.clear();
+        getInstance()._openPhase.reset();
+    }
+};
+
+/// Records the memory of the enclosing scope as a phase in the MemoryProfiler. Closes an open
+/// aggregated phase, since the peak resident memory is reset for the new phase.
+class ScopedMemoryPhase {
+    /// The name of the phase.
+    std::string _name;
+
+    /// The resident set size when the phase started.
+    uint64_t _residentBefore;
+
+ public:
+    explicit ScopedMemoryPhase(std::string name);
+    ScopedMemoryPhase(const ScopedMemoryPhase &) = delete;
+    ScopedMemoryPhase &operator=(const ScopedMemoryPhase &) = delete;
+    ScopedMemoryPhase(ScopedMemoryPhase &&) = delete;
+    ScopedMemoryPhase &operator=(ScopedMemoryPhase &&) = delete;
+    ~ScopedMemoryPhase();
+};
+
+}  // namespace P4::P4Tools::Flay
+
+#endif /* BACKENDS_P4TOOLS_MODULES_FLAY_CORE_LIB_MEMORY_USAGE_H_ */
@@ -1,15 +1,27 @@
 #include "backends/p4tools/modules/flay/core/lib/simplify_expression.h"
 
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <map>
 #include <optional>
+#include <string_view>
 #include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/hash/hash.h"
 #include "backends/p4tools/modules/flay/core/lib/collapse_dataplane_variables.h"
+#include "backends/p4tools/modules/flay/core/lib/egraph.h"
 #include "backends/p4tools/modules/flay/core/lib/expression_strength_reduction.h"
 #include "backends/p4tools/modules/flay/options.h"
 #include "frontends/common/constantFolding.h"
 #include "ir/compare.h"
 #include "ir/irutils.h"
 #include "ir/pass_manager.h"
+#include "lib/big_int.h"
 #include "lib/timer.h"
 
 namespace P4::P4Tools {
@@ -21,102 +33,337 @@ namespace {
 /// "|X(bool)| ? |X(bool)| ? |A(bit<8>)| : |B(bit<8>)| : |B(bit<8>)|"
 /// turns into
 /// "|X(bool)| ? |A(bit<8>)| : |B(bit<8>)|"
+///
+/// The folding is a memoized rewrite over the expression DAG. Every branch of a Mux is folded
+/// under the conditions assumed by all enclosing Muxes. The result of folding an expression only
+/// depends on the assumed conditions which share a variable with the expression, so results are
+/// memoized by the expression and these relevant assumptions. A sub-expression which is shared
+/// by many paths is folded once per distinct set of relevant assumptions instead of once per path.
 class FoldMuxConditionDown : public Transform {
  private:
-    using ExpressionMap = std::map<const IR::Expression *, bool, IR::IsSemanticallyLessComparator>;
+    /// A set of ids, sorted in ascending order.
+    using IdSet = std::vector<size_t>;
 
-    static std::optional<bool> optionalValue(const ExpressionMap &expressionMap,
-                                             const IR::Expression *cond) {
-        if (const auto *boolLiteral = cond->to<IR::BoolLiteral>()) {
-            return boolLiteral->value;
-        }
-        auto it = expressionMap.find(cond);
-        if (it != expressionMap.end()) {
-            return it->second;
+    /// Assumed conditions as pairs of the id of the condition and its value, sorted by id.
+    using Assumptions = std::vector<std::pair<size_t, bool>>;
+
+    /// @returns true if the sorted sets @p left and @p right have a common element.
+    static bool intersects(const IdSet &left, const IdSet &right) {
+        auto leftIt = left.begin();
+        auto rightIt = right.begin();
+        while (leftIt != left.end() && rightIt != right.end()) {
+            if (*leftIt == *rightIt) {
+                return true;
+            }
+            if (*leftIt < *rightIt) {
+                ++leftIt;
+            } else {
+                ++rightIt;
+            }
         }
-        return std::nullopt;
+        return false;
     }
 
-    class FoldExpression : public Transform {
-     private:
-        ExpressionMap expressionMap;
+    /// The state shared by all folds of a single expression.
+    class FoldContext {
+        /// Collects the variables of expressions bottom up. Every sub-expression is visited once.
+        class VariableCollector : public Inspector {
+            /// The context which stores the variables of the expressions.
+            FoldContext &_context;
 
-     public:
-        explicit FoldExpression(ExpressionMap expressionMap)
-            : expressionMap(std::move(expressionMap)) {}
-        FoldExpression() = default;
-
-        const IR::Node *postorder(IR::LAnd *expr) override {
-            auto leftOpt = optionalValue(expressionMap, expr->left);
-            if (leftOpt.has_value()) {
-                if (leftOpt.value()) {
-                    auto rightOpt = optionalValue(expressionMap, expr->right);
-                    return rightOpt.has_value()
-                               ? IR::BoolLiteral::get(rightOpt.value(), expr->getSourceInfo())
-                               : expr->right;
+            /// The variables of the expressions which are being visited.
+            std::vector<IdSet> _variableStack;
+
+            /// Add @p variables to the variables of the expression on top of the stack.
+            void addToParent(const IdSet &variables) {
+                if (_variableStack.empty()) {
+                    return;
                 }
-                return IR::BoolLiteral::get(false, expr->getSourceInfo());
+                IdSet mergedVariables;
+                std::set_union(_variableStack.back().begin(), _variableStack.back().end(),
+                               variables.begin(), variables.end(),
+                               std::back_inserter(mergedVariables));
+                _variableStack.back() = std::move(mergedVariables);
             }
-            auto rightOpt = optionalValue(expressionMap, expr->right);
-            if (rightOpt.has_value()) {
-                return rightOpt.value() ? expr->left
-                                        : IR::BoolLiteral::get(false, expr->getSourceInfo());
+
+            bool preorder(const IR::Type * /*type*/) override { return false; }
+
+            bool preorder(const IR::Expression *expr) override {
+                auto it = _context._expressionVariables.find(expr);
+                if (it != _context._expressionVariables.end()) {
+                    addToParent(it->second);
+                    return false;
+                }
+                _variableStack.emplace_back();
+                if (const auto *variable = expr->to<IR::SymbolicVariable>()) {
+                    auto variableId = _context._variableIds.size();
+                    _variableStack.back().push_back(
+                        _context._variableIds.emplace(variable, variableId).first->second);
+                }
+                return true;
             }
-            return expr;
+
+            void postorder(const IR::Expression *expr) override {
+                auto variables = std::move(_variableStack.back());
+                _variableStack.pop_back();
+                addToParent(variables);
+                _context._expressionVariables.emplace(expr, std::move(variables));
+            }
+
+         public:
+            explicit VariableCollector(FoldContext &context) : _context(context) {
+                // Shared sub-expressions must contribute to every parent, see the preorder.
+                visitDagOnce = false;
+            }
+        };
+
+        /// The ids of the symbolic variables. Variables are compared structurally.
+        std::map<const IR::Expression *, size_t, IR::IsSemanticallyLessComparator> _variableIds;
+
+        /// The variables of the visited expressions.
+        absl::flat_hash_map<const IR::Expression *, IdSet> _expressionVariables;
+
+        /// The ids of the assumed conditions. Conditions are compared structurally.
+        std::map<const IR::Expression *, size_t, IR::IsSemanticallyLessComparator> _conditionIds;
+
+        /// The variables of the assumed conditions, indexed by the id of the condition.
+        std::vector<IdSet> _conditionVariables;
+
+        /// The folded expressions, keyed by the expression and the assumptions it was folded
+        /// under.
+        absl::flat_hash_map<std::pair<const IR::Expression *, Assumptions>, const IR::Expression *>
+            _foldedExpressions;
+
+     public:
+        /// @returns the variables of @p expr.
+        const IdSet &variables(const IR::Expression *expr) {
+            auto it = _expressionVariables.find(expr);
+            if (it == _expressionVariables.end()) {
+                expr->apply(VariableCollector(*this));
+                it = _expressionVariables.find(expr);
+            }
+            return it->second;
         }
 
-        const IR::Node *postorder(IR::LOr *expr) override {
-            auto leftOpt = optionalValue(expressionMap, expr->left);
-            if (leftOpt.has_value()) {
-                if (leftOpt.value()) {
-                    return IR::BoolLiteral::get(true, expr->getSourceInfo());
+        /// @returns the value @p assumptions assign to @p expr, if any.
+        std::optional<bool> value(const Assumptions &assumptions, const IR::Expression *expr) {
+            if (assumptions.empty()) {
+                return std::nullopt;
+            }
+            auto conditionIt = _conditionIds.find(expr);
+            if (conditionIt == _conditionIds.end()) {
+                return std::nullopt;
+            }
+            auto it = std::lower_bound(assumptions.begin(), assumptions.end(),
+                                       std::make_pair(conditionIt->second, false));
+            if (it == assumptions.end() || it->first != conditionIt->second) {
+                return std::nullopt;
+            }
+            return it->second;
+        }
+
+        /// @returns @p assumptions extended by @p cond having @p value. Conjunctions, disjunctions
+        /// and negations are decomposed into the conditions they are made of.
+        Assumptions assume(Assumptions assumptions, const IR::Expression *cond, bool value) {
+            if (cond->is<IR::BoolLiteral>()) {
+                return assumptions;
+            }
+            if (const auto *notExpr = cond->to<IR::LNot>()) {
+                return assume(std::move(assumptions), notExpr->expr, !value);
+            }
+            const auto *andExpr = cond->to<IR::LAnd>();
+            if (andExpr != nullptr && value) {
+                return assume(assume(std::move(assumptions), andExpr->left, true), andExpr->right,
+                              true);
+            }
+            const auto *orExpr = cond->to<IR::LOr>();
+            if (orExpr != nullptr && !value) {
+                return assume(assume(std::move(assumptions), orExpr->left, false), orExpr->right,
+                              false);
+            }
+            auto [conditionIt, inserted] = _conditionIds.emplace(cond, _conditionIds.size());
+            if (inserted) {
+                _conditionVariables.push_back(variables(cond));
+            }
+            auto conditionId = conditionIt->second;
+            auto it = std::lower_bound(assumptions.begin(), assumptions.end(),
+                                       std::make_pair(conditionId, false));
+            // Contradicting assumptions can only occur in dead branches, keep the first one.
+            if (it == assumptions.end() || it->first != conditionId) {
+                assumptions.emplace(it, conditionId, value);
+            }
+            return assumptions;
+        }
+
+        /// @returns the subset of @p assumptions which can affect @p expr, i.e., the conditions
+        /// which share a variable with @p expr or have no variables.
+        Assumptions relevantAssumptions(const Assumptions &assumptions,
+                                        const IR::Expression *expr) {
+            if (assumptions.empty()) {
+                return {};
+            }
+            const auto &expressionVariables = variables(expr);
+            Assumptions result;
+            for (const auto &assumption : assumptions) {
+                const auto &conditionVariables = _conditionVariables[assumption.first];
+                if (conditionVariables.empty() ||
+                    intersects(conditionVariables, expressionVariables)) {
+                    result.push_back(assumption);
                 }
-                auto rightOpt = optionalValue(expressionMap, expr->right);
-                return rightOpt.has_value()
-                           ? IR::BoolLiteral::get(rightOpt.value(), expr->getSourceInfo())
-                           : expr->right;
             }
-            auto rightOpt = optionalValue(expressionMap, expr->right);
-            if (rightOpt.has_value()) {
-                return rightOpt.value() ? IR::BoolLiteral::get(true, expr->getSourceInfo())
-                                        : expr->left;
+            return result;
+        }
+
+        /// @returns the result of folding @p expr under @p assumptions, if it is memoized.
+        std::optional<const IR::Expression *> folded(const IR::Expression *expr,
+                                                     const Assumptions &assumptions) const {
+            auto it = _foldedExpressions.find(std::make_pair(expr, assumptions));
+            if (it == _foldedExpressions.end()) {
+                return std::nullopt;
             }
-            return expr;
+            return it->second;
+        }
+
+        /// Memoize that folding @p expr under @p assumptions results in @p result.
+        void memoize(const IR::Expression *expr, const Assumptions &assumptions,
+                     const IR::Expression *result) {
+            _foldedExpressions.emplace(std::make_pair(expr, assumptions), result);
         }
+    };
 
-        const IR::Node *postorder(IR::LNot *expr) override {
-            auto exprIt = expressionMap.find(expr->expr);
-            if (exprIt != expressionMap.end()) {
-                return IR::BoolLiteral::get(!exprIt->second, expr->getSourceInfo());
+    /// Folds an expression under a fixed set of assumptions.
+    class FoldUnderAssumptions : public Transform {
+        /// The shared state of the fold.
+        FoldContext &_context;
+
+        /// The conditions assumed by the enclosing Muxes.
+        Assumptions _assumptions;
+
+        /// @returns the literal value of @p expr, if it is a literal.
+        static std::optional<bool> literalValue(const IR::Expression *expr) {
+            if (const auto *boolLiteral = expr->to<IR::BoolLiteral>()) {
+                return boolLiteral->value;
             }
+            return std::nullopt;
+        }
 
+        /// @returns the folded Mux @p mux.
+        const IR::Expression *foldMux(const IR::Mux *mux) {
+            const auto *cond = fold(_context, mux->e0, _assumptions);
+            auto condValue = literalValue(cond);
+            if (condValue.has_value()) {
+                return fold(_context, condValue.value() ? mux->e1 : mux->e2, _assumptions);
+            }
+            const auto *trueExpr =
+                fold(_context, mux->e1, _context.assume(_assumptions, cond, true));
+            const auto *falseExpr =
+                fold(_context, mux->e2, _context.assume(_assumptions, cond, false));
+            if (trueExpr->equiv(*falseExpr)) {
+                return trueExpr;
+            }
+            if (cond == mux->e0 && trueExpr == mux->e1 && falseExpr == mux->e2) {
+                return mux;
+            }
+            return new IR::Mux(mux->srcInfo, mux->type, cond, trueExpr, falseExpr);
+        }
+
+        /// @returns @p expr with literal operands of conjunctions, disjunctions and negations
+        /// folded. The operands of @p expr have been folded already.
+        static const IR::Expression *foldConnective(const IR::Expression *expr) {
+            if (const auto *andExpr = expr->to<IR::LAnd>()) {
+                auto leftValue = literalValue(andExpr->left);
+                if (leftValue.has_value()) {
+                    return leftValue.value() ? andExpr->right
+                                             : IR::BoolLiteral::get(false, expr->getSourceInfo());
+                }
+                auto rightValue = literalValue(andExpr->right);
+                if (rightValue.has_value()) {
+                    return rightValue.value() ? andExpr->left
+                                              : IR::BoolLiteral::get(false, expr->getSourceInfo());
+                }
+            } else if (const auto *orExpr = expr->to<IR::LOr>()) {
+                auto leftValue = literalValue(orExpr->left);
+                if (leftValue.has_value()) {
+                    return leftValue.value() ? IR::BoolLiteral::get(true, expr->getSourceInfo())
+                                             : orExpr->right;
+                }
+                auto rightValue = literalValue(orExpr->right);
+                if (rightValue.has_value()) {
+                    return rightValue.value() ? IR::BoolLiteral::get(true, expr->getSourceInfo())
+                                              : orExpr->left;
+                }
+            } else if (const auto *notExpr = expr->to<IR::LNot>()) {
+                auto value = literalValue(notExpr->expr);
+                if (value.has_value()) {
+                    return IR::BoolLiteral::get(!value.value(), expr->getSourceInfo());
+                }
+            }
             return expr;
         }
 
-        const IR::Node *postorder(IR::Mux *mux) override {
-            auto condOpt = optionalValue(expressionMap, mux->e0);
-            if (condOpt.has_value()) {
-                return condOpt.value() ? mux->e1 : mux->e2;
+        const IR::Node *preorder(IR::Type *type) override {
+            prune();
+            return type;
+        }
+
+        const IR::Node *preorder(IR::Expression *expr) override {
+            const auto *original = getOriginal<IR::Expression>();
+            if (original->type != nullptr && original->type->is<IR::Type_Boolean>()) {
+                auto value = _context.value(_assumptions, original);
+                if (value.has_value()) {
+                    prune();
+                    return IR::BoolLiteral::get(value.value(), expr->getSourceInfo());
+                }
+            }
+            auto relevantAssumptions = _context.relevantAssumptions(_assumptions, original);
+            if (relevantAssumptions != _assumptions) {
+                // Share the result with all occurrences which have the same relevant assumptions.
+                prune();
+                return fold(_context, original, relevantAssumptions);
+            }
+            auto foldedExpr = _context.folded(original, _assumptions);
+            if (foldedExpr.has_value()) {
+                prune();
+                return foldedExpr.value();
             }
-            if (mux->e1->equiv(*mux->e2)) {
-                return mux->e1;
+            if (const auto *mux = original->to<IR::Mux>()) {
+                prune();
+                const auto *result = foldMux(mux);
+                _context.memoize(original, _assumptions, result);
+                return result;
             }
-            return mux;
+            return expr;
+        }
+
+        const IR::Node *postorder(IR::Expression *expr) override {
+            const auto *result = foldConnective(expr);
+            _context.memoize(getOriginal<IR::Expression>(), _assumptions, result);
+            return result;
+        }
+
+     public:
+        FoldUnderAssumptions(FoldContext &context, Assumptions assumptions)
+            : _context(context), _assumptions(std::move(assumptions)) {}
+
+        /// @returns @p expr folded under @p assumptions.
+        static const IR::Expression *fold(FoldContext &context, const IR::Expression *expr,
+                                          const Assumptions &assumptions) {
+            auto foldedExpr = context.folded(expr, assumptions);
+            if (foldedExpr.has_value()) {
+                return foldedExpr.value();
+            }
+            return expr->apply(FoldUnderAssumptions(context, assumptions));
         }
     };
 
-    const IR::Node *preorder(IR::Mux *mux) override {
-        // TODO: We should not need to use this prune but it is needed to avoid a massive slowdown
-        // for reasons unclear to me.
+    const IR::Node *preorder(IR::Expression * /*expr*/) override {
         prune();
-        mux->e0 = mux->e0->apply(FoldExpression());
-        mux->e1 = mux->e1->apply(FoldExpression({{mux->e0, true}}));
-        mux->e2 = mux->e2->apply(FoldExpression({{mux->e0, false}}));
-        return mux;
+        FoldContext context;
+        return FoldUnderAssumptions::fold(context, getOriginal<IR::Expression>(), {});
     }
 
  public:
-    FoldMuxConditionDown() { visitDagOnce = false; }
+    FoldMuxConditionDown() = default;
 };
 
 /// Lifts conditions in mux expressions "upward" and converts the conditions into disjunctive or
@@ -181,6 +428,159 @@ class LiftMuxConditions : public Transform {
     }
 };
 
+/// Replaces an expression by the smallest equivalent expression its e-graph contains.
+class EGraphRewrite : public Transform {
+ public:
+    EGraphRewrite() = default;
+
+    const IR::Node *preorder(IR::Expression * /*expr*/) override {
+        prune();
+        return EGraph::simplify(getOriginal<IR::Expression>());
+    }
+};
+
+/// Hashes expressions by their structure. Expressions which are equivalent under IR::Node::equiv
+/// have the same hash. Only the kind of every node and the values of literals and names are
+/// hashed. Types are skipped.
+class StructuralHash : public Inspector {
+    /// The hash of the nodes visited so far.
+    size_t _hash = 0;
+
+    /// Mix @p value into the hash.
+    void combine(size_t value) { _hash = absl::Hash<std::pair<size_t, size_t>>()({_hash, value}); }
+
+    /// Mix @p name into the hash.
+    void combine(cstring name) { combine(std::hash<std::string_view>()(name.string_view())); }
+
+    bool preorder(const IR::Type * /*type*/) override { return false; }
+
+    bool preorder(const IR::Node *node) override {
+        combine(node->node_type_name());
+        if (const auto *constant = node->to<IR::Constant>()) {
+            combine(boost::multiprecision::hash_value(constant->value));
+        } else if (const auto *boolLiteral = node->to<IR::BoolLiteral>()) {
+            combine(static_cast<size_t>(boolLiteral->value));
+        } else if (const auto *stringLiteral = node->to<IR::StringLiteral>()) {
+            combine(stringLiteral->value);
+        } else if (const auto *symbolicVariable = node->to<IR::SymbolicVariable>()) {
+            combine(symbolicVariable->label);
+        } else if (const auto *member = node->to<IR::Member>()) {
+            combine(member->member.name);
+        } else if (const auto *pathExpression = node->to<IR::PathExpression>()) {
+            combine(pathExpression->path->name.name);
+        }
+        return true;
+    }
+
+    StructuralHash() {
+        // Shared sub-expressions are hashed on every path, like equiv compares them.
+        visitDagOnce = false;
+    }
+
+ public:
+    /// @returns the structural hash of @p expr.
+    static size_t hash(const IR::Expression *expr) {
+        StructuralHash structuralHash;
+        expr->apply(structuralHash);
+        return structuralHash._hash;
+    }
+};
+
+/// Memoizes the results of SimplifyExpression::simplify. Inputs are compared structurally, since
+/// callers rebuild the same conditions over and over. The cache is bounded and drops the least
+/// recently used result once it is full.
+class SimplificationCache {
+ public:
+    /// The maximum number of memoized results.
+    static constexpr size_t kCapacity = 1 << 16;
+
+ private:
+    /// An input with its structural hash, which is computed once per lookup or insertion.
+    struct HashedExpression {
+        const IR::Expression *expr;
+        size_t hash;
+
+        explicit HashedExpression(const IR::Expression *expr)
+            : expr(expr), hash(StructuralHash::hash(expr)) {}
+
+        bool operator==(const HashedExpression &other) const {
+            return hash == other.hash && (expr == other.expr || expr->equiv(*other.expr));
+        }
+
+        template <typename H>
+        friend H AbslHashValue(H state, const HashedExpression &hashedExpression) {
+            return H::combine(std::move(state), hashedExpression.hash);
+        }
+    };
+
+    /// Pairs of inputs and their simplified results, most recently used first.
+    using EntryList = std::list<std::pair<HashedExpression, const IR::Expression *>>;
+
+    /// The memoized results.
+    EntryList _entries;
+
+    /// The memoized results, keyed by the structure of the input.
+    absl::flat_hash_map<HashedExpression, EntryList::iterator> _entryIndex;
+
+    /// Expressions which are known to simplify to themselves, compared by pointer. A lookup in
+    /// this set is cheaper than a structural comparison.
+    absl::flat_hash_set<const IR::Expression *> _fixpoints;
+
+    /// The statistics of the cache.
+    SimplifyExpression::CacheStatistics _statistics;
+
+ public:
+    /// @returns the memoized result for @p expr, if any.
+    std::optional<const IR::Expression *> lookup(const IR::Expression *expr) {
+        if (_fixpoints.contains(expr)) {
+            _statistics.hits++;
+            _statistics.fixpointHits++;
+            return expr;
+        }
+        auto it = _entryIndex.find(HashedExpression(expr));
+        if (it == _entryIndex.end()) {
+            _statistics.misses++;
+            return std::nullopt;
+        }
+        _statistics.hits++;
+        _entries.splice(_entries.begin(), _entries, it->second);
+        return it->second->second;
+    }
+
+    /// Memoize that @p expr simplifies to @p result.
+    void insert(const IR::Expression *expr, const IR::Expression *result) {
+        if (result == expr || result->equiv(*expr)) {
+            if (_fixpoints.size() >= kCapacity) {
+                _fixpoints.clear();
+            }
+            _fixpoints.insert(expr);
+            _fixpoints.insert(result);
+        }
+        if (_entries.size() >= kCapacity) {
+            _entryIndex.erase(_entries.back().first);
+            _entries.pop_back();
+            _statistics.evictions++;
+        }
+        _entries.emplace_front(HashedExpression(expr), result);
+        if (!_entryIndex.emplace(_entries.front().first, _entries.begin()).second) {
+            _entries.pop_front();
+        }
+    }
+
+    /// @returns the statistics of the cache.
+    [[nodiscard]] SimplifyExpression::CacheStatistics statistics() const {
+        auto statistics = _statistics;
+        statistics.size = _entries.size();
+        return statistics;
+    }
+};
+
+/// @returns the cache of SimplifyExpression::simplify.
+SimplificationCache &simplificationCache() {
+    static SimplificationCache SIMPLIFICATION_CACHE;
+    return SIMPLIFICATION_CACHE;
+}
+
 }  // namespace
 
 namespace SimplifyExpression {
@@ -207,16 +607,32 @@ class ExpressionRewriter : public PassManager {
         if (options.collapseDataPlaneOperations() && !options.skipParsers()) {
             addPasses({new Flay::DataPlaneVariablePropagator()});
         }
+        if (options.expressionSimplifier() == "EGRAPH") {
+            addPasses({new EGraphRewrite()});
+        }
     }
 };
 
 const IR::Expression *simplify(const IR::Expression *expr) {
     static ExpressionRewriter REWRITER;
-    expr = expr->apply(REWRITER);
+    auto &cache = simplificationCache();
+    auto memoizedResult = cache.lookup(expr);
+    if (memoizedResult.has_value()) {
+        return memoizedResult.value();
+    }
+    const auto *result = expr->apply(REWRITER);
     BUG_CHECK(errorCount() == 0, "Encountered errors while trying to simplify expressions.");
-    return expr;
+    cache.insert(expr, result);
+    return result;
+}
+
+double CacheStatistics::hitRate() const {
+    auto lookups = hits + misses;
+    return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
 }
 
+CacheStatistics cacheStatistics() { return simplificationCache().statistics(); }
+
 }  // namespace SimplifyExpression
 
 }  // namespace P4::P4Tools
@@ -1,6 +1,9 @@
 #ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_LIB_SIMPLIFY_EXPRESSION_H_
 #define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_LIB_SIMPLIFY_EXPRESSION_H_
 
+#include <cstddef>
+#include <cstdint>
+
 #include "ir/ir.h"
 
 namespace P4::P4Tools {
@@ -13,9 +16,34 @@ const IR::Expression *produceSimplifiedMux(const IR::Expression *cond,
                                            const IR::Expression *trueExpression,
                                            const IR::Expression *falseExpression);
 
-/// Simplify the given expression using a series of compiler passes.
+/// Simplify the given expression using a series of compiler passes. Results are memoized, an
+/// expression which is structurally equal to a previously simplified one is not simplified again.
 const IR::Expression *simplify(const IR::Expression *expr);
 
+/// Statistics of the memoization of @ref simplify.
+struct CacheStatistics {
+    /// The number of calls answered with a memoized result.
+    uint64_t hits = 0;
+
+    /// The number of calls whose input was known to be simplified already. Counted in @ref hits.
+    uint64_t fixpointHits = 0;
+
+    /// The number of calls which ran the passes.
+    uint64_t misses = 0;
+
+    /// The number of memoized results which were dropped to bound the cache.
+    uint64_t evictions = 0;
+
+    /// The number of memoized results.
+    size_t size = 0;
+
+    /// @returns the fraction of calls answered with a memoized result.
+    [[nodiscard]] double hitRate() const;
+};
+
+/// @returns the statistics of the memoization of @ref simplify.
+CacheStatistics cacheStatistics();
+
 };  // namespace SimplifyExpression
 
 }  // namespace P4::P4Tools
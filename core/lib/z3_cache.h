@@ -64,6 +64,16 @@ class Z3Cache : protected absl::flat_hash_map<const IR::Expression *, z3::expr>
     /// Remove the provided expression from the cache.
     static void remove(const IR::Expression *expression) { getInstance().removeImpl(expression); }
 
+    /// Return the number of memoized expressions.
+    static size_t size() { return getInstance().flat_hash_map::size(); }
+
+    /// Return the approximate number of bytes used by the cache itself. The memory of the Z3
+    /// expressions is owned by the Z3 context.
+    static uint64_t estimateMemoryUsage() {
+        // Swiss tables use one control byte per slot.
+        return getInstance().capacity() * (sizeof(value_type) + 1);
+    }
+
     /// Return the underlying Z3 context.
     static z3::context &context() { return getInstance()._z3Solver.mutableContext(); }
 };
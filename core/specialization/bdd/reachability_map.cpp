@@ -0,0 +1,183 @@
+#include "backends/p4tools/modules/flay/core/specialization/bdd/reachability_map.h"
+
+#include <z3++.h>
+
+#include "backends/p4tools/modules/flay/core/lib/memory_usage.h"
+#include "lib/timer.h"
+
+namespace P4::P4Tools::Flay {
+
+BddReachabilityExpression::BddReachabilityExpression(ReachabilityExpression reachabilityExpression,
+                                                     BddManager::NodeId bddCondition)
+    : ReachabilityExpression(reachabilityExpression), _bddCondition(bddCondition) {}
+
+BddManager::NodeId BddReachabilityExpression::getBddCondition() const { return _bddCondition; }
+
+BddManager::NodeId BddReachabilityMap::computeDiagram(const z3::expr &term) {
+    auto it = _termDiagrams.find(term.id());
+    if (it != _termDiagrams.end()) {
+        return it->second;
+    }
+    auto diagram = [this, &term]() -> BddManager::NodeId {
+        if (term.is_app()) {
+            switch (term.decl().decl_kind()) {
+                case Z3_OP_TRUE:
+                    return BddManager::kTrue;
+                case Z3_OP_FALSE:
+                    return BddManager::kFalse;
+                case Z3_OP_AND: {
+                    auto result = BddManager::kTrue;
+                    for (unsigned idx = 0; idx < term.num_args(); ++idx) {
+                        result = _bddManager.conjunction(result, computeDiagram(term.arg(idx)));
+                    }
+                    return result;
+                }
+                case Z3_OP_OR: {
+                    auto result = BddManager::kFalse;
+                    for (unsigned idx = 0; idx < term.num_args(); ++idx) {
+                        result = _bddManager.disjunction(result, computeDiagram(term.arg(idx)));
+                    }
+                    return result;
+                }
+                case Z3_OP_NOT:
+                    return _bddManager.negation(computeDiagram(term.arg(0)));
+                case Z3_OP_ITE:
+                    if (term.is_bool()) {
+                        return _bddManager.ite(computeDiagram(term.arg(0)),
+                                               computeDiagram(term.arg(1)),
+                                               computeDiagram(term.arg(2)));
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        // An atom. Atoms are ordered by their first occurrence, so the atoms of the execution
+        // conditions of enclosing nodes are tested first.
+        _atoms.push_back(term);
+        return _bddManager.variable(_bddManager.createVariable());
+    }();
+    _termDiagrams.emplace(term.id(), diagram);
+    return diagram;
+}
+
+std::optional<bool> BddReachabilityMap::computeNodeReachability(
+    const IR::Node *node, const BddManager::Valuation &valuation,
+    BddManager::EvaluationCache &evaluationCache) {
+    auto it = find(node);
+    if (it == end()) {
+        error("Reachability mapping for node %1% does not exist.", node);
+        return std::nullopt;
+    }
+    auto *reachabilityExpression = it->second;
+    auto reachability =
+        _bddManager.evaluate(reachabilityExpression->getBddCondition(), valuation, evaluationCache);
+    auto reachabilityAssignment = reachabilityExpression->getReachability();
+    reachabilityExpression->setReachability(reachability);
+    return reachabilityAssignment != reachability;
+}
+
+BddReachabilityMap::BddReachabilityMap(const NodeAnnotationMap &map, const IR::P4Program &program,
+                                       size_t nodeBudget)
+    : _symbolMap(map.reachabilitySymbolMap()), _bddManager(nodeBudget) {
+    Util::ScopedTimer timer("Precomputing BDD Reachability");
+    for (const auto &[node, reachabilityExpression] : map.reachabilityMap()) {
+        auto z3Condition = _conditionDag.translate(reachabilityExpression->getCondition());
+        auto bddCondition = computeDiagram(z3Condition);
+        if (_bddManager.exceedsNodeBudget()) {
+            return;
+        }
+        (*this)[node] = new BddReachabilityExpression(*reachabilityExpression, bddCondition);
+    }
+    _hierarchy = ReachabilityHierarchy(program, map.reachabilityMap());
+}
+
+std::optional<bool> BddReachabilityMap::isNodeReachable(const IR::Node *node) const {
+    auto it = find(node);
+    if (it != end()) {
+        return it->second->getReachability();
+    }
+    warning(
+        "Unable to find node %1% in the reachability map of this execution state. There might be "
+        "issues with the source information.",
+        node);
+    return std::nullopt;
+}
+
+size_t BddReachabilityMap::atomCount() const { return _atoms.size(); }
+
+size_t BddReachabilityMap::diagramSize() const { return _bddManager.size(); }
+
+bool BddReachabilityMap::exceedsNodeBudget() const { return _bddManager.exceedsNodeBudget(); }
+
+uint64_t BddReachabilityMap::estimateMemoryUsage() const {
+    const auto &reachabilityMap =
+        static_cast<const std::map<const IR::Node *, BddReachabilityExpression *, SourceIdCmp> &>(
+            *this);
+    // Swiss tables use one control byte per slot.
+    return MemoryUsage::estimateContainerMemory(reachabilityMap) +
+           reachabilityMap.size() * sizeof(BddReachabilityExpression) +
+           MemoryUsage::estimateNestedContainerMemory(_symbolMap) +
+           _hierarchy.estimateMemoryUsage() + _conditionDag.estimateMemoryUsage() +
+           _bddManager.estimateMemoryUsage() + _atoms.capacity() * sizeof(z3::expr) +
+           _termDiagrams.capacity() * (sizeof(decltype(_termDiagrams)::value_type) + 1);
+}
+
+std::optional<bool> BddReachabilityMap::recomputeReachability(
+    const ControlPlaneConstraints &controlPlaneConstraints) {
+    NodeSet targetNodes;
+    for (const auto &pair : *this) {
+        targetNodes.insert(pair.first);
+    }
+    return recomputeReachability(targetNodes, controlPlaneConstraints);
+}
+
+std::optional<bool> BddReachabilityMap::recomputeReachability(
+    const SymbolSet &symbolSet, const ControlPlaneConstraints &controlPlaneConstraints) {
+    NodeSet targetNodes;
+    for (const auto &symbol : symbolSet) {
+        auto it = _symbolMap.find(symbol);
+        if (it != _symbolMap.end()) {
+            for (const auto *node : it->second) {
+                targetNodes.insert(node);
+            }
+        }
+    }
+    return recomputeReachability(targetNodes, controlPlaneConstraints);
+}
+
+std::optional<bool> BddReachabilityMap::recomputeReachability(
+    const NodeSet &targetNodes, const ControlPlaneConstraints &controlPlaneConstraints) {
+    Z3ControlPlaneAssignmentSet assignmentSet;
+    for (const auto &[entityName, controlPlaneConstraint] : controlPlaneConstraints) {
+        assignmentSet.merge(controlPlaneConstraint.get().computeZ3ControlPlaneAssignments());
+    }
+    return recomputeReachability(targetNodes, assignmentSet);
+}
+
+std::optional<bool> BddReachabilityMap::recomputeReachability(
+    const NodeSet &targetNodes, const Z3ControlPlaneAssignmentSet &assignmentSet) {
+    // Atoms are only decided when a diagram tests them and at most once per update. The
+    // evaluation cache shares the evaluation of common subdiagrams between all target nodes.
+    Z3ConditionEvaluation atomEvaluation(_conditionDag, assignmentSet);
+    BddManager::Valuation valuation = [this,
+                                       &atomEvaluation](uint32_t variable) -> std::optional<bool> {
+        auto atom = atomEvaluation.evaluate(_atoms[variable]);
+        if (atom.is_true() || atom.is_false()) {
+            return atom.is_true();
+        }
+        return std::nullopt;
+    };
+    BddManager::EvaluationCache evaluationCache;
+    return _hierarchy.recompute(
+        targetNodes,
+        [this](const IR::Node *node) -> ReachabilityExpression * {
+            auto it = find(node);
+            return it != end() ? it->second : nullptr;
+        },
+        [this, &valuation, &evaluationCache](const IR::Node *node) {
+            return computeNodeReachability(node, valuation, evaluationCache);
+        });
+}
+
+}  // namespace P4::P4Tools::Flay
@@ -0,0 +1,121 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_BDD_REACHABILITY_MAP_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_BDD_REACHABILITY_MAP_H_
+
+#include <z3++.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "backends/p4tools/modules/flay/core/interpreter/node_map.h"
+#include "backends/p4tools/modules/flay/core/lib/bdd.h"
+#include "backends/p4tools/modules/flay/core/specialization/reachability_map.h"
+#include "backends/p4tools/modules/flay/core/specialization/z3/condition_dag.h"
+
+namespace P4::P4Tools::Flay {
+
+/// A BddReachabilityExpression extends the ReachabilityExpression class with the binary decision
+/// diagram of its condition.
+class BddReachabilityExpression : public ReachabilityExpression {
+ private:
+    /// The diagram of the condition over the atoms of the map.
+    BddManager::NodeId _bddCondition;
+
+ public:
+    explicit BddReachabilityExpression(ReachabilityExpression reachabilityExpression,
+                                       BddManager::NodeId bddCondition);
+
+    /// @returns the diagram of the condition.
+    [[nodiscard]] BddManager::NodeId getBddCondition() const;
+};
+
+/// A reachability map which compiles the boolean structure of every condition into a binary
+/// decision diagram once. The atoms of the conditions, e.g., comparisons, are the variables of
+/// the diagrams. An update assigns the atoms which the control plane decides and leaves all others
+/// unassigned. A node is reachable or unreachable if the assigned atoms decide its diagram.
+///
+/// Atoms are decided as in the Z3SolverReachabilityMap, natively if possible. Atoms which remain
+/// symbolic are treated as independent of each other. The map may therefore miss that a node is
+/// unreachable because two undecided atoms contradict each other, which Z3 would detect, and
+/// report the node as conditionally reachable instead.
+///
+/// The diagrams of some conditions are exponential in the number of their atoms. The map stops
+/// building diagrams once they exceed a budget of nodes. Such a map must not be used; the caller
+/// falls back to another map, see exceedsNodeBudget.
+class BddReachabilityMap
+    : private std::map<const IR::Node *, BddReachabilityExpression *, SourceIdCmp>,
+      public AbstractReachabilityMap {
+ private:
+    /// A mapping of symbolic variables to IR nodes that depend on these symbolic variables in the
+    /// reachability map. This map can we used for incremental re-computation of reachability.
+    SymbolMap _symbolMap;
+
+    /// The translation of the conditions into Z3, which provides the atoms.
+    Z3ConditionDag _conditionDag;
+
+    /// The diagrams of all conditions.
+    BddManager _bddManager;
+
+    /// The atoms of the conditions, indexed by their variable in the diagrams.
+    std::vector<z3::expr> _atoms;
+
+    /// The diagrams of the translated Z3 terms, keyed by the id of the term.
+    absl::flat_hash_map<unsigned, BddManager::NodeId> _termDiagrams;
+
+    /// @returns the diagram of @p term. Atoms are assigned a new variable on first use.
+    BddManager::NodeId computeDiagram(const z3::expr &term);
+
+    /// Compute reachability for the node under @p valuation of the atoms.
+    std::optional<bool> computeNodeReachability(const IR::Node *node,
+                                                const BddManager::Valuation &valuation,
+                                                BddManager::EvaluationCache &evaluationCache);
+
+    /// Recompute reachability for @p targetNodes given the set of constraints. Nodes below
+    /// unreachable nodes are not evaluated.
+    std::optional<bool> recomputeReachability(const NodeSet &targetNodes,
+                                              const Z3ControlPlaneAssignmentSet &assignmentSet);
+
+ public:
+    /// The default maximum number of nodes of all diagrams. A node takes 12 bytes and an entry of
+    /// the unique table 17 bytes, including its control byte. With the ite cache about as large as
+    /// the unique table and containers at most half full after growing, a node costs at most
+    /// about 100 bytes. 2^22 nodes thus bound the diagrams at roughly 400 MiB.
+    static constexpr size_t kMaxDiagramNodes = 1 << 22;
+
+    /// Create the map for the nodes of @p map. @p program is the program the nodes belong to.
+    /// Construction stops once the diagrams have more than @p nodeBudget nodes.
+    BddReachabilityMap(const NodeAnnotationMap &map, const IR::P4Program &program,
+                       size_t nodeBudget = kMaxDiagramNodes);
+
+    std::optional<bool> recomputeReachability(
+        const ControlPlaneConstraints &controlPlaneConstraints) override;
+
+    std::optional<bool> recomputeReachability(
+        const SymbolSet &symbolSet,
+        const ControlPlaneConstraints &controlPlaneConstraints) override;
+
+    std::optional<bool> recomputeReachability(
+        const NodeSet &targetNodes,
+        const ControlPlaneConstraints &controlPlaneConstraints) override;
+
+    std::optional<bool> isNodeReachable(const IR::Node *node) const override;
+
+    /// @returns the number of distinct atoms of the conditions.
+    [[nodiscard]] size_t atomCount() const;
+
+    /// @returns the number of nodes of all diagrams.
+    [[nodiscard]] size_t diagramSize() const;
+
+    /// @returns true if the diagrams exceeded the node budget during construction. The map is
+    /// incomplete then and must not be used.
+    [[nodiscard]] bool exceedsNodeBudget() const;
+
+    [[nodiscard]] uint64_t estimateMemoryUsage() const override;
+};
+
+}  // namespace P4::P4Tools::Flay
+
+#endif  // BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_BDD_REACHABILITY_MAP_H_
@@ -2,6 +2,7 @@
 
 #include <glob.h>
 
+#include <chrono>
 #include <cstdlib>
 #include <fstream>
 #include <utility>
@@ -9,6 +10,10 @@
 
 #include "backends/p4tools/common/lib/logging.h"
 #include "backends/p4tools/modules/flay/core/lib/analysis.h"
+#include "backends/p4tools/modules/flay/core/lib/egraph.h"
+#include "backends/p4tools/modules/flay/core/lib/memory_usage.h"
+#include "backends/p4tools/modules/flay/core/lib/simplify_expression.h"
+#include "backends/p4tools/modules/flay/core/lib/z3_cache.h"
 #include "frontends/p4/toP4/toP4.h"
 #include "lib/error.h"
 #include "lib/timer.h"
@@ -50,6 +55,7 @@ const IR::P4Program &FlayServiceBase::midEndProgram() const { return _midEndProg
 
 int FlayServiceBase::specializeProgram() {
     Util::ScopedTimer timer("Specialize program");
+    ScopedMemoryPhase memoryPhase("initial_specialization");
     const auto *optimizedProg = &originalProgram();
     for (const auto &[analysisName, incrementalAnalysis] : _incrementalAnalysisMap) {
         auto optProgram = incrementalAnalysis->specializeProgram(*optimizedProg);
@@ -63,8 +69,20 @@ int FlayServiceBase::specializeProgram() {
     return EXIT_SUCCESS;
 }
 
+void FlayServiceBase::recordUpdateMetrics(size_t updateCount,
+                                          std::chrono::steady_clock::time_point startTime,
+                                          bool respecialized) {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    _metrics.recordUpdate(updateCount, elapsed.count(), respecialized);
+    _metrics.setZ3CacheSize(Z3Cache::size());
+    _metrics.setTableEncodingCounts(computeTableEncodingCounts());
+    _metrics.setShadowedEntryCount(computeShadowedEntryCount());
+}
+
 int FlayServiceBase::processControlPlaneUpdate(const ControlPlaneUpdate &controlPlaneUpdate) {
     Util::ScopedTimer timer("Processing control plane update");
+    auto startTime = std::chrono::steady_clock::now();
+    MemoryProfiler::enterAggregatedPhase("update");
     const auto *optimizedProg = &originalProgram();
     _updateCount++;
     bool hasRespecialized = false;
@@ -72,6 +90,7 @@ int FlayServiceBase::processControlPlaneUpdate(const ControlPlaneUpdate &control
         auto optProgram =
             incrementalAnalysis->processControlPlaneUpdate(*optimizedProg, controlPlaneUpdate);
         if (!optProgram.has_value()) {
+            _metrics.recordFailedUpdate(1);
             return EXIT_FAILURE;
         }
         if (optProgram.value() != nullptr) {
@@ -84,12 +103,15 @@ int FlayServiceBase::processControlPlaneUpdate(const ControlPlaneUpdate &control
     if (hasRespecialized) {
         _respecializationCount++;
     }
+    recordUpdateMetrics(1, startTime, hasRespecialized);
     return EXIT_SUCCESS;
 }
 
 int FlayServiceBase::processControlPlaneUpdate(
     const std::vector<const ControlPlaneUpdate *> &controlPlaneUpdates) {
     Util::ScopedTimer timer("Processing control plane updates");
+    auto startTime = std::chrono::steady_clock::now();
+    MemoryProfiler::enterAggregatedPhase("update");
     _updateCount += controlPlaneUpdates.size();
     const auto *optimizedProg = &originalProgram();
     bool hasRespecialized = false;
@@ -97,6 +119,7 @@ int FlayServiceBase::processControlPlaneUpdate(
         auto optProgram =
             incrementalAnalysis->processControlPlaneUpdate(*optimizedProg, controlPlaneUpdates);
         if (!optProgram.has_value()) {
+            _metrics.recordFailedUpdate(controlPlaneUpdates.size());
             return EXIT_FAILURE;
         }
         if (optProgram.value() != nullptr) {
@@ -108,6 +131,7 @@ int FlayServiceBase::processControlPlaneUpdate(
     if (hasRespecialized) {
         _respecializationCount++;
     }
+    recordUpdateMetrics(controlPlaneUpdates.size(), startTime, hasRespecialized);
     return EXIT_SUCCESS;
 }
 
@@ -118,6 +142,26 @@ void FlayServiceBase::recordProgramChange() const {
                                          static_cast<float>(statementCountBefore));
     printInfo("Number of statements - Before: %1% After: %2% Total reduction in statements = %3%%%",
               statementCountBefore, statementCountAfter, stmtPct);
+    auto tableEncodingCounts = computeTableEncodingCounts();
+    printInfo("Table encodings - Per entry: %1% Summarized: %2% Action set: %3%",
+              tableEncodingCounts[tableEncodingName(TableEncoding::kPerEntry)],
+              tableEncodingCounts[tableEncodingName(TableEncoding::kSummarized)],
+              tableEncodingCounts[tableEncodingName(TableEncoding::kActionSet)]);
+    printInfo("Shadowed table entries: %1%", computeShadowedEntryCount());
+    auto simplificationStatistics = SimplifyExpression::cacheStatistics();
+    printInfo("Simplification cache - Hits: %1% Misses: %2% Hit rate: %3%%% Evictions: %4%",
+              simplificationStatistics.hits, simplificationStatistics.misses,
+              100.0 * simplificationStatistics.hitRate(), simplificationStatistics.evictions);
+    const auto &egraphStatistics = EGraph::statistics();
+    if (egraphStatistics.expressionCount > 0) {
+        float nodePct = 100.0F * (1.0F - static_cast<float>(egraphStatistics.outputNodeCount) /
+                                             static_cast<float>(egraphStatistics.inputNodeCount));
+        printInfo(
+            "E-graph simplification - Expressions: %1% Saturated: %2% Nodes before: %3% After: %4% "
+            "Total reduction in nodes = %5%%%",
+            egraphStatistics.expressionCount, egraphStatistics.saturatedCount,
+            egraphStatistics.inputNodeCount, egraphStatistics.outputNodeCount, nodePct);
+    }
 }
 
 FlayServiceStatisticsMap FlayServiceBase::computeFlayServiceStatistics() const {
@@ -129,11 +173,63 @@ FlayServiceStatisticsMap FlayServiceBase::computeFlayServiceStatistics() const {
     for (const auto &[analysisName, incrementalAnalysis] : _incrementalAnalysisMap) {
         statistics.emplace(analysisName, incrementalAnalysis->computeAnalysisStatistics());
     }
-    statistics.emplace(
-        "main", new FlayServiceStatistics(&optimizedProgram(), statementCountBefore,
-                                          statementCountAfter, cyclomaticComplexity,
-                                          numParsersPaths, updateCount(), respecializationCount()));
+    auto *serviceStatistics = new FlayServiceStatistics(
+        &optimizedProgram(), statementCountBefore, statementCountAfter, cyclomaticComplexity,
+        numParsersPaths, updateCount(), respecializationCount());
+    serviceStatistics->memoryStatistics = computeMemoryStatistics();
+    statistics.emplace("main", serviceStatistics);
     return statistics;
 }
 
+MemoryStatistics *FlayServiceBase::computeMemoryStatistics() const {
+    MemoryBreakdown subsystems;
+    for (const auto &[analysisName, incrementalAnalysis] : _incrementalAnalysisMap) {
+        for (const auto &[subsystem, bytes] : incrementalAnalysis->computeMemoryUsage()) {
+            subsystems[subsystem] += bytes;
+        }
+    }
+    subsystems.emplace("z3_cache", Z3Cache::estimateMemoryUsage());
+    subsystems.emplace("z3_context", MemoryUsage::z3Memory());
+    // The IR lives in the garbage-collected heap, together with most other objects.
+    if (auto gcBytes = MemoryUsage::garbageCollectedMemory(); gcBytes.has_value()) {
+        subsystems.emplace("ir_gc_heap", gcBytes.value());
+    }
+    subsystems.emplace("resident", MemoryUsage::residentMemory());
+    subsystems.emplace("peak_resident", MemoryUsage::peakResidentMemory());
+    return new MemoryStatistics(subsystems, MemoryProfiler::phases());
+}
+
+TableEncodingCounts FlayServiceBase::computeTableEncodingCounts() const {
+    TableEncodingCounts tableEncodingCounts;
+    for (const auto &[analysisName, incrementalAnalysis] : _incrementalAnalysisMap) {
+        for (const auto &[encoding, count] : incrementalAnalysis->computeTableEncodingCounts()) {
+            tableEncodingCounts[encoding] += count;
+        }
+    }
+    return tableEncodingCounts;
+}
+
+size_t FlayServiceBase::computeShadowedEntryCount() const {
+    size_t shadowedEntryCount = 0;
+    for (const auto &[analysisName, incrementalAnalysis] : _incrementalAnalysisMap) {
+        shadowedEntryCount += incrementalAnalysis->computeShadowedEntryCount();
+    }
+    return shadowedEntryCount;
+}
+
+const FlayServiceMetrics &FlayServiceBase::metrics() const { return _metrics; }
+
+void FlayServiceBase::setPendingUpdateCount(size_t pendingUpdateCount) {
+    _metrics.setQueueDepth(pendingUpdateCount);
+}
+
+int FlayServiceBase::startMetricsServer(std::string_view address) {
+    _metricsServer = std::make_unique<MetricsServer>(_metrics);
+    if (!_metricsServer->start(address)) {
+        _metricsServer = nullptr;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
 }  // namespace P4::P4Tools::Flay
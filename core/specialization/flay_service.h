@@ -1,9 +1,12 @@
 #ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_FLAY_SERVICE_H_
 #define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_FLAY_SERVICE_H_
 
+#include <chrono>
 #include <functional>
+#include <memory>
 
 #include "backends/p4tools/modules/flay/core/lib/incremental_analysis.h"
+#include "backends/p4tools/modules/flay/core/specialization/service_metrics.h"
 #include "frontends/p4/toP4/toP4.h"
 
 namespace P4::P4Tools::Flay {
@@ -44,6 +47,37 @@ inline double measureSizeDifference(const IR::P4Program &programBefore,
     return (beforeLength - measureProgramSize(programAfter)) * (100.0 / beforeLength);
 }
 
+/// Memory attributed to individual subsystems and peak memory per phase of execution.
+struct MemoryStatistics : public AnalysisStatistics {
+    MemoryStatistics(MemoryBreakdown subsystems, std::vector<MemoryPhase> phases)
+        : subsystems(std::move(subsystems)), phases(std::move(phases)) {}
+
+    /// The approximate number of bytes held by each subsystem.
+    MemoryBreakdown subsystems;
+    /// The peak resident memory per phase, in order of completion.
+    std::vector<MemoryPhase> phases;
+
+    [[nodiscard]] std::string toFormattedString() const override {
+        std::stringstream output;
+        for (const auto &[subsystem, bytes] : subsystems) {
+            output << "memory_" << subsystem << ":" << bytes << "\n";
+        }
+        for (const auto &phase : phases) {
+            output << "phase_" << phase.name << ":rss_before=" << phase.residentBefore
+                   << ",rss_after=" << phase.residentAfter << ",peak_rss=" << phase.peakResident
+                   << ",count=" << phase.count << ",max_entry_growth=" << phase.maxEntryGrowth
+                   << ",max_entry=" << phase.maxEntryIndex << ",entry_histogram=";
+            for (size_t bucket = 0; bucket < phase.entryHistogram.size(); ++bucket) {
+                output << (bucket == 0 ? "" : "|") << phase.entryHistogram.at(bucket);
+            }
+            output << "\n";
+        }
+        return output.str();
+    }
+
+    DECLARE_TYPEINFO(MemoryStatistics);
+};
+
 struct FlayServiceStatistics : public AnalysisStatistics {
     FlayServiceStatistics(const IR::P4Program *optimizedProgram, uint64_t statementCountBefore,
                           uint64_t statementCountAfter, size_t cyclomaticComplexity,
@@ -71,6 +105,9 @@ struct FlayServiceStatistics : public AnalysisStatistics {
     size_t numUpdatesProcessed = 0;
     /// The total number of times a respecialization was necessary.
     size_t numRespecializations = 0;
+    /// Memory usage of the service. Not part of the formatted output, since it is not
+    /// deterministic.
+    const MemoryStatistics *memoryStatistics = nullptr;
 
     [[nodiscard]] std::string toFormattedString() const override {
         std::stringstream output;
@@ -97,6 +134,16 @@ class FlayServiceBase {
     /// Number of times respecialization was necessary.
     size_t _respecializationCount = 0;
 
+    /// Live metrics of the service, which can be scraped while updates are processed.
+    FlayServiceMetrics _metrics;
+
+    /// Serves @ref _metrics over HTTP. Only initialized when the metrics endpoint is enabled.
+    std::unique_ptr<MetricsServer> _metricsServer;
+
+    /// Record a processed batch of updates, which started at @p startTime, in the metrics.
+    void recordUpdateMetrics(size_t updateCount, std::chrono::steady_clock::time_point startTime,
+                             bool respecialized);
+
  protected:
     /// The incremental analysis.
     IncrementalAnalysisMap _incrementalAnalysisMap;
@@ -147,6 +194,25 @@ class FlayServiceBase {
 
     /// Compute and return some statistics on the changes in the program.
     [[nodiscard]] FlayServiceStatisticsMap computeFlayServiceStatistics() const;
+
+    /// Attribute the memory of the service to its subsystems and collect the recorded phases.
+    [[nodiscard]] MemoryStatistics *computeMemoryStatistics() const;
+
+    /// Count the tables of all analyses by the encoding of their entries.
+    [[nodiscard]] TableEncodingCounts computeTableEncodingCounts() const;
+
+    /// Count the table entries of all analyses which are shadowed by other entries.
+    [[nodiscard]] size_t computeShadowedEntryCount() const;
+
+    /// @returns the live metrics of the service.
+    [[nodiscard]] const FlayServiceMetrics &metrics() const;
+
+    /// Set the number of received updates which are still waiting to be processed.
+    void setPendingUpdateCount(size_t pendingUpdateCount);
+
+    /// Serve the metrics of this service at http://@p address/metrics in Prometheus format.
+    /// @returns EXIT_FAILURE if the endpoint could not be started.
+    int startMetricsServer(std::string_view address);
 };
 
 }  // namespace P4::P4Tools::Flay
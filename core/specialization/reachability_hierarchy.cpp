@@ -0,0 +1,281 @@
+#include "backends/p4tools/modules/flay/core/specialization/reachability_hierarchy.h"
+
+#include <set>
+
+#include "backends/p4tools/modules/flay/core/lib/memory_usage.h"
+#include "ir/visitor.h"
+
+namespace P4::P4Tools::Flay {
+
+namespace {
+
+/// @returns true if @p left and @p right denote the same node of a reachability map.
+bool isSameNode(const IR::Node *left, const IR::Node *right) {
+    if (left == nullptr || right == nullptr) {
+        return left == right;
+    }
+    return !SourceIdCmp()(left, right) && !SourceIdCmp()(right, left);
+}
+
+/// @returns true if @p node is known to be never reachable.
+bool isUnreachable(const IR::Node *node, const ReachabilityHierarchy::NodeLookup &lookup) {
+    const auto *reachabilityExpression = lookup(node);
+    return reachabilityExpression != nullptr &&
+           reachabilityExpression->getReachability() == std::optional<bool>(false);
+}
+
+/// Collects the closest enclosing node of every node of a reachability map, whose reachability is
+/// implied by the reachability of the nested node.
+class NestingCollector : public Inspector {
+    /// The nodes whose nesting is collected.
+    const ReachabilityMap &_reachabilityMap;
+
+    /// The stack of enclosing nodes. nullptr marks a scope which can be entered from anywhere,
+    /// e.g., the body of an action.
+    std::vector<const IR::Node *> _enclosingNodes;
+
+    /// The collected parent of every node. nullptr if the node is not nested.
+    std::map<const IR::Node *, const IR::Node *, SourceIdCmp> _parents;
+
+    /// @returns true if @p node is a node of the reachability map.
+    [[nodiscard]] bool isMapped(const IR::Node *node) const {
+        return _reachabilityMap.find(node) != _reachabilityMap.end();
+    }
+
+    /// @returns the closest enclosing node, or nullptr if there is none.
+    [[nodiscard]] const IR::Node *enclosingNode() const {
+        return _enclosingNodes.empty() ? nullptr : _enclosingNodes.back();
+    }
+
+    /// Record the enclosing node of @p node. A node which is visited in several places, e.g., as
+    /// part of a shared subtree, is only nested if all places agree.
+    void record(const IR::Node *node) {
+        if (!isMapped(node)) {
+            return;
+        }
+        auto [it, inserted] = _parents.emplace(node, enclosingNode());
+        if (!inserted && !isSameNode(it->second, enclosingNode())) {
+            it->second = nullptr;
+        }
+    }
+
+    /// Visit @p node with @p enclosing as closest enclosing node.
+    void visitEnclosedBy(const IR::Node *node, const IR::Node *enclosing, const char *name) {
+        if (node == nullptr) {
+            return;
+        }
+        _enclosingNodes.push_back(enclosing);
+        visit(node, name);
+        _enclosingNodes.pop_back();
+    }
+
+ public:
+    explicit NestingCollector(const ReachabilityMap &reachabilityMap)
+        : _reachabilityMap(reachabilityMap) {
+        visitDagOnce = false;
+    }
+
+    bool preorder(const IR::Node *node) override {
+        record(node);
+        return true;
+    }
+
+    bool preorder(const IR::IfStatement *ifStatement) override {
+        record(ifStatement);
+        // The condition is evaluated whether or not the true branch executes.
+        visit(ifStatement->condition, "condition");
+        const auto *enclosing = isMapped(ifStatement) ? ifStatement : enclosingNode();
+        visitEnclosedBy(ifStatement->ifTrue, enclosing, "ifTrue");
+        if (ifStatement->ifFalse != nullptr) {
+            visit(ifStatement->ifFalse, "ifFalse");
+        }
+        return false;
+    }
+
+    bool preorder(const IR::SwitchStatement *switchStatement) override {
+        record(switchStatement);
+        visit(switchStatement->expression, "expression");
+        bool fallsThrough = false;
+        for (const auto *switchCase : switchStatement->cases) {
+            record(switchCase);
+            visit(switchCase->label, "label");
+            // A block which is reached by falling through executes under the labels of several
+            // cases. The default case is not part of the reachability map.
+            const auto *enclosing = enclosingNode();
+            const auto *statement = switchCase->statement;
+            if (!fallsThrough && statement != nullptr && statement->is<IR::BlockStatement>() &&
+                !switchCase->label->is<IR::DefaultExpression>() && isMapped(switchCase)) {
+                enclosing = switchCase;
+            }
+            visitEnclosedBy(statement, enclosing, "statement");
+            fallsThrough = statement == nullptr || !statement->is<IR::BlockStatement>();
+        }
+        return false;
+    }
+
+    bool preorder(const IR::P4Action * /*action*/) override {
+        _enclosingNodes.push_back(nullptr);
+        return true;
+    }
+
+    void postorder(const IR::P4Action * /*action*/) override { _enclosingNodes.pop_back(); }
+
+    bool preorder(const IR::Function * /*function*/) override {
+        _enclosingNodes.push_back(nullptr);
+        return true;
+    }
+
+    void postorder(const IR::Function * /*function*/) override { _enclosingNodes.pop_back(); }
+
+    /// @returns the collected parent of every node.
+    [[nodiscard]] const std::map<const IR::Node *, const IR::Node *, SourceIdCmp> &parents()
+        const {
+        return _parents;
+    }
+};
+
+}  // namespace
+
+ReachabilityHierarchy::ReachabilityHierarchy(const IR::Node &program,
+                                             const ReachabilityMap &reachabilityMap) {
+    NestingCollector nestingCollector(reachabilityMap);
+    program.apply(nestingCollector);
+    const auto &parents = nestingCollector.parents();
+
+    // Parents must be added before their children.
+    NodeSet visitedNodes;
+    std::function<void(const IR::Node *)> addWithAncestors = [&](const IR::Node *node) {
+        if (!visitedNodes.insert(node).second) {
+            return;
+        }
+        auto it = parents.find(node);
+        if (it == parents.end() || it->second == nullptr) {
+            return;
+        }
+        addWithAncestors(it->second);
+        addNode(node, it->second);
+    };
+    for (const auto &[node, parent] : parents) {
+        addWithAncestors(node);
+    }
+}
+
+void ReachabilityHierarchy::addNode(const IR::Node *node, const IR::Node *parent) {
+    // The collected nesting follows the tree of the program, so it can only be cyclic if source
+    // information is ambiguous. Keep such nodes unnested.
+    for (const auto *ancestor = parent; ancestor != nullptr; ancestor = this->parent(ancestor)) {
+        if (isSameNode(ancestor, node)) {
+            return;
+        }
+    }
+    _parents[node] = parent;
+    _children[parent].push_back(node);
+    _depths[node] = depth(parent) + 1;
+}
+
+const IR::Node *ReachabilityHierarchy::parent(const IR::Node *node) const {
+    auto it = _parents.find(node);
+    if (it == _parents.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+size_t ReachabilityHierarchy::depth(const IR::Node *node) const {
+    auto it = _depths.find(node);
+    if (it == _depths.end()) {
+        return 0;
+    }
+    return it->second;
+}
+
+bool ReachabilityHierarchy::deferSubtree(const IR::Node *node, const NodeLookup &lookup) {
+    // The nodes below a deferred node are deferred as well.
+    if (!_deferredNodes.insert(node).second) {
+        return false;
+    }
+    _skippedNodeCount++;
+    bool hasChanged = false;
+    if (auto *reachabilityExpression = lookup(node)) {
+        auto reachability = reachabilityExpression->getReachability();
+        if (!reachability.has_value() || reachability.value()) {
+            reachabilityExpression->setReachability(false);
+            hasChanged = true;
+        }
+    }
+    auto it = _children.find(node);
+    if (it != _children.end()) {
+        for (const auto *child : it->second) {
+            hasChanged |= deferSubtree(child, lookup);
+        }
+    }
+    return hasChanged;
+}
+
+std::optional<bool> ReachabilityHierarchy::recompute(const NodeSet &targetNodes,
+                                                     const NodeLookup &lookup,
+                                                     const NodeEvaluator &evaluate) {
+    // Process parents before their children.
+    auto byDepth = [this](const IR::Node *left, const IR::Node *right) {
+        auto leftDepth = depth(left);
+        auto rightDepth = depth(right);
+        if (leftDepth != rightDepth) {
+            return leftDepth < rightDepth;
+        }
+        return SourceIdCmp()(left, right);
+    };
+    std::set<const IR::Node *, decltype(byDepth)> worklist(targetNodes.begin(), targetNodes.end(),
+                                                           byDepth);
+
+    bool hasChanged = false;
+    while (!worklist.empty()) {
+        const auto *node = *worklist.begin();
+        worklist.erase(worklist.begin());
+
+        // A node below an unreachable parent is unreachable. There is no need to evaluate it.
+        const auto *parentNode = parent(node);
+        if (parentNode != nullptr && isUnreachable(parentNode, lookup)) {
+            hasChanged |= deferSubtree(node, lookup);
+            continue;
+        }
+
+        auto result = evaluate(node);
+        if (!result.has_value()) {
+            return std::nullopt;
+        }
+        hasChanged |= result.value();
+        _evaluatedNodeCount++;
+        _deferredNodes.erase(node);
+
+        auto it = _children.find(node);
+        if (it == _children.end()) {
+            continue;
+        }
+        if (isUnreachable(node, lookup)) {
+            for (const auto *child : it->second) {
+                hasChanged |= deferSubtree(child, lookup);
+            }
+            continue;
+        }
+        // The parent may have become reachable again. Resolve the nodes deferred below it.
+        for (const auto *child : it->second) {
+            if (_deferredNodes.find(child) != _deferredNodes.end()) {
+                worklist.insert(child);
+            }
+        }
+    }
+    return hasChanged;
+}
+
+uint64_t ReachabilityHierarchy::evaluatedNodeCount() const { return _evaluatedNodeCount; }
+
+uint64_t ReachabilityHierarchy::skippedNodeCount() const { return _skippedNodeCount; }
+
+uint64_t ReachabilityHierarchy::estimateMemoryUsage() const {
+    return MemoryUsage::estimateContainerMemory(_parents) +
+           MemoryUsage::estimateNestedContainerMemory(_children) +
+           MemoryUsage::estimateContainerMemory(_depths) +
+           MemoryUsage::estimateContainerMemory(_deferredNodes);
+}
+
+}  // namespace P4::P4Tools::Flay
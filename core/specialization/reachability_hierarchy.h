@@ -0,0 +1,92 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_REACHABILITY_HIERARCHY_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_REACHABILITY_HIERARCHY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "backends/p4tools/modules/flay/core/control_plane/symbols.h"
+#include "backends/p4tools/modules/flay/core/interpreter/reachability_expression.h"
+#include "ir/ir.h"
+
+namespace P4::P4Tools::Flay {
+
+/// The nesting of the nodes of a reachability map in the program. The parent of a node is the
+/// closest enclosing node whose reachability is a precondition of the reachability of the node,
+/// e.g., the if statement whose true branch contains the node. A node can only execute if its
+/// parent executes, so every node below an unreachable parent is unreachable as well.
+///
+/// The hierarchy evaluates parents before their children. Nodes below an unreachable parent are
+/// marked unreachable without evaluating their condition and are deferred. Deferred nodes are
+/// evaluated once their parent becomes reachable again.
+class ReachabilityHierarchy {
+ public:
+    /// Looks up the reachability expression of a node of the map.
+    using NodeLookup = std::function<ReachabilityExpression *(const IR::Node *)>;
+
+    /// Evaluates the condition of a node and updates its reachability.
+    /// @returns whether the reachability changed, or std::nullopt if an error occurred.
+    using NodeEvaluator = std::function<std::optional<bool>(const IR::Node *)>;
+
+ private:
+    /// The parent of every nested node. Nodes without a parent are not contained.
+    std::map<const IR::Node *, const IR::Node *, SourceIdCmp> _parents;
+
+    /// The children of every node with nested nodes.
+    std::map<const IR::Node *, std::vector<const IR::Node *>, SourceIdCmp> _children;
+
+    /// The number of ancestors of every nested node.
+    std::map<const IR::Node *, size_t, SourceIdCmp> _depths;
+
+    /// The nodes which were marked unreachable because of an unreachable ancestor, without
+    /// evaluating their condition.
+    NodeSet _deferredNodes;
+
+    /// The number of conditions evaluated by all recomputations.
+    uint64_t _evaluatedNodeCount = 0;
+
+    /// The number of nodes marked unreachable without evaluation by all recomputations.
+    uint64_t _skippedNodeCount = 0;
+
+    /// Mark @p node and all nodes below it unreachable and defer them.
+    /// @returns whether the reachability of any node changed.
+    bool deferSubtree(const IR::Node *node, const NodeLookup &lookup);
+
+ public:
+    /// A hierarchy without nesting. Every node is evaluated.
+    ReachabilityHierarchy() = default;
+
+    /// Build the hierarchy of the nodes of @p reachabilityMap from their nesting in @p program.
+    ReachabilityHierarchy(const IR::Node &program, const ReachabilityMap &reachabilityMap);
+
+    /// Record that @p node is nested in @p parent.
+    void addNode(const IR::Node *node, const IR::Node *parent);
+
+    /// @returns the parent of @p node, or nullptr if the node is not nested.
+    [[nodiscard]] const IR::Node *parent(const IR::Node *node) const;
+
+    /// @returns the number of ancestors of @p node.
+    [[nodiscard]] size_t depth(const IR::Node *node) const;
+
+    /// Recompute the reachability of @p targetNodes. Parents are evaluated before their children.
+    /// Deferred nodes below a parent that became reachable are evaluated as well.
+    /// @returns whether the reachability of any node changed, or std::nullopt if an error occurred.
+    std::optional<bool> recompute(const NodeSet &targetNodes, const NodeLookup &lookup,
+                                  const NodeEvaluator &evaluate);
+
+    /// @returns the number of conditions evaluated by all recomputations.
+    [[nodiscard]] uint64_t evaluatedNodeCount() const;
+
+    /// @returns the number of nodes marked unreachable without evaluation by all recomputations.
+    [[nodiscard]] uint64_t skippedNodeCount() const;
+
+    /// @returns the approximate number of bytes held by the hierarchy.
+    [[nodiscard]] uint64_t estimateMemoryUsage() const;
+};
+
+}  // namespace P4::P4Tools::Flay
+
+#endif /* BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_REACHABILITY_HIERARCHY_H_ */
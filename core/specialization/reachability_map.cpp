@@ -1,17 +1,21 @@
 #include "backends/p4tools/modules/flay/core/specialization/reachability_map.h"
 
 #include "backends/p4tools/modules/flay/core/control_plane/substitute_variable.h"
+#include "backends/p4tools/modules/flay/core/lib/memory_usage.h"
 #include "backends/p4tools/modules/flay/core/lib/simplify_expression.h"
 #include "lib/error.h"
 #include "lib/timer.h"
 
 namespace P4::P4Tools::Flay {
 
-IRReachabilityMap::IRReachabilityMap(const NodeAnnotationMap &map)
+const ReachabilityHierarchy &AbstractReachabilityMap::hierarchy() const { return _hierarchy; }
+
+IRReachabilityMap::IRReachabilityMap(const NodeAnnotationMap &map, const IR::P4Program &program)
     : _symbolMap(map.reachabilitySymbolMap()) {
     for (auto &pair : map.reachabilityMap()) {
         emplace(pair.first, pair.second);
     }
+    _hierarchy = ReachabilityHierarchy(program, map.reachabilityMap());
 }
 
 std::optional<bool> IRReachabilityMap::computeNodeReachability(
@@ -54,6 +58,13 @@ std::optional<bool> IRReachabilityMap::isNodeReachable(const IR::Node *node) con
     return std::nullopt;
 }
 
+uint64_t IRReachabilityMap::estimateMemoryUsage() const {
+    // The reachability expressions are shared with the node annotation map.
+    return MemoryUsage::estimateContainerMemory(static_cast<const ReachabilityMap &>(*this)) +
+           MemoryUsage::estimateNestedContainerMemory(_symbolMap) +
+           _hierarchy.estimateMemoryUsage();
+}
+
 std::optional<bool> IRReachabilityMap::recomputeReachability(
     const ControlPlaneConstraints &controlPlaneConstraints) {
     /// Generate IR equalities from the control plane constraints.
@@ -65,15 +76,11 @@ std::optional<bool> IRReachabilityMap::recomputeReachability(
                                             controlPlaneAssignments.end());
     }
 
-    bool hasChanged = false;
-    for (auto &pair : *this) {
-        auto result = computeNodeReachability(pair.first, totalControlPlaneAssignments);
-        if (!result.has_value()) {
-            return std::nullopt;
-        }
-        hasChanged |= result.value();
+    NodeSet targetNodes;
+    for (const auto &pair : *this) {
+        targetNodes.insert(pair.first);
     }
-    return hasChanged;
+    return recomputeReachability(targetNodes, totalControlPlaneAssignments);
 }
 
 std::optional<bool> IRReachabilityMap::recomputeReachability(
@@ -102,15 +109,20 @@ std::optional<bool> IRReachabilityMap::recomputeReachability(
                                             controlPlaneAssignments.end());
     }
 
-    bool hasChanged = false;
-    for (const auto *node : targetNodes) {
-        auto result = computeNodeReachability(node, totalControlPlaneAssignments);
-        if (!result.has_value()) {
-            return std::nullopt;
-        }
-        hasChanged |= result.value();
-    }
-    return hasChanged;
+    return recomputeReachability(targetNodes, totalControlPlaneAssignments);
+}
+
+std::optional<bool> IRReachabilityMap::recomputeReachability(
+    const NodeSet &targetNodes, const ControlPlaneAssignmentSet &controlPlaneAssignments) {
+    return _hierarchy.recompute(
+        targetNodes,
+        [this](const IR::Node *node) -> ReachabilityExpression * {
+            auto it = find(node);
+            return it != end() ? it->second : nullptr;
+        },
+        [this, &controlPlaneAssignments](const IR::Node *node) {
+            return computeNodeReachability(node, controlPlaneAssignments);
+        });
 }
 
 }  // namespace P4::P4Tools::Flay
@@ -5,10 +5,15 @@
 
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_item.h"
 #include "backends/p4tools/modules/flay/core/interpreter/node_map.h"
+#include "backends/p4tools/modules/flay/core/specialization/reachability_hierarchy.h"
 
 namespace P4::P4Tools::Flay {
 
 class AbstractReachabilityMap {
+ protected:
+    /// The nesting of the nodes of the map. Used to skip nodes below unreachable nodes.
+    ReachabilityHierarchy _hierarchy;
+
  public:
     AbstractReachabilityMap(const AbstractReachabilityMap &) = default;
     AbstractReachabilityMap(AbstractReachabilityMap &&) = delete;
@@ -36,6 +41,13 @@ class AbstractReachabilityMap {
     /// true when the node is always reachable, and std::nullopt if the node is sometimes reachable
     /// or the node could not be found.
     virtual std::optional<bool> isNodeReachable(const IR::Node *node) const = 0;
+
+    /// @returns the approximate number of bytes held by the map. Does not include the memory of
+    /// IR nodes or Z3 expressions, which are accounted for separately.
+    [[nodiscard]] virtual uint64_t estimateMemoryUsage() const = 0;
+
+    /// @returns the nesting of the nodes of the map.
+    [[nodiscard]] const ReachabilityHierarchy &hierarchy() const;
 };
 
 class IRReachabilityMap : private ReachabilityMap, public AbstractReachabilityMap {
@@ -48,8 +60,14 @@ class IRReachabilityMap : private ReachabilityMap, public AbstractReachabilityMa
     std::optional<bool> computeNodeReachability(
         const IR::Node *node, const ControlPlaneAssignmentSet &controlPlaneAssignments);
 
+    /// Recompute reachability for @p targetNodes given the set of constraints. Nodes below
+    /// unreachable nodes are not evaluated.
+    std::optional<bool> recomputeReachability(
+        const NodeSet &targetNodes, const ControlPlaneAssignmentSet &controlPlaneAssignments);
+
  public:
-    explicit IRReachabilityMap(const NodeAnnotationMap &map);
+    /// Create the map for the nodes of @p map. @p program is the program the nodes belong to.
+    IRReachabilityMap(const NodeAnnotationMap &map, const IR::P4Program &program);
 
     std::optional<bool> recomputeReachability(
         const ControlPlaneConstraints &controlPlaneConstraints) override;
@@ -63,6 +81,8 @@ class IRReachabilityMap : private ReachabilityMap, public AbstractReachabilityMa
         const ControlPlaneConstraints &controlPlaneConstraints) override;
 
     std::optional<bool> isNodeReachable(const IR::Node *node) const override;
+
+    [[nodiscard]] uint64_t estimateMemoryUsage() const override;
 };
 
 }  // namespace P4::P4Tools::Flay
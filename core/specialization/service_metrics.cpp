@@ -0,0 +1,341 @@
+#include "backends/p4tools/modules/flay/core/specialization/service_metrics.h"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "backends/p4tools/common/lib/logging.h"
+#include "backends/p4tools/modules/flay/core/lib/memory_usage.h"
+#include "lib/error.h"
+
+namespace P4::P4Tools::Flay {
+
+namespace {
+
+/// Append the HELP and TYPE header of a metric to @p output.
+void appendHeader(std::string_view name, std::string_view help, std::string_view type,
+                  std::string &output) {
+    output.append("# HELP ").append(name).append(" ").append(help).append("\n");
+    output.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+}
+
+/// Append a single sample of a counter or gauge to @p output.
+template <typename T>
+void appendSample(std::string_view name, std::string_view help, std::string_view type, T value,
+                  std::string &output) {
+    appendHeader(name, help, type, output);
+    std::stringstream sample;
+    sample << name << " " << value << "\n";
+    output.append(sample.str());
+}
+
+}  // namespace
+
+/**************************************************************************************************
+LatencyHistogram
+**************************************************************************************************/
+
+void LatencyHistogram::observe(double seconds) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t bucketIdx = 0;
+    while (bucketIdx < kBucketBounds.size() && seconds > kBucketBounds.at(bucketIdx)) {
+        bucketIdx++;
+    }
+    _bucketCounts.at(bucketIdx)++;
+    _sum += seconds;
+    _count++;
+}
+
+uint64_t LatencyHistogram::count() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _count;
+}
+
+double LatencyHistogram::sum() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _sum;
+}
+
+void LatencyHistogram::toPrometheusText(std::string_view name, std::string_view help,
+                                        std::string &output) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    appendHeader(name, help, "histogram", output);
+    std::stringstream samples;
+    uint64_t cumulativeCount = 0;
+    for (size_t bucketIdx = 0; bucketIdx < kBucketBounds.size(); bucketIdx++) {
+        cumulativeCount += _bucketCounts.at(bucketIdx);
+        samples << name << "_bucket{le=\"" << kBucketBounds.at(bucketIdx) << "\"} "
+                << cumulativeCount << "\n";
+    }
+    samples << name << "_bucket{le=\"+Inf\"} " << _count << "\n";
+    samples << name << "_sum " << _sum << "\n";
+    samples << name << "_count " << _count << "\n";
+    output.append(samples.str());
+}
+
+/**************************************************************************************************
+FlayServiceMetrics
+**************************************************************************************************/
+
+void FlayServiceMetrics::recordUpdate(size_t updateCount, double seconds, bool respecialized) {
+    _updatesProcessed += updateCount;
+    _updateLatency.observe(seconds);
+    if (respecialized) {
+        _respecializations++;
+        _respecializationLatency.observe(seconds);
+    }
+}
+
+void FlayServiceMetrics::recordFailedUpdate(size_t updateCount) { _updatesFailed += updateCount; }
+
+void FlayServiceMetrics::setQueueDepth(size_t queueDepth) { _queueDepth = queueDepth; }
+
+void FlayServiceMetrics::setZ3CacheSize(size_t z3CacheSize) { _z3CacheSize = z3CacheSize; }
+
+void FlayServiceMetrics::setShadowedEntryCount(size_t shadowedEntryCount) {
+    _shadowedEntryCount = shadowedEntryCount;
+}
+
+void FlayServiceMetrics::setTableEncodingCounts(
+    const std::map<std::string_view, size_t> &tableEncodingCounts) {
+    std::lock_guard<std::mutex> lock(_tableEncodingMutex);
+    _tableEncodingCounts.clear();
+    for (const auto &[encoding, count] : tableEncodingCounts) {
+        _tableEncodingCounts.emplace(encoding, count);
+    }
+}
+
+uint64_t FlayServiceMetrics::updatesProcessed() const { return _updatesProcessed; }
+
+uint64_t FlayServiceMetrics::updatesFailed() const { return _updatesFailed; }
+
+uint64_t FlayServiceMetrics::respecializations() const { return _respecializations; }
+
+uint64_t FlayServiceMetrics::queueDepth() const { return _queueDepth; }
+
+uint64_t FlayServiceMetrics::z3CacheSize() const { return _z3CacheSize; }
+
+uint64_t FlayServiceMetrics::shadowedEntryCount() const { return _shadowedEntryCount; }
+
+std::map<std::string, uint64_t, std::less<>> FlayServiceMetrics::tableEncodingCounts() const {
+    std::lock_guard<std::mutex> lock(_tableEncodingMutex);
+    return _tableEncodingCounts;
+}
+
+const LatencyHistogram &FlayServiceMetrics::updateLatency() const { return _updateLatency; }
+
+std::string FlayServiceMetrics::toPrometheusText() const {
+    std::string output;
+    appendSample("flay_updates_processed_total",
+                 "Number of control-plane updates processed by the service.", "counter",
+                 updatesProcessed(), output);
+    appendSample("flay_updates_failed_total",
+                 "Number of control-plane updates the service failed to process.", "counter",
+                 updatesFailed(), output);
+    appendSample("flay_respecializations_total",
+                 "Number of times the program was respecialized after an update.", "counter",
+                 respecializations(), output);
+    appendSample("flay_update_queue_depth",
+                 "Number of received control-plane updates waiting to be processed.", "gauge",
+                 queueDepth(), output);
+    appendSample("flay_z3_cache_entries", "Number of expressions memoized in the Z3 cache.",
+                 "gauge", z3CacheSize(), output);
+    appendSample("flay_shadowed_table_entries",
+                 "Number of table entries which are shadowed by entries of higher precedence.",
+                 "gauge", shadowedEntryCount(), output);
+    appendHeader("flay_tables", "Number of tables per encoding of their entries.", "gauge", output);
+    for (const auto &[encoding, count] : tableEncodingCounts()) {
+        std::stringstream sample;
+        sample << "flay_tables{encoding=\"" << encoding << "\"} " << count << "\n";
+        output.append(sample.str());
+    }
+    appendSample("process_resident_memory_bytes", "Resident memory size in bytes.", "gauge",
+                 MemoryUsage::residentMemory(), output);
+    appendSample("flay_z3_memory_bytes", "Estimated memory allocated by Z3 in bytes.", "gauge",
+                 MemoryUsage::z3Memory(), output);
+    _updateLatency.toPrometheusText("flay_update_latency_seconds",
+                                    "Time spent processing a batch of control-plane updates.",
+                                    output);
+    _respecializationLatency.toPrometheusText(
+        "flay_respecialization_latency_seconds",
+        "Time spent processing a batch of updates which required respecialization.", output);
+    return output;
+}
+
+/**************************************************************************************************
+MetricsServer
+**************************************************************************************************/
+
+MetricsServer::MetricsServer(const FlayServiceMetrics &metrics) : _metrics(metrics) {}
+
+MetricsServer::~MetricsServer() { stop(); }
+
+std::optional<std::pair<std::string, std::string>> MetricsServer::splitAddress(
+    std::string_view address) {
+    std::string_view host;
+    std::string_view port;
+    if (address.substr(0, 1) == "[") {
+        auto closingPos = address.find(']');
+        if (closingPos == std::string_view::npos || address.substr(closingPos + 1, 1) != ":") {
+            return std::nullopt;
+        }
+        host = address.substr(1, closingPos - 1);
+        port = address.substr(closingPos + 2);
+    } else {
+        auto separatorPos = address.rfind(':');
+        if (separatorPos == std::string_view::npos) {
+            return std::nullopt;
+        }
+        host = address.substr(0, separatorPos);
+        port = address.substr(separatorPos + 1);
+        // An IPv6 host without brackets can not be told apart from its port.
+        if (host.find(':') != std::string_view::npos) {
+            return std::nullopt;
+        }
+    }
+    if (port.empty()) {
+        return std::nullopt;
+    }
+    return std::make_pair(std::string(host), std::string(port));
+}
+
+bool MetricsServer::start(std::string_view address) {
+    auto hostAndPort = splitAddress(address);
+    if (!hostAndPort.has_value()) {
+        error(
+            "Invalid metrics address %1%. Expected the format ADDRESS:PORT, with IPv6 addresses "
+            "in brackets.",
+            std::string(address));
+        return false;
+    }
+    const auto &[host, port] = hostAndPort.value();
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo *addressInfo = nullptr;
+    if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &addressInfo) !=
+        0) {
+        error("Unable to resolve metrics address %1%.", std::string(address));
+        return false;
+    }
+    for (auto *info = addressInfo; info != nullptr; info = info->ai_next) {
+        _socket = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        if (_socket < 0) {
+            continue;
+        }
+        int reuse = 1;
+        setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (bind(_socket, info->ai_addr, info->ai_addrlen) == 0 && listen(_socket, 16) == 0) {
+            break;
+        }
+        close(_socket);
+        _socket = -1;
+    }
+    freeaddrinfo(addressInfo);
+    if (_socket < 0) {
+        error("Unable to listen on metrics address %1%: %2%", std::string(address),
+              strerror(errno));
+        return false;
+    }
+
+    sockaddr_storage boundAddress{};
+    socklen_t boundAddressLength = sizeof(boundAddress);
+    getsockname(_socket, reinterpret_cast<sockaddr *>(&boundAddress), &boundAddressLength);
+    if (boundAddress.ss_family == AF_INET6) {
+        _port = ntohs(reinterpret_cast<sockaddr_in6 *>(&boundAddress)->sin6_port);
+    } else {
+        _port = ntohs(reinterpret_cast<sockaddr_in *>(&boundAddress)->sin_port);
+    }
+
+    _stopRequested = false;
+    _servingThread = std::thread([this]() { serve(); });
+    printInfo("Serving Flay metrics on %1%:%2%/metrics", host, _port);
+    return true;
+}
+
+void MetricsServer::stop() {
+    _stopRequested = true;
+    if (_servingThread.joinable()) {
+        _servingThread.join();
+    }
+    if (_socket >= 0) {
+        close(_socket);
+        _socket = -1;
+    }
+}
+
+uint16_t MetricsServer::port() const { return _port; }
+
+void MetricsServer::serve() {
+    pollfd listeningSocket{_socket, POLLIN, 0};
+    while (!_stopRequested) {
+        // Wake up periodically to check whether we should stop.
+        if (poll(&listeningSocket, 1, 100) <= 0) {
+            continue;
+        }
+        int connection = accept(_socket, nullptr, nullptr);
+        if (connection < 0) {
+            continue;
+        }
+        handleConnection(connection);
+        close(connection);
+    }
+}
+
+void MetricsServer::handleConnection(int connection) const {
+    // Do not let a stalled client block the server.
+    timeval timeout{1, 0};
+    setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // We only need the request line, but read the full header to be well-behaved.
+    static constexpr size_t kMaxRequestSize = 8192;
+    std::string request;
+    std::array<char, 1024> buffer{};
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < kMaxRequestSize) {
+        auto bytesRead = recv(connection, buffer.data(), buffer.size(), 0);
+        if (bytesRead <= 0) {
+            break;
+        }
+        request.append(buffer.data(), bytesRead);
+    }
+
+    std::string status = "404 Not Found";
+    std::string body = "Not Found\n";
+    std::string contentType = "text/plain";
+    if (request.rfind("GET /metrics ", 0) == 0 || request.rfind("GET /metrics?", 0) == 0) {
+        status = "200 OK";
+        body = _metrics.toPrometheusText();
+        contentType = "text/plain; version=0.0.4";
+    }
+    std::stringstream response;
+    response << "HTTP/1.1 " << status << "\r\n"
+             << "Content-Type: " << contentType << "\r\n"
+             << "Content-Length: " << body.size() << "\r\n"
+             << "Connection: close\r\n\r\n"
+             << body;
+    auto responseString = response.str();
+    size_t bytesSent = 0;
+    while (bytesSent < responseString.size()) {
+        auto sent = send(connection, responseString.data() + bytesSent,
+                         responseString.size() - bytesSent, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            break;
+        }
+        bytesSent += sent;
+    }
+}
+
+}  // namespace P4::P4Tools::Flay
@@ -0,0 +1,168 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_SERVICE_METRICS_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_SERVICE_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace P4::P4Tools::Flay {
+
+/// A latency histogram with fixed, cumulative buckets. Mirrors the semantics of a Prometheus
+/// histogram: each bucket counts the observations which are less or equal to its upper bound.
+class LatencyHistogram {
+ public:
+    /// The upper bounds of the histogram buckets in seconds. The implicit last bucket is +Inf.
+    static constexpr std::array<double, 12> kBucketBounds = {
+        0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 10.0};
+
+ private:
+    /// Guards the bucket counts and the sum.
+    mutable std::mutex _mutex;
+
+    /// The non-cumulative number of observations per bucket. The last entry is the +Inf bucket.
+    std::array<uint64_t, kBucketBounds.size() + 1> _bucketCounts{};
+
+    /// The sum of all observed values.
+    double _sum = 0;
+
+    /// The total number of observations.
+    uint64_t _count = 0;
+
+ public:
+    /// Record a single observation of @p seconds.
+    void observe(double seconds);
+
+    /// @returns the total number of observations.
+    [[nodiscard]] uint64_t count() const;
+
+    /// @returns the sum of all observations.
+    [[nodiscard]] double sum() const;
+
+    /// Append the Prometheus text representation of this histogram to @p output.
+    void toPrometheusText(std::string_view name, std::string_view help, std::string &output) const;
+};
+
+/// Live counters and gauges of a running Flay service. All members may be read from a different
+/// thread than the one processing the updates, e.g., the thread serving the /metrics endpoint.
+class FlayServiceMetrics {
+    /// The number of control-plane updates which have been processed.
+    std::atomic<uint64_t> _updatesProcessed = 0;
+
+    /// The number of control-plane updates which could not be processed.
+    std::atomic<uint64_t> _updatesFailed = 0;
+
+    /// The number of times the program was respecialized.
+    std::atomic<uint64_t> _respecializations = 0;
+
+    /// The number of received updates which are still waiting to be processed.
+    std::atomic<uint64_t> _queueDepth = 0;
+
+    /// The number of expressions memoized in the Z3 cache.
+    std::atomic<uint64_t> _z3CacheSize = 0;
+
+    /// The number of table entries which are shadowed by other entries.
+    std::atomic<uint64_t> _shadowedEntryCount = 0;
+
+    /// Guards the table encoding counts.
+    mutable std::mutex _tableEncodingMutex;
+
+    /// The number of tables using each encoding, keyed by the name of the encoding.
+    std::map<std::string, uint64_t, std::less<>> _tableEncodingCounts;
+
+    /// The time it takes to process a batch of control-plane updates.
+    LatencyHistogram _updateLatency;
+
+    /// The time it takes to produce a respecialized program.
+    LatencyHistogram _respecializationLatency;
+
+ public:
+    /// Record a processed batch of @p updateCount control-plane updates which took @p seconds.
+    void recordUpdate(size_t updateCount, double seconds, bool respecialized);
+
+    /// Record a batch of @p updateCount control-plane updates which failed to process.
+    void recordFailedUpdate(size_t updateCount);
+
+    /// Set the number of updates which are still waiting to be processed.
+    void setQueueDepth(size_t queueDepth);
+
+    /// Set the number of expressions memoized in the Z3 cache.
+    void setZ3CacheSize(size_t z3CacheSize);
+
+    /// Set the number of table entries which are shadowed by other entries.
+    void setShadowedEntryCount(size_t shadowedEntryCount);
+
+    /// Set the number of tables using each encoding, keyed by the name of the encoding.
+    void setTableEncodingCounts(const std::map<std::string_view, size_t> &tableEncodingCounts);
+
+    [[nodiscard]] uint64_t updatesProcessed() const;
+    [[nodiscard]] uint64_t updatesFailed() const;
+    [[nodiscard]] uint64_t respecializations() const;
+    [[nodiscard]] uint64_t queueDepth() const;
+    [[nodiscard]] uint64_t z3CacheSize() const;
+    [[nodiscard]] uint64_t shadowedEntryCount() const;
+    [[nodiscard]] std::map<std::string, uint64_t, std::less<>> tableEncodingCounts() const;
+    [[nodiscard]] const LatencyHistogram &updateLatency() const;
+
+    /// @returns the metrics in the Prometheus text exposition format (version 0.0.4).
+    [[nodiscard]] std::string toPrometheusText() const;
+};
+
+/// A minimal HTTP server, which serves the metrics of a Flay service at /metrics.
+/// Only intended for local scraping. Requests are answered sequentially on a single thread.
+class MetricsServer {
+    /// The metrics which are exposed.
+    const FlayServiceMetrics &_metrics;
+
+    /// The listening socket.
+    int _socket = -1;
+
+    /// The port the server is bound to.
+    uint16_t _port = 0;
+
+    /// Set when the server should stop accepting connections.
+    std::atomic<bool> _stopRequested = false;
+
+    /// The thread which accepts and answers requests.
+    std::thread _servingThread;
+
+    /// Answer a single request on the connection @p connection.
+    void handleConnection(int connection) const;
+
+    /// Accept connections until a stop is requested.
+    void serve();
+
+ public:
+    explicit MetricsServer(const FlayServiceMetrics &metrics);
+    MetricsServer(const MetricsServer &) = delete;
+    MetricsServer &operator=(const MetricsServer &) = delete;
+    MetricsServer(MetricsServer &&) = delete;
+    MetricsServer &operator=(MetricsServer &&) = delete;
+    ~MetricsServer();
+
+    /// Split @p address of the format ADDRESS:PORT into its host and port. IPv6 hosts must be
+    /// enclosed in brackets, e.g., [::1]:9000. The host may be empty, the port may not.
+    /// @returns std::nullopt if @p address does not have this format.
+    static std::optional<std::pair<std::string, std::string>> splitAddress(
+        std::string_view address);
+
+    /// Start listening on @p address, which has the format ADDRESS:PORT, see splitAddress. A port
+    /// of 0 picks an ephemeral port. @returns false if the server could not be started.
+    bool start(std::string_view address);
+
+    /// Stop the server and join the serving thread.
+    void stop();
+
+    /// @returns the port the server is bound to.
+    [[nodiscard]] uint16_t port() const;
+};
+
+}  // namespace P4::P4Tools::Flay
+
+#endif  // BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_SERVICE_METRICS_H_
@@ -8,7 +8,9 @@
 #include <vector>
 
 #include "backends/p4tools/common/lib/logging.h"
+#include "backends/p4tools/modules/flay/core/lib/return_macros.h"
 #include "backends/p4tools/modules/flay/options.h"
+#include "lib/error.h"
 
 namespace P4::P4Tools::Flay {
 
@@ -20,49 +22,6 @@ void FlayServiceWrapper::outputOptimizedProgram(
     printInfo("Wrote optimized program to %1%", absoluteFilePath);
 }
 
-namespace {
-
-/// Sourced from https://stackoverflow.com/a/9745132.
-bool compareNat(const std::string &a, const std::string &b) {
-    if (a.empty()) {
-        return true;
-    }
-    if (b.empty()) {
-        return false;
-    }
-    if ((std::isdigit(a[0]) != 0) && (std::isdigit(b[0]) == 0)) {
-        return true;
-    }
-    if ((std::isdigit(a[0]) == 0) && (std::isdigit(b[0]) != 0)) {
-        return false;
-    }
-    if ((std::isdigit(a[0]) == 0) && (std::isdigit(b[0]) == 0)) {
-        if (std::toupper(a[0]) == std::toupper(b[0])) {
-            return compareNat(a.substr(1), b.substr(1));
-        }
-        return (std::toupper(a[0]) < std::toupper(b[0]));
-    }
-
-    // Both strings begin with digit --> parse both numbers
-    std::istringstream issa(a);
-    std::istringstream issb(b);
-    int ia = 0;
-    int ib = 0;
-    issa >> ia;
-    issb >> ib;
-    if (ia != ib) {
-        return ia < ib;
-    }
-
-    // Numbers are the same --> remove numbers and recurse
-    std::string anew;
-    std::string bnew;
-    std::getline(issa, anew);
-    std::getline(issb, bnew);
-    return (compareNat(anew, bnew));
-}
-}  // namespace
-
 std::vector<std::string> FlayServiceWrapper::findFiles(std::string_view pattern) {
     std::vector<std::string> files;
     glob_t globResult;
@@ -74,7 +33,7 @@ std::vector<std::string> FlayServiceWrapper::findFiles(std::string_view pattern)
         }
     }
     // Ensures natural order.
-    std::sort(files.begin(), files.end(), compareNat);
+    std::sort(files.begin(), files.end(), naturalOrderLess);
 
     // Free allocated resources
     globfree(&globResult);
@@ -82,10 +41,38 @@ std::vector<std::string> FlayServiceWrapper::findFiles(std::string_view pattern)
     return files;
 }
 
+void FlayServiceWrapper::appendControlPlaneUpdateFileNames(const std::filesystem::path &file,
+                                                           size_t requestCount) {
+    if (requestCount == 1) {
+        _controlPlaneUpdateFileNames.emplace_back(file.filename());
+        return;
+    }
+    for (size_t requestIdx = 0; requestIdx < requestCount; requestIdx++) {
+        _controlPlaneUpdateFileNames.emplace_back(file.stem().string() + "_" +
+                                                  std::to_string(requestIdx) +
+                                                  file.extension().string());
+    }
+}
+
 FlayServiceStatisticsMap FlayServiceWrapper::computeFlayServiceStatistics() const {
     return _flayService.computeFlayServiceStatistics();
 }
 
+int FlayServiceWrapper::startMetricsServer(std::string_view address) {
+    return _flayService.startMetricsServer(address);
+}
+
+int FlayServiceWrapper::setUpdateStream(std::string_view description, size_t queueCapacity) {
+    auto source = UpdateStreamSource::parse(description);
+    RETURN_IF_FALSE_WITH_MESSAGE(
+        source.has_value(), EXIT_FAILURE,
+        error("Invalid update stream %1%. Expected dir:PATH, fifo:PATH, unix:PATH or stdin.",
+              std::string(description)));
+    _updateStreamSource = source;
+    _updateQueueCapacity = queueCapacity;
+    return EXIT_SUCCESS;
+}
+
 FlayServiceWrapper::FlayServiceWrapper(const FlayCompilerResult &compilerResult,
                                        IncrementalAnalysisMap incrementalAnalysisMap)
     : _flayService(compilerResult, std::move(incrementalAnalysisMap)) {}
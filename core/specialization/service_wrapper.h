@@ -1,10 +1,12 @@
 #ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_SERVICE_WRAPPER_H_
 #define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_SERVICE_WRAPPER_H_
 
+#include <optional>
 #include <vector>
 
 #include "backends/p4tools/modules/flay/core/interpreter/node_map.h"
 #include "backends/p4tools/modules/flay/core/specialization/flay_service.h"
+#include "backends/p4tools/modules/flay/core/specialization/update_stream.h"
 
 namespace P4::P4Tools::Flay {
 
@@ -17,6 +19,16 @@ class FlayServiceWrapper {
     /// Helper function to retrieve a list of files matching a pattern.
     static std::vector<std::string> findFiles(std::string_view pattern);
 
+    /// Record the names of @p requestCount control plane updates parsed from @p file. A file
+    /// holding a stream of updates produces one name per update, suffixed by its index.
+    void appendControlPlaneUpdateFileNames(const std::filesystem::path &file, size_t requestCount);
+
+    /// If set, updates are streamed from this source after the preloaded updates are processed.
+    std::optional<UpdateStreamSource> _updateStreamSource;
+
+    /// The maximum number of parsed updates buffered ahead of processing when streaming.
+    size_t _updateQueueCapacity = 0;
+
     /// The Flay service that is being wrapped.
     FlayServiceBase _flayService;
 
@@ -37,6 +49,14 @@ class FlayServiceWrapper {
 
     /// Compute and return some statistics on the changes in the program.
     [[nodiscard]] FlayServiceStatisticsMap computeFlayServiceStatistics() const;
+
+    /// Serve the metrics of the wrapped service at http://@p address/metrics.
+    int startMetricsServer(std::string_view address);
+
+    /// Stream updates from the source described by @p description when running the service
+    /// instead of preloading them. See UpdateStreamSource::parse for the accepted descriptions.
+    /// At most @p queueCapacity parsed updates are buffered ahead of processing.
+    int setUpdateStream(std::string_view description, size_t queueCapacity);
 };
 
 }  // namespace P4::P4Tools::Flay
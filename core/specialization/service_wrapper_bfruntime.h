@@ -19,6 +19,14 @@ class BfRuntimeFlayServiceWrapper : public FlayServiceWrapper {
     /// The parsed series of control plane updates which is applied after Flay service has started.
     std::vector<bfrt_proto::WriteRequest> _controlPlaneUpdates;
 
+    /// Apply a single write request to the service. @p updateName names the optimized program
+    /// written after the update.
+    int processWriteRequest(const bfrt_proto::WriteRequest &writeRequest,
+                            const std::filesystem::path &updateName);
+
+    /// Process updates from the configured update stream until the stream ends.
+    int processUpdateStream();
+
  public:
     BfRuntimeFlayServiceWrapper(const FlayCompilerResult &compilerResult,
                                 IncrementalAnalysisMap incrementalAnalysisMap)
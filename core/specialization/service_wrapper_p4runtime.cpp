@@ -7,6 +7,7 @@
 
 #include "backends/p4tools/common/lib/logging.h"
 #include "backends/p4tools/modules/flay/core/control_plane/protobuf_utils.h"
+#include "backends/p4tools/modules/flay/core/lib/return_macros.h"
 #include "backends/p4tools/modules/flay/options.h"
 #include "lib/error.h"
 
@@ -16,12 +17,17 @@ int P4RuntimeFlayServiceWrapper::parseControlUpdatesFromPattern(std::string_view
     auto files = findFiles(pattern);
     for (const auto &file : files) {
         printInfo("Processing control plane update: %1%", file);
-        auto entityOpt = Protobuf::deserializeObjectFromFile<p4::v1::WriteRequest>(file);
-        if (!entityOpt.has_value()) {
+        auto format =
+            Protobuf::formatFromExtension(file).value_or(Protobuf::ProtobufFormat::kText);
+        auto writeRequestsOpt =
+            Protobuf::deserializeObjectsFromFile<p4::v1::WriteRequest>(file, format);
+        if (!writeRequestsOpt.has_value()) {
             return EXIT_FAILURE;
         }
-        _controlPlaneUpdateFileNames.emplace_back(std::filesystem::path(file).filename());
-        _controlPlaneUpdates.emplace_back(entityOpt.value());
+        appendControlPlaneUpdateFileNames(file, writeRequestsOpt.value().size());
+        for (auto &writeRequest : writeRequestsOpt.value()) {
+            _controlPlaneUpdates.emplace_back(std::move(writeRequest));
+        }
     }
     return EXIT_SUCCESS;
 }
@@ -41,22 +47,50 @@ int P4RuntimeFlayServiceWrapper::run() {
         printInfo("Processing control plane updates...");
     }
     for (size_t updateIdx = 0; updateIdx < _controlPlaneUpdates.size(); updateIdx++) {
-        const auto &controlPlaneUpdate = _controlPlaneUpdates[updateIdx];
-        std::vector<const ControlPlaneUpdate *> p4RuntimeUpdates;
-        for (const auto &update : controlPlaneUpdate.updates()) {
-            p4RuntimeUpdates.emplace_back(new P4RuntimeControlPlaneUpdate(update));
-        }
-        auto result = _flayService.processControlPlaneUpdate(p4RuntimeUpdates);
-        if (result != EXIT_SUCCESS) {
-            return EXIT_FAILURE;
-        }
+        _flayService.setPendingUpdateCount(_controlPlaneUpdates.size() - updateIdx);
+        RETURN_IF_FALSE(processWriteRequest(_controlPlaneUpdates[updateIdx],
+                                            _controlPlaneUpdateFileNames[updateIdx]) ==
+                            EXIT_SUCCESS,
+                        EXIT_FAILURE);
+    }
+    _flayService.setPendingUpdateCount(0);
+    if (_updateStreamSource.has_value()) {
+        RETURN_IF_FALSE(processUpdateStream() == EXIT_SUCCESS, EXIT_FAILURE);
+    }
+    return EXIT_SUCCESS;
+}
 
-        _flayService.recordProgramChange();
-        if (FlayOptions::get().optimizedOutputDir() != std::nullopt) {
-            outputOptimizedProgram(std::filesystem::path(_controlPlaneUpdateFileNames[updateIdx])
-                                       .replace_extension(".p4"));
-        }
+int P4RuntimeFlayServiceWrapper::processWriteRequest(const p4::v1::WriteRequest &writeRequest,
+                                                     const std::filesystem::path &updateName) {
+    std::vector<const ControlPlaneUpdate *> p4RuntimeUpdates;
+    for (const auto &update : writeRequest.updates()) {
+        p4RuntimeUpdates.emplace_back(new P4RuntimeControlPlaneUpdate(update));
+    }
+    RETURN_IF_FALSE(_flayService.processControlPlaneUpdate(p4RuntimeUpdates) == EXIT_SUCCESS,
+                    EXIT_FAILURE);
+
+    _flayService.recordProgramChange();
+    if (FlayOptions::get().optimizedOutputDir() != std::nullopt) {
+        outputOptimizedProgram(std::filesystem::path(updateName).replace_extension(".p4"));
+    }
+    return EXIT_SUCCESS;
+}
+
+int P4RuntimeFlayServiceWrapper::processUpdateStream() {
+    UpdateStream<p4::v1::WriteRequest> updateStream(_updateStreamSource.value(),
+                                                    _updateQueueCapacity);
+    updateStream.start();
+    printInfo("Processing streamed control plane updates...");
+    while (auto update = updateStream.next()) {
+        _flayService.setPendingUpdateCount(updateStream.pending() + 1);
+        RETURN_IF_FALSE(processWriteRequest(update.value().request, update.value().name) ==
+                            EXIT_SUCCESS,
+                        EXIT_FAILURE);
     }
+    _flayService.setPendingUpdateCount(0);
+    RETURN_IF_FALSE_WITH_MESSAGE(!updateStream.failed(), EXIT_FAILURE,
+                                 error("Failed to read the control plane update stream: %1%",
+                                       updateStream.failure().value()));
     return EXIT_SUCCESS;
 }
 
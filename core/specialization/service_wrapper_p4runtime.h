@@ -20,6 +20,14 @@ class P4RuntimeFlayServiceWrapper : public FlayServiceWrapper {
     /// The parsed series of control plane updates which is applied after Flay service has started.
     std::vector<p4::v1::WriteRequest> _controlPlaneUpdates;
 
+    /// Apply a single write request to the service. @p updateName names the optimized program
+    /// written after the update.
+    int processWriteRequest(const p4::v1::WriteRequest &writeRequest,
+                            const std::filesystem::path &updateName);
+
+    /// Process updates from the configured update stream until the stream ends.
+    int processUpdateStream();
+
  public:
     P4RuntimeFlayServiceWrapper(const FlayCompilerResult &compilerResult,
                                 IncrementalAnalysisMap incrementalAnalysisMap)
@@ -3,6 +3,7 @@
 #include <optional>
 
 #include "backends/p4tools/modules/flay/core/control_plane/substitute_variable.h"
+#include "backends/p4tools/modules/flay/core/lib/memory_usage.h"
 #include "backends/p4tools/modules/flay/core/lib/simplify_expression.h"
 #include "lib/error.h"
 #include "lib/timer.h"
@@ -63,6 +64,12 @@ std::optional<const IR::Literal *> IrSubstitutionMap::isExpressionConstant(
     return std::nullopt;
 }
 
+uint64_t IrSubstitutionMap::estimateMemoryUsage() const {
+    // The substitution expressions are shared with the node annotation map.
+    return MemoryUsage::estimateContainerMemory(static_cast<const SubstitutionMap &>(*this)) +
+           MemoryUsage::estimateNestedContainerMemory(_symbolMap);
+}
+
 std::optional<bool> IrSubstitutionMap::recomputeSubstitution(
     const ControlPlaneConstraints &controlPlaneConstraints) {
     /// Generate IR equalities from the control plane constraints.
@@ -36,6 +36,10 @@ class AbstractSubstitutionMap {
     /// @return true if the node can be replace with a constant, false otherwise
     virtual std::optional<const IR::Literal *> isExpressionConstant(
         const IR::Expression *expression) const = 0;
+
+    /// @returns the approximate number of bytes held by the map. Does not include the memory of
+    /// IR nodes or Z3 expressions, which are accounted for separately.
+    [[nodiscard]] virtual uint64_t estimateMemoryUsage() const = 0;
 };
 
 class IrSubstitutionMap : private SubstitutionMap, public AbstractSubstitutionMap {
@@ -64,6 +68,8 @@ class IrSubstitutionMap : private SubstitutionMap, public AbstractSubstitutionMa
 
     std::optional<const IR::Literal *> isExpressionConstant(
         const IR::Expression *expression) const override;
+
+    [[nodiscard]] uint64_t estimateMemoryUsage() const override;
 };
 
 }  // namespace P4::P4Tools::Flay
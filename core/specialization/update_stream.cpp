@@ -0,0 +1,313 @@
+#include "backends/p4tools/modules/flay/core/specialization/update_stream.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#include "config.h"
+
+#if HAVE_LIBGC
+#include <gc/gc.h>
+#endif
+
+namespace P4::P4Tools::Flay {
+
+namespace {
+
+/// How long blocking calls wait before checking whether a stop was requested, in milliseconds.
+constexpr int kStopPollIntervalMs = 100;
+
+/// The name of the file which marks the end of a directory stream.
+constexpr std::string_view kEndOfStreamFile = "END";
+
+/// Wait until @p fd becomes readable or a stop is requested.
+/// @returns false if a stop was requested or polling failed.
+bool waitUntilReadable(int fd, const std::atomic<bool> &stopRequested) {
+    pollfd descriptor{fd, POLLIN, 0};
+    while (!stopRequested) {
+        auto result = poll(&descriptor, 1, kStopPollIntervalMs);
+        if (result > 0) {
+            return true;
+        }
+        if (result < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+/// Sourced from https://stackoverflow.com/a/9745132.
+bool naturalOrderLess(const std::string &a, const std::string &b) {
+    if (a.empty()) {
+        return true;
+    }
+    if (b.empty()) {
+        return false;
+    }
+    if ((std::isdigit(a[0]) != 0) && (std::isdigit(b[0]) == 0)) {
+        return true;
+    }
+    if ((std::isdigit(a[0]) == 0) && (std::isdigit(b[0]) != 0)) {
+        return false;
+    }
+    if ((std::isdigit(a[0]) == 0) && (std::isdigit(b[0]) == 0)) {
+        if (std::toupper(a[0]) == std::toupper(b[0])) {
+            return naturalOrderLess(a.substr(1), b.substr(1));
+        }
+        return (std::toupper(a[0]) < std::toupper(b[0]));
+    }
+
+    // Both strings begin with digit --> parse both numbers
+    std::istringstream issa(a);
+    std::istringstream issb(b);
+    int ia = 0;
+    int ib = 0;
+    issa >> ia;
+    issb >> ib;
+    if (ia != ib) {
+        return ia < ib;
+    }
+
+    // Numbers are the same --> remove numbers and recurse
+    std::string anew;
+    std::string bnew;
+    std::getline(issa, anew);
+    std::getline(issb, bnew);
+    return (naturalOrderLess(anew, bnew));
+}
+
+/**************************************************************************************************
+UpdateStreamSource
+**************************************************************************************************/
+
+std::optional<UpdateStreamSource> UpdateStreamSource::parse(std::string_view description) {
+    if (description == "stdin" || description == "-") {
+        return UpdateStreamSource{Kind::kStdin, {}};
+    }
+    auto separatorPos = description.find(':');
+    if (separatorPos == std::string_view::npos || separatorPos + 1 == description.size()) {
+        return std::nullopt;
+    }
+    auto prefix = description.substr(0, separatorPos);
+    std::filesystem::path path(description.substr(separatorPos + 1));
+    if (prefix == "dir") {
+        return UpdateStreamSource{Kind::kDirectory, path};
+    }
+    if (prefix == "fifo") {
+        return UpdateStreamSource{Kind::kFifo, path};
+    }
+    if (prefix == "unix") {
+        return UpdateStreamSource{Kind::kUnixSocket, path};
+    }
+    return std::nullopt;
+}
+
+/**************************************************************************************************
+DirectoryWatcher
+**************************************************************************************************/
+
+DirectoryWatcher::DirectoryWatcher(std::filesystem::path directory,
+                                   const std::atomic<bool> &stopRequested)
+    : _directory(std::move(directory)), _stopRequested(stopRequested) {
+    // Set up the watch before listing the directory, so we do not miss files created in between.
+    _inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_inotifyFd < 0) {
+        return;
+    }
+    if (inotify_add_watch(_inotifyFd, _directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(_inotifyFd);
+        _inotifyFd = -1;
+        return;
+    }
+    std::vector<std::string> files;
+    for (const auto &entry : std::filesystem::directory_iterator(_directory)) {
+        if (entry.is_regular_file()) {
+            files.emplace_back(entry.path().filename());
+        }
+    }
+    std::sort(files.begin(), files.end(), naturalOrderLess);
+    for (const auto &file : files) {
+        _initialFiles.insert(file);
+        if (file == kEndOfStreamFile) {
+            _isDone = true;
+        } else if (file.front() != '.') {
+            _pendingFiles.emplace_back(_directory / file);
+        }
+    }
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    if (_inotifyFd >= 0) {
+        close(_inotifyFd);
+    }
+}
+
+bool DirectoryWatcher::isValid() const { return _inotifyFd >= 0; }
+
+void DirectoryWatcher::readEvents() {
+    alignas(inotify_event) std::array<char, 4096> buffer{};
+    while (true) {
+        auto bytesRead = read(_inotifyFd, buffer.data(), buffer.size());
+        if (bytesRead <= 0) {
+            return;
+        }
+        for (ssize_t offset = 0; offset < bytesRead;) {
+            const auto *event = reinterpret_cast<const inotify_event *>(buffer.data() + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            if (event->len == 0) {
+                continue;
+            }
+            std::string file(event->name);
+            // Events for files we already listed are duplicates. Each name is only skipped once,
+            // so a file which is rewritten later is picked up again.
+            if (_initialFiles.erase(file) > 0) {
+                continue;
+            }
+            if (file == kEndOfStreamFile) {
+                _isDone = true;
+            } else if (file.front() != '.') {
+                _pendingFiles.emplace_back(_directory / file);
+            }
+        }
+    }
+}
+
+std::optional<std::filesystem::path> DirectoryWatcher::next() {
+    while (_pendingFiles.empty()) {
+        if (_isDone || !waitUntilReadable(_inotifyFd, _stopRequested)) {
+            return std::nullopt;
+        }
+        readEvents();
+    }
+    auto file = std::move(_pendingFiles.front());
+    _pendingFiles.pop_front();
+    return file;
+}
+
+/**************************************************************************************************
+InterruptibleDescriptorStream
+**************************************************************************************************/
+
+InterruptibleDescriptorStream::InterruptibleDescriptorStream(
+    int fd, const std::atomic<bool> &stopRequested)
+    : _fd(fd), _stopRequested(stopRequested) {}
+
+int InterruptibleDescriptorStream::Read(void *buffer, int size) {
+    while (true) {
+        if (!waitUntilReadable(_fd, _stopRequested)) {
+            return -1;
+        }
+        auto bytesRead = read(_fd, buffer, size);
+        if (bytesRead >= 0 || (errno != EINTR && errno != EAGAIN)) {
+            return static_cast<int>(bytesRead);
+        }
+    }
+}
+
+/**************************************************************************************************
+Stream descriptors
+**************************************************************************************************/
+
+namespace {
+
+/// Listen on the Unix domain socket at @p path and accept a single client.
+/// @returns the descriptor of the connection or a negative value on failure, which is described
+/// in @p failure.
+int acceptUnixSocketClient(const std::filesystem::path &path,
+                           const std::atomic<bool> &stopRequested, std::string &failure) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.native().size() >= sizeof(address.sun_path)) {
+        failure = "Unix socket path " + path.native() + " is too long.";
+        return -1;
+    }
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    int listeningSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listeningSocket < 0) {
+        failure = std::string("Unable to create Unix socket: ") + strerror(errno);
+        return -1;
+    }
+    // Remove a stale socket left behind by a previous run.
+    unlink(path.c_str());
+    if (bind(listeningSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listeningSocket, 1) != 0) {
+        failure = "Unable to listen on Unix socket " + path.native() + ": " + strerror(errno);
+        close(listeningSocket);
+        return -1;
+    }
+    int connection = -1;
+    if (waitUntilReadable(listeningSocket, stopRequested)) {
+        connection = accept4(listeningSocket, nullptr, nullptr, SOCK_CLOEXEC);
+    }
+    close(listeningSocket);
+    unlink(path.c_str());
+    return connection;
+}
+
+}  // namespace
+
+int openUpdateStreamDescriptor(const UpdateStreamSource &source,
+                               const std::atomic<bool> &stopRequested, std::string &failure) {
+    switch (source.kind) {
+        case UpdateStreamSource::Kind::kStdin:
+            return STDIN_FILENO;
+        case UpdateStreamSource::Kind::kFifo: {
+            // Opening a FIFO for reading blocks until there is a writer. Open it non-blocking and
+            // wait for data instead, so the open can be interrupted.
+            int fd = open(source.path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);  // NOLINT
+            if (fd < 0) {
+                failure =
+                    "Unable to open update FIFO " + source.path.native() + ": " + strerror(errno);
+            }
+            return fd;
+        }
+        case UpdateStreamSource::Kind::kUnixSocket:
+            return acceptUnixSocketClient(source.path, stopRequested, failure);
+        case UpdateStreamSource::Kind::kDirectory:
+            break;
+    }
+    failure = "Update stream source " + source.path.native() + " is not a byte stream.";
+    return -1;
+}
+
+/**************************************************************************************************
+Garbage collection
+**************************************************************************************************/
+
+void GcThreadRegistration::allowRegistration() {
+#if HAVE_LIBGC
+    GC_allow_register_threads();
+#endif
+}
+
+GcThreadRegistration::GcThreadRegistration() {
+#if HAVE_LIBGC
+    GC_stack_base stackBase{};
+    if (GC_get_stack_base(&stackBase) == GC_SUCCESS) {
+        _isRegistered = GC_register_my_thread(&stackBase) == GC_SUCCESS;
+    }
+#endif
+}
+
+GcThreadRegistration::~GcThreadRegistration() {
+#if HAVE_LIBGC
+    if (_isRegistered) {
+        GC_unregister_my_thread();
+    }
+#endif
+}
+
+}  // namespace P4::P4Tools::Flay
@@ -0,0 +1,360 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_UPDATE_STREAM_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_UPDATE_STREAM_H_
+
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "backends/p4tools/common/lib/logging.h"
+#include "backends/p4tools/modules/flay/core/control_plane/protobuf_utils.h"
+#include "backends/p4tools/modules/flay/core/lib/return_macros.h"
+
+namespace P4::P4Tools::Flay {
+
+/// Compares file names in natural order, i.e., "update_2" orders before "update_10".
+bool naturalOrderLess(const std::string &a, const std::string &b);
+
+/// A FIFO queue with a fixed capacity. Producers block while the queue is full, consumers block
+/// while it is empty. Once the queue is closed, pushes fail and pops drain the remaining items.
+template <typename T>
+class BoundedQueue {
+    /// The maximum number of items in the queue.
+    size_t _capacity;
+
+    /// The queued items.
+    std::deque<T> _items;
+
+    /// Whether the queue has been closed.
+    bool _isClosed = false;
+
+    /// Guards all members.
+    mutable std::mutex _mutex;
+
+    /// Signalled when an item was pushed or the queue was closed.
+    std::condition_variable _notEmpty;
+
+    /// Signalled when an item was popped or the queue was closed.
+    std::condition_variable _notFull;
+
+ public:
+    explicit BoundedQueue(size_t capacity) : _capacity(std::max<size_t>(capacity, 1)) {}
+
+    /// Append @p item to the queue. Blocks while the queue is full.
+    /// @returns false if the queue was closed, in which case @p item is dropped.
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _notFull.wait(lock, [this]() { return _isClosed || _items.size() < _capacity; });
+        if (_isClosed) {
+            return false;
+        }
+        _items.emplace_back(std::move(item));
+        _notEmpty.notify_one();
+        return true;
+    }
+
+    /// Remove the first item of the queue. Blocks while the queue is empty and open.
+    /// @returns std::nullopt once the queue is closed and drained.
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _notEmpty.wait(lock, [this]() { return _isClosed || !_items.empty(); });
+        if (_items.empty()) {
+            return std::nullopt;
+        }
+        T item = std::move(_items.front());
+        _items.pop_front();
+        _notFull.notify_one();
+        return item;
+    }
+
+    /// Close the queue and wake up all waiting producers and consumers.
+    void close() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _isClosed = true;
+        _notEmpty.notify_all();
+        _notFull.notify_all();
+    }
+
+    /// @returns the number of queued items.
+    [[nodiscard]] size_t size() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _items.size();
+    }
+};
+
+/// Describes where a stream of control-plane updates is read from.
+struct UpdateStreamSource {
+    enum class Kind {
+        /// Update files dropped into a directory. Each file is parsed according to its extension.
+        kDirectory,
+        /// Length-delimited binary messages written to a named pipe.
+        kFifo,
+        /// Length-delimited binary messages on standard input.
+        kStdin,
+        /// Length-delimited binary messages sent by a client of a Unix domain socket.
+        kUnixSocket,
+    };
+
+    /// The kind of the source.
+    Kind kind;
+
+    /// The directory, FIFO or socket path. Empty for standard input.
+    std::filesystem::path path;
+
+    /// Parse a source description of the form "dir:PATH", "fifo:PATH", "unix:PATH" or "stdin".
+    /// @returns std::nullopt if the description is malformed.
+    static std::optional<UpdateStreamSource> parse(std::string_view description);
+};
+
+/// Watches a directory for completed update files. Files which already exist are returned first,
+/// in natural order, followed by files as they are closed after writing or moved into the
+/// directory. Hidden files are ignored, which allows writers to create a file under a temporary
+/// name and rename it once complete. The stream ends once a file named END is created.
+class DirectoryWatcher {
+    /// The watched directory.
+    std::filesystem::path _directory;
+
+    /// The inotify instance. Negative if the watch could not be set up.
+    int _inotifyFd = -1;
+
+    /// Files found when the watch started, which have not been returned yet.
+    std::deque<std::filesystem::path> _pendingFiles;
+
+    /// Names of the files found when the watch started. Events for these files are ignored.
+    std::set<std::string> _initialFiles;
+
+    /// Whether the END file has been seen.
+    bool _isDone = false;
+
+    /// Set by the owner to interrupt a blocking call to next().
+    const std::atomic<bool> &_stopRequested;
+
+    /// Read pending inotify events into _pendingFiles.
+    void readEvents();
+
+ public:
+    DirectoryWatcher(std::filesystem::path directory, const std::atomic<bool> &stopRequested);
+    DirectoryWatcher(const DirectoryWatcher &) = delete;
+    DirectoryWatcher &operator=(const DirectoryWatcher &) = delete;
+    DirectoryWatcher(DirectoryWatcher &&) = delete;
+    DirectoryWatcher &operator=(DirectoryWatcher &&) = delete;
+    ~DirectoryWatcher();
+
+    /// @returns false if the directory could not be watched.
+    [[nodiscard]] bool isValid() const;
+
+    /// Block until the next update file is available.
+    /// @returns std::nullopt once the stream has ended or a stop was requested.
+    std::optional<std::filesystem::path> next();
+};
+
+/// Reads from a file descriptor and gives up once a stop is requested. Used to read streams of
+/// delimited messages from pipes and sockets without blocking the owner indefinitely.
+class InterruptibleDescriptorStream : public google::protobuf::io::CopyingInputStream {
+    /// The descriptor which is read.
+    int _fd;
+
+    /// Set by the owner to interrupt a blocking read.
+    const std::atomic<bool> &_stopRequested;
+
+ public:
+    InterruptibleDescriptorStream(int fd, const std::atomic<bool> &stopRequested);
+
+    int Read(void *buffer, int size) override;
+};
+
+/// Open the descriptor of a stream-based @p source. Blocks until a writer opens a FIFO or a client
+/// connects to a Unix domain socket. Does not report errors, so it may run on a background thread.
+/// @returns a negative value if the source could not be opened, in which case @p failure
+/// describes the problem, or if a stop was requested.
+int openUpdateStreamDescriptor(const UpdateStreamSource &source,
+                               const std::atomic<bool> &stopRequested, std::string &failure);
+
+/// Registers the calling thread with the garbage collector while it exists, so the collector
+/// scans the stack of the thread and the thread may allocate. Does nothing without the garbage
+/// collector.
+class GcThreadRegistration {
+    /// Whether the thread was registered by this object.
+    [[maybe_unused]] bool _isRegistered = false;
+
+ public:
+    /// Allow threads to register. Has to be called on the main thread before the registering
+    /// thread is started.
+    static void allowRegistration();
+
+    GcThreadRegistration();
+    GcThreadRegistration(const GcThreadRegistration &) = delete;
+    GcThreadRegistration &operator=(const GcThreadRegistration &) = delete;
+    GcThreadRegistration(GcThreadRegistration &&) = delete;
+    GcThreadRegistration &operator=(GcThreadRegistration &&) = delete;
+    ~GcThreadRegistration();
+};
+
+/// Reads control-plane updates of type T from an UpdateStreamSource on a background thread.
+/// Parsing is overlapped with processing through a bounded queue, so memory use does not depend
+/// on the length of the update trace.
+///
+/// The error reporter and the logging of P4C are not thread-safe. The background thread therefore
+/// only reads and parses. It records why the stream failed and the consumer reports it on the
+/// main thread.
+template <class T>
+class UpdateStream {
+ public:
+    /// A single streamed update.
+    struct Update {
+        /// A name identifying the update, e.g., the name of the file it was read from.
+        std::string name;
+
+        /// The parsed update.
+        T request;
+    };
+
+ private:
+    /// Where updates are read from.
+    UpdateStreamSource _source;
+
+    /// Parsed updates waiting to be processed.
+    BoundedQueue<Update> _queue;
+
+    /// Set when the consumer is done and the producer should stop.
+    std::atomic<bool> _stopRequested = false;
+
+    /// Why the producer failed to read or parse an update. Written by the producer before it
+    /// closes the queue.
+    std::optional<std::string> _failure;
+
+    /// The thread which reads and parses updates.
+    std::thread _producer;
+
+    /// Push an update to the queue. @returns EXIT_FAILURE if the consumer has stopped.
+    int emit(std::string name, T &&request) {
+        return _queue.push(Update{std::move(name), std::move(request)}) ? EXIT_SUCCESS
+                                                                          : EXIT_FAILURE;
+    }
+
+    /// Read all updates from a directory of update files.
+    int produceFromDirectory(std::string &failure) {
+        DirectoryWatcher watcher(_source.path, _stopRequested);
+        if (!watcher.isValid()) {
+            failure = "Unable to watch update directory " + _source.path.native();
+            return EXIT_FAILURE;
+        }
+        while (auto file = watcher.next()) {
+            auto format = Protobuf::formatFromExtension(file.value())
+                              .value_or(Protobuf::ProtobufFormat::kText);
+            size_t requestIdx = 0;
+            auto stem = file.value().stem().string();
+            auto extension = file.value().extension().string();
+            auto fileName = file.value().filename().string();
+            RETURN_IF_FALSE(
+                Protobuf::parseObjectsInFile<T>(
+                    file.value(), format,
+                    [this, format, &fileName, &stem, &extension, &requestIdx](T &&request) {
+                        if (format != Protobuf::ProtobufFormat::kDelimited) {
+                            return emit(fileName, std::move(request));
+                        }
+                        return emit(stem + "_" + std::to_string(requestIdx++) + extension,
+                                    std::move(request));
+                    },
+                    failure) == EXIT_SUCCESS,
+                EXIT_FAILURE);
+        }
+        return EXIT_SUCCESS;
+    }
+
+    /// Read all updates from a stream of length-delimited messages.
+    int produceFromDescriptor(std::string &failure) {
+        int fd = openUpdateStreamDescriptor(_source, _stopRequested, failure);
+        RETURN_IF_FALSE(fd >= 0, EXIT_FAILURE);
+        InterruptibleDescriptorStream descriptorStream(fd, _stopRequested);
+        google::protobuf::io::CopyingInputStreamAdaptor input(&descriptorStream);
+        size_t requestIdx = 0;
+        auto streamName = _source.kind == UpdateStreamSource::Kind::kStdin
+                              ? std::string("stdin")
+                              : _source.path.string();
+        auto result = Protobuf::parseDelimitedObjectsInStream<T>(
+            input, streamName,
+            [this, &requestIdx](T &&request) {
+                return emit("update_" + std::to_string(requestIdx++), std::move(request));
+            },
+            failure);
+        if (_source.kind != UpdateStreamSource::Kind::kStdin) {
+            close(fd);
+        }
+        // A consumer which stopped early is not a failure of the stream.
+        return _stopRequested ? EXIT_SUCCESS : result;
+    }
+
+    /// Read updates until the source is exhausted, then close the queue.
+    void produce() {
+        GcThreadRegistration gcRegistration;
+        std::string failure;
+        auto result = _source.kind == UpdateStreamSource::Kind::kDirectory
+                          ? produceFromDirectory(failure)
+                          : produceFromDescriptor(failure);
+        if (result != EXIT_SUCCESS && !_stopRequested) {
+            _failure = failure.empty() ? "Unable to read the update stream." : failure;
+        }
+        _queue.close();
+    }
+
+ public:
+    UpdateStream(UpdateStreamSource source, size_t capacity)
+        : _source(std::move(source)), _queue(capacity) {}
+    UpdateStream(const UpdateStream &) = delete;
+    UpdateStream &operator=(const UpdateStream &) = delete;
+    UpdateStream(UpdateStream &&) = delete;
+    UpdateStream &operator=(UpdateStream &&) = delete;
+    ~UpdateStream() { stop(); }
+
+    /// Start reading updates in the background.
+    void start() {
+        if (_source.kind == UpdateStreamSource::Kind::kUnixSocket) {
+            printInfo("Waiting for control plane updates on %1%", _source.path.c_str());
+        }
+        GcThreadRegistration::allowRegistration();
+        _producer = std::thread([this]() { produce(); });
+    }
+
+    /// Stop reading updates and join the background thread. Pending updates are discarded.
+    void stop() {
+        _stopRequested = true;
+        _queue.close();
+        if (_producer.joinable()) {
+            _producer.join();
+        }
+    }
+
+    /// Block until the next update is available.
+    /// @returns std::nullopt once the stream has ended.
+    std::optional<Update> next() { return _queue.pop(); }
+
+    /// @returns the number of parsed updates waiting to be processed.
+    [[nodiscard]] size_t pending() const { return _queue.size(); }
+
+    /// @returns true if reading or parsing the stream failed. Only valid once next() returned
+    /// std::nullopt.
+    [[nodiscard]] bool failed() const { return _failure.has_value(); }
+
+    /// @returns why reading or parsing the stream failed, or std::nullopt if it did not. Only
+    /// valid once next() returned std::nullopt. The failure is not reported, so the caller can
+    /// report it on the main thread.
+    [[nodiscard]] const std::optional<std::string> &failure() const { return _failure; }
+};
+
+}  // namespace P4::P4Tools::Flay
+
+#endif  // BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_UPDATE_STREAM_H_
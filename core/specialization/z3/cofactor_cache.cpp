@@ -0,0 +1,131 @@
+#include "backends/p4tools/modules/flay/core/specialization/z3/cofactor_cache.h"
+
+#include <iterator>
+
+#include "backends/p4tools/modules/flay/core/lib/memory_usage.h"
+
+namespace P4::P4Tools::Flay {
+
+Z3CofactorCache::Z3CofactorCache(Z3ConditionDag &conditionDag) : _conditionDag(conditionDag) {}
+
+SymbolSet Z3CofactorCache::recordChanges(const SymbolSet &changedSymbols) {
+    SymbolSet newlySelectedSymbols;
+    for (const auto &symbol : changedSymbols) {
+        if (_selectedSymbols.size() >= kMaxSymbols) {
+            break;
+        }
+        if (_selectedSymbols.find(symbol) != _selectedSymbols.end()) {
+            continue;
+        }
+        auto &changeCount = _changeCounts[symbol];
+        if (++changeCount < kSelectionThreshold) {
+            continue;
+        }
+        _changeCounts.erase(symbol);
+        _selectedSymbols.insert(symbol);
+        newlySelectedSymbols.insert(symbol);
+    }
+    return newlySelectedSymbols;
+}
+
+Z3ConditionEvaluation *Z3CofactorCache::symbolEvaluation(const z3::expr &symbol, uint64_t value) {
+    auto key = std::make_pair(symbol.id(), value);
+    auto it = _symbolEvaluations.find(key);
+    if (it != _symbolEvaluations.end()) {
+        return &it->second;
+    }
+    // The evaluations of a symbol are adjacent in the map.
+    auto valueCount = std::distance(_symbolEvaluations.lower_bound({symbol.id(), 0}),
+                                    _symbolEvaluations.upper_bound({symbol.id(), UINT64_MAX}));
+    if (static_cast<size_t>(valueCount) >= kMaxCofactors) {
+        return nullptr;
+    }
+    auto &context = symbol.ctx();
+    z3::expr_vector variables(context);
+    z3::expr_vector values(context);
+    variables.push_back(symbol);
+    values.push_back(symbol.is_bool() ? context.bool_val(value != 0)
+                                      : context.bv_val(value, symbol.get_sort().bv_size()));
+    return &_symbolEvaluations.try_emplace(key, _conditionDag, variables, values).first->second;
+}
+
+std::optional<z3::expr> Z3CofactorCache::cofactor(ConditionCofactors &conditionCofactors,
+                                                  uint64_t value) {
+    for (const auto &[cofactorValue, cofactor] : conditionCofactors.cofactors) {
+        if (cofactorValue == value) {
+            return cofactor;
+        }
+    }
+    if (conditionCofactors.cofactors.size() >= kMaxCofactors) {
+        return std::nullopt;
+    }
+    auto *evaluation = symbolEvaluation(conditionCofactors.symbol, value);
+    if (evaluation == nullptr) {
+        return std::nullopt;
+    }
+    auto cofactor = evaluation->reduce(conditionCofactors.condition);
+    conditionCofactors.cofactors.emplace_back(value, cofactor);
+    return cofactor;
+}
+
+void Z3CofactorCache::addCondition(const z3::expr &condition, const z3::expr &symbol) {
+    // Values which do not fit into 64 bits are never concrete in a ground assignment.
+    if (!symbol.is_bool() && !(symbol.is_bv() && symbol.get_sort().bv_size() <= 64)) {
+        return;
+    }
+    auto [it, inserted] =
+        _conditionCofactors.try_emplace(condition.id(), ConditionCofactors{condition, symbol, {}});
+    if (!inserted || !symbol.is_bool()) {
+        return;
+    }
+    // Both Shannon cofactors.
+    cofactor(it->second, 0);
+    cofactor(it->second, 1);
+}
+
+std::optional<z3::expr> Z3CofactorCache::lookup(const z3::expr &condition,
+                                                const Z3GroundAssignment &assignment) {
+    auto it = _conditionCofactors.find(condition.id());
+    if (it == _conditionCofactors.end()) {
+        return std::nullopt;
+    }
+    auto valueIt = assignment.find(it->second.symbol.id());
+    if (valueIt == assignment.end()) {
+        return std::nullopt;
+    }
+    auto cofactorCount = it->second.cofactors.size();
+    auto result = cofactor(it->second, valueIt->second);
+    if (it->second.cofactors.size() == cofactorCount) {
+        _hitCount += result.has_value() ? 1 : 0;
+    } else {
+        _missCount++;
+    }
+    return result;
+}
+
+const SymbolSet &Z3CofactorCache::selectedSymbols() const { return _selectedSymbols; }
+
+size_t Z3CofactorCache::size() const { return _conditionCofactors.size(); }
+
+uint64_t Z3CofactorCache::hitCount() const { return _hitCount; }
+
+uint64_t Z3CofactorCache::missCount() const { return _missCount; }
+
+uint64_t Z3CofactorCache::estimateMemoryUsage() const {
+    // Swiss tables use one control byte per slot.
+    uint64_t bytes = MemoryUsage::estimateContainerMemory(_changeCounts) +
+                     MemoryUsage::estimateContainerMemory(_selectedSymbols) +
+                     MemoryUsage::estimateContainerMemory(_symbolEvaluations) +
+                     _conditionCofactors.capacity() *
+                         (sizeof(decltype(_conditionCofactors)::value_type) + 1);
+    for (const auto &[id, conditionCofactors] : _conditionCofactors) {
+        bytes += conditionCofactors.cofactors.capacity() *
+                 sizeof(decltype(conditionCofactors.cofactors)::value_type);
+    }
+    for (const auto &[key, evaluation] : _symbolEvaluations) {
+        bytes += evaluation.estimateMemoryUsage();
+    }
+    return bytes;
+}
+
+}  // namespace P4::P4Tools::Flay
@@ -0,0 +1,125 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_Z3_COFACTOR_CACHE_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_Z3_COFACTOR_CACHE_H_
+
+#include <z3++.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "backends/p4tools/modules/flay/core/control_plane/symbols.h"
+#include "backends/p4tools/modules/flay/core/specialization/z3/condition_dag.h"
+#include "backends/p4tools/modules/flay/core/specialization/z3/ground_program.h"
+#include "ir/ir.h"
+
+namespace P4::P4Tools::Flay {
+
+/// Caches the cofactors of conditions with respect to the control-plane symbols which change most
+/// often, e.g., whether a table has entries or which default action it executes. The cofactor of
+/// a condition for a value of a symbol is the condition with the symbol replaced by the value.
+/// Once the symbol changes back to a value it had before, the condition is evaluated from the
+/// cached cofactor instead of from scratch. If the condition only depends on the symbol, the
+/// cofactor is a literal and the evaluation is a lookup.
+///
+/// Cofactors are computed with a Z3ConditionEvaluation per symbol value, which assigns only the
+/// symbol. They keep the form of the Z3ConditionDag: subconditions shared by several conditions
+/// are reduced once per value and stay shared by the cofactors, so the evaluation of an update
+/// still memoizes them.
+///
+/// Symbols are selected by profiling: a symbol is selected once it changed in kSelectionThreshold
+/// updates. Every condition is cofactored with respect to at most one symbol.
+class Z3CofactorCache {
+ public:
+    /// The number of updates which must change a symbol before it is selected.
+    static constexpr uint64_t kSelectionThreshold = 4;
+
+    /// The maximum number of selected symbols.
+    static constexpr size_t kMaxSymbols = 64;
+
+    /// The maximum number of cofactors cached per condition and per symbol.
+    static constexpr size_t kMaxCofactors = 16;
+
+ private:
+    /// The cofactors of a single condition.
+    struct ConditionCofactors {
+        /// The condition. Kept, so its id is not reused.
+        z3::expr condition;
+
+        /// The symbol the condition is cofactored on.
+        z3::expr symbol;
+
+        /// The cofactors, keyed by the value of the symbol. Booleans are 0 or 1.
+        std::vector<std::pair<uint64_t, z3::expr>> cofactors;
+    };
+
+    /// The DAG which built the conditions.
+    Z3ConditionDag &_conditionDag;
+
+    /// The evaluations which compute the cofactors, keyed by the id of the symbol and its value.
+    std::map<std::pair<unsigned, uint64_t>, Z3ConditionEvaluation> _symbolEvaluations;
+
+    /// The number of updates which changed each symbol, until the symbol is selected.
+    std::map<std::reference_wrapper<const IR::SymbolicVariable>, uint64_t,
+             IR::IsSemanticallyLessComparator>
+        _changeCounts;
+
+    /// The selected symbols.
+    SymbolSet _selectedSymbols;
+
+    /// The cofactors of the conditions, keyed by the id of the condition.
+    absl::flat_hash_map<unsigned, ConditionCofactors> _conditionCofactors;
+
+    /// The number of lookups answered with a cached cofactor.
+    uint64_t _hitCount = 0;
+
+    /// The number of cofactors computed on lookup.
+    uint64_t _missCount = 0;
+
+    /// @returns the evaluation which assigns @p value to @p symbol, or nullptr if the symbol
+    /// already has kMaxCofactors evaluations.
+    Z3ConditionEvaluation *symbolEvaluation(const z3::expr &symbol, uint64_t value);
+
+    /// @returns the cofactor of @p conditionCofactors for @p value. Computes it if needed.
+    /// std::nullopt if the condition or its symbol already has kMaxCofactors cofactors.
+    std::optional<z3::expr> cofactor(ConditionCofactors &conditionCofactors, uint64_t value);
+
+ public:
+    /// Create a cache for the conditions built by @p conditionDag.
+    explicit Z3CofactorCache(Z3ConditionDag &conditionDag);
+
+    /// Record that an update changed @p changedSymbols.
+    /// @returns the symbols which were selected because of this update.
+    SymbolSet recordChanges(const SymbolSet &changedSymbols);
+
+    /// Cofactor @p condition on @p symbol, unless it is already cofactored. Both cofactors of a
+    /// boolean symbol are computed immediately, all others on lookup.
+    void addCondition(const z3::expr &condition, const z3::expr &symbol);
+
+    /// @returns the cofactor of @p condition for the value of its symbol in @p assignment, or
+    /// std::nullopt if the condition is not cofactored or the symbol has no concrete value.
+    std::optional<z3::expr> lookup(const z3::expr &condition,
+                                   const Z3GroundAssignment &assignment);
+
+    /// @returns the selected symbols.
+    [[nodiscard]] const SymbolSet &selectedSymbols() const;
+
+    /// @returns the number of cofactored conditions.
+    [[nodiscard]] size_t size() const;
+
+    /// @returns the number of lookups answered with a cached cofactor.
+    [[nodiscard]] uint64_t hitCount() const;
+
+    /// @returns the number of cofactors computed on lookup.
+    [[nodiscard]] uint64_t missCount() const;
+
+    /// @returns the approximate number of bytes held by the cache, excluding Z3 terms.
+    [[nodiscard]] uint64_t estimateMemoryUsage() const;
+};
+
+}  // namespace P4::P4Tools::Flay
+
+#endif  // BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_Z3_COFACTOR_CACHE_H_
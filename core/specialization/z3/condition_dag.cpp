@@ -0,0 +1,202 @@
+#include "backends/p4tools/modules/flay/core/specialization/z3/condition_dag.h"
+
+#include <utility>
+
+#include "backends/p4tools/modules/flay/core/lib/z3_cache.h"
+
+namespace P4::P4Tools::Flay {
+
+/**************************************************************************************************
+Z3ConditionDag
+**************************************************************************************************/
+
+z3::expr Z3ConditionDag::translate(const IR::Expression *condition) {
+    auto it = _terms.find(condition);
+    if (it != _terms.end()) {
+        return it->second;
+    }
+    auto term = [this, condition]() -> z3::expr {
+        if (const auto *lAnd = condition->to<IR::LAnd>()) {
+            return translate(lAnd->left) && translate(lAnd->right);
+        }
+        if (const auto *lOr = condition->to<IR::LOr>()) {
+            return translate(lOr->left) || translate(lOr->right);
+        }
+        if (const auto *lNot = condition->to<IR::LNot>()) {
+            return !translate(lNot->expr);
+        }
+        if (const auto *mux = condition->to<IR::Mux>()) {
+            if (mux->type->is<IR::Type_Boolean>()) {
+                return z3::ite(translate(mux->e0), translate(mux->e1), translate(mux->e2));
+            }
+        }
+        return Z3Cache::set(condition);
+    }();
+    _terms.emplace(condition, term);
+    return term;
+}
+
+const Z3GroundProgram *Z3ConditionDag::groundProgram(const z3::expr &atom) {
+    auto it = _groundPrograms.find(atom.id());
+    if (it == _groundPrograms.end()) {
+        auto compiledAtom = std::make_pair(atom, Z3GroundProgram::compile(atom));
+        it = _groundPrograms.emplace(atom.id(), std::move(compiledAtom)).first;
+    }
+    const auto &program = it->second.second;
+    return program.has_value() ? &program.value() : nullptr;
+}
+
+size_t Z3ConditionDag::size() const { return _terms.size(); }
+
+uint64_t Z3ConditionDag::estimateMemoryUsage() const {
+    // Swiss tables use one control byte per slot.
+    uint64_t bytes = _terms.capacity() * (sizeof(decltype(_terms)::value_type) + 1);
+    bytes += _groundPrograms.capacity() * (sizeof(decltype(_groundPrograms)::value_type) + 1);
+    for (const auto &[id, compiledAtom] : _groundPrograms) {
+        if (compiledAtom.second.has_value()) {
+            bytes += compiledAtom.second->estimateMemoryUsage();
+        }
+    }
+    return bytes;
+}
+
+/**************************************************************************************************
+Z3ConditionEvaluation
+**************************************************************************************************/
+
+Z3ConditionEvaluation::Z3ConditionEvaluation(Z3ConditionDag &conditionDag,
+                                             const Z3ControlPlaneAssignmentSet &assignmentSet)
+    : _conditionDag(conditionDag),
+      _substitutionVariables(Z3Cache::context()),
+      _substitutionAssignments(Z3Cache::context()) {
+    assignmentSet.collectSubstitutions(_substitutionVariables, _substitutionAssignments);
+    _groundAssignment = Z3GroundProgram::collectGroundAssignment(_substitutionVariables,
+                                                                 _substitutionAssignments);
+}
+
+Z3ConditionEvaluation::Z3ConditionEvaluation(Z3ConditionDag &conditionDag,
+                                             const z3::expr_vector &variables,
+                                             const z3::expr_vector &values)
+    : _conditionDag(conditionDag),
+      _substitutionVariables(variables),
+      _substitutionAssignments(values),
+      _groundAssignment(Z3GroundProgram::collectGroundAssignment(variables, values)) {}
+
+z3::expr Z3ConditionEvaluation::evaluateJunction(const z3::expr &term, bool isConjunction) {
+    z3::expr_vector undecidedArguments(term.ctx());
+    for (unsigned idx = 0; idx < term.num_args(); ++idx) {
+        auto argument = evaluateTerm(term.arg(idx));
+        // A false argument decides a conjunction, a true argument a disjunction.
+        if (isConjunction ? argument.is_false() : argument.is_true()) {
+            return argument;
+        }
+        if (isConjunction ? !argument.is_true() : !argument.is_false()) {
+            undecidedArguments.push_back(argument);
+        }
+    }
+    if (undecidedArguments.empty()) {
+        return term.ctx().bool_val(isConjunction);
+    }
+    if (undecidedArguments.size() == 1) {
+        return undecidedArguments[0];
+    }
+    return isConjunction ? z3::mk_and(undecidedArguments) : z3::mk_or(undecidedArguments);
+}
+
+z3::expr Z3ConditionEvaluation::evaluateTerm(const z3::expr &term) {
+    auto it = _evaluatedTerms.find(term.id());
+    if (it != _evaluatedTerms.end()) {
+        _hitCount++;
+        return it->second;
+    }
+    _missCount++;
+
+    auto result = [this, &term]() -> z3::expr {
+        if (!term.is_app()) {
+            return term;
+        }
+        switch (term.decl().decl_kind()) {
+            case Z3_OP_TRUE:
+            case Z3_OP_FALSE:
+                return term;
+            case Z3_OP_AND:
+                return evaluateJunction(term, true);
+            case Z3_OP_OR:
+                return evaluateJunction(term, false);
+            case Z3_OP_NOT: {
+                auto argument = evaluateTerm(term.arg(0));
+                if (argument.is_true() || argument.is_false()) {
+                    return term.ctx().bool_val(argument.is_false());
+                }
+                return !argument;
+            }
+            case Z3_OP_ITE: {
+                if (!term.is_bool()) {
+                    break;
+                }
+                auto condition = evaluateTerm(term.arg(0));
+                if (condition.is_true()) {
+                    return evaluateTerm(term.arg(1));
+                }
+                if (condition.is_false()) {
+                    return evaluateTerm(term.arg(2));
+                }
+                return z3::ite(condition, evaluateTerm(term.arg(1)), evaluateTerm(term.arg(2)));
+            }
+            default:
+                break;
+        }
+        // An atom. If all its variables are constants, there is no need for Z3.
+        if (const auto *groundProgram = _conditionDag.groundProgram(term)) {
+            if (auto value = groundProgram->evaluate(_groundAssignment)) {
+                _groundCount++;
+                return term.ctx().bool_val(value.value() != 0);
+            }
+        }
+        // Substitute the control-plane variables the atom contains.
+        auto atom = term;
+        return atom.substitute(_substitutionVariables, _substitutionAssignments).simplify();
+    }();
+    _evaluatedTerms.emplace(term.id(), result);
+    return result;
+}
+
+z3::expr Z3ConditionEvaluation::evaluate(const z3::expr &condition) {
+    auto result = evaluateTerm(condition);
+    if (result.is_true() || result.is_false()) {
+        return result;
+    }
+    // Simplify the whole remainder, which may still be decided by the interplay of its atoms,
+    // e.g., if it contains an atom and its negation.
+    auto it = _simplifiedConditions.find(result.id());
+    if (it != _simplifiedConditions.end()) {
+        return it->second;
+    }
+    auto simplified = result.simplify();
+    _simplifiedConditions.emplace(result.id(), simplified);
+    return simplified;
+}
+
+z3::expr Z3ConditionEvaluation::reduce(const z3::expr &condition) {
+    return evaluateTerm(condition);
+}
+
+const Z3GroundAssignment &Z3ConditionEvaluation::groundAssignment() const {
+    return _groundAssignment;
+}
+
+uint64_t Z3ConditionEvaluation::hitCount() const { return _hitCount; }
+
+uint64_t Z3ConditionEvaluation::missCount() const { return _missCount; }
+
+uint64_t Z3ConditionEvaluation::groundCount() const { return _groundCount; }
+
+uint64_t Z3ConditionEvaluation::estimateMemoryUsage() const {
+    // Swiss tables use one control byte per slot.
+    return _groundAssignment.capacity() * (sizeof(Z3GroundAssignment::value_type) + 1) +
+           _evaluatedTerms.capacity() * (sizeof(decltype(_evaluatedTerms)::value_type) + 1) +
+           _simplifiedConditions.capacity() *
+               (sizeof(decltype(_simplifiedConditions)::value_type) + 1);
+}
+
+}  // namespace P4::P4Tools::Flay
@@ -0,0 +1,127 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_Z3_CONDITION_DAG_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_Z3_CONDITION_DAG_H_
+
+#include <z3++.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "backends/p4tools/modules/flay/core/control_plane/z3_control_plane_assignment.h"
+#include "backends/p4tools/modules/flay/core/specialization/z3/ground_program.h"
+#include "ir/ir.h"
+
+namespace P4::P4Tools::Flay {
+
+/// Translates reachability conditions into Z3 while preserving their structure. The condition of
+/// a node extends the execution condition of the enclosing nodes, so the conditions of a program
+/// share long prefixes. Z3 shares structurally equal terms, but simplification flattens
+/// conjunctions into a single term per condition, which no longer contains the prefixes. The
+/// connectives of a condition are therefore translated as they are and only the atoms, e.g.,
+/// comparisons, are simplified.
+class Z3ConditionDag {
+    /// The translated conditions and subconditions, keyed by IR node.
+    absl::flat_hash_map<const IR::Expression *, z3::expr> _terms;
+
+    /// The compiled atoms, keyed by the id of their Z3 term. The term is kept to keep the id
+    /// valid. The program is std::nullopt if the atom can not be evaluated natively.
+    absl::flat_hash_map<unsigned, std::pair<z3::expr, std::optional<Z3GroundProgram>>>
+        _groundPrograms;
+
+ public:
+    /// @returns the translation of @p condition.
+    z3::expr translate(const IR::Expression *condition);
+
+    /// @returns the compiled program of @p atom, or nullptr if the atom can not be evaluated
+    /// natively. Atoms are compiled on first use.
+    const Z3GroundProgram *groundProgram(const z3::expr &atom);
+
+    /// @returns the number of translated IR nodes.
+    [[nodiscard]] size_t size() const;
+
+    /// @returns the approximate number of bytes held by the DAG, excluding Z3 terms.
+    [[nodiscard]] uint64_t estimateMemoryUsage() const;
+};
+
+/// Evaluates conditions built by a Z3ConditionDag under a single assignment of the control-plane
+/// variables. Every distinct subterm is substituted and simplified at most once and the result is
+/// reused by all conditions which contain it. The results are only valid for the assignment, so a
+/// new evaluation is needed whenever the control plane changes.
+///
+/// Atoms whose variables are all assigned numerals or boolean literals are evaluated natively.
+/// Z3 is only used for atoms which remain symbolic.
+class Z3ConditionEvaluation {
+    /// The DAG which built the conditions.
+    Z3ConditionDag &_conditionDag;
+
+    /// The control-plane variables to substitute.
+    z3::expr_vector _substitutionVariables;
+
+    /// The values of the control-plane variables, in the order of the variables.
+    z3::expr_vector _substitutionAssignments;
+
+    /// The concrete values of the control-plane variables which are assigned a constant.
+    Z3GroundAssignment _groundAssignment;
+
+    /// The evaluated subterms, keyed by the id of the Z3 term.
+    absl::flat_hash_map<unsigned, z3::expr> _evaluatedTerms;
+
+    /// The simplified undecided conditions, keyed by the id of the unsimplified condition.
+    absl::flat_hash_map<unsigned, z3::expr> _simplifiedConditions;
+
+    /// The number of subterms which were already evaluated.
+    uint64_t _hitCount = 0;
+
+    /// The number of subterms which had to be evaluated.
+    uint64_t _missCount = 0;
+
+    /// The number of atoms which were evaluated natively.
+    uint64_t _groundCount = 0;
+
+    /// Evaluate @p term and memoize the result.
+    z3::expr evaluateTerm(const z3::expr &term);
+
+    /// Evaluate the conjunction or disjunction @p term. Stops at the first argument which decides
+    /// the result.
+    z3::expr evaluateJunction(const z3::expr &term, bool isConjunction);
+
+ public:
+    Z3ConditionEvaluation(Z3ConditionDag &conditionDag,
+                          const Z3ControlPlaneAssignmentSet &assignmentSet);
+
+    /// Evaluate under the assignment of each of @p variables to the value at the same position in
+    /// @p values.
+    Z3ConditionEvaluation(Z3ConditionDag &conditionDag, const z3::expr_vector &variables,
+                          const z3::expr_vector &values);
+
+    /// @returns @p condition under the assignment. The result is true or false if the assignment
+    /// decides the condition.
+    z3::expr evaluate(const z3::expr &condition);
+
+    /// @returns @p condition under the assignment without simplifying the remainder as a whole.
+    /// The connectives of the condition are kept, so the result shares its subterms with the
+    /// results of all other conditions of this evaluation and can itself be evaluated again.
+    z3::expr reduce(const z3::expr &condition);
+
+    /// @returns the concrete values of the control-plane variables which are assigned a
+    /// constant.
+    [[nodiscard]] const Z3GroundAssignment &groundAssignment() const;
+
+    /// @returns the number of subterms which were already evaluated.
+    [[nodiscard]] uint64_t hitCount() const;
+
+    /// @returns the number of subterms which had to be evaluated.
+    [[nodiscard]] uint64_t missCount() const;
+
+    /// @returns the number of atoms which were evaluated natively.
+    [[nodiscard]] uint64_t groundCount() const;
+
+    /// @returns the approximate number of bytes held by the evaluation, excluding Z3 terms.
+    [[nodiscard]] uint64_t estimateMemoryUsage() const;
+};
+
+}  // namespace P4::P4Tools::Flay
+
+#endif  // BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_Z3_CONDITION_DAG_H_
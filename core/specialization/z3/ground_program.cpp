@@ -0,0 +1,351 @@
+#include "backends/p4tools/modules/flay/core/specialization/z3/ground_program.h"
+
+#include "absl/container/inlined_vector.h"
+
+namespace P4::P4Tools::Flay {
+
+namespace {
+
+/// The widest bit vector which is evaluated natively.
+constexpr uint32_t kMaxWidth = 64;
+
+/// @returns the width of the values of @p term, or std::nullopt if the term is neither a boolean
+/// nor a bit vector of at most kMaxWidth bits.
+std::optional<uint32_t> valueWidth(const z3::expr &term) {
+    if (term.is_bool()) {
+        return 1;
+    }
+    if (term.is_bv() && term.get_sort().bv_size() <= kMaxWidth) {
+        return term.get_sort().bv_size();
+    }
+    return std::nullopt;
+}
+
+/// @returns the mask of the low @p width bits.
+uint64_t widthMask(uint32_t width) {
+    return width >= kMaxWidth ? ~static_cast<uint64_t>(0) : (static_cast<uint64_t>(1) << width) - 1;
+}
+
+/// @returns @p value of @p width bits interpreted as two's complement number.
+int64_t toSigned(uint64_t value, uint32_t width) {
+    if (width >= kMaxWidth) {
+        return static_cast<int64_t>(value);
+    }
+    auto shift = kMaxWidth - width;
+    return static_cast<int64_t>(value << shift) >> shift;
+}
+
+}  // namespace
+
+void Z3GroundProgram::emit(Opcode opcode, uint32_t width, uint64_t operand) {
+    _instructions.push_back({opcode, width, operand});
+}
+
+bool Z3GroundProgram::compileFold(const z3::expr &term, Opcode opcode, uint32_t width,
+                                  std::map<unsigned, uint64_t> &slots) {
+    if (term.num_args() == 0 || !compileTerm(term.arg(0), slots)) {
+        return false;
+    }
+    for (unsigned idx = 1; idx < term.num_args(); ++idx) {
+        if (!compileTerm(term.arg(idx), slots)) {
+            return false;
+        }
+        emit(opcode, width);
+    }
+    return true;
+}
+
+bool Z3GroundProgram::compileTerm(const z3::expr &term, std::map<unsigned, uint64_t> &slots) {
+    auto width = valueWidth(term);
+    if (!width.has_value() || !term.is_app()) {
+        return false;
+    }
+    if (term.is_numeral()) {
+        emit(Opcode::kConstant, width.value(), term.get_numeral_uint64());
+        return true;
+    }
+    auto declKind = term.decl().decl_kind();
+    if (declKind == Z3_OP_UNINTERPRETED) {
+        if (term.num_args() != 0) {
+            return false;
+        }
+        auto [it, inserted] = slots.emplace(term.id(), _variables.size());
+        if (inserted) {
+            _variables.push_back(term.id());
+        }
+        emit(Opcode::kVariable, width.value(), it->second);
+        return true;
+    }
+
+    // Comparisons and ites are typed by their operands.
+    auto compileComparison = [&](Opcode opcode, bool swapOperands) {
+        if (term.num_args() != 2) {
+            return false;
+        }
+        auto operandWidth = valueWidth(term.arg(0));
+        if (!operandWidth.has_value()) {
+            return false;
+        }
+        const auto &left = swapOperands ? term.arg(1) : term.arg(0);
+        const auto &right = swapOperands ? term.arg(0) : term.arg(1);
+        if (!compileTerm(left, slots) || !compileTerm(right, slots)) {
+            return false;
+        }
+        emit(opcode, operandWidth.value());
+        return true;
+    };
+
+    switch (declKind) {
+        case Z3_OP_TRUE:
+            emit(Opcode::kConstant, 1, 1);
+            return true;
+        case Z3_OP_FALSE:
+            emit(Opcode::kConstant, 1, 0);
+            return true;
+        case Z3_OP_AND:
+        case Z3_OP_BAND:
+            return compileFold(term, Opcode::kAnd, width.value(), slots);
+        case Z3_OP_OR:
+        case Z3_OP_BOR:
+            return compileFold(term, Opcode::kOr, width.value(), slots);
+        case Z3_OP_XOR:
+        case Z3_OP_BXOR:
+            return compileFold(term, Opcode::kXor, width.value(), slots);
+        case Z3_OP_BADD:
+            return compileFold(term, Opcode::kAdd, width.value(), slots);
+        case Z3_OP_BSUB:
+            return compileFold(term, Opcode::kSub, width.value(), slots);
+        case Z3_OP_BMUL:
+            return compileFold(term, Opcode::kMul, width.value(), slots);
+        case Z3_OP_BSHL:
+            return compileFold(term, Opcode::kShl, width.value(), slots);
+        case Z3_OP_BLSHR:
+            return compileFold(term, Opcode::kLshr, width.value(), slots);
+        case Z3_OP_NOT:
+        case Z3_OP_BNOT:
+            if (!compileTerm(term.arg(0), slots)) {
+                return false;
+            }
+            emit(Opcode::kNot, width.value());
+            return true;
+        case Z3_OP_BNEG:
+            // -x = 0 - x.
+            emit(Opcode::kConstant, width.value(), 0);
+            if (!compileTerm(term.arg(0), slots)) {
+                return false;
+            }
+            emit(Opcode::kSub, width.value());
+            return true;
+        case Z3_OP_IMPLIES:
+            // a => b = !a | b.
+            if (!compileTerm(term.arg(0), slots)) {
+                return false;
+            }
+            emit(Opcode::kNot, 1);
+            if (!compileTerm(term.arg(1), slots)) {
+                return false;
+            }
+            emit(Opcode::kOr, 1);
+            return true;
+        case Z3_OP_EQ:
+            return compileComparison(Opcode::kEq, false);
+        case Z3_OP_DISTINCT:
+            if (!compileComparison(Opcode::kEq, false)) {
+                return false;
+            }
+            emit(Opcode::kNot, 1);
+            return true;
+        case Z3_OP_ULT:
+            return compileComparison(Opcode::kUlt, false);
+        case Z3_OP_ULEQ:
+            return compileComparison(Opcode::kUle, false);
+        case Z3_OP_UGT:
+            return compileComparison(Opcode::kUlt, true);
+        case Z3_OP_UGEQ:
+            return compileComparison(Opcode::kUle, true);
+        case Z3_OP_SLT:
+            return compileComparison(Opcode::kSlt, false);
+        case Z3_OP_SLEQ:
+            return compileComparison(Opcode::kSle, false);
+        case Z3_OP_SGT:
+            return compileComparison(Opcode::kSlt, true);
+        case Z3_OP_SGEQ:
+            return compileComparison(Opcode::kSle, true);
+        case Z3_OP_ITE:
+            if (!compileTerm(term.arg(0), slots) || !compileTerm(term.arg(1), slots) ||
+                !compileTerm(term.arg(2), slots)) {
+                return false;
+            }
+            emit(Opcode::kIte, width.value());
+            return true;
+        case Z3_OP_CONCAT: {
+            if (term.num_args() == 0 || !compileTerm(term.arg(0), slots)) {
+                return false;
+            }
+            for (unsigned idx = 1; idx < term.num_args(); ++idx) {
+                auto lowWidth = valueWidth(term.arg(idx));
+                if (!lowWidth.has_value() || !compileTerm(term.arg(idx), slots)) {
+                    return false;
+                }
+                emit(Opcode::kConcat, lowWidth.value());
+            }
+            return true;
+        }
+        case Z3_OP_EXTRACT:
+            if (!compileTerm(term.arg(0), slots)) {
+                return false;
+            }
+            emit(Opcode::kExtract, width.value(), term.lo());
+            return true;
+        case Z3_OP_ZERO_EXT:
+            // Values are kept zero-extended.
+            return compileTerm(term.arg(0), slots);
+        case Z3_OP_SIGN_EXT: {
+            auto sourceWidth = valueWidth(term.arg(0));
+            if (!sourceWidth.has_value() || !compileTerm(term.arg(0), slots)) {
+                return false;
+            }
+            emit(Opcode::kSignExtend, width.value(), sourceWidth.value());
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+std::optional<Z3GroundProgram> Z3GroundProgram::compile(const z3::expr &term) {
+    Z3GroundProgram program;
+    std::map<unsigned, uint64_t> slots;
+    if (!program.compileTerm(term, slots)) {
+        return std::nullopt;
+    }
+    return program;
+}
+
+std::optional<uint64_t> Z3GroundProgram::evaluate(const Z3GroundAssignment &assignment) const {
+    // Resolve all variables first, so a program with a symbolic variable fails early.
+    absl::InlinedVector<uint64_t, 8> slotValues;
+    slotValues.reserve(_variables.size());
+    for (auto variable : _variables) {
+        auto it = assignment.find(variable);
+        if (it == assignment.end()) {
+            return std::nullopt;
+        }
+        slotValues.push_back(it->second);
+    }
+
+    absl::InlinedVector<uint64_t, 16> stack;
+    for (const auto &instruction : _instructions) {
+        auto mask = widthMask(instruction.width);
+        switch (instruction.opcode) {
+            case Opcode::kConstant:
+                stack.push_back(instruction.operand);
+                continue;
+            case Opcode::kVariable:
+                stack.push_back(slotValues[instruction.operand] & mask);
+                continue;
+            case Opcode::kNot:
+                stack.back() = ~stack.back() & mask;
+                continue;
+            case Opcode::kExtract:
+                stack.back() = (stack.back() >> instruction.operand) & mask;
+                continue;
+            case Opcode::kSignExtend: {
+                auto sourceWidth = static_cast<uint32_t>(instruction.operand);
+                stack.back() = static_cast<uint64_t>(toSigned(stack.back(), sourceWidth)) & mask;
+                continue;
+            }
+            case Opcode::kIte: {
+                auto falseValue = stack.back();
+                stack.pop_back();
+                auto trueValue = stack.back();
+                stack.pop_back();
+                stack.back() = stack.back() != 0 ? trueValue : falseValue;
+                continue;
+            }
+            default:
+                break;
+        }
+        // Binary operations.
+        auto right = stack.back();
+        stack.pop_back();
+        auto &left = stack.back();
+        switch (instruction.opcode) {
+            case Opcode::kAnd:
+                left &= right;
+                break;
+            case Opcode::kOr:
+                left |= right;
+                break;
+            case Opcode::kXor:
+                left ^= right;
+                break;
+            case Opcode::kAdd:
+                left = (left + right) & mask;
+                break;
+            case Opcode::kSub:
+                left = (left - right) & mask;
+                break;
+            case Opcode::kMul:
+                left = (left * right) & mask;
+                break;
+            case Opcode::kShl:
+                left = right >= instruction.width ? 0 : (left << right) & mask;
+                break;
+            case Opcode::kLshr:
+                left = right >= instruction.width ? 0 : left >> right;
+                break;
+            case Opcode::kEq:
+                left = static_cast<uint64_t>(left == right);
+                break;
+            case Opcode::kUlt:
+                left = static_cast<uint64_t>(left < right);
+                break;
+            case Opcode::kUle:
+                left = static_cast<uint64_t>(left <= right);
+                break;
+            case Opcode::kSlt:
+                left = static_cast<uint64_t>(toSigned(left, instruction.width) <
+                                             toSigned(right, instruction.width));
+                break;
+            case Opcode::kSle:
+                left = static_cast<uint64_t>(toSigned(left, instruction.width) <=
+                                             toSigned(right, instruction.width));
+                break;
+            case Opcode::kConcat:
+                left = (left << instruction.width) | right;
+                break;
+            default:
+                return std::nullopt;
+        }
+    }
+    return stack.back();
+}
+
+Z3GroundAssignment Z3GroundProgram::collectGroundAssignment(const z3::expr_vector &variables,
+                                                            const z3::expr_vector &assignments) {
+    Z3GroundAssignment groundAssignment;
+    for (unsigned idx = 0; idx < variables.size(); ++idx) {
+        auto assignment = assignments[static_cast<int>(idx)];
+        auto width = valueWidth(assignment);
+        if (!width.has_value()) {
+            continue;
+        }
+        auto variableId = variables[static_cast<int>(idx)].id();
+        if (assignment.is_true() || assignment.is_false()) {
+            groundAssignment.emplace(variableId, static_cast<uint64_t>(assignment.is_true()));
+        } else if (assignment.is_numeral()) {
+            groundAssignment.emplace(variableId, assignment.get_numeral_uint64());
+        }
+    }
+    return groundAssignment;
+}
+
+size_t Z3GroundProgram::size() const { return _instructions.size(); }
+
+uint64_t Z3GroundProgram::estimateMemoryUsage() const {
+    return _instructions.capacity() * sizeof(Instruction) +
+           _variables.capacity() * sizeof(unsigned);
+}
+
+}  // namespace P4::P4Tools::Flay
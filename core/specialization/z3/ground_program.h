@@ -0,0 +1,105 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_Z3_GROUND_PROGRAM_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_Z3_GROUND_PROGRAM_H_
+
+#include <z3++.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+
+namespace P4::P4Tools::Flay {
+
+/// Concrete values of variables, keyed by the id of their Z3 constant. Booleans are 0 or 1.
+using Z3GroundAssignment = absl::flat_hash_map<unsigned, uint64_t>;
+
+/// A Z3 term compiled into a program for a small stack machine. Once all variables of the term
+/// have concrete values, the program evaluates the term without Z3. Supports booleans and bit
+/// vectors of up to 64 bits with the operators that the translation of P4 expressions produces.
+class Z3GroundProgram {
+ public:
+    /// The operations of the stack machine. Binary operations pop their right operand first.
+    enum class Opcode : uint8_t {
+        kConstant,
+        kVariable,
+        kNot,
+        kAnd,
+        kOr,
+        kXor,
+        kAdd,
+        kSub,
+        kMul,
+        kShl,
+        kLshr,
+        kEq,
+        kUlt,
+        kUle,
+        kSlt,
+        kSle,
+        kIte,
+        kConcat,
+        kExtract,
+        kSignExtend,
+    };
+
+ private:
+    /// A single operation of the program.
+    struct Instruction {
+        /// The operation.
+        Opcode opcode;
+
+        /// The width of the result. For comparisons, the width of the operands. For kConcat, the
+        /// width of the low operand.
+        uint32_t width;
+
+        /// The value of a constant, the slot of a variable, the low bit of an extraction, or the
+        /// source width of a sign extension.
+        uint64_t operand;
+    };
+
+    /// The instructions in postfix order.
+    std::vector<Instruction> _instructions;
+
+    /// The ids of the variables, indexed by slot.
+    std::vector<unsigned> _variables;
+
+    /// Append the instructions which compute @p term.
+    /// @returns false if the term contains an unsupported operation or width.
+    bool compileTerm(const z3::expr &term, std::map<unsigned, uint64_t> &slots);
+
+    /// Append the instructions which fold the arguments of @p term with @p opcode.
+    bool compileFold(const z3::expr &term, Opcode opcode, uint32_t width,
+                     std::map<unsigned, uint64_t> &slots);
+
+    /// Append an instruction.
+    void emit(Opcode opcode, uint32_t width, uint64_t operand = 0);
+
+    Z3GroundProgram() = default;
+
+ public:
+    /// Compile @p term.
+    /// @returns std::nullopt if the term can not be evaluated natively.
+    static std::optional<Z3GroundProgram> compile(const z3::expr &term);
+
+    /// Evaluate the program under @p assignment.
+    /// @returns std::nullopt if a variable of the program has no concrete value.
+    [[nodiscard]] std::optional<uint64_t> evaluate(const Z3GroundAssignment &assignment) const;
+
+    /// @returns the concrete values in @p assignments, keyed by the corresponding entry of
+    /// @p variables. Assignments which are not numerals or boolean literals are skipped.
+    static Z3GroundAssignment collectGroundAssignment(const z3::expr_vector &variables,
+                                                      const z3::expr_vector &assignments);
+
+    /// @returns the number of instructions.
+    [[nodiscard]] size_t size() const;
+
+    /// @returns the approximate number of bytes held by the program.
+    [[nodiscard]] uint64_t estimateMemoryUsage() const;
+};
+
+}  // namespace P4::P4Tools::Flay
+
+#endif  // BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_Z3_GROUND_PROGRAM_H_
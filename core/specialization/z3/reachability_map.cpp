@@ -5,6 +5,9 @@
 #include <cstdio>
 #include <utility>
 
+#include "backends/p4tools/modules/flay/core/lib/memory_usage.h"
+#include "backends/p4tools/modules/flay/core/lib/z3_cache.h"
+#include "backends/p4tools/modules/flay/core/specialization/z3/condition_dag.h"
 #include "lib/timer.h"
 
 namespace P4::P4Tools::Flay {
@@ -16,7 +19,7 @@ Z3ReachabilityExpression::Z3ReachabilityExpression(ReachabilityExpression reacha
 z3::expr &Z3ReachabilityExpression::getZ3Condition() { return _z3Condition; }
 
 std::optional<bool> Z3SolverReachabilityMap::computeNodeReachability(
-    const IR::Node *node, const Z3ControlPlaneAssignmentSet &assignmentSet) {
+    const IR::Node *node, Z3ConditionEvaluation &conditionEvaluation) {
     auto it = find(node);
     if (it == end()) {
         error("Reachability mapping for node %1% does not exist.", node);
@@ -24,7 +27,15 @@ std::optional<bool> Z3SolverReachabilityMap::computeNodeReachability(
     }
     auto *reachabilityExpression = it->second;
     auto &reachabilityCondition = reachabilityExpression->getZ3Condition();
-    auto newExpr = assignmentSet.substitute(reachabilityCondition).simplify();
+    // If the condition is cofactored, its symbol is already replaced by its current value.
+    auto cofactor =
+        _cofactorCache.lookup(reachabilityCondition, conditionEvaluation.groundAssignment());
+    auto newExpr = conditionEvaluation.evaluate(cofactor.value_or(reachabilityCondition));
+    // Simplification does not detect every condition which can not hold.
+    if (_solver.has_value() && !newExpr.is_true() && !newExpr.is_false() &&
+        _solver->isSatisfiable(reachabilityCondition) == false) {
+        newExpr = newExpr.ctx().bool_val(false);
+    }
     auto reachabilityAssignment = reachabilityExpression->getReachability();
     auto declKind = newExpr.decl().decl_kind();
     if (declKind == Z3_decl_kind::Z3_OP_FALSE || declKind == Z3_decl_kind::Z3_OP_TRUE) {
@@ -44,17 +55,25 @@ std::optional<bool> Z3SolverReachabilityMap::computeNodeReachability(
     return false;
 }
 
-Z3SolverReachabilityMap::Z3SolverReachabilityMap(const NodeAnnotationMap &map)
-    : _symbolMap(map.reachabilitySymbolMap()) {
+Z3SolverReachabilityMap::Z3SolverReachabilityMap(const NodeAnnotationMap &map,
+                                                 const IR::P4Program &program,
+                                                 std::optional<uint64_t> solverBudgetMilliseconds,
+                                                 uint64_t solverUpdateBudgetMilliseconds)
+    : _symbolMap(map.reachabilitySymbolMap()), _cofactorCache(_conditionDag) {
     Util::ScopedTimer timer("Precomputing Z3 Reachability");
+    if (solverBudgetMilliseconds.has_value()) {
+        _solver.emplace(Z3Cache::context(), solverBudgetMilliseconds.value(),
+                        solverUpdateBudgetMilliseconds);
+    }
+    // The conditions share the execution conditions of enclosing nodes. Keep them shared.
     for (const auto &[node, reachabilityExpression] : map.reachabilityMap()) {
-        (*this)[node] = new Z3ReachabilityExpression(
-            *reachabilityExpression,
-            Z3Cache::set(reachabilityExpression->getCondition()).simplify());
+        auto z3Condition = _conditionDag.translate(reachabilityExpression->getCondition());
+        (*this)[node] = new Z3ReachabilityExpression(*reachabilityExpression, z3Condition);
         // printInfo("Computing reachability for %1%:\t%2%", node,
         //           reachabilityExpression->getCondition());
         // printInfo("##############");
     }
+    _hierarchy = ReachabilityHierarchy(program, map.reachabilityMap());
 }
 
 std::optional<bool> Z3SolverReachabilityMap::isNodeReachable(const IR::Node *node) const {
@@ -72,6 +91,24 @@ std::optional<bool> Z3SolverReachabilityMap::isNodeReachable(const IR::Node *nod
     return std::nullopt;
 }
 
+const Z3CofactorCache &Z3SolverReachabilityMap::cofactorCache() const { return _cofactorCache; }
+
+const Z3ReachabilitySolver *Z3SolverReachabilityMap::solver() const {
+    return _solver.has_value() ? &_solver.value() : nullptr;
+}
+
+uint64_t Z3SolverReachabilityMap::estimateMemoryUsage() const {
+    const auto &reachabilityMap =
+        static_cast<const std::map<const IR::Node *, Z3ReachabilityExpression *, SourceIdCmp> &>(
+            *this);
+    return MemoryUsage::estimateContainerMemory(reachabilityMap) +
+           reachabilityMap.size() * sizeof(Z3ReachabilityExpression) +
+           MemoryUsage::estimateNestedContainerMemory(_symbolMap) +
+           _hierarchy.estimateMemoryUsage() + _conditionDag.estimateMemoryUsage() +
+           _cofactorCache.estimateMemoryUsage() +
+           (_solver.has_value() ? _solver->estimateMemoryUsage() : 0);
+}
+
 std::optional<bool> Z3SolverReachabilityMap::recomputeReachability(
     const ControlPlaneConstraints &controlPlaneConstraints) {
     /// Generate IR equalities from the control plane constraints.
@@ -80,19 +117,29 @@ std::optional<bool> Z3SolverReachabilityMap::recomputeReachability(
         assignmentSet.merge(controlPlaneConstraint.get().computeZ3ControlPlaneAssignments());
     }
 
-    bool hasChanged = false;
-    for (auto &pair : *this) {
-        auto result = computeNodeReachability(pair.first, assignmentSet);
-        if (!result.has_value()) {
-            return std::nullopt;
-        }
-        hasChanged |= result.value();
+    NodeSet targetNodes;
+    for (const auto &pair : *this) {
+        targetNodes.insert(pair.first);
     }
-    return hasChanged;
+    return recomputeReachability(targetNodes, assignmentSet);
 }
 
 std::optional<bool> Z3SolverReachabilityMap::recomputeReachability(
     const SymbolSet &symbolSet, const ControlPlaneConstraints &controlPlaneConstraints) {
+    // Cofactor the conditions which depend on symbols that keep changing.
+    for (const auto &symbol : _cofactorCache.recordChanges(symbolSet)) {
+        auto it = _symbolMap.find(symbol);
+        if (it == _symbolMap.end()) {
+            continue;
+        }
+        auto symbolTerm = Z3Cache::set(&symbol.get());
+        for (const auto *node : it->second) {
+            auto nodeIt = find(node);
+            if (nodeIt != end()) {
+                _cofactorCache.addCondition(nodeIt->second->getZ3Condition(), symbolTerm);
+            }
+        }
+    }
     NodeSet targetNodes;
     for (const auto &symbol : symbolSet) {
         auto it = _symbolMap.find(symbol);
@@ -113,15 +160,28 @@ std::optional<bool> Z3SolverReachabilityMap::recomputeReachability(
         assignmentSet.merge(controlPlaneConstraint.get().computeZ3ControlPlaneAssignments());
     }
 
-    bool hasChanged = false;
-    for (const auto *node : targetNodes) {
-        auto result = computeNodeReachability(node, assignmentSet);
-        if (!result.has_value()) {
-            return std::nullopt;
-        }
-        hasChanged |= result.value();
+    return recomputeReachability(targetNodes, assignmentSet);
+}
+
+std::optional<bool> Z3SolverReachabilityMap::recomputeReachability(
+    const NodeSet &targetNodes, const Z3ControlPlaneAssignmentSet &assignmentSet) {
+    // Shared subconditions are evaluated once for all target nodes.
+    Z3ConditionEvaluation conditionEvaluation(_conditionDag, assignmentSet);
+    if (_solver.has_value()) {
+        z3::expr_vector variables(Z3Cache::context());
+        z3::expr_vector values(Z3Cache::context());
+        assignmentSet.collectSubstitutions(variables, values);
+        _solver->setBindings(variables, values);
     }
-    return hasChanged;
+    return _hierarchy.recompute(
+        targetNodes,
+        [this](const IR::Node *node) -> ReachabilityExpression * {
+            auto it = find(node);
+            return it != end() ? it->second : nullptr;
+        },
+        [this, &conditionEvaluation](const IR::Node *node) {
+            return computeNodeReachability(node, conditionEvaluation);
+        });
 }
 
 }  // namespace P4::P4Tools::Flay
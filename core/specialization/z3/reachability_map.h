@@ -5,6 +5,9 @@
 
 #include "backends/p4tools/modules/flay/core/interpreter/node_map.h"
 #include "backends/p4tools/modules/flay/core/specialization/reachability_map.h"
+#include "backends/p4tools/modules/flay/core/specialization/z3/cofactor_cache.h"
+#include "backends/p4tools/modules/flay/core/specialization/z3/condition_dag.h"
+#include "backends/p4tools/modules/flay/core/specialization/z3/reachability_solver.h"
 
 namespace P4::P4Tools::Flay {
 
@@ -31,12 +34,33 @@ class Z3SolverReachabilityMap
     /// reachability map. This map can we used for incremental re-computation of reachability.
     SymbolMap _symbolMap;
 
-    /// Compute reachability for the node given the set of constraints.
+    /// The shared translation of the conditions of the map.
+    Z3ConditionDag _conditionDag;
+
+    /// The cofactors of the conditions which depend on frequently changing symbols.
+    Z3CofactorCache _cofactorCache;
+
+    /// Checks the conditions which simplification does not decide. Disabled if std::nullopt.
+    std::optional<Z3ReachabilitySolver> _solver;
+
+    /// Compute reachability for the node under the assignment of @p conditionEvaluation.
     std::optional<bool> computeNodeReachability(const IR::Node *node,
-                                                const Z3ControlPlaneAssignmentSet &assignmentSet);
+                                                Z3ConditionEvaluation &conditionEvaluation);
+
+    /// Recompute reachability for @p targetNodes given the set of constraints. Nodes below
+    /// unreachable nodes are not evaluated.
+    std::optional<bool> recomputeReachability(const NodeSet &targetNodes,
+                                              const Z3ControlPlaneAssignmentSet &assignmentSet);
 
  public:
-    explicit Z3SolverReachabilityMap(const NodeAnnotationMap &map);
+    /// Create the map for the nodes of @p map. @p program is the program the nodes belong to.
+    /// If @p solverBudgetMilliseconds is set, conditions which simplification does not decide are
+    /// checked with a solver, which may spend up to the budget on each of them and up to
+    /// @p solverUpdateBudgetMilliseconds on all of them in one update.
+    Z3SolverReachabilityMap(
+        const NodeAnnotationMap &map, const IR::P4Program &program,
+        std::optional<uint64_t> solverBudgetMilliseconds = std::nullopt,
+        uint64_t solverUpdateBudgetMilliseconds = Z3ReachabilitySolver::kMaxUpdateMilliseconds);
 
     std::optional<bool> recomputeReachability(
         const ControlPlaneConstraints &controlPlaneConstraints) override;
@@ -50,6 +74,14 @@ class Z3SolverReachabilityMap
         const ControlPlaneConstraints &controlPlaneConstraints) override;
 
     std::optional<bool> isNodeReachable(const IR::Node *node) const override;
+
+    /// @returns the cofactors of the conditions.
+    [[nodiscard]] const Z3CofactorCache &cofactorCache() const;
+
+    /// @returns the solver which checks undecided conditions, or nullptr if it is disabled.
+    [[nodiscard]] const Z3ReachabilitySolver *solver() const;
+
+    [[nodiscard]] uint64_t estimateMemoryUsage() const override;
 };
 
 }  // namespace P4::P4Tools::Flay
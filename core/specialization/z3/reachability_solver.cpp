@@ -0,0 +1,155 @@
+#include "backends/p4tools/modules/flay/core/specialization/z3/reachability_solver.h"
+
+#include <algorithm>
+
+#include "absl/container/flat_hash_set.h"
+
+namespace P4::P4Tools::Flay {
+
+Z3ReachabilitySolver::Z3ReachabilitySolver(z3::context &context, uint64_t budgetMilliseconds,
+                                           uint64_t updateBudgetMilliseconds)
+    : _solver(context),
+      _budgetMilliseconds(budgetMilliseconds),
+      _updateBudgetMilliseconds(updateBudgetMilliseconds) {
+    configureSolver(_budgetMilliseconds);
+}
+
+void Z3ReachabilitySolver::configureSolver(uint64_t timeoutMilliseconds) {
+    z3::params params(_solver.ctx());
+    params.set("timeout", static_cast<unsigned>(timeoutMilliseconds));
+    _solver.set(params);
+    _timeoutMilliseconds = timeoutMilliseconds;
+}
+
+z3::expr Z3ReachabilitySolver::createLiteral() {
+    auto &context = _solver.ctx();
+    return {context, Z3_mk_fresh_const(context, "reachable", context.bool_sort())};
+}
+
+z3::expr Z3ReachabilitySolver::bindingLiteral(const z3::expr &variable, const z3::expr &value) {
+    auto it = _bindingLiterals.find(std::make_pair(variable.id(), value.id()));
+    if (it == _bindingLiterals.end()) {
+        auto literal = createLiteral();
+        _solver.add(z3::implies(literal, variable == value));
+        it = _bindingLiterals
+                 .emplace(std::make_pair(variable.id(), value.id()), std::make_pair(value, literal))
+                 .first;
+    }
+    return it->second.second;
+}
+
+const std::tuple<z3::expr, z3::expr, std::vector<unsigned>> &
+Z3ReachabilitySolver::conditionLiteral(const z3::expr &condition) {
+    auto it = _conditionLiterals.find(condition.id());
+    if (it != _conditionLiterals.end()) {
+        return it->second;
+    }
+    // Collect the uninterpreted constants of the condition, which may be bound.
+    std::vector<unsigned> variables;
+    absl::flat_hash_set<unsigned> visitedTerms;
+    std::vector<z3::expr> worklist = {condition};
+    while (!worklist.empty()) {
+        auto term = worklist.back();
+        worklist.pop_back();
+        if (!term.is_app() || !visitedTerms.insert(term.id()).second) {
+            continue;
+        }
+        if (term.is_const() && term.decl().decl_kind() == Z3_OP_UNINTERPRETED) {
+            variables.push_back(term.id());
+            continue;
+        }
+        for (unsigned idx = 0; idx < term.num_args(); ++idx) {
+            worklist.push_back(term.arg(idx));
+        }
+    }
+    auto literal = createLiteral();
+    _solver.add(z3::implies(literal, condition));
+    return _conditionLiterals
+        .emplace(condition.id(), std::make_tuple(condition, literal, std::move(variables)))
+        .first->second;
+}
+
+void Z3ReachabilitySolver::limitAssertions() {
+    if (_bindingLiterals.size() + _conditionLiterals.size() <= kMaxAssertions) {
+        return;
+    }
+    _solver.reset();
+    configureSolver(_timeoutMilliseconds);
+    _bindingLiterals.clear();
+    _conditionLiterals.clear();
+}
+
+void Z3ReachabilitySolver::setBindings(const z3::expr_vector &variables,
+                                       const z3::expr_vector &values) {
+    _updateTime = {};
+    _bindings.clear();
+    for (unsigned idx = 0; idx < variables.size(); ++idx) {
+        const auto &variable = variables[static_cast<int>(idx)];
+        _bindings.insert_or_assign(variable.id(),
+                                   std::make_pair(variable, values[static_cast<int>(idx)]));
+    }
+}
+
+std::optional<bool> Z3ReachabilitySolver::isSatisfiable(const z3::expr &condition) {
+    auto updateMilliseconds = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(_updateTime).count());
+    if (updateMilliseconds >= _updateBudgetMilliseconds) {
+        _skippedCount++;
+        return std::nullopt;
+    }
+    limitAssertions();
+    // Copy the entry, adding bindings below may rehash the map of conditions.
+    auto [conditionTerm, literal, variables] = conditionLiteral(condition);
+    z3::expr_vector assumptions(_solver.ctx());
+    assumptions.push_back(literal);
+    for (auto variableId : variables) {
+        auto it = _bindings.find(variableId);
+        if (it != _bindings.end()) {
+            const auto &[variable, value] = it->second;
+            assumptions.push_back(bindingLiteral(variable, value));
+        }
+    }
+
+    // The last check of an update only gets the rest of the budget of the update.
+    auto timeoutMilliseconds =
+        std::min(_budgetMilliseconds, _updateBudgetMilliseconds - updateMilliseconds);
+    if (timeoutMilliseconds != _timeoutMilliseconds) {
+        configureSolver(timeoutMilliseconds);
+    }
+    _checkCount++;
+    auto start = std::chrono::steady_clock::now();
+    auto result = _solver.check(assumptions);
+    _updateTime += std::chrono::steady_clock::now() - start;
+    switch (result) {
+        case z3::unsat:
+            _unsatisfiableCount++;
+            return false;
+        case z3::sat:
+            return true;
+        default:
+            _unknownCount++;
+            return std::nullopt;
+    }
+}
+
+uint64_t Z3ReachabilitySolver::checkCount() const { return _checkCount; }
+
+uint64_t Z3ReachabilitySolver::unsatisfiableCount() const { return _unsatisfiableCount; }
+
+uint64_t Z3ReachabilitySolver::unknownCount() const { return _unknownCount; }
+
+uint64_t Z3ReachabilitySolver::skippedCount() const { return _skippedCount; }
+
+uint64_t Z3ReachabilitySolver::estimateMemoryUsage() const {
+    // Swiss tables use one control byte per slot.
+    uint64_t bytes =
+        _bindingLiterals.capacity() * (sizeof(decltype(_bindingLiterals)::value_type) + 1) +
+        _conditionLiterals.capacity() * (sizeof(decltype(_conditionLiterals)::value_type) + 1) +
+        _bindings.capacity() * (sizeof(decltype(_bindings)::value_type) + 1);
+    for (const auto &[id, conditionEntry] : _conditionLiterals) {
+        bytes += std::get<2>(conditionEntry).capacity() * sizeof(unsigned);
+    }
+    return bytes;
+}
+
+}  // namespace P4::P4Tools::Flay
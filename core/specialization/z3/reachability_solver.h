@@ -0,0 +1,133 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_Z3_REACHABILITY_SOLVER_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_Z3_REACHABILITY_SOLVER_H_
+
+#include <z3++.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+
+namespace P4::P4Tools::Flay {
+
+/// Decides whether reachability conditions which simplification leaves open are satisfiable.
+///
+/// A single incremental solver is shared by all checks. Neither the bindings of control-plane
+/// variables to their values nor the conditions are asserted directly. Every binding and every
+/// condition is asserted once, guarded by its own assumption literal, i.e., as "literal =>
+/// binding". A check enables the literals of the condition and the current bindings of its
+/// variables. Assertions therefore never have to be retracted and the clauses the solver learns
+/// in one check are available to all later checks, across control-plane updates.
+///
+/// Besides the budget of a single check, the checks of one update share a total budget. Once it
+/// is spent, the remaining conditions of the update are not checked and stay undecided.
+class Z3ReachabilitySolver {
+ public:
+    /// The maximum number of guarded assertions. The solver starts over once there are more.
+    static constexpr size_t kMaxAssertions = 1 << 16;
+
+    /// The default time budget of all checks of an update in milliseconds.
+    static constexpr uint64_t kMaxUpdateMilliseconds = 10000;
+
+ private:
+    /// The incremental solver.
+    z3::solver _solver;
+
+    /// The time budget of a single check in milliseconds.
+    uint64_t _budgetMilliseconds;
+
+    /// The time budget of all checks of an update in milliseconds.
+    uint64_t _updateBudgetMilliseconds;
+
+    /// The time spent on the checks of the current update.
+    std::chrono::steady_clock::duration _updateTime{};
+
+    /// The timeout the solver is configured with in milliseconds.
+    uint64_t _timeoutMilliseconds = 0;
+
+    /// The literals guarding the asserted bindings, keyed by the ids of the variable and the
+    /// value. The value is kept, so its id is not reused.
+    absl::flat_hash_map<std::pair<unsigned, unsigned>, std::pair<z3::expr, z3::expr>>
+        _bindingLiterals;
+
+    /// The literals guarding the asserted conditions and the ids of the uninterpreted constants
+    /// of the condition, keyed by the id of the condition. The condition is kept, so its id is not
+    /// reused.
+    absl::flat_hash_map<unsigned, std::tuple<z3::expr, z3::expr, std::vector<unsigned>>>
+        _conditionLiterals;
+
+    /// The current bindings, keyed by the id of the variable.
+    absl::flat_hash_map<unsigned, std::pair<z3::expr, z3::expr>> _bindings;
+
+    /// The number of checks.
+    uint64_t _checkCount = 0;
+
+    /// The number of checks which found a condition unsatisfiable.
+    uint64_t _unsatisfiableCount = 0;
+
+    /// The number of checks which exceeded the time budget or were otherwise inconclusive.
+    uint64_t _unknownCount = 0;
+
+    /// The number of conditions which were not checked because the budget of the update was
+    /// spent.
+    uint64_t _skippedCount = 0;
+
+    /// @returns a fresh assumption literal.
+    z3::expr createLiteral();
+
+    /// @returns the literal guarding the binding of @p variable to @p value.
+    z3::expr bindingLiteral(const z3::expr &variable, const z3::expr &value);
+
+    /// @returns the literal guarding @p condition and the uninterpreted constants of the
+    /// condition.
+    const std::tuple<z3::expr, z3::expr, std::vector<unsigned>> &conditionLiteral(
+        const z3::expr &condition);
+
+    /// Drop all assertions once there are more than kMaxAssertions.
+    void limitAssertions();
+
+    /// Apply the timeout @p timeoutMilliseconds to the solver.
+    void configureSolver(uint64_t timeoutMilliseconds);
+
+ public:
+    /// Create a solver for the terms of @p context which spends at most @p budgetMilliseconds on
+    /// a single check and at most @p updateBudgetMilliseconds on all checks of an update.
+    Z3ReachabilitySolver(z3::context &context, uint64_t budgetMilliseconds,
+                         uint64_t updateBudgetMilliseconds = kMaxUpdateMilliseconds);
+
+    /// Bind each of @p variables to the value at the same position in @p values. Replaces all
+    /// previous bindings. Variables without a binding are unconstrained. Starts a new update,
+    /// which resets the time spent on checks.
+    void setBindings(const z3::expr_vector &variables, const z3::expr_vector &values);
+
+    /// @returns false if @p condition can not hold under the current bindings, true if it can,
+    /// or std::nullopt if the check was inconclusive within the time budget or the budget of the
+    /// update is spent.
+    std::optional<bool> isSatisfiable(const z3::expr &condition);
+
+    /// @returns the number of checks.
+    [[nodiscard]] uint64_t checkCount() const;
+
+    /// @returns the number of checks which found a condition unsatisfiable.
+    [[nodiscard]] uint64_t unsatisfiableCount() const;
+
+    /// @returns the number of inconclusive checks.
+    [[nodiscard]] uint64_t unknownCount() const;
+
+    /// @returns the number of conditions which were not checked because the budget of their
+    /// update was spent.
+    [[nodiscard]] uint64_t skippedCount() const;
+
+    /// @returns the approximate number of bytes held by the solver, excluding Z3 terms and the
+    /// state of the solver itself.
+    [[nodiscard]] uint64_t estimateMemoryUsage() const;
+};
+
+}  // namespace P4::P4Tools::Flay
+
+#endif  // BACKENDS_P4TOOLS_MODULES_FLAY_CORE_SPECIALIZATION_Z3_REACHABILITY_SOLVER_H_
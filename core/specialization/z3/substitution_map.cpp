@@ -4,6 +4,7 @@
 
 #include <optional>
 
+#include "backends/p4tools/modules/flay/core/lib/memory_usage.h"
 #include "lib/error.h"
 #include "lib/timer.h"
 
@@ -88,6 +89,13 @@ std::optional<const IR::Literal *> Z3SolverSubstitutionMap::isExpressionConstant
     return std::nullopt;
 }
 
+uint64_t Z3SolverSubstitutionMap::estimateMemoryUsage() const {
+    const auto &substitutionMap = static_cast<const Z3ExpressionMap &>(*this);
+    return MemoryUsage::estimateContainerMemory(substitutionMap) +
+           substitutionMap.size() * sizeof(Z3SubstitutionExpression) +
+           MemoryUsage::estimateNestedContainerMemory(_symbolMap);
+}
+
 std::optional<bool> Z3SolverSubstitutionMap::recomputeSubstitution(
     const ControlPlaneConstraints &controlPlaneConstraints) {
     /// Generate IR equalities from the control plane constraints.
@@ -61,6 +61,8 @@ class Z3SolverSubstitutionMap : private Z3ExpressionMap, public AbstractSubstitu
 
     std::optional<const IR::Literal *> isExpressionConstant(
         const IR::Expression *expression) const override;
+
+    [[nodiscard]] uint64_t estimateMemoryUsage() const override;
 };
 
 }  // namespace P4::P4Tools::Flay
@@ -11,6 +11,7 @@
 #include "backends/p4tools/common/lib/logging.h"
 #include "backends/p4tools/modules/flay/core/interpreter/partial_evaluator.h"
 #include "backends/p4tools/modules/flay/core/interpreter/target.h"
+#include "backends/p4tools/modules/flay/core/lib/memory_usage.h"
 #include "backends/p4tools/modules/flay/core/lib/return_macros.h"
 #include "backends/p4tools/modules/flay/core/specialization/service_wrapper_bfruntime.h"
 #include "backends/p4tools/modules/flay/core/specialization/service_wrapper_p4runtime.h"
@@ -33,6 +34,19 @@ void Flay::registerTarget() {
     registerFlayTargets();
 }
 
+/// @returns the partial evaluation options selected by @p flayOptions.
+PartialEvaluationOptions getPartialEvaluationOptions(const FlayOptions &flayOptions) {
+    PartialEvaluationOptions partialEvaluationOptions;
+    auto reachabilityMap = flayOptions.reachabilityMap();
+    if (reachabilityMap == "BDD") {
+        partialEvaluationOptions.mapType = ReachabilityMapType::kBdd;
+    } else if (reachabilityMap == "IR") {
+        partialEvaluationOptions.mapType = ReachabilityMapType::kDefault;
+    }
+    partialEvaluationOptions.solverBudgetMilliseconds = flayOptions.reachabilitySolverBudget();
+    return partialEvaluationOptions;
+}
+
 #ifdef FLAY_WITH_GRPC
 int runServer(const FlayOptions &flayOptions, const FlayCompilerResult &flayCompilerResult,
               const ExecutionState &executionState, const ControlPlaneConstraints &constraints) {
@@ -67,11 +81,21 @@ std::optional<FlayServiceStatisticsMap> runServiceWrapper(
         error("Unsupported control plane API %1%.", controlPlaneApi.data());
         return std::nullopt;
     }
+    if (auto metricsAddress = flayOptions.metricsAddress(); metricsAddress.has_value()) {
+        RETURN_IF_FALSE(serviceWrapper->startMetricsServer(metricsAddress.value()) == EXIT_SUCCESS,
+                        std::nullopt);
+    }
     if (flayOptions.hasConfigurationUpdatePattern()) {
         RETURN_IF_FALSE(serviceWrapper->parseControlUpdatesFromPattern(
                             flayOptions.configurationUpdatePattern()) == EXIT_SUCCESS,
                         std::nullopt);
     }
+    if (auto updateStream = flayOptions.configurationUpdateStream(); updateStream.has_value()) {
+        RETURN_IF_FALSE(serviceWrapper->setUpdateStream(
+                            updateStream.value(), flayOptions.configurationUpdateQueueSize()) ==
+                            EXIT_SUCCESS,
+                        std::nullopt);
+    }
     RETURN_IF_FALSE(serviceWrapper->run() == EXIT_SUCCESS, std::nullopt);
     if (FlayOptions::get().optimizedOutputDir() != std::nullopt) {
         serviceWrapper->outputOptimizedProgram("optimized.final.p4");
@@ -144,7 +168,7 @@ int Flay::mainImpl(const CompilerResult &compilerResult) {
                          constraints);
     }
 #endif
-    PartialEvaluationOptions partialEvaluationOptions;
+    auto partialEvaluationOptions = getPartialEvaluationOptions(flayOptions);
     IncrementalAnalysisMap incrementalAnalysisMap;
     auto [result, inserted] = incrementalAnalysisMap.emplace(
         "partialEvaluation",
@@ -168,6 +192,8 @@ std::optional<FlayServiceStatisticsMap> optimizeProgramImpl(
     P4Tools::Target::init(flayOptions.target.c_str(), flayOptions.arch.c_str());
 
     CompilerResultOrError compilerResult;
+    MemoryProfiler::clear();
+    std::optional<ScopedMemoryPhase> compilePhase(std::in_place, "compile");
     if (program.has_value()) {
         // Run the compiler to get an IR and invoke the tool.
         ASSIGN_OR_RETURN(
@@ -182,6 +208,7 @@ std::optional<FlayServiceStatisticsMap> optimizeProgramImpl(
                          P4Tools::CompilerTarget::runCompiler(flayOptions, TOOL_NAME),
                          std::nullopt);
     }
+    compilePhase.reset();
 
     ASSIGN_OR_RETURN_WITH_MESSAGE(const auto &flayCompilerResult,
                                   compilerResult.value().get().to<FlayCompilerResult>(),
@@ -201,7 +228,7 @@ std::optional<FlayServiceStatisticsMap> optimizeProgramImpl(
         }
     }
 
-    PartialEvaluationOptions partialEvaluationOptions;
+    auto partialEvaluationOptions = getPartialEvaluationOptions(flayOptions);
     IncrementalAnalysisMap incrementalAnalysisMap;
     auto [result, inserted] = incrementalAnalysisMap.emplace(
         "partialEvaluation",
@@ -8,6 +8,7 @@
 #include "backends/p4tools/common/lib/logging.h"
 #include "backends/p4tools/modules/flay/core/control_plane/p4runtime/protobuf.h"
 #include "backends/p4tools/modules/flay/core/specialization/flay_service.h"
+#include "backends/p4tools/modules/flay/options.h"
 #include "lib/timer.h"
 
 namespace P4::P4Tools::Flay {
@@ -44,6 +45,12 @@ bool FlayService::startServer(const std::string &serverAddress) {
     }
 
     printInfo("Flay service listening on: %1%", serverAddress);
+    if (auto metricsAddress = FlayOptions::get().metricsAddress(); metricsAddress.has_value()) {
+        if (startMetricsServer(metricsAddress.value()) != EXIT_SUCCESS) {
+            server->Shutdown();
+            return false;
+        }
+    }
 
     auto serveFn = [&]() { server->Wait(); };
     std::thread servingThread(serveFn);
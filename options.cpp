@@ -1,5 +1,9 @@
 #include "backends/p4tools/modules/flay/options.h"
 
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+
 #include "backends/p4tools/common/compiler/context.h"
 #include "backends/p4tools/common/lib/logging.h"
 #include "backends/p4tools/common/lib/util.h"
@@ -13,6 +17,10 @@ FlayOptions &FlayOptions::get() { return P4Tools::CompileContext<FlayOptions>::g
 
 const std::set<std::string> K_SUPPORTED_CONTROL_PLANES = {"P4RUNTIME", "BFRUNTIME"};
 
+const std::set<std::string> K_SUPPORTED_REACHABILITY_MAPS = {"Z3", "BDD", "IR"};
+
+const std::set<std::string> K_SUPPORTED_EXPRESSION_SIMPLIFIERS = {"PASSES", "EGRAPH"};
+
 FlayOptions::FlayOptions()
     : AbstractP4cToolOptions(TOOL_NAME, "Remove control-plane dead code from a P4 program.") {
     registerOption(
@@ -63,7 +71,8 @@ FlayOptions::FlayOptions()
             return true;
         },
         "A pattern which can either match a single file or a list of files. Primarily used for "
-        "testing.");
+        "testing. Files ending in .binpb or .pb are parsed as binary Protobuf, files ending in "
+        ".binpbs as a stream of length-delimited binary messages, and all others as text.");
     registerOption(
         "--use-placeholders", nullptr,
         [this](const char *) {
@@ -159,6 +168,121 @@ FlayOptions::FlayOptions()
             return true;
         },
         "Disable using a symbol set.");
+    registerOption(
+        "--metrics-address", "metricsAddress",
+        [this](const char *arg) {
+            _metricsAddress = arg;
+            return true;
+        },
+        "Expose the metrics of the Flay service in Prometheus format at ADDRESS:PORT/metrics. "
+        "IPv6 addresses are written in brackets, e.g., [::1]:9000.");
+    registerOption(
+        "--config-update-stream", "source",
+        [this](const char *arg) {
+            _configUpdateStream = arg;
+            return true;
+        },
+        "Stream control plane updates from a source instead of preloading them. The source is "
+        "either dir:PATH, which processes update files as they appear in a directory until a file "
+        "named END is created, or fifo:PATH, unix:PATH or stdin, which read a stream of "
+        "length-delimited binary WriteRequest messages until the writer closes the stream.");
+    registerOption(
+        "--config-update-queue-size", "size",
+        [this](const char *arg) {
+            // strtoull accepts a sign and wraps negative numbers.
+            char *end = nullptr;
+            errno = 0;
+            auto queueSize = std::strtoull(arg, &end, 10);
+            if (std::isdigit(static_cast<unsigned char>(*arg)) == 0 || *end != '\0' ||
+                errno == ERANGE || queueSize == 0) {
+                error("Invalid update queue size %1%. Expected a positive number.", arg);
+                return false;
+            }
+            _configUpdateQueueSize = queueSize;
+            return true;
+        },
+        "The maximum number of parsed control plane updates buffered ahead of processing when "
+        "streaming updates. Defaults to 64.");
+    registerOption(
+        "--table-entry-budget", "[table=]budget",
+        [this](const char *arg) {
+            std::string_view argument(arg);
+            auto separatorPos = argument.rfind('=');
+            auto budgetString = separatorPos == std::string_view::npos
+                                    ? std::string(argument)
+                                    : std::string(argument.substr(separatorPos + 1));
+            char *end = nullptr;
+            auto budget = std::strtoull(budgetString.c_str(), &end, 10);
+            if (budgetString.empty() || *end != '\0') {
+                error("Invalid table entry budget %1%. Expected a number.", arg);
+                return false;
+            }
+            if (separatorPos == std::string_view::npos) {
+                _tableEntryBudget = budget;
+            } else {
+                _tableEntryBudgets[std::string(argument.substr(0, separatorPos))] = budget;
+            }
+            return true;
+        },
+        "The number of entries up to which every entry of a table is encoded individually. "
+        "Beyond the budget, entries of tables with a single exact, LPM or range key, or with only "
+        "exact keys, are grouped by the action they execute. Tables with other keys or more than "
+        "10000 entries only track their installed actions and constant action arguments. Applies "
+        "to all tables, or to a single table if prefixed with its control plane name. Can be "
+        "given multiple times. Defaults to 50.");
+    registerOption(
+        "--reachability-map", "mapType",
+        [this](const char *arg) {
+            _reachabilityMap = arg;
+            transform(_reachabilityMap.begin(), _reachabilityMap.end(), _reachabilityMap.begin(),
+                      ::toupper);
+            if (K_SUPPORTED_REACHABILITY_MAPS.find(_reachabilityMap) ==
+                K_SUPPORTED_REACHABILITY_MAPS.end()) {
+                error("Unknown reachability map %1%. Supported maps are %2%.", arg,
+                      Utils::containerToString(K_SUPPORTED_REACHABILITY_MAPS));
+                return false;
+            }
+            return true;
+        },
+        "The representation used to recompute the reachability of program nodes. Z3 simplifies "
+        "every condition with Z3. BDD compiles the conditions into binary decision diagrams over "
+        "their atoms and only decides the atoms with Z3. IR substitutes and simplifies the P4 "
+        "expressions of the conditions. Defaults to Z3.");
+    registerOption(
+        "--reachability-solver-budget", "milliseconds",
+        [this](const char *arg) {
+            char *end = nullptr;
+            auto budget = std::strtoull(arg, &end, 10);
+            if (*arg == '\0' || *end != '\0' || budget == 0) {
+                error("Invalid solver budget %1%. Expected a positive number.", arg);
+                return false;
+            }
+            _reachabilitySolverBudget = budget;
+            return true;
+        },
+        "Check the reachability conditions which simplification does not decide with an "
+        "incremental solver, which spends at most the given number of milliseconds per "
+        "condition. All checks of one control-plane update share a total budget of ten "
+        "seconds; the conditions left once it is spent stay reachable. Conditions the solver "
+        "proves unsatisfiable are unreachable. Only applies to the Z3 reachability map. "
+        "Disabled by default.");
+    registerOption(
+        "--expression-simplifier", "simplifier",
+        [this](const char *arg) {
+            _expressionSimplifier = arg;
+            transform(_expressionSimplifier.begin(), _expressionSimplifier.end(),
+                      _expressionSimplifier.begin(), ::toupper);
+            if (K_SUPPORTED_EXPRESSION_SIMPLIFIERS.find(_expressionSimplifier) ==
+                K_SUPPORTED_EXPRESSION_SIMPLIFIERS.end()) {
+                error("Unknown expression simplifier %1%. Supported simplifiers are %2%.", arg,
+                      Utils::containerToString(K_SUPPORTED_EXPRESSION_SIMPLIFIERS));
+                return false;
+            }
+            return true;
+        },
+        "The simplifier applied to reachability and substitution conditions. PASSES folds and "
+        "lifts Mux conditions. EGRAPH additionally rewrites the result by equality saturation "
+        "and keeps the smallest equivalent expression. Defaults to PASSES.");
 }
 
 bool FlayOptions::validateOptions() const {
@@ -207,6 +331,38 @@ bool FlayOptions::skipSideEffectOrdering() const { return _skipSideEffectOrderin
 
 bool FlayOptions::useSymbolSet() const { return _useSymbolSet; }
 
+std::optional<std::string_view> FlayOptions::configurationUpdateStream() const {
+    if (_configUpdateStream.has_value()) {
+        return _configUpdateStream.value();
+    }
+    return std::nullopt;
+}
+
+size_t FlayOptions::configurationUpdateQueueSize() const { return _configUpdateQueueSize; }
+
+std::optional<size_t> FlayOptions::tableEntryBudget(std::string_view tableName) const {
+    auto it = _tableEntryBudgets.find(tableName);
+    if (it != _tableEntryBudgets.end()) {
+        return it->second;
+    }
+    return _tableEntryBudget;
+}
+
+std::string_view FlayOptions::reachabilityMap() const { return _reachabilityMap; }
+
+std::optional<uint64_t> FlayOptions::reachabilitySolverBudget() const {
+    return _reachabilitySolverBudget;
+}
+
+std::string_view FlayOptions::expressionSimplifier() const { return _expressionSimplifier; }
+
+std::optional<std::string_view> FlayOptions::metricsAddress() const {
+    if (_metricsAddress.has_value()) {
+        return _metricsAddress.value();
+    }
+    return std::nullopt;
+}
+
 void FlayOptions::setControlPlaneConfig(const std::filesystem::path &path) {
     _controlPlaneConfig = path;
 }
@@ -239,4 +395,10 @@ void FlayOptions::setSkipSideEffectOrdering() { _skipSideEffectOrdering = true;
 
 void FlayOptions::setUseSymbolSet() { _useSymbolSet = true; }
 
+void FlayOptions::setMetricsAddress(const std::string &address) { _metricsAddress = address; }
+
+void FlayOptions::setConfigurationUpdateStream(const std::string &source) {
+    _configUpdateStream = source;
+}
+
 }  // namespace P4::P4Tools::Flay
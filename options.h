@@ -1,8 +1,11 @@
 #ifndef BACKENDS_P4TOOLS_MODULES_FLAY_OPTIONS_H_
 #define BACKENDS_P4TOOLS_MODULES_FLAY_OPTIONS_H_
 
+#include <cstdint>
 #include <filesystem>
+#include <map>
 #include <optional>
+#include <string>
 
 #include "backends/p4tools/common/options.h"
 
@@ -70,6 +73,27 @@ class FlayOptions : public AbstractP4cToolOptions {
     /// @returns false when the --no-symbol-set option has been set.
     [[nodiscard]] bool useSymbolSet() const;
 
+    /// @returns the update stream source set with --config-update-stream, if any.
+    [[nodiscard]] std::optional<std::string_view> configurationUpdateStream() const;
+
+    /// @returns the update queue size set with --config-update-queue-size.
+    [[nodiscard]] size_t configurationUpdateQueueSize() const;
+
+    /// @returns the address set with --metrics-address, if any.
+    [[nodiscard]] std::optional<std::string_view> metricsAddress() const;
+
+    /// @returns the entry budget of table @p tableName set with --table-entry-budget, if any.
+    [[nodiscard]] std::optional<size_t> tableEntryBudget(std::string_view tableName) const;
+
+    /// @returns the reachability map set with --reachability-map, in upper case.
+    [[nodiscard]] std::string_view reachabilityMap() const;
+
+    /// @returns the time budget set with --reachability-solver-budget, if any.
+    [[nodiscard]] std::optional<uint64_t> reachabilitySolverBudget() const;
+
+    /// @returns the expression simplifier set with --expression-simplifier, in upper case.
+    [[nodiscard]] std::string_view expressionSimplifier() const;
+
     /// Sets the path to the initial control plane configuration file.
     void setControlPlaneConfig(const std::filesystem::path &path);
 
@@ -110,6 +134,12 @@ class FlayOptions : public AbstractP4cToolOptions {
     /// Set whether to use the symbol set.
     void setUseSymbolSet();
 
+    /// Sets the address of the metrics endpoint.
+    void setMetricsAddress(const std::string &address);
+
+    /// Sets the source control plane updates are streamed from.
+    void setConfigurationUpdateStream(const std::string &source);
+
  private:
     /// Path to the initial control plane configuration file.
     std::optional<std::filesystem::path> _controlPlaneConfig = std::nullopt;
@@ -156,6 +186,30 @@ class FlayOptions : public AbstractP4cToolOptions {
 
     /// If useSymbolSet is true, we only check whether the symbols in the set have changed.
     bool _useSymbolSet = true;
+
+    /// If set, the service exposes its metrics in Prometheus format at ADDRESS:PORT/metrics.
+    std::optional<std::string> _metricsAddress = std::nullopt;
+
+    /// If set, control plane updates are streamed from this source while they are processed.
+    std::optional<std::string> _configUpdateStream = std::nullopt;
+
+    /// The maximum number of parsed updates buffered ahead of processing when streaming.
+    size_t _configUpdateQueueSize = 64;
+
+    /// The number of entries up to which every entry of a table is encoded individually.
+    std::optional<size_t> _tableEntryBudget = std::nullopt;
+
+    /// Entry budgets of individual tables, keyed by the control plane name of the table.
+    std::map<std::string, size_t, std::less<>> _tableEntryBudgets;
+
+    /// The representation used to recompute reachability.
+    std::string _reachabilityMap = "Z3";
+
+    /// The time budget per condition of the reachability solver in milliseconds.
+    std::optional<uint64_t> _reachabilitySolverBudget = std::nullopt;
+
+    /// The simplifier applied to conditions.
+    std::string _expressionSimplifier = "PASSES";
 };
 
 }  // namespace P4::P4Tools::Flay
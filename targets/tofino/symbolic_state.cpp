@@ -7,6 +7,7 @@
 #include "backends/p4tools/common/lib/variables.h"
 #include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
 #include "backends/p4tools/modules/flay/core/lib/return_macros.h"
+#include "backends/p4tools/modules/flay/options.h"
 #include "backends/p4tools/modules/flay/targets/tofino/constants.h"
 
 namespace P4::P4Tools::Flay::Tofino {
@@ -191,13 +192,12 @@ bool TofinoControlPlaneInitializer::preorder(const IR::P4Table *table) {
     ASSIGN_OR_RETURN(auto defaultActionConstraints, computeDefaultActionConstraints(table), false);
 
     ASSIGN_OR_RETURN(TableEntrySet initialTableEntries, initializeTableEntries(table), false);
-    auto config =
-        *new TableConfiguration(table->controlPlaneName(),
-                                TableDefaultAction(defaultActionConstraints), initialTableEntries);
-    _defaultConstraints.insert(
-        {tableName, *new TableConfiguration(table->controlPlaneName(),
-                                            TableDefaultAction(defaultActionConstraints),
-                                            initialTableEntries)});
+    auto *tableConfiguration = new TableConfiguration(
+        tableName, TableDefaultAction(defaultActionConstraints), initialTableEntries);
+    if (auto entryBudget = FlayOptions::get().tableEntryBudget(tableName.string_view())) {
+        tableConfiguration->setEntryBudget(entryBudget.value());
+    }
+    _defaultConstraints.insert({tableName, *tableConfiguration});
 
     return false;
 }
@@ -0,0 +1,43 @@
+#include "backends/p4tools/modules/flay/core/control_plane/action_enumeration.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "backends/p4tools/modules/flay/test/helpers.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::P4Tools::Flay;
+
+TEST_F(P4FlayTest, ActionEnumerationOrdersActionsByName) {
+    // The order and duplicates of the names do not matter.
+    ActionEnumeration actionEnumeration(
+        {"ingress.set_port", "NoAction", "ingress.drop", "ingress.set_port"});
+    ASSERT_EQ(actionEnumeration.size(), 4U);
+    EXPECT_EQ(actionEnumeration.type()->width_bits(), 2);
+    EXPECT_EQ(actionEnumeration.ordinal(ActionEnumeration::kNoAction), 0U);
+    EXPECT_EQ(actionEnumeration.ordinal("NoAction"), 1U);
+    EXPECT_EQ(actionEnumeration.ordinal("ingress.drop"), 2U);
+    EXPECT_EQ(actionEnumeration.ordinal("ingress.set_port"), 3U);
+    EXPECT_EQ(actionEnumeration.ordinal("ingress.missing"), std::nullopt);
+    EXPECT_EQ(actionEnumeration.actionName(2), cstring("ingress.drop"));
+    EXPECT_EQ(actionEnumeration.actionName(4), std::nullopt);
+
+    const auto *literal = actionEnumeration.literal("ingress.set_port");
+    ASSERT_NE(literal, nullptr);
+    EXPECT_EQ(literal->value, 3);
+    EXPECT_EQ(literal->type, actionEnumeration.type());
+    EXPECT_EQ(actionEnumeration.literal("ingress.missing"), nullptr);
+
+    // A table without actions still has a one-bit enumeration.
+    ActionEnumeration emptyEnumeration(std::vector<cstring>{});
+    EXPECT_EQ(emptyEnumeration.size(), 1U);
+    EXPECT_EQ(emptyEnumeration.type()->width_bits(), 1);
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
@@ -0,0 +1,146 @@
+#include "backends/p4tools/modules/flay/core/lib/bdd.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
+#include "backends/p4tools/modules/flay/core/specialization/bdd/reachability_map.h"
+#include "backends/p4tools/modules/flay/core/specialization/z3/reachability_map.h"
+#include "backends/p4tools/modules/flay/test/helpers.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::P4Tools::Flay;
+
+TEST_F(P4FlayTest, BddIsCanonical) {
+    BddManager bddManager;
+    auto variableA = bddManager.variable(bddManager.createVariable());
+    auto variableB = bddManager.variable(bddManager.createVariable());
+    auto conjunction = bddManager.conjunction(variableA, variableB);
+    EXPECT_EQ(conjunction, bddManager.conjunction(variableB, variableA));
+    EXPECT_EQ(conjunction,
+              bddManager.negation(bddManager.disjunction(bddManager.negation(variableA),
+                                                         bddManager.negation(variableB))));
+    EXPECT_EQ(bddManager.ite(variableA, variableB, variableB), variableB);
+    EXPECT_EQ(bddManager.conjunction(variableA, bddManager.negation(variableA)),
+              BddManager::kFalse);
+    EXPECT_EQ(bddManager.disjunction(variableA, bddManager.negation(variableA)),
+              BddManager::kTrue);
+}
+
+TEST_F(P4FlayTest, BddEvaluatesPartialAssignments) {
+    BddManager bddManager;
+    auto variableA = bddManager.variable(bddManager.createVariable());
+    auto variableB = bddManager.variable(bddManager.createVariable());
+    auto variableC = bddManager.variable(bddManager.createVariable());
+    // (a && b) || (!a && c).
+    auto diagram = bddManager.ite(variableA, variableB, variableC);
+
+    auto evaluate = [&](const std::map<uint32_t, bool> &assignment,
+                        std::vector<uint32_t> *requestedVariables = nullptr) {
+        BddManager::EvaluationCache evaluationCache;
+        return bddManager.evaluate(
+            diagram,
+            [&](uint32_t variable) -> std::optional<bool> {
+                if (requestedVariables != nullptr) {
+                    requestedVariables->push_back(variable);
+                }
+                auto it = assignment.find(variable);
+                if (it == assignment.end()) {
+                    return std::nullopt;
+                }
+                return it->second;
+            },
+            evaluationCache);
+    };
+
+    EXPECT_EQ(evaluate({}), std::nullopt);
+    EXPECT_EQ(evaluate({{0, true}}), std::nullopt);
+    EXPECT_EQ(evaluate({{0, true}, {1, false}}), false);
+    // Both branches are true, so the first variable does not matter.
+    EXPECT_EQ(evaluate({{1, true}, {2, true}}), true);
+    EXPECT_EQ(evaluate({{1, true}, {2, false}}), std::nullopt);
+
+    // Variables of branches which are not taken are not requested.
+    std::vector<uint32_t> requestedVariables;
+    EXPECT_EQ(evaluate({{0, false}, {2, true}}, &requestedVariables), true);
+    EXPECT_EQ(requestedVariables, std::vector<uint32_t>({0, 2}));
+}
+
+TEST_F(P4FlayTest, BddReachabilityMapMatchesZ3Map) {
+    const auto *variableA = makeVariable("a");
+    const auto *variableB = makeVariable("b");
+    // Not assigned by the control plane.
+    const auto *variableD = makeVariable("d");
+    const auto *guardedNode = new IR::EmptyStatement();
+    const auto *dataPlaneNode = new IR::EmptyStatement();
+    const auto *elseNode = new IR::EmptyStatement();
+    const auto *contradictoryNode = new IR::EmptyStatement();
+
+    NodeAnnotationMap nodeAnnotationMap;
+    nodeAnnotationMap.initializeReachabilityMapping(guardedNode, variableA);
+    nodeAnnotationMap.initializeReachabilityMapping(dataPlaneNode,
+                                                    new IR::LAnd(variableA, variableD));
+    nodeAnnotationMap.initializeReachabilityMapping(
+        elseNode, new IR::LAnd(new IR::LNot(variableA), variableB));
+    nodeAnnotationMap.initializeReachabilityMapping(
+        contradictoryNode,
+        new IR::LAnd(new IR::LAnd(variableA, variableD), new IR::LNot(variableD)));
+
+    IR::P4Program program{IR::Vector<IR::Node>()};
+    BddReachabilityMap bddReachabilityMap(nodeAnnotationMap, program);
+    Z3SolverReachabilityMap z3ReachabilityMap(nodeAnnotationMap, program);
+    EXPECT_EQ(bddReachabilityMap.atomCount(), 3U);
+
+    auto expectReachability = [&](bool valueA, bool valueB) {
+        ControlPlaneAssignmentSet assignment;
+        assignment.emplace(*variableA, *IR::BoolLiteral::get(valueA));
+        assignment.emplace(*variableB, *IR::BoolLiteral::get(valueB));
+        TableDefaultAction controlPlaneItem(assignment);
+        ControlPlaneConstraints controlPlaneConstraints;
+        controlPlaneConstraints.emplace("control_plane", controlPlaneItem);
+        ASSERT_TRUE(bddReachabilityMap.recomputeReachability(controlPlaneConstraints).has_value());
+        ASSERT_TRUE(z3ReachabilityMap.recomputeReachability(controlPlaneConstraints).has_value());
+
+        const std::map<const IR::Node *, std::optional<bool>> expectedReachability = {
+            {guardedNode, valueA},
+            {dataPlaneNode, valueA ? std::nullopt : std::optional<bool>(false)},
+            {elseNode, !valueA && valueB},
+            {contradictoryNode, false},
+        };
+        for (const auto &[node, reachability] : expectedReachability) {
+            EXPECT_EQ(bddReachabilityMap.isNodeReachable(node), reachability);
+            EXPECT_EQ(z3ReachabilityMap.isNodeReachable(node), reachability);
+        }
+    };
+    expectReachability(true, false);
+    expectReachability(false, true);
+    expectReachability(false, false);
+}
+
+TEST_F(P4FlayTest, BddReachabilityMapRespectsNodeBudget) {
+    const auto *variableA = makeVariable("a");
+    const auto *variableB = makeVariable("b");
+    const auto *variableC = makeVariable("c");
+    const auto *node = new IR::EmptyStatement();
+
+    NodeAnnotationMap nodeAnnotationMap;
+    nodeAnnotationMap.initializeReachabilityMapping(
+        node, new IR::LOr(new IR::LAnd(variableA, variableB), variableC));
+
+    IR::P4Program program{IR::Vector<IR::Node>()};
+    BddReachabilityMap bddReachabilityMap(nodeAnnotationMap, program);
+    EXPECT_FALSE(bddReachabilityMap.exceedsNodeBudget());
+    // The diagram has two terminals and at least one node per variable.
+    BddReachabilityMap boundedReachabilityMap(nodeAnnotationMap, program, 4);
+    EXPECT_TRUE(boundedReachabilityMap.exceedsNodeBudget());
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
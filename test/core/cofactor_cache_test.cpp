@@ -0,0 +1,105 @@
+#include "backends/p4tools/modules/flay/core/specialization/z3/cofactor_cache.h"
+
+#include <gtest/gtest.h>
+
+#include "backends/p4tools/common/lib/variables.h"
+#include "backends/p4tools/modules/flay/core/lib/z3_cache.h"
+#include "backends/p4tools/modules/flay/test/helpers.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::P4Tools::Flay;
+
+TEST_F(P4FlayTest, CofactorCacheSelectsFrequentlyChangedSymbols) {
+    const auto *variableA = makeVariable("a");
+    const auto *variableB = makeVariable("b");
+    Z3ConditionDag conditionDag;
+    Z3CofactorCache cofactorCache(conditionDag);
+    for (uint64_t update = 1; update < Z3CofactorCache::kSelectionThreshold; ++update) {
+        EXPECT_TRUE(cofactorCache.recordChanges({*variableA}).empty());
+    }
+    auto selectedSymbols = cofactorCache.recordChanges({*variableA, *variableB});
+    ASSERT_EQ(selectedSymbols.size(), 1U);
+    EXPECT_TRUE(selectedSymbols.begin()->get().equiv(*variableA));
+    // Symbols are selected once.
+    EXPECT_TRUE(cofactorCache.recordChanges({*variableA}).empty());
+    EXPECT_EQ(cofactorCache.selectedSymbols().size(), 1U);
+}
+
+TEST_F(P4FlayTest, CofactorCacheReplacesSymbolByValue) {
+    const auto *variableA = makeVariable("a");
+    const auto *variableB = makeVariable("b");
+    const auto *variableK = ToolsVariables::getSymbolicVariable(IR::Type_Bits::get(8), "k");
+    auto symbolA = Z3Cache::set(variableA);
+    auto symbolK = Z3Cache::set(variableK);
+    auto booleanCondition = Z3Cache::set(new IR::LAnd(variableA, variableB));
+    auto bitVectorCondition = Z3Cache::set(new IR::LAnd(
+        new IR::Equ(variableK, IR::Constant::get(IR::Type_Bits::get(8), 3)), variableB));
+
+    Z3ConditionDag conditionDag;
+    Z3CofactorCache cofactorCache(conditionDag);
+    cofactorCache.addCondition(booleanCondition, symbolA);
+    cofactorCache.addCondition(bitVectorCondition, symbolK);
+    EXPECT_EQ(cofactorCache.size(), 2U);
+
+    // Both cofactors of a boolean symbol are precomputed.
+    auto trueCofactor = cofactorCache.lookup(booleanCondition, {{symbolA.id(), 1}});
+    ASSERT_TRUE(trueCofactor.has_value());
+    EXPECT_EQ(trueCofactor->id(), Z3Cache::set(variableB).id());
+    auto falseCofactor = cofactorCache.lookup(booleanCondition, {{symbolA.id(), 0}});
+    ASSERT_TRUE(falseCofactor.has_value());
+    EXPECT_TRUE(falseCofactor->is_false());
+    EXPECT_EQ(cofactorCache.hitCount(), 2U);
+    EXPECT_EQ(cofactorCache.missCount(), 0U);
+
+    // Other symbols are cofactored on first use.
+    auto matchingCofactor = cofactorCache.lookup(bitVectorCondition, {{symbolK.id(), 3}});
+    ASSERT_TRUE(matchingCofactor.has_value());
+    EXPECT_EQ(matchingCofactor->id(), Z3Cache::set(variableB).id());
+    EXPECT_EQ(cofactorCache.missCount(), 1U);
+    EXPECT_TRUE(cofactorCache.lookup(bitVectorCondition, {{symbolK.id(), 4}})->is_false());
+    EXPECT_TRUE(cofactorCache.lookup(bitVectorCondition, {{symbolK.id(), 3}}).has_value());
+    EXPECT_EQ(cofactorCache.hitCount(), 3U);
+    EXPECT_EQ(cofactorCache.missCount(), 2U);
+
+    // Without a concrete value there is no cofactor.
+    EXPECT_FALSE(cofactorCache.lookup(booleanCondition, {}).has_value());
+    // Conditions which are not cofactored have none.
+    EXPECT_FALSE(cofactorCache.lookup(symbolA, {{symbolA.id(), 1}}).has_value());
+}
+
+TEST_F(P4FlayTest, CofactorCacheKeepsSharedSubconditions) {
+    const auto *variableA = makeVariable("a");
+    const auto *variableB = makeVariable("b");
+    const auto *variableC = makeVariable("c");
+    const auto *variableD = makeVariable("d");
+    const auto *prefix = new IR::LAnd(variableB, variableC);
+    auto symbolA = Z3Cache::set(variableA);
+
+    Z3ConditionDag conditionDag;
+    auto prefixCondition = conditionDag.translate(prefix);
+    auto firstCondition = conditionDag.translate(new IR::LAnd(prefix, variableA));
+    auto secondCondition =
+        conditionDag.translate(new IR::LAnd(prefix, new IR::LOr(variableA, variableD)));
+    Z3CofactorCache cofactorCache(conditionDag);
+    cofactorCache.addCondition(firstCondition, symbolA);
+    cofactorCache.addCondition(secondCondition, symbolA);
+
+    // The cofactors are not flattened, both keep the shared prefix.
+    auto firstCofactor = cofactorCache.lookup(firstCondition, {{symbolA.id(), 1}});
+    ASSERT_TRUE(firstCofactor.has_value());
+    EXPECT_EQ(firstCofactor->id(), prefixCondition.id());
+    auto secondCofactor = cofactorCache.lookup(secondCondition, {{symbolA.id(), 0}});
+    ASSERT_TRUE(secondCofactor.has_value());
+    ASSERT_TRUE(secondCofactor->is_and());
+    ASSERT_EQ(secondCofactor->num_args(), 2U);
+    EXPECT_EQ(secondCofactor->arg(0).id(), prefixCondition.id());
+    EXPECT_EQ(secondCofactor->arg(1).id(), Z3Cache::set(variableD).id());
+    EXPECT_TRUE(cofactorCache.lookup(firstCondition, {{symbolA.id(), 0}})->is_false());
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
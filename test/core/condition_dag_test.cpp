@@ -0,0 +1,65 @@
+#include "backends/p4tools/modules/flay/core/specialization/z3/condition_dag.h"
+
+#include <gtest/gtest.h>
+
+#include "backends/p4tools/modules/flay/core/lib/z3_cache.h"
+#include "backends/p4tools/modules/flay/test/helpers.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::P4Tools::Flay;
+
+TEST_F(P4FlayTest, ConditionDagSharesPrefixes) {
+    const auto *variableC = makeVariable("c");
+    const auto *prefix = new IR::LAnd(makeVariable("a"), makeVariable("b"));
+    const auto *first = new IR::LAnd(prefix, variableC);
+    const auto *second = new IR::LAnd(prefix, new IR::LNot(variableC));
+
+    Z3ConditionDag conditionDag;
+    auto firstTerm = conditionDag.translate(first);
+    auto secondTerm = conditionDag.translate(second);
+    ASSERT_TRUE(firstTerm.is_and());
+    ASSERT_TRUE(secondTerm.is_and());
+    EXPECT_EQ(firstTerm.arg(0).id(), secondTerm.arg(0).id());
+    // Every IR node is translated once.
+    EXPECT_EQ(conditionDag.size(), 7U);
+}
+
+TEST_F(P4FlayTest, ConditionEvaluationReusesSharedSubconditions) {
+    const auto *variableA = makeVariable("a");
+    const auto *variableC = makeVariable("c");
+    const auto *prefix = new IR::LAnd(variableA, makeVariable("b"));
+    const auto *first = new IR::LAnd(prefix, variableC);
+    const auto *second = new IR::LAnd(prefix, new IR::LNot(variableC));
+    Z3ConditionDag conditionDag;
+    auto firstTerm = conditionDag.translate(first);
+    auto secondTerm = conditionDag.translate(second);
+
+    {
+        Z3ControlPlaneAssignmentSet assignments;
+        assignments.add(*variableA, Z3Cache::set(IR::BoolLiteral::get(false)));
+        Z3ConditionEvaluation conditionEvaluation(conditionDag, assignments);
+        EXPECT_TRUE(conditionEvaluation.evaluate(firstTerm).is_false());
+        // The prefix decides the second condition without evaluating its last atom.
+        EXPECT_TRUE(conditionEvaluation.evaluate(secondTerm).is_false());
+        EXPECT_EQ(conditionEvaluation.hitCount(), 1U);
+        EXPECT_EQ(conditionEvaluation.missCount(), 4U);
+        // The only atom which was evaluated has a constant value.
+        EXPECT_EQ(conditionEvaluation.groundCount(), 1U);
+    }
+    {
+        Z3ControlPlaneAssignmentSet assignments;
+        assignments.add(*variableA, Z3Cache::set(IR::BoolLiteral::get(true)));
+        Z3ConditionEvaluation conditionEvaluation(conditionDag, assignments);
+        auto firstResult = conditionEvaluation.evaluate(firstTerm);
+        EXPECT_FALSE(firstResult.is_true() || firstResult.is_false());
+        auto secondResult = conditionEvaluation.evaluate(secondTerm);
+        EXPECT_FALSE(secondResult.is_true() || secondResult.is_false());
+    }
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
@@ -0,0 +1,100 @@
+#include "backends/p4tools/modules/flay/core/lib/egraph.h"
+
+#include <gtest/gtest.h>
+
+#include "backends/p4tools/common/lib/variables.h"
+#include "backends/p4tools/modules/flay/test/helpers.h"
+#include "ir/ir.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::literals;
+
+TEST_F(P4FlayTest, EGraphCombinesRules) {
+    const auto *xVar =
+        P4Tools::ToolsVariables::getSymbolicVariable(IR::Type_Boolean::get(), "X"_cs);
+    const auto *yVar =
+        P4Tools::ToolsVariables::getSymbolicVariable(IR::Type_Boolean::get(), "Y"_cs);
+
+    // |X(bool)| && |Y(bool)| || |Y(bool)| && |X(bool)| is only idempotent after commuting.
+    const auto *disjunction = new IR::LOr(new IR::LAnd(xVar, yVar), new IR::LAnd(yVar, xVar));
+    const auto *simplifiedExpression = P4Tools::EGraph::simplify(disjunction);
+    EXPECT_EQ(P4Tools::EGraph::treeSize(simplifiedExpression), 3U);
+    const auto *conjunction = simplifiedExpression->to<IR::LAnd>();
+    ASSERT_NE(conjunction, nullptr);
+    EXPECT_TRUE((conjunction->left->equiv(*xVar) && conjunction->right->equiv(*yVar)) ||
+                (conjunction->left->equiv(*yVar) && conjunction->right->equiv(*xVar)));
+
+    // !!(|X(bool)| == false) turns into !|X(bool)|.
+    const auto *negation =
+        new IR::LNot(new IR::LNot(new IR::Equ(xVar, IR::BoolLiteral::get(false))));
+    simplifiedExpression = P4Tools::EGraph::simplify(negation);
+    const auto *simplifiedNegation = simplifiedExpression->to<IR::LNot>();
+    ASSERT_NE(simplifiedNegation, nullptr);
+    EXPECT_TRUE(simplifiedNegation->expr->equiv(*xVar));
+}
+
+TEST_F(P4FlayTest, EGraphFoldsArithmetic) {
+    const auto *eightBitType = IR::Type_Bits::get(8);
+    const auto *aVar = P4Tools::ToolsVariables::getSymbolicVariable(eightBitType, "A"_cs);
+    const auto *bVar = P4Tools::ToolsVariables::getSymbolicVariable(eightBitType, "B"_cs);
+
+    // (|A(bit<8>)| ^ |A(bit<8>)|) + |B(bit<8>)| turns into |B(bit<8>)|.
+    const auto *sum = new IR::Add(eightBitType, new IR::BXor(eightBitType, aVar, aVar), bVar);
+    EXPECT_TRUE(P4Tools::EGraph::simplify(sum)->equiv(*bVar));
+
+    // (~|A(bit<8>)| & ~|B(bit<8>)|) * 1 turns into ~(|A(bit<8>)| | |B(bit<8>)|).
+    const auto *product = new IR::Mul(
+        eightBitType,
+        new IR::BAnd(eightBitType, new IR::Cmpl(eightBitType, aVar),
+                     new IR::Cmpl(eightBitType, bVar)),
+        IR::Constant::get(eightBitType, 1));
+    const auto *simplifiedExpression = P4Tools::EGraph::simplify(product);
+    EXPECT_EQ(P4Tools::EGraph::treeSize(simplifiedExpression), 4U);
+    EXPECT_TRUE(simplifiedExpression->is<IR::Cmpl>());
+}
+
+TEST_F(P4FlayTest, EGraphAppliesStrengthReduction) {
+    const auto *eightBitType = IR::Type_Bits::get(8);
+    const auto *aVar = P4Tools::ToolsVariables::getSymbolicVariable(eightBitType, "A"_cs);
+    const auto *xVar =
+        P4Tools::ToolsVariables::getSymbolicVariable(IR::Type_Boolean::get(), "X"_cs);
+
+    // The rules of ExpressionStrengthReduction also apply to operands of other forms.
+    // !|X(bool)| ? false : true turns into |X(bool)|.
+    const auto *mux = new IR::Mux(IR::Type_Boolean::get(), new IR::LNot(xVar),
+                                  IR::BoolLiteral::get(false), IR::BoolLiteral::get(true));
+    EXPECT_TRUE(P4Tools::EGraph::simplify(mux)->equiv(*xVar));
+
+    // (|A(bit<8>)| &&& 0xFF) | 0 turns into |A(bit<8>)|.
+    const auto *mask = new IR::Mask(eightBitType, aVar, IR::Constant::get(eightBitType, 255));
+    const auto *disjunction = new IR::BOr(eightBitType, mask, IR::Constant::get(eightBitType, 0));
+    EXPECT_TRUE(P4Tools::EGraph::simplify(disjunction)->equiv(*aVar));
+
+    // |X(bool)| != false turns into |X(bool)|.
+    const auto *inequality =
+        new IR::Neq(IR::Type_Boolean::get(), xVar, IR::BoolLiteral::get(false));
+    EXPECT_TRUE(P4Tools::EGraph::simplify(inequality)->equiv(*xVar));
+}
+
+TEST_F(P4FlayTest, EGraphKeepsMinimalExpressions) {
+    const auto *eightBitType = IR::Type_Bits::get(8);
+    const auto *aVar = P4Tools::ToolsVariables::getSymbolicVariable(eightBitType, "A"_cs);
+    const auto *bVar = P4Tools::ToolsVariables::getSymbolicVariable(eightBitType, "B"_cs);
+    auto statistics = P4Tools::EGraph::statistics();
+
+    const auto *sum = new IR::Add(eightBitType, aVar, bVar);
+    EXPECT_EQ(P4Tools::EGraph::simplify(sum), sum);
+
+    const auto &updatedStatistics = P4Tools::EGraph::statistics();
+    EXPECT_EQ(updatedStatistics.expressionCount, statistics.expressionCount + 1);
+    EXPECT_EQ(updatedStatistics.saturatedCount, statistics.saturatedCount + 1);
+    EXPECT_EQ(updatedStatistics.inputNodeCount, statistics.inputNodeCount + 3);
+    EXPECT_EQ(updatedStatistics.outputNodeCount, statistics.outputNodeCount + 3);
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
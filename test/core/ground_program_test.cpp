@@ -0,0 +1,97 @@
+#include "backends/p4tools/modules/flay/core/specialization/z3/ground_program.h"
+
+#include <gtest/gtest.h>
+
+#include <z3++.h>
+
+#include <utility>
+#include <vector>
+
+#include "backends/p4tools/modules/flay/core/lib/z3_cache.h"
+#include "backends/p4tools/modules/flay/test/helpers.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::P4Tools::Flay;
+
+/// @returns the value of @p term under @p variables = @p values, computed by Z3.
+bool evaluateWithZ3(z3::expr term, const z3::expr_vector &variables,
+                    const z3::expr_vector &values) {
+    return term.substitute(variables, values).simplify().is_true();
+}
+
+TEST_F(P4FlayTest, GroundProgramMatchesZ3) {
+    auto &context = Z3Cache::context();
+    for (unsigned width : {1U, 7U, 16U, 32U, 48U, 64U}) {
+        auto x = context.bv_const("ground_x", width);
+        auto y = context.bv_const("ground_y", width);
+        auto flag = context.bool_const("ground_flag");
+        std::vector<z3::expr> terms = {
+            x + y == y * x,
+            x - y == context.bv_val(3, width),
+            z3::ult(x, y),
+            z3::uge(x, y),
+            x < y,
+            x >= y,
+            (x & y) != (x | y),
+            (x ^ ~y) == -x,
+            z3::ite(flag, x, y) == x,
+            z3::shl(x, y) == z3::lshr(x, y),
+            x.extract(width - 1, (width - 1) / 2) == y.extract(width - 1, (width - 1) / 2),
+            z3::sext(x, 64 - width) == z3::zext(y, 64 - width),
+            z3::implies(flag, x == y),
+        };
+        if (width <= 32) {
+            terms.push_back(z3::concat(x, y) == z3::concat(y, x));
+        }
+        uint64_t mask = width == 64 ? ~static_cast<uint64_t>(0) : (uint64_t(1) << width) - 1;
+        for (auto [xValue, yValue] : std::vector<std::pair<uint64_t, uint64_t>>{
+                 {0, 0}, {1, 2}, {mask, 1}, {mask / 2 + 1, mask / 2}, {5, mask}}) {
+            z3::expr_vector variables(context);
+            z3::expr_vector values(context);
+            variables.push_back(x);
+            values.push_back(context.bv_val(xValue & mask, width));
+            variables.push_back(y);
+            values.push_back(context.bv_val(yValue & mask, width));
+            variables.push_back(flag);
+            values.push_back(context.bool_val((xValue & 1) != 0));
+            auto assignment = Z3GroundProgram::collectGroundAssignment(variables, values);
+            for (const auto &term : terms) {
+                auto program = Z3GroundProgram::compile(term);
+                ASSERT_TRUE(program.has_value()) << term;
+                auto value = program->evaluate(assignment);
+                ASSERT_TRUE(value.has_value()) << term;
+                EXPECT_EQ(value.value() != 0, evaluateWithZ3(term, variables, values))
+                    << term << " with x = " << xValue << ", y = " << yValue;
+            }
+        }
+    }
+}
+
+TEST_F(P4FlayTest, GroundProgramRequiresConstantVariables) {
+    auto &context = Z3Cache::context();
+    auto x = context.bv_const("ground_x", 8);
+    auto y = context.bv_const("ground_y", 8);
+    auto program = Z3GroundProgram::compile(x == y);
+    ASSERT_TRUE(program.has_value());
+
+    z3::expr_vector variables(context);
+    z3::expr_vector values(context);
+    variables.push_back(x);
+    values.push_back(context.bv_val(1, 8));
+    // The value of y is not a constant.
+    variables.push_back(y);
+    values.push_back(x + 1);
+    auto assignment = Z3GroundProgram::collectGroundAssignment(variables, values);
+    EXPECT_FALSE(program->evaluate(assignment).has_value());
+
+    // Bit vectors wider than 64 bits are not compiled.
+    auto wide = context.bv_const("ground_wide", 128);
+    EXPECT_FALSE(Z3GroundProgram::compile(wide == context.bv_val(1, 128)).has_value());
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
@@ -0,0 +1,68 @@
+#include "backends/p4tools/modules/flay/core/lib/memory_usage.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "backends/p4tools/modules/flay/test/helpers.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::P4Tools::Flay;
+
+TEST_F(P4FlayTest, MemoryProfilerAggregatesConsecutivePhases) {
+    MemoryProfiler::clear();
+    for (int update = 0; update < 100; ++update) {
+        MemoryProfiler::enterAggregatedPhase("update");
+    }
+    ASSERT_EQ(MemoryProfiler::phases().size(), 1U);
+    EXPECT_EQ(MemoryProfiler::phases().front().name, "update");
+    EXPECT_EQ(MemoryProfiler::phases().front().count, 100U);
+
+    // A scoped phase closes the aggregated phase, so later updates start a new one.
+    { ScopedMemoryPhase memoryPhase("respecialization"); }
+    MemoryProfiler::enterAggregatedPhase("update");
+    const auto &phases = MemoryProfiler::phases();
+    ASSERT_EQ(phases.size(), 3U);
+    EXPECT_EQ(phases[1].name, "respecialization");
+    EXPECT_EQ(phases[2].name, "update");
+    EXPECT_EQ(phases[2].count, 1U);
+    MemoryProfiler::clear();
+}
+
+TEST_F(P4FlayTest, MemoryProfilerRecordsThePeakOfEveryEntry) {
+    MemoryProfiler::clear();
+    if (!MemoryUsage::resetPeakResidentMemory()) {
+        GTEST_SKIP() << "The peak resident memory can not be reset on this system.";
+    }
+    static constexpr size_t kExpensiveEntry = 5;
+    static constexpr size_t kAllocationSize = 64 << 20;
+    for (size_t update = 0; update < 10; ++update) {
+        MemoryProfiler::enterAggregatedPhase("update");
+        if (update == kExpensiveEntry) {
+            // Touch every page so the allocation is resident until it is freed again.
+            std::vector<char> buffer(kAllocationSize, 1);
+            ASSERT_EQ(buffer.back(), 1);
+        }
+    }
+    MemoryProfiler::closeAggregatedPhase();
+
+    const auto &phase = MemoryProfiler::phases().front();
+    EXPECT_EQ(phase.count, 10U);
+    EXPECT_EQ(phase.maxEntryIndex, kExpensiveEntry);
+    EXPECT_GE(phase.maxEntryGrowth, kAllocationSize);
+    uint64_t entries = 0;
+    for (auto bucketCount : phase.entryHistogram) {
+        entries += bucketCount;
+    }
+    EXPECT_EQ(entries, 10U);
+    // 64 MiB of growth falls into the bucket of growth below 128 MiB.
+    EXPECT_EQ(phase.entryHistogram.at(7), 1U);
+    MemoryProfiler::clear();
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
@@ -0,0 +1,86 @@
+#include "backends/p4tools/modules/flay/core/control_plane/p4info_index.h"
+
+#include <gtest/gtest.h>
+
+#include "backends/p4tools/common/control_plane/symbolic_variables.h"
+#include "backends/p4tools/modules/flay/test/helpers.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::P4Tools::Flay;
+
+/// Produce a P4Info with a single table "ingress.forward", which matches on an exact and a
+/// ternary field and references the action "ingress.set_port".
+p4::config::v1::P4Info makeP4Info() {
+    p4::config::v1::P4Info p4Info;
+    auto *action = p4Info.add_actions();
+    action->mutable_preamble()->set_id(20);
+    action->mutable_preamble()->set_name("ingress.set_port");
+    auto *param = action->add_params();
+    param->set_id(1);
+    param->set_name("port");
+    param->set_bitwidth(9);
+    auto *unreferencedAction = p4Info.add_actions();
+    unreferencedAction->mutable_preamble()->set_id(21);
+    unreferencedAction->mutable_preamble()->set_name("ingress.drop");
+
+    auto *table = p4Info.add_tables();
+    table->mutable_preamble()->set_id(10);
+    table->mutable_preamble()->set_name("ingress.forward");
+    auto *exactField = table->add_match_fields();
+    exactField->set_id(1);
+    exactField->set_name("hdr.eth.dst");
+    exactField->set_bitwidth(48);
+    exactField->set_match_type(p4::config::v1::MatchField::EXACT);
+    auto *ternaryField = table->add_match_fields();
+    ternaryField->set_id(2);
+    ternaryField->set_name("hdr.eth.type");
+    ternaryField->set_bitwidth(16);
+    ternaryField->set_match_type(p4::config::v1::MatchField::TERNARY);
+    table->add_action_refs()->set_id(20);
+    return p4Info;
+}
+
+TEST_F(P4FlayTest, P4InfoIndexLookup) {
+    auto p4Info = makeP4Info();
+    P4InfoIndex p4InfoIndex(p4Info);
+
+    const auto *table = p4InfoIndex.findTable(10);
+    ASSERT_NE(table, nullptr);
+    EXPECT_EQ(table->name, "ingress.forward");
+    EXPECT_EQ(p4InfoIndex.findTable(cstring("ingress.forward")), table);
+    EXPECT_EQ(p4InfoIndex.findTable(11), nullptr);
+    EXPECT_EQ(p4InfoIndex.findTable(cstring("ingress.missing")), nullptr);
+
+    // Match fields keep their P4Info order and are addressable by id.
+    ASSERT_EQ(table->matchFields.size(), 2U);
+    EXPECT_EQ(table->findMatchFieldPosition(2), 1U);
+    EXPECT_EQ(table->findMatchFieldPosition(3), std::nullopt);
+    const auto &ternaryField = table->matchFields.at(1);
+    EXPECT_EQ(ternaryField.keyType->width_bits(), 16);
+    // The interned symbols are the ones the converters produced before the index existed.
+    EXPECT_TRUE(ternaryField.keySymbol->equiv(*ControlPlaneState::getTableKey(
+        "ingress.forward", "hdr.eth.type", ternaryField.keyType)));
+    EXPECT_TRUE(ternaryField.maskSymbol->equiv(*ControlPlaneState::getTableTernaryMask(
+        "ingress.forward", "hdr.eth.type", ternaryField.keyType)));
+
+    // Only actions referenced by the table are resolved for it.
+    const auto *action = table->findAction(20);
+    ASSERT_NE(action, nullptr);
+    // Actions are encoded by their ordinal in the table. Ordinal 0 denotes no action.
+    EXPECT_EQ(table->actionEnumeration.size(), 2U);
+    EXPECT_EQ(action->choiceLiteral->value, 1);
+    EXPECT_EQ(action->choiceLiteral->type->width_bits(), 1);
+    EXPECT_EQ(table->actionChoiceSymbol->type, table->actionEnumeration.type());
+    ASSERT_EQ(action->params.size(), 1U);
+    EXPECT_EQ(action->params.at(1).type->width_bits(), 9);
+    EXPECT_EQ(table->findAction(21), nullptr);
+    ASSERT_NE(p4InfoIndex.findAction(21), nullptr);
+    EXPECT_EQ(p4InfoIndex.findAction(22), nullptr);
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
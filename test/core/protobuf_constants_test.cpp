@@ -0,0 +1,48 @@
+#include "backends/p4tools/modules/flay/core/control_plane/protobuf_constants.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "backends/p4tools/modules/flay/core/control_plane/protobuf_utils.h"
+#include "backends/p4tools/modules/flay/test/helpers.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::P4Tools::Flay;
+
+TEST_F(P4FlayTest, ProtobufStringToUint64) {
+    EXPECT_EQ(Protobuf::stringToUint64(std::string()), 0U);
+    EXPECT_EQ(Protobuf::stringToUint64(std::string("\x0a\x00\x00\x01", 4)), 0x0a000001U);
+    // Leading zero bytes do not count towards the width.
+    EXPECT_EQ(Protobuf::stringToUint64(std::string("\x00\x00\xff\xff\xff\xff\xff\xff\xff\xff", 10)),
+              UINT64_MAX);
+    EXPECT_EQ(Protobuf::stringToUint64(std::string("\x01\x00\x00\x00\x00\x00\x00\x00\x00", 9)),
+              std::nullopt);
+}
+
+TEST_F(P4FlayTest, ProtobufConstantsAreInterned) {
+    const auto *type = IR::Type_Bits::get(32);
+    const auto *first = Protobuf::stringToConstant(std::string("\x0a\x00\x00\x01", 4), type);
+    const auto *second = Protobuf::stringToConstant(std::string("\x00\x0a\x00\x00\x01", 5), type);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(first->value, big_int(0x0a000001));
+    EXPECT_EQ(first->type, type);
+    EXPECT_EQ(Protobuf::uint64ToConstant(0x0a000001, type), first);
+    // The same value of a different type is a different constant.
+    EXPECT_NE(Protobuf::uint64ToConstant(0x0a000001, IR::Type_Bits::get(48)), first);
+}
+
+TEST_F(P4FlayTest, ProtobufWideConstantsMatchBigIntConversion) {
+    const auto *type = IR::Type_Bits::get(128);
+    std::string valueString("\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f\x10", 16);
+    const auto *constant = Protobuf::stringToConstant(valueString, type);
+    EXPECT_EQ(constant->value, Protobuf::stringToBigInt(valueString));
+    EXPECT_EQ(constant->type, type);
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
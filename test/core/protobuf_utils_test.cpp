@@ -0,0 +1,88 @@
+#include "backends/p4tools/modules/flay/core/control_plane/protobuf_utils.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "backends/p4tools/modules/flay/test/helpers.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wpedantic"
+#include "p4/v1/p4runtime.pb.h"
+#pragma GCC diagnostic pop
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::P4Tools::Flay;
+
+/// Produce a write request which inserts a single table entry with id @p tableId.
+p4::v1::WriteRequest makeWriteRequest(uint32_t tableId) {
+    p4::v1::WriteRequest request;
+    auto *update = request.add_updates();
+    update->set_type(p4::v1::Update::INSERT);
+    auto *tableEntry = update->mutable_entity()->mutable_table_entry();
+    tableEntry->set_table_id(tableId);
+    tableEntry->mutable_action()->mutable_action()->set_action_id(tableId + 1);
+    return request;
+}
+
+TEST_F(P4FlayTest, ProtobufFormatFromExtension) {
+    EXPECT_EQ(Protobuf::formatFromExtension("update.txtpb"), Protobuf::ProtobufFormat::kText);
+    EXPECT_EQ(Protobuf::formatFromExtension("update.binpb"), Protobuf::ProtobufFormat::kBinary);
+    EXPECT_EQ(Protobuf::formatFromExtension("update.pb"), Protobuf::ProtobufFormat::kBinary);
+    EXPECT_EQ(Protobuf::formatFromExtension("trace.binpbs"), Protobuf::ProtobufFormat::kDelimited);
+    EXPECT_EQ(Protobuf::formatFromExtension("update.json"), std::nullopt);
+}
+
+TEST_F(P4FlayTest, ProtobufBinaryRoundTrip) {
+    auto file = std::filesystem::temp_directory_path() / "flay_protobuf_utils_test.binpb";
+    auto request = makeWriteRequest(7);
+    {
+        std::ofstream output(file, std::ios::binary | std::ios::trunc);
+        ASSERT_TRUE(request.SerializeToOstream(&output));
+    }
+    auto parsed = Protobuf::deserializeObjectsFromFile<p4::v1::WriteRequest>(
+        file, Protobuf::ProtobufFormat::kBinary);
+    ASSERT_TRUE(parsed.has_value());
+    ASSERT_EQ(parsed.value().size(), 1U);
+    EXPECT_EQ(parsed.value().at(0).SerializeAsString(), request.SerializeAsString());
+    std::filesystem::remove(file);
+}
+
+TEST_F(P4FlayTest, ProtobufDelimitedRoundTrip) {
+    auto file = std::filesystem::temp_directory_path() / "flay_protobuf_utils_test.binpbs";
+    std::vector<p4::v1::WriteRequest> requests;
+    for (uint32_t tableId = 0; tableId < 100; tableId++) {
+        requests.emplace_back(makeWriteRequest(tableId));
+    }
+    ASSERT_EQ(Protobuf::serializeDelimitedObjectsToFile(requests, file), EXIT_SUCCESS);
+
+    auto parsed = Protobuf::deserializeObjectsFromFile<p4::v1::WriteRequest>(
+        file, Protobuf::ProtobufFormat::kDelimited);
+    ASSERT_TRUE(parsed.has_value());
+    ASSERT_EQ(parsed.value().size(), requests.size());
+    for (size_t requestIdx = 0; requestIdx < requests.size(); requestIdx++) {
+        EXPECT_EQ(parsed.value().at(requestIdx).SerializeAsString(),
+                  requests.at(requestIdx).SerializeAsString());
+    }
+    std::filesystem::remove(file);
+}
+
+TEST_F(P4FlayTest, ProtobufEmptyDelimitedStream) {
+    auto file = std::filesystem::temp_directory_path() / "flay_protobuf_utils_test_empty.binpbs";
+    { std::ofstream output(file, std::ios::binary | std::ios::trunc); }
+    auto parsed = Protobuf::deserializeObjectsFromFile<p4::v1::WriteRequest>(
+        file, Protobuf::ProtobufFormat::kDelimited);
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_TRUE(parsed.value().empty());
+    std::filesystem::remove(file);
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
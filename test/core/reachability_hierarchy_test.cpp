@@ -0,0 +1,168 @@
+#include "backends/p4tools/modules/flay/core/specialization/reachability_hierarchy.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "backends/p4tools/modules/flay/test/helpers.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::P4Tools::Flay;
+
+/// @returns an if statement with an opaque condition and the true branch @p ifTrue.
+const IR::IfStatement *makeIf(const IR::StatOrDecl *ifTrue = nullptr,
+                              const IR::StatOrDecl *ifFalse = nullptr) {
+    IR::IndexedVector<IR::StatOrDecl> components;
+    if (ifTrue != nullptr) {
+        components.push_back(ifTrue);
+    }
+    return new IR::IfStatement(new IR::BoolLiteral(true), new IR::BlockStatement(components),
+                               ifFalse);
+}
+
+/// Evaluates nodes to preset verdicts and records which nodes were evaluated.
+class FakeEvaluation {
+    /// The reachability expressions of the nodes.
+    ReachabilityMap _reachabilityMap;
+
+    /// The verdicts returned by the evaluation.
+    std::map<const IR::Node *, std::optional<bool>, SourceIdCmp> _verdicts;
+
+    /// The nodes evaluated since the last call to evaluatedNodes.
+    std::vector<const IR::Node *> _evaluatedNodes;
+
+ public:
+    explicit FakeEvaluation(const std::vector<const IR::Node *> &nodes) {
+        for (const auto *node : nodes) {
+            _reachabilityMap.emplace(node, new ReachabilityExpression(new IR::BoolLiteral(true)));
+            _verdicts.emplace(node, std::nullopt);
+        }
+    }
+
+    [[nodiscard]] const ReachabilityMap &reachabilityMap() const { return _reachabilityMap; }
+
+    void setVerdict(const IR::Node *node, std::optional<bool> verdict) {
+        _verdicts[node] = verdict;
+    }
+
+    [[nodiscard]] std::optional<bool> reachability(const IR::Node *node) const {
+        return _reachabilityMap.at(node)->getReachability();
+    }
+
+    std::vector<const IR::Node *> evaluatedNodes() {
+        auto evaluatedNodes = std::move(_evaluatedNodes);
+        _evaluatedNodes.clear();
+        return evaluatedNodes;
+    }
+
+    std::optional<bool> recompute(ReachabilityHierarchy &hierarchy, const NodeSet &targetNodes) {
+        return hierarchy.recompute(
+            targetNodes,
+            [this](const IR::Node *node) -> ReachabilityExpression * {
+                auto it = _reachabilityMap.find(node);
+                return it != _reachabilityMap.end() ? it->second : nullptr;
+            },
+            [this](const IR::Node *node) -> std::optional<bool> {
+                _evaluatedNodes.push_back(node);
+                auto *reachabilityExpression = _reachabilityMap.at(node);
+                auto previous = reachabilityExpression->getReachability();
+                reachabilityExpression->setReachability(_verdicts.at(node));
+                return previous != _verdicts.at(node);
+            });
+    }
+
+    std::optional<bool> recomputeAll(ReachabilityHierarchy &hierarchy) {
+        NodeSet targetNodes;
+        for (const auto &[node, reachabilityExpression] : _reachabilityMap) {
+            targetNodes.insert(node);
+        }
+        return recompute(hierarchy, targetNodes);
+    }
+};
+
+TEST_F(P4FlayTest, ReachabilityHierarchyFollowsNesting) {
+    const auto *innermost = makeIf();
+    const auto *elseBranch = makeIf();
+    const auto *inner = makeIf(innermost);
+    const auto *outer = makeIf(inner, elseBranch);
+    const auto *sibling = makeIf();
+    const auto *program = new IR::BlockStatement({outer, sibling});
+
+    FakeEvaluation evaluation({outer, inner, innermost, elseBranch, sibling});
+    ReachabilityHierarchy hierarchy(*program, evaluation.reachabilityMap());
+    EXPECT_EQ(hierarchy.parent(outer), nullptr);
+    EXPECT_EQ(hierarchy.parent(inner), outer);
+    EXPECT_EQ(hierarchy.parent(innermost), inner);
+    // The false branch does not execute under the condition of the if statement.
+    EXPECT_EQ(hierarchy.parent(elseBranch), nullptr);
+    EXPECT_EQ(hierarchy.parent(sibling), nullptr);
+    EXPECT_EQ(hierarchy.depth(outer), 0U);
+    EXPECT_EQ(hierarchy.depth(innermost), 2U);
+}
+
+TEST_F(P4FlayTest, ReachabilityHierarchyNestsOnlyDominatedSwitchCases) {
+    const auto *fallThroughTarget = makeIf();
+    const auto *blockTarget = makeIf();
+    const auto *defaultTarget = makeIf();
+    auto *fallThroughCase = new IR::SwitchCase(new IR::PathExpression(IR::ID("a")), nullptr);
+    auto *sharedCase = new IR::SwitchCase(new IR::PathExpression(IR::ID("b")),
+                                          new IR::BlockStatement({fallThroughTarget}));
+    auto *blockCase = new IR::SwitchCase(new IR::PathExpression(IR::ID("c")),
+                                         new IR::BlockStatement({blockTarget}));
+    auto *defaultCase =
+        new IR::SwitchCase(new IR::DefaultExpression(), new IR::BlockStatement({defaultTarget}));
+    const auto *program = new IR::SwitchStatement(
+        new IR::PathExpression(IR::ID("x")),
+        IR::Vector<IR::SwitchCase>({fallThroughCase, sharedCase, blockCase, defaultCase}));
+
+    FakeEvaluation evaluation({fallThroughCase, sharedCase, blockCase, fallThroughTarget,
+                               blockTarget, defaultTarget});
+    ReachabilityHierarchy hierarchy(*program, evaluation.reachabilityMap());
+    // The block of the second case also executes when the first label matches.
+    EXPECT_EQ(hierarchy.parent(fallThroughTarget), nullptr);
+    EXPECT_EQ(hierarchy.parent(blockTarget), blockCase);
+    EXPECT_EQ(hierarchy.parent(defaultTarget), nullptr);
+}
+
+TEST_F(P4FlayTest, ReachabilityHierarchyDefersNodesBelowUnreachableNodes) {
+    const auto *innermost = makeIf();
+    const auto *inner = makeIf(innermost);
+    const auto *outer = makeIf(inner);
+    const auto *sibling = makeIf();
+    const auto *program = new IR::BlockStatement({outer, sibling});
+
+    FakeEvaluation evaluation({outer, inner, innermost, sibling});
+    ReachabilityHierarchy hierarchy(*program, evaluation.reachabilityMap());
+
+    // Nodes below an unreachable node are unreachable without evaluating them.
+    evaluation.setVerdict(outer, false);
+    ASSERT_EQ(evaluation.recomputeAll(hierarchy), true);
+    EXPECT_EQ(evaluation.evaluatedNodes(), std::vector<const IR::Node *>({outer, sibling}));
+    EXPECT_EQ(evaluation.reachability(inner), false);
+    EXPECT_EQ(evaluation.reachability(innermost), false);
+    EXPECT_EQ(hierarchy.skippedNodeCount(), 2U);
+
+    // Updating a deferred node does not evaluate it as long as its parent is unreachable.
+    ASSERT_EQ(evaluation.recompute(hierarchy, {innermost}), false);
+    EXPECT_TRUE(evaluation.evaluatedNodes().empty());
+
+    // Once the parent becomes reachable, the deferred nodes below it are resolved.
+    evaluation.setVerdict(outer, std::nullopt);
+    evaluation.setVerdict(innermost, true);
+    ASSERT_EQ(evaluation.recompute(hierarchy, {outer}), true);
+    EXPECT_EQ(evaluation.evaluatedNodes(),
+              std::vector<const IR::Node *>({outer, inner, innermost}));
+    EXPECT_EQ(evaluation.reachability(inner), std::nullopt);
+    EXPECT_EQ(evaluation.reachability(innermost), true);
+    EXPECT_EQ(hierarchy.evaluatedNodeCount(), 5U);
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
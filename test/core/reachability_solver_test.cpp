@@ -0,0 +1,121 @@
+#include "backends/p4tools/modules/flay/core/specialization/z3/reachability_solver.h"
+
+#include <gtest/gtest.h>
+
+#include "backends/p4tools/common/lib/variables.h"
+#include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
+#include "backends/p4tools/modules/flay/core/lib/z3_cache.h"
+#include "backends/p4tools/modules/flay/core/specialization/z3/reachability_map.h"
+#include "backends/p4tools/modules/flay/test/helpers.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::P4Tools::Flay;
+
+/// The width of the variables of the tests.
+constexpr int kWidth = 8;
+
+/// @returns a constant of the width of the variables.
+const IR::Constant *makeConstant(uint64_t value) {
+    return IR::Constant::get(IR::Type_Bits::get(kWidth), value);
+}
+
+/// @returns the condition "(@p dataPlaneVariable & 1) == 1 && (@p dataPlaneVariable & 3) ==
+/// @p controlPlaneVariable", which can not hold if the control-plane variable is 0. Simplification
+/// does not detect this.
+const IR::Expression *makeCondition(const IR::Expression *dataPlaneVariable,
+                                    const IR::Expression *controlPlaneVariable) {
+    const auto *type = IR::Type_Bits::get(kWidth);
+    return new IR::LAnd(
+        new IR::Equ(new IR::BAnd(type, dataPlaneVariable, makeConstant(1)), makeConstant(1)),
+        new IR::Equ(new IR::BAnd(type, dataPlaneVariable, makeConstant(3)), controlPlaneVariable));
+}
+
+TEST_F(P4FlayTest, ReachabilitySolverUsesCurrentBindings) {
+    const auto *dataPlaneVariable =
+        ToolsVariables::getSymbolicVariable(IR::Type_Bits::get(kWidth), "d");
+    const auto *controlPlaneVariable =
+        ToolsVariables::getSymbolicVariable(IR::Type_Bits::get(kWidth), "k");
+    auto condition = Z3Cache::set(makeCondition(dataPlaneVariable, controlPlaneVariable));
+
+    Z3ReachabilitySolver solver(Z3Cache::context(), 1000);
+    auto checkWithBinding = [&](uint64_t value) {
+        z3::expr_vector variables(Z3Cache::context());
+        z3::expr_vector values(Z3Cache::context());
+        variables.push_back(Z3Cache::set(controlPlaneVariable));
+        values.push_back(Z3Cache::set(makeConstant(value)));
+        solver.setBindings(variables, values);
+        return solver.isSatisfiable(condition);
+    };
+    EXPECT_EQ(checkWithBinding(0), false);
+    EXPECT_EQ(checkWithBinding(3), true);
+    // The assertions of the first check are reused.
+    EXPECT_EQ(checkWithBinding(0), false);
+    z3::expr_vector noBindings(Z3Cache::context());
+    solver.setBindings(noBindings, noBindings);
+    EXPECT_EQ(solver.isSatisfiable(condition), true);
+    EXPECT_EQ(solver.checkCount(), 4U);
+    EXPECT_EQ(solver.unsatisfiableCount(), 2U);
+    EXPECT_EQ(solver.unknownCount(), 0U);
+}
+
+TEST_F(P4FlayTest, ReachabilitySolverEliminatesUnsatisfiableNodes) {
+    const auto *dataPlaneVariable =
+        ToolsVariables::getSymbolicVariable(IR::Type_Bits::get(kWidth), "d");
+    const auto *controlPlaneVariable =
+        ToolsVariables::getSymbolicVariable(IR::Type_Bits::get(kWidth), "k");
+    const auto *node = new IR::EmptyStatement();
+    NodeAnnotationMap nodeAnnotationMap;
+    nodeAnnotationMap.initializeReachabilityMapping(
+        node, makeCondition(dataPlaneVariable, controlPlaneVariable));
+
+    ControlPlaneAssignmentSet assignment;
+    assignment.emplace(*controlPlaneVariable, *makeConstant(0));
+    TableDefaultAction controlPlaneItem(assignment);
+    ControlPlaneConstraints controlPlaneConstraints;
+    controlPlaneConstraints.emplace("control_plane", controlPlaneItem);
+
+    IR::P4Program program{IR::Vector<IR::Node>()};
+    Z3SolverReachabilityMap simplifyingMap(nodeAnnotationMap, program);
+    ASSERT_TRUE(simplifyingMap.recomputeReachability(controlPlaneConstraints).has_value());
+    EXPECT_EQ(simplifyingMap.isNodeReachable(node), std::nullopt);
+    EXPECT_EQ(simplifyingMap.solver(), nullptr);
+
+    Z3SolverReachabilityMap solvingMap(nodeAnnotationMap, program, 1000);
+    ASSERT_TRUE(solvingMap.recomputeReachability(controlPlaneConstraints).has_value());
+    EXPECT_EQ(solvingMap.isNodeReachable(node), false);
+    ASSERT_NE(solvingMap.solver(), nullptr);
+    EXPECT_EQ(solvingMap.solver()->unsatisfiableCount(), 1U);
+}
+
+TEST_F(P4FlayTest, ReachabilitySolverRespectsUpdateBudget) {
+    const auto *dataPlaneVariable =
+        ToolsVariables::getSymbolicVariable(IR::Type_Bits::get(kWidth), "d");
+    const auto *controlPlaneVariable =
+        ToolsVariables::getSymbolicVariable(IR::Type_Bits::get(kWidth), "k");
+    const auto *node = new IR::EmptyStatement();
+    NodeAnnotationMap nodeAnnotationMap;
+    nodeAnnotationMap.initializeReachabilityMapping(
+        node, makeCondition(dataPlaneVariable, controlPlaneVariable));
+
+    ControlPlaneAssignmentSet assignment;
+    assignment.emplace(*controlPlaneVariable, *makeConstant(0));
+    TableDefaultAction controlPlaneItem(assignment);
+    ControlPlaneConstraints controlPlaneConstraints;
+    controlPlaneConstraints.emplace("control_plane", controlPlaneItem);
+
+    // Without a budget for the update, the condition is not checked and stays undecided.
+    IR::P4Program program{IR::Vector<IR::Node>()};
+    Z3SolverReachabilityMap solvingMap(nodeAnnotationMap, program, 1000, 0);
+    ASSERT_TRUE(solvingMap.recomputeReachability(controlPlaneConstraints).has_value());
+    EXPECT_EQ(solvingMap.isNodeReachable(node), std::nullopt);
+    ASSERT_NE(solvingMap.solver(), nullptr);
+    EXPECT_EQ(solvingMap.solver()->checkCount(), 0U);
+    EXPECT_EQ(solvingMap.solver()->skippedCount(), 1U);
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
@@ -0,0 +1,118 @@
+#include "backends/p4tools/modules/flay/core/specialization/service_metrics.h"
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "backends/p4tools/modules/flay/test/helpers.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using P4::P4Tools::Flay::FlayServiceMetrics;
+using P4::P4Tools::Flay::MetricsServer;
+
+/// A minimal stand-in for a Prometheus scraper. Issues a GET request for @p path and returns the
+/// full HTTP response.
+std::string scrape(uint16_t port, std::string_view path) {
+    int connection = socket(AF_INET, SOCK_STREAM, 0);
+    EXPECT_GE(connection, 0);
+    sockaddr_in serverAddress{};
+    serverAddress.sin_family = AF_INET;
+    serverAddress.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &serverAddress.sin_addr);
+    EXPECT_EQ(
+        connect(connection, reinterpret_cast<sockaddr *>(&serverAddress), sizeof(serverAddress)),
+        0);
+    std::string request = "GET " + std::string(path) + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    EXPECT_EQ(send(connection, request.data(), request.size(), 0),
+              static_cast<ssize_t>(request.size()));
+    std::string response;
+    std::array<char, 1024> buffer{};
+    ssize_t bytesRead = 0;
+    while ((bytesRead = recv(connection, buffer.data(), buffer.size(), 0)) > 0) {
+        response.append(buffer.data(), bytesRead);
+    }
+    close(connection);
+    return response;
+}
+
+TEST_F(P4FlayTest, MetricsExposition) {
+    FlayServiceMetrics metrics;
+    metrics.recordUpdate(3, 0.002, true);
+    metrics.recordUpdate(1, 0.3, false);
+    metrics.recordFailedUpdate(2);
+    metrics.setQueueDepth(5);
+    metrics.setZ3CacheSize(42);
+    metrics.setTableEncodingCounts({{"per_entry", 7}, {"action_set", 1}});
+    metrics.setShadowedEntryCount(3);
+
+    auto text = metrics.toPrometheusText();
+    EXPECT_NE(text.find("flay_updates_processed_total 4\n"), std::string::npos);
+    EXPECT_NE(text.find("flay_updates_failed_total 2\n"), std::string::npos);
+    EXPECT_NE(text.find("flay_respecializations_total 1\n"), std::string::npos);
+    EXPECT_NE(text.find("flay_update_queue_depth 5\n"), std::string::npos);
+    EXPECT_NE(text.find("flay_z3_cache_entries 42\n"), std::string::npos);
+    EXPECT_NE(text.find("flay_shadowed_table_entries 3\n"), std::string::npos);
+    EXPECT_NE(text.find("flay_tables{encoding=\"per_entry\"} 7\n"), std::string::npos);
+    EXPECT_NE(text.find("flay_tables{encoding=\"action_set\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE flay_update_latency_seconds histogram\n"), std::string::npos);
+    // Buckets are cumulative.
+    EXPECT_NE(text.find("flay_update_latency_seconds_bucket{le=\"0.001\"} 0\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("flay_update_latency_seconds_bucket{le=\"0.0025\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("flay_update_latency_seconds_bucket{le=\"0.5\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("flay_update_latency_seconds_bucket{le=\"+Inf\"} 2\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("flay_update_latency_seconds_count 2\n"), std::string::npos);
+    EXPECT_NE(text.find("flay_respecialization_latency_seconds_count 1\n"), std::string::npos);
+}
+
+TEST_F(P4FlayTest, MetricsAddressSplitsHostAndPort) {
+    using HostAndPort = std::pair<std::string, std::string>;
+    EXPECT_EQ(MetricsServer::splitAddress("127.0.0.1:9000"), HostAndPort("127.0.0.1", "9000"));
+    EXPECT_EQ(MetricsServer::splitAddress("localhost:9000"), HostAndPort("localhost", "9000"));
+    EXPECT_EQ(MetricsServer::splitAddress(":9000"), HostAndPort("", "9000"));
+    EXPECT_EQ(MetricsServer::splitAddress("[::1]:9000"), HostAndPort("::1", "9000"));
+    EXPECT_EQ(MetricsServer::splitAddress("[::]:0"), HostAndPort("::", "0"));
+    // IPv6 addresses need brackets, and the port is required.
+    EXPECT_EQ(MetricsServer::splitAddress("::1:9000"), std::nullopt);
+    EXPECT_EQ(MetricsServer::splitAddress("[::1]9000"), std::nullopt);
+    EXPECT_EQ(MetricsServer::splitAddress("[::1:9000"), std::nullopt);
+    EXPECT_EQ(MetricsServer::splitAddress("127.0.0.1"), std::nullopt);
+    EXPECT_EQ(MetricsServer::splitAddress("127.0.0.1:"), std::nullopt);
+}
+
+TEST_F(P4FlayTest, MetricsEndpoint) {
+    FlayServiceMetrics metrics;
+    MetricsServer server(metrics);
+    ASSERT_TRUE(server.start("127.0.0.1:0"));
+    ASSERT_NE(server.port(), 0);
+
+    metrics.recordUpdate(7, 0.01, true);
+    auto response = scrape(server.port(), "/metrics");
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0U);
+    EXPECT_NE(response.find("flay_updates_processed_total 7\n"), std::string::npos);
+
+    // Metrics are read live.
+    metrics.recordUpdate(1, 0.01, false);
+    response = scrape(server.port(), "/metrics");
+    EXPECT_NE(response.find("flay_updates_processed_total 8\n"), std::string::npos);
+
+    response = scrape(server.port(), "/");
+    EXPECT_EQ(response.rfind("HTTP/1.1 404 Not Found\r\n", 0), 0U);
+    server.stop();
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
@@ -0,0 +1,127 @@
+#include "backends/p4tools/modules/flay/core/control_plane/shadow_detection.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "backends/p4tools/common/lib/variables.h"
+#include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
+#include "backends/p4tools/modules/flay/core/control_plane/p4info_index.h"
+#include "backends/p4tools/modules/flay/test/helpers.h"
+#include "backends/p4tools/modules/flay/test/p4runtime_helpers.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::P4Tools::Flay;
+
+/// @returns the vector instructions supported by the processor, including the scalar fallback.
+std::vector<SimdLevel> supportedSimdLevels() {
+    std::vector<SimdLevel> simdLevels = {SimdLevel::kScalar};
+    auto supportedLevel = ShadowDetector::supportedSimdLevel();
+    if (supportedLevel == SimdLevel::kSse2 || supportedLevel == SimdLevel::kAvx2) {
+        simdLevels.push_back(SimdLevel::kSse2);
+    }
+    if (supportedLevel == SimdLevel::kAvx2) {
+        simdLevels.push_back(SimdLevel::kAvx2);
+    }
+    return simdLevels;
+}
+
+TEST_F(P4FlayTest, ShadowDetectorFindsCoveredTernaryEntries) {
+    // Entries are appended in descending order of precedence.
+    ShadowDetector shadowDetector({16});
+    shadowDetector.append({FieldMatch::masked(0x0800, 0xFF00)});
+    shadowDetector.append({FieldMatch::masked(0x0806, 0xFFFF)});
+    shadowDetector.append({FieldMatch::masked(0x0900, 0xFF00)});
+    shadowDetector.append({FieldMatch::masked(0x0000, 0x0000)});
+    shadowDetector.append({FieldMatch::masked(0x1234, 0xFFFF)});
+    // The second entry with the same match as the first is shadowed as well.
+    shadowDetector.append({FieldMatch::masked(0x0800, 0xFF00)});
+    ASSERT_EQ(shadowDetector.size(), 6U);
+
+    std::vector<bool> expected = {false, true, false, false, true, true};
+    for (auto simdLevel : supportedSimdLevels()) {
+        EXPECT_EQ(shadowDetector.findShadowedEntries(simdLevel), expected);
+    }
+}
+
+TEST_F(P4FlayTest, ShadowDetectorRequiresCoverOfAllFields) {
+    ShadowDetector shadowDetector({8, 8});
+    shadowDetector.append({FieldMatch::masked(0x10, 0xF0), FieldMatch::masked(0x01, 0xFF)});
+    // Covered in the first field only.
+    shadowDetector.append({FieldMatch::masked(0x12, 0xFF), FieldMatch::masked(0x02, 0xFF)});
+    // Covered in both fields.
+    shadowDetector.append({FieldMatch::masked(0x12, 0xFF), FieldMatch::masked(0x01, 0xFF)});
+    // Covered in the second field only.
+    shadowDetector.append({FieldMatch::masked(0x00, 0x00), FieldMatch::masked(0x01, 0xFF)});
+
+    std::vector<bool> expected = {false, false, true, false};
+    for (auto simdLevel : supportedSimdLevels()) {
+        EXPECT_EQ(shadowDetector.findShadowedEntries(simdLevel), expected);
+    }
+}
+
+TEST_F(P4FlayTest, ShadowDetectorComparesWideFields) {
+    // IPv6 addresses span multiple words. Prefixes differ in the high word only.
+    big_int address = big_int(0x20010DB8) << 96;
+    big_int prefix32 = big_int(0xFFFFFFFF) << 96;
+    big_int fullMask = (big_int(1) << 128) - 1;
+    ShadowDetector shadowDetector({128});
+    shadowDetector.append({FieldMatch::masked(address, prefix32)});
+    shadowDetector.append({FieldMatch::masked(address | 1, fullMask)});
+    shadowDetector.append({FieldMatch::masked((address + (big_int(1) << 96)) | 1, fullMask)});
+
+    std::vector<bool> expected = {false, true, false};
+    for (auto simdLevel : supportedSimdLevels()) {
+        EXPECT_EQ(shadowDetector.findShadowedEntries(simdLevel), expected);
+    }
+}
+
+TEST_F(P4FlayTest, ShadowDetectorKeepsLongerPrefixesOfTheP4RuntimeConverter) {
+    auto p4Info = P4Runtime::makeRoutingP4Info();
+    P4InfoIndex p4InfoIndex(p4Info);
+    auto *tableConfiguration = P4Runtime::makeRoutingTableConfiguration();
+    // The /8 is inserted last, so only the prefix length gives the /24 precedence.
+    ASSERT_EQ(P4Runtime::insertRoute(p4InfoIndex, *tableConfiguration, 0x0A010200, 24,
+                                     P4Runtime::kSetPortActionId),
+              EXIT_SUCCESS);
+    ASSERT_EQ(P4Runtime::insertRoute(p4InfoIndex, *tableConfiguration, 0x0A000000, 8,
+                                     P4Runtime::kDropActionId),
+              EXIT_SUCCESS);
+    const auto *subnetRoute =
+        P4Runtime::findRoute(p4InfoIndex, *tableConfiguration, P4Runtime::kSetPortActionId);
+    const auto *networkRoute =
+        P4Runtime::findRoute(p4InfoIndex, *tableConfiguration, P4Runtime::kDropActionId);
+    ASSERT_NE(subnetRoute, nullptr);
+    ASSERT_NE(networkRoute, nullptr);
+
+    // The longest prefix wins, so the /8 does not shadow the /24.
+    EXPECT_EQ(tableConfiguration->shadowedEntryCount(), 0U);
+    EXPECT_EQ(tableConfiguration->findShadowingEntry(*subnetRoute), nullptr);
+    EXPECT_EQ(tableConfiguration->findShadowingEntry(*networkRoute), nullptr);
+
+    // Had the /8 precedence, it would shadow the /24, but not the other way around.
+    const auto *keyExpression = ToolsVariables::getSymbolicVariable(
+        IR::Type_Bits::get(32), P4Runtime::kRoutingKeyName);
+    LpmTableMatchKey lpmKey(P4Runtime::kRoutingTableName, P4Runtime::kRoutingKeyName,
+                            keyExpression);
+    auto subnetMatch = computeFieldMatch(lpmKey, subnetRoute->matches());
+    auto networkMatch = computeFieldMatch(lpmKey, networkRoute->matches());
+    ASSERT_TRUE(subnetMatch.has_value());
+    ASSERT_TRUE(networkMatch.has_value());
+    ShadowDetector shadowDetector({32});
+    shadowDetector.append({networkMatch.value()});
+    shadowDetector.append({subnetMatch.value()});
+    shadowDetector.append({networkMatch.value()});
+    std::vector<bool> expected = {false, true, true};
+    for (auto simdLevel : supportedSimdLevels()) {
+        EXPECT_EQ(shadowDetector.findShadowedEntries(simdLevel), expected);
+    }
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
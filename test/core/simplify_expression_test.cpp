@@ -4,6 +4,7 @@
 #include <gtest/gtest.h>
 
 #include <sstream>
+#include <string>
 
 #include <boost/multiprecision/cpp_int.hpp>
 
@@ -129,6 +130,85 @@ TEST_F(P4FlayTest, Optimization04) {
     }
 }
 
+TEST_F(P4FlayTest, Optimization05) {
+    const auto *eightBitType = IR::Type_Bits::get(8);
+    const auto *xVar =
+        P4Tools::ToolsVariables::getSymbolicVariable(IR::Type_Boolean::get(), "X"_cs);
+    const auto *yVar =
+        P4Tools::ToolsVariables::getSymbolicVariable(IR::Type_Boolean::get(), "Y"_cs);
+    const auto *aVar = P4Tools::ToolsVariables::getSymbolicVariable(eightBitType, "A"_cs);
+    const auto *bVar = P4Tools::ToolsVariables::getSymbolicVariable(eightBitType, "B"_cs);
+    const auto *cVar = P4Tools::ToolsVariables::getSymbolicVariable(eightBitType, "C"_cs);
+    const auto *dVar = P4Tools::ToolsVariables::getSymbolicVariable(eightBitType, "D"_cs);
+    {
+        // The conditions of all enclosing muxes are folded down.
+        // |X(bool)| ? |Y(bool)| ? |Y(bool)| ? |A(bit<8>)| : |B(bit<8>)| : |C(bit<8>)| : |D(bit<8>)|
+        const auto *nestedMuxExpression =
+            new IR::Mux(xVar, new IR::Mux(yVar, new IR::Mux(yVar, aVar, bVar), cVar), dVar);
+        const auto *optimizedExpression =
+            P4Tools::SimplifyExpression::simplify(nestedMuxExpression);
+        const auto *expectedExpression = new IR::Mux(xVar, new IR::Mux(yVar, aVar, cVar), dVar);
+        ASSERT_TRUE(optimizedExpression->equiv(*expectedExpression));
+    }
+    {
+        // Conjunctive conditions are folded down as individual conditions.
+        // |X(bool)| && |Y(bool)| ? |Y(bool)| ? |A(bit<8>)| : |B(bit<8>)| : |C(bit<8>)|
+        const auto *conjunction = new IR::LAnd(xVar, yVar);
+        const auto *nestedMuxExpression =
+            new IR::Mux(conjunction, new IR::Mux(yVar, aVar, bVar), cVar);
+        const auto *optimizedExpression =
+            P4Tools::SimplifyExpression::simplify(nestedMuxExpression);
+        const auto *expectedExpression = new IR::Mux(conjunction, aVar, cVar);
+        ASSERT_TRUE(optimizedExpression->equiv(*expectedExpression));
+    }
+}
+
+TEST_F(P4FlayTest, Optimization06) {
+    const auto *eightBitType = IR::Type_Bits::get(8);
+    const auto *aVar = P4Tools::ToolsVariables::getSymbolicVariable(eightBitType, "A"_cs);
+    const auto *bVar = P4Tools::ToolsVariables::getSymbolicVariable(eightBitType, "B"_cs);
+
+    // Every level refers to the previous level twice, the expression has 2^64 paths.
+    // |C(bool)| ? |E(bit<8>)| : |C(bool)| ? |B(bit<8>)| : |E(bit<8>)|
+    const IR::Expression *sharedExpression = aVar;
+    for (int level = 0; level < 64; ++level) {
+        const auto *cVar = P4Tools::ToolsVariables::getSymbolicVariable(
+            IR::Type_Boolean::get(), cstring("C" + std::to_string(level)));
+        sharedExpression = new IR::Mux(cVar, sharedExpression,
+                                       new IR::Mux(cVar, bVar, sharedExpression));
+    }
+    const auto *optimizedExpression = P4Tools::SimplifyExpression::simplify(sharedExpression);
+    ASSERT_TRUE(optimizedExpression->equiv(*aVar));
+}
+
+TEST_F(P4FlayTest, SimplificationIsMemoized) {
+    const auto *eightBitType = IR::Type_Bits::get(8);
+    const auto *xVar =
+        P4Tools::ToolsVariables::getSymbolicVariable(IR::Type_Boolean::get(), "X"_cs);
+    const auto *aVar = P4Tools::ToolsVariables::getSymbolicVariable(eightBitType, "A"_cs);
+    const auto *cVar = P4Tools::ToolsVariables::getSymbolicVariable(eightBitType, "C"_cs);
+    auto statistics = P4Tools::SimplifyExpression::cacheStatistics();
+
+    // |X(bool)| ? |X(bool)| ? |A(bit<8>)| : |C(bit<8>)| : |C(bit<8>)|
+    const auto *optimizedExpression = P4Tools::SimplifyExpression::simplify(
+        new IR::Mux(xVar, new IR::Mux(xVar, aVar, cVar), cVar));
+    EXPECT_EQ(P4Tools::SimplifyExpression::cacheStatistics().misses, statistics.misses + 1);
+
+    // A structurally equal expression is not simplified again.
+    const auto *memoizedExpression = P4Tools::SimplifyExpression::simplify(
+        new IR::Mux(xVar, new IR::Mux(xVar, aVar, cVar), cVar));
+    EXPECT_EQ(memoizedExpression, optimizedExpression);
+    EXPECT_EQ(P4Tools::SimplifyExpression::cacheStatistics().hits, statistics.hits + 1);
+
+    // The result simplifies to itself. Once this is known, it is returned without comparison.
+    EXPECT_TRUE(
+        P4Tools::SimplifyExpression::simplify(optimizedExpression)->equiv(*optimizedExpression));
+    EXPECT_EQ(P4Tools::SimplifyExpression::simplify(optimizedExpression), optimizedExpression);
+    auto fixpointStatistics = P4Tools::SimplifyExpression::cacheStatistics();
+    EXPECT_EQ(fixpointStatistics.fixpointHits, statistics.fixpointHits + 1);
+    EXPECT_EQ(fixpointStatistics.misses, statistics.misses + 2);
+}
+
 }  // anonymous namespace
 
 }  // namespace P4::P4Tools::Test
@@ -0,0 +1,589 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "backends/p4tools/common/control_plane/symbolic_variables.h"
+#include "backends/p4tools/common/lib/variables.h"
+#include "backends/p4tools/modules/flay/core/control_plane/action_enumeration.h"
+#include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
+#include "backends/p4tools/modules/flay/core/lib/z3_cache.h"
+#include "backends/p4tools/modules/flay/test/helpers.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::P4Tools::Flay;
+
+/// The name of the table under test.
+constexpr const char *kTableName = "ingress.forward";
+
+/// @returns the enumeration of the actions of the table under test.
+const ActionEnumeration &tableActions() {
+    static const ActionEnumeration kTableActions({"NoAction", "ingress.drop", "ingress.set_port"});
+    return kTableActions;
+}
+
+/// @returns the ordinal of @p actionName in the table under test.
+const IR::Constant *actionLiteral(const char *actionName) {
+    return tableActions().literal(actionName);
+}
+
+/// @returns the action choice of the table under test.
+const IR::SymbolicVariable *actionChoiceVariable() {
+    return ControlPlaneState::getActionChoiceVariable(kTableName, tableActions().type());
+}
+
+/// Produce an entry of the table under test which matches @p key and executes @p actionName.
+TableMatchEntry *makeEntry(uint64_t key, const char *actionName, int32_t priority = 0) {
+    const auto *keyType = IR::Type_Bits::get(16);
+    ControlPlaneAssignmentSet actionAssignment;
+    actionAssignment.emplace(*actionChoiceVariable(), *actionLiteral(actionName));
+    ControlPlaneAssignmentSet matches;
+    matches.emplace(*ControlPlaneState::getTableKey(kTableName, "hdr.eth.type", keyType),
+                    *IR::Constant::get(keyType, key));
+    return new TableMatchEntry(actionAssignment, priority, matches);
+}
+
+/// Let @p tableConfiguration match exactly on a 16-bit field.
+void setExactKey(TableConfiguration &tableConfiguration) {
+    const auto *keyExpression =
+        ToolsVariables::getSymbolicVariable(IR::Type_Bits::get(16), "hdr.eth.type");
+    tableConfiguration.setTableKeyMatch(
+        {new ExactTableMatchKey(kTableName, "hdr.eth.type", keyExpression)});
+}
+
+TEST_F(P4FlayTest, TableConfigurationTracksActionSummary) {
+    TableConfiguration tableConfiguration(kTableName, TableDefaultAction({}), {});
+    setExactKey(tableConfiguration);
+    EXPECT_TRUE(tableConfiguration.isDeterminedByActionSummary());
+    EXPECT_EQ(tableConfiguration.keySymbols().size(), 1U);
+    tableConfiguration.consumeSummaryChange();
+
+    // The first entry activates the table and installs an action.
+    ASSERT_EQ(tableConfiguration.addTableEntry(*makeEntry(1, "ingress.set_port"), false),
+              EXIT_SUCCESS);
+    EXPECT_TRUE(tableConfiguration.consumeSummaryChange());
+    EXPECT_FALSE(tableConfiguration.consumeSummaryChange());
+
+    // Another entry with the same action preserves the summary.
+    ASSERT_EQ(tableConfiguration.addTableEntry(*makeEntry(2, "ingress.set_port"), false),
+              EXIT_SUCCESS);
+    EXPECT_FALSE(tableConfiguration.consumeSummaryChange());
+
+    // A new action changes the summary, and so does removing its only entry.
+    ASSERT_EQ(tableConfiguration.addTableEntry(*makeEntry(3, "ingress.drop"), false),
+              EXIT_SUCCESS);
+    EXPECT_TRUE(tableConfiguration.consumeSummaryChange());
+    EXPECT_EQ(tableConfiguration.deleteTableEntry(*makeEntry(3, "ingress.drop")), 1U);
+    EXPECT_TRUE(tableConfiguration.consumeSummaryChange());
+
+    // Replacing the action of an entry only changes the summary if the old action disappears.
+    tableConfiguration.addTableEntry(*makeEntry(2, "ingress.drop"), true);
+    EXPECT_TRUE(tableConfiguration.consumeSummaryChange());
+    tableConfiguration.addTableEntry(*makeEntry(2, "ingress.drop"), true);
+    EXPECT_FALSE(tableConfiguration.consumeSummaryChange());
+
+    // Deleting a missing entry changes nothing.
+    EXPECT_EQ(tableConfiguration.deleteTableEntry(*makeEntry(4, "ingress.drop")), 0U);
+    EXPECT_FALSE(tableConfiguration.consumeSummaryChange());
+
+    tableConfiguration.clearTableEntries();
+    EXPECT_TRUE(tableConfiguration.consumeSummaryChange());
+}
+
+TEST_F(P4FlayTest, TableConfigurationWithoutDisjointKeysIsNotSummarized) {
+    TableConfiguration tableConfiguration(kTableName, TableDefaultAction({}), {});
+    EXPECT_FALSE(tableConfiguration.isDeterminedByActionSummary());
+    const auto *keyExpression =
+        ToolsVariables::getSymbolicVariable(IR::Type_Bits::get(16), "hdr.eth.type");
+    tableConfiguration.setTableKeyMatch(
+        {new TernaryTableMatchKey(kTableName, "hdr.eth.type", keyExpression)});
+    EXPECT_FALSE(tableConfiguration.isDeterminedByActionSummary());
+}
+
+TEST_F(P4FlayTest, TableConfigurationWithRestrictedKeysIsNotSummarized) {
+    const auto *keyType = IR::Type_Bits::get(16);
+    const auto *keyVariable = ToolsVariables::getSymbolicVariable(keyType, "hdr.eth.type");
+    const auto *bitVariable =
+        ToolsVariables::getSymbolicVariable(IR::Type_Bits::get(1), "hdr.eth.flag");
+    // Both keys only take the values 0 and 1, so two entries make the default action unreachable.
+    const std::vector<const IR::Expression *> restrictedKeys = {
+        new IR::BAnd(keyType, keyVariable, IR::Constant::get(keyType, 1)),
+        new IR::Cast(keyType, bitVariable),
+    };
+    for (const auto *keyExpression : restrictedKeys) {
+        TableConfiguration tableConfiguration(kTableName, TableDefaultAction({}), {});
+        tableConfiguration.setTableKeyMatch(
+            {new ExactTableMatchKey(kTableName, "hdr.eth.type", keyExpression)});
+        ASSERT_EQ(tableConfiguration.addTableEntry(*makeEntry(0, "ingress.set_port"), false),
+                  EXIT_SUCCESS);
+        ASSERT_EQ(tableConfiguration.addTableEntry(*makeEntry(1, "ingress.drop"), false),
+                  EXIT_SUCCESS);
+        EXPECT_FALSE(tableConfiguration.isDeterminedByActionSummary());
+        EXPECT_EQ(tableConfiguration.keySymbols().size(), 1U);
+    }
+
+    // Matching the same symbol twice only covers the diagonal of the key space.
+    TableConfiguration tableConfiguration(kTableName, TableDefaultAction({}), {});
+    tableConfiguration.setTableKeyMatch(
+        {new ExactTableMatchKey(kTableName, "hdr.eth.type", keyVariable),
+         new ExactTableMatchKey(kTableName, "hdr.eth.type_copy", keyVariable)});
+    EXPECT_FALSE(tableConfiguration.isDeterminedByActionSummary());
+}
+
+TEST_F(P4FlayTest, TableConfigurationSummarizesEntriesBeyondBudget) {
+    const auto *keyType = IR::Type_Bits::get(16);
+    const auto *actionChoice = actionChoiceVariable();
+    ControlPlaneAssignmentSet defaultAssignment;
+    defaultAssignment.emplace(*actionChoice, *actionLiteral("NoAction"));
+    TableConfiguration tableConfiguration(kTableName, TableDefaultAction(defaultAssignment), {});
+    setExactKey(tableConfiguration);
+    tableConfiguration.setEntryBudget(2);
+    for (uint64_t key = 1; key <= 3; ++key) {
+        ASSERT_EQ(tableConfiguration.addTableEntry(*makeEntry(key, "ingress.set_port"), false),
+                  EXIT_SUCCESS);
+    }
+    ASSERT_EQ(tableConfiguration.addTableEntry(*makeEntry(7, "ingress.drop"), false),
+              EXIT_SUCCESS);
+    EXPECT_EQ(tableConfiguration.encoding(), TableEncoding::kSummarized);
+
+    // Resolve the action the table selects for a concrete key.
+    auto assignments = tableConfiguration.computeZ3ControlPlaneAssignments();
+    auto z3ActionChoice = Z3Cache::set(actionChoice);
+    auto selectedAction = assignments.substitute(z3ActionChoice);
+    auto selectActionFor = [&](uint64_t key) {
+        z3::expr_vector from(Z3Cache::context());
+        z3::expr_vector to(Z3Cache::context());
+        from.push_back(Z3Cache::set(ToolsVariables::getSymbolicVariable(keyType, "hdr.eth.type")));
+        to.push_back(Z3Cache::set(IR::Constant::get(keyType, key)));
+        return selectedAction.substitute(from, to).simplify();
+    };
+    auto expectAction = [&](uint64_t key, const char *actionName) {
+        EXPECT_TRUE(z3::eq(selectActionFor(key), Z3Cache::set(actionLiteral(actionName))))
+            << "key " << key;
+    };
+    expectAction(0, "NoAction");
+    expectAction(1, "ingress.set_port");
+    expectAction(3, "ingress.set_port");
+    expectAction(4, "NoAction");
+    expectAction(7, "ingress.drop");
+
+    // Beyond the summary budget, the table only tracks its installed actions.
+    tableConfiguration.setSummaryBudget(3);
+    EXPECT_EQ(tableConfiguration.encoding(), TableEncoding::kActionSet);
+    tableConfiguration.setSummaryBudget(kMaxSummarizedEntriesPerTable);
+
+    // Without a budget, the table falls back to the per-entry encoding.
+    tableConfiguration.setEntryBudget(kMaxEntriesPerTable);
+    EXPECT_EQ(tableConfiguration.encoding(), TableEncoding::kPerEntry);
+}
+
+TEST_F(P4FlayTest, TableConfigurationWithTernaryKeyTracksActionSetBeyondBudget) {
+    const auto *actionChoice = actionChoiceVariable();
+    ControlPlaneAssignmentSet defaultAssignment;
+    defaultAssignment.emplace(*actionChoice, *actionLiteral("NoAction"));
+    TableConfiguration tableConfiguration(kTableName, TableDefaultAction(defaultAssignment), {});
+    const auto *keyExpression =
+        ToolsVariables::getSymbolicVariable(IR::Type_Bits::get(16), "hdr.eth.type");
+    tableConfiguration.setTableKeyMatch(
+        {new TernaryTableMatchKey(kTableName, "hdr.eth.type", keyExpression)});
+    tableConfiguration.setEntryBudget(0);
+    ASSERT_EQ(tableConfiguration.addTableEntry(*makeEntry(1, "ingress.set_port"), false),
+              EXIT_SUCCESS);
+    ASSERT_EQ(tableConfiguration.addTableEntry(*makeEntry(2, "ingress.drop"), false),
+              EXIT_SUCCESS);
+    EXPECT_EQ(tableConfiguration.encoding(), TableEncoding::kActionSet);
+    EXPECT_TRUE(tableConfiguration.isDeterminedByActionSummary());
+
+    // The action choice is free to select any installed action or the default, but nothing else.
+    auto assignments = tableConfiguration.computeZ3ControlPlaneAssignments();
+    auto z3ActionChoice = Z3Cache::set(actionChoice);
+    auto selectedAction = assignments.substitute(z3ActionChoice);
+    auto canSelect = [&](const char *actionName) {
+        z3::solver solver(Z3Cache::context());
+        solver.add(selectedAction == Z3Cache::set(actionLiteral(actionName)));
+        return solver.check() == z3::sat;
+    };
+    EXPECT_TRUE(canSelect("ingress.set_port"));
+    EXPECT_TRUE(canSelect("ingress.drop"));
+    EXPECT_TRUE(canSelect("NoAction"));
+    EXPECT_FALSE(canSelect("ingress.forward"));
+}
+
+TEST_F(P4FlayTest, TableConfigurationKeepsConstantArgumentsInActionSet) {
+    const auto *portType = IR::Type_Bits::get(9);
+    const auto *portArgument = ControlPlaneState::getTableActionArgument(
+        kTableName, "ingress.set_port", "port", portType);
+    auto makePortEntry = [&](uint64_t key, uint64_t port) {
+        auto *entry = makeEntry(key, "ingress.set_port");
+        auto actionAssignment = entry->actionAssignment();
+        actionAssignment.emplace(*portArgument, *IR::Constant::get(portType, port));
+        return new TableMatchEntry(actionAssignment, 0, entry->matches());
+    };
+    TableConfiguration tableConfiguration(kTableName, TableDefaultAction({}), {});
+    const auto *keyExpression =
+        ToolsVariables::getSymbolicVariable(IR::Type_Bits::get(16), "hdr.eth.type");
+    tableConfiguration.setTableKeyMatch(
+        {new TernaryTableMatchKey(kTableName, "hdr.eth.type", keyExpression)});
+    tableConfiguration.setEntryBudget(0);
+    ASSERT_EQ(tableConfiguration.addTableEntry(*makePortEntry(1, 3), false), EXIT_SUCCESS);
+    ASSERT_EQ(tableConfiguration.addTableEntry(*makePortEntry(2, 3), false), EXIT_SUCCESS);
+
+    auto assignments = tableConfiguration.computeControlPlaneAssignments();
+    auto it = assignments.find(*portArgument);
+    ASSERT_NE(it, assignments.end());
+    EXPECT_TRUE(it->second.get().equiv(*IR::Constant::get(portType, 3)));
+
+    // Once the entries disagree, the argument is a wildcard.
+    ASSERT_EQ(tableConfiguration.addTableEntry(*makePortEntry(4, 5), false), EXIT_SUCCESS);
+    assignments = tableConfiguration.computeControlPlaneAssignments();
+    it = assignments.find(*portArgument);
+    ASSERT_NE(it, assignments.end());
+    EXPECT_TRUE(it->second.get().is<IR::SymbolicVariable>());
+}
+
+TEST_F(P4FlayTest, TableConfigurationPrunesEntriesWhichCanNotMatchConstantKeys) {
+    const auto *keyType = IR::Type_Bits::get(16);
+    const auto *actionChoice = actionChoiceVariable();
+    ControlPlaneAssignmentSet defaultAssignment;
+    defaultAssignment.emplace(*actionChoice, *actionLiteral("NoAction"));
+    TableConfiguration tableConfiguration(kTableName, TableDefaultAction(defaultAssignment), {});
+    setExactKey(tableConfiguration);
+    tableConfiguration.setEntryBudget(1);
+    ASSERT_EQ(tableConfiguration.addTableEntry(*makeEntry(1, "ingress.set_port"), false),
+              EXIT_SUCCESS);
+    ASSERT_EQ(tableConfiguration.addTableEntry(*makeEntry(2, "ingress.drop"), false),
+              EXIT_SUCCESS);
+    ASSERT_EQ(tableConfiguration.addTableEntry(*makeEntry(3, "ingress.set_port"), false),
+              EXIT_SUCCESS);
+    EXPECT_EQ(tableConfiguration.encoding(), TableEncoding::kSummarized);
+    EXPECT_TRUE(tableConfiguration.isDeterminedByActionSummary());
+
+    // Only the entry which matches the constant key remains, which fits the entry budget.
+    EXPECT_TRUE(
+        tableConfiguration.setConstantKeys({{"hdr.eth.type", IR::Constant::get(keyType, 2)}}));
+    EXPECT_FALSE(
+        tableConfiguration.setConstantKeys({{"hdr.eth.type", IR::Constant::get(keyType, 2)}}));
+    EXPECT_EQ(tableConfiguration.encoding(), TableEncoding::kPerEntry);
+    EXPECT_FALSE(tableConfiguration.isDeterminedByActionSummary());
+
+    auto canSelect = [&](const char *actionName) {
+        auto assignments = tableConfiguration.computeZ3ControlPlaneAssignments();
+        auto selectedAction = assignments.substitute(Z3Cache::set(actionChoice));
+        z3::solver solver(Z3Cache::context());
+        solver.add(selectedAction == Z3Cache::set(actionLiteral(actionName)));
+        return solver.check() == z3::sat;
+    };
+    EXPECT_TRUE(canSelect("ingress.drop"));
+    EXPECT_TRUE(canSelect("NoAction"));
+    EXPECT_FALSE(canSelect("ingress.set_port"));
+
+    // No entry matches this key, so only the default action remains.
+    EXPECT_TRUE(
+        tableConfiguration.setConstantKeys({{"hdr.eth.type", IR::Constant::get(keyType, 5)}}));
+    EXPECT_FALSE(canSelect("ingress.drop"));
+    EXPECT_TRUE(canSelect("NoAction"));
+
+    // Once the key is no longer constant, all entries are encoded again.
+    EXPECT_TRUE(tableConfiguration.setConstantKeys({}));
+    EXPECT_EQ(tableConfiguration.encoding(), TableEncoding::kSummarized);
+    EXPECT_TRUE(canSelect("ingress.set_port"));
+}
+
+/// Produce an entry of the table under test which matches the top @p prefixLength bits of the
+/// 16-bit @p key.
+TableMatchEntry *makeLpmEntry(uint64_t key, int prefixLength, const char *actionName,
+                              int32_t priority = 0) {
+    const auto *keyType = IR::Type_Bits::get(16);
+    ControlPlaneAssignmentSet actionAssignment;
+    actionAssignment.emplace(*actionChoiceVariable(), *actionLiteral(actionName));
+    ControlPlaneAssignmentSet matches;
+    matches.emplace(*ControlPlaneState::getTableKey(kTableName, "hdr.eth.type", keyType),
+                    *IR::Constant::get(keyType, key));
+    // Like the control-plane converters, the prefix symbol holds the prefix length.
+    matches.emplace(
+        *ControlPlaneState::getTableMatchLpmPrefix(kTableName, "hdr.eth.type", keyType),
+        *IR::Constant::get(keyType, prefixLength));
+    return new TableMatchEntry(actionAssignment, priority, matches);
+}
+
+TEST_F(P4FlayTest, LpmKeyAndFieldMatchAgreeOnThePrefixLength) {
+    const auto *keyType = IR::Type_Bits::get(16);
+    const auto *keyExpression = ToolsVariables::getSymbolicVariable(keyType, "hdr.eth.type");
+    const auto *lpmKey = new LpmTableMatchKey(kTableName, "hdr.eth.type", keyExpression);
+    for (int prefixLength : {0, 1, 12, 16}) {
+        auto *entry = makeLpmEntry(0x1234, prefixLength, "ingress.drop");
+        // The mask covers the top prefixLength bits, mask = ~0 << (width - prefix_len).
+        uint64_t mask = (0xFFFFULL << (16 - prefixLength)) & 0xFFFF;
+        auto fieldMatch = computeFieldMatch(*lpmKey, entry->matches());
+        ASSERT_TRUE(fieldMatch.has_value());
+        EXPECT_EQ(fieldMatch.value().mask, mask) << "prefix length " << prefixLength;
+
+        // The symbolic key matches exactly the values which agree with the entry under the mask.
+        z3::expr_vector from(Z3Cache::context());
+        z3::expr_vector to(Z3Cache::context());
+        for (const auto &[symbol, value] : entry->matches()) {
+            from.push_back(Z3Cache::set(&symbol.get()));
+            to.push_back(Z3Cache::set(&value.get()));
+        }
+        auto entryKey = Z3Cache::set(lpmKey->computedKey()).substitute(from, to);
+        z3::solver solver(Z3Cache::context());
+        auto maskedKey =
+            Z3Cache::set(keyExpression) & Z3Cache::set(IR::Constant::get(keyType, mask));
+        auto maskedValue = Z3Cache::set(IR::Constant::get(keyType, 0x1234 & mask));
+        solver.add(entryKey != (maskedKey == maskedValue));
+        EXPECT_EQ(solver.check(), z3::unsat) << "prefix length " << prefixLength;
+    }
+}
+
+TEST_F(P4FlayTest, TableConfigurationPrunesAndShadowsLpmEntries) {
+    const auto *keyType = IR::Type_Bits::get(16);
+    TableConfiguration tableConfiguration(kTableName, TableDefaultAction({}), {});
+    const auto *keyExpression = ToolsVariables::getSymbolicVariable(keyType, "hdr.eth.type");
+    tableConfiguration.setTableKeyMatch(
+        {new LpmTableMatchKey(kTableName, "hdr.eth.type", keyExpression)});
+    auto *hostEntry = makeLpmEntry(0x1234, 16, "ingress.set_port");
+    auto *subnetEntry = makeLpmEntry(0x1200, 8, "ingress.drop", 1);
+    auto *otherEntry = makeLpmEntry(0x3400, 8, "ingress.drop");
+    for (auto *entry : {hostEntry, subnetEntry, otherEntry}) {
+        ASSERT_EQ(tableConfiguration.addTableEntry(*entry, false), EXIT_SUCCESS);
+    }
+
+    // The subnet entry has the higher priority and covers the host entry.
+    EXPECT_EQ(tableConfiguration.findShadowingEntry(*hostEntry), subnetEntry);
+    EXPECT_EQ(tableConfiguration.findShadowingEntry(*subnetEntry), nullptr);
+    EXPECT_EQ(tableConfiguration.findShadowingEntry(*otherEntry), nullptr);
+
+    // The encoding tells how many entries remain. The shadowed host entry does not count.
+    EXPECT_EQ(tableConfiguration.shadowedEntryCount(), 1U);
+    tableConfiguration.setEntryBudget(2);
+    EXPECT_EQ(tableConfiguration.encoding(), TableEncoding::kPerEntry);
+    tableConfiguration.setEntryBudget(1);
+    EXPECT_NE(tableConfiguration.encoding(), TableEncoding::kPerEntry);
+    EXPECT_TRUE(tableConfiguration.setConstantKeys(
+        {{"hdr.eth.type", IR::Constant::get(keyType, 0x1234)}}));
+    EXPECT_EQ(tableConfiguration.encoding(), TableEncoding::kPerEntry);
+    EXPECT_TRUE(tableConfiguration.setConstantKeys(
+        {{"hdr.eth.type", IR::Constant::get(keyType, 0x3456)}}));
+    EXPECT_EQ(tableConfiguration.encoding(), TableEncoding::kPerEntry);
+    EXPECT_TRUE(tableConfiguration.setConstantKeys({}));
+    EXPECT_NE(tableConfiguration.encoding(), TableEncoding::kPerEntry);
+}
+
+TEST_F(P4FlayTest, TableConfigurationKeepsLongerLpmPrefixesInstalledFirst) {
+    const auto *keyType = IR::Type_Bits::get(16);
+    const auto *actionChoice = actionChoiceVariable();
+    ControlPlaneAssignmentSet defaultAssignment;
+    defaultAssignment.emplace(*actionChoice, *actionLiteral("NoAction"));
+    TableConfiguration tableConfiguration(kTableName, TableDefaultAction(defaultAssignment), {});
+    const auto *keyExpression = ToolsVariables::getSymbolicVariable(keyType, "hdr.eth.type");
+    tableConfiguration.setTableKeyMatch(
+        {new LpmTableMatchKey(kTableName, "hdr.eth.type", keyExpression)});
+    // The longer prefix is installed before the shorter prefix which contains it.
+    auto *hostEntry = makeLpmEntry(0x1234, 12, "ingress.set_port");
+    auto *subnetEntry = makeLpmEntry(0x1200, 8, "ingress.drop");
+    ASSERT_EQ(tableConfiguration.addTableEntry(*hostEntry, false), EXIT_SUCCESS);
+    ASSERT_EQ(tableConfiguration.addTableEntry(*subnetEntry, false), EXIT_SUCCESS);
+
+    // The longest prefix wins, so the shorter prefix does not shadow the longer one.
+    EXPECT_EQ(tableConfiguration.findShadowingEntry(*hostEntry), nullptr);
+    EXPECT_EQ(tableConfiguration.findShadowingEntry(*subnetEntry), nullptr);
+    EXPECT_EQ(tableConfiguration.shadowedEntryCount(), 0U);
+    EXPECT_EQ(tableConfiguration.encoding(), TableEncoding::kPerEntry);
+
+    auto canSelect = [&](const char *actionName) {
+        auto assignments = tableConfiguration.computeZ3ControlPlaneAssignments();
+        auto selectedAction = assignments.substitute(Z3Cache::set(actionChoice));
+        z3::solver solver(Z3Cache::context());
+        solver.add(selectedAction == Z3Cache::set(actionLiteral(actionName)));
+        return solver.check() == z3::sat;
+    };
+    EXPECT_TRUE(canSelect("ingress.set_port"));
+    EXPECT_TRUE(canSelect("ingress.drop"));
+    EXPECT_TRUE(canSelect("NoAction"));
+}
+
+TEST_F(P4FlayTest, TableConfigurationSummarizesLpmEntriesByPrefixLength) {
+    const auto *keyType = IR::Type_Bits::get(16);
+    const auto *actionChoice = actionChoiceVariable();
+    ControlPlaneAssignmentSet defaultAssignment;
+    defaultAssignment.emplace(*actionChoice, *actionLiteral("NoAction"));
+    TableConfiguration tableConfiguration(kTableName, TableDefaultAction(defaultAssignment), {});
+    const auto *keyExpression = ToolsVariables::getSymbolicVariable(keyType, "hdr.eth.type");
+    tableConfiguration.setTableKeyMatch(
+        {new LpmTableMatchKey(kTableName, "hdr.eth.type", keyExpression)});
+    tableConfiguration.setEntryBudget(1);
+    // The longer prefix is installed first and still wins within the shorter one.
+    ASSERT_EQ(tableConfiguration.addTableEntry(*makeLpmEntry(0x1234, 16, "ingress.set_port"),
+                                               false),
+              EXIT_SUCCESS);
+    ASSERT_EQ(tableConfiguration.addTableEntry(*makeLpmEntry(0x1200, 8, "ingress.drop"), false),
+              EXIT_SUCCESS);
+    EXPECT_EQ(tableConfiguration.shadowedEntryCount(), 0U);
+    EXPECT_EQ(tableConfiguration.encoding(), TableEncoding::kSummarized);
+
+    auto assignments = tableConfiguration.computeZ3ControlPlaneAssignments();
+    auto selectedAction = assignments.substitute(Z3Cache::set(actionChoice));
+    auto expectAction = [&](uint64_t key, const char *actionName) {
+        z3::expr_vector from(Z3Cache::context());
+        z3::expr_vector to(Z3Cache::context());
+        from.push_back(Z3Cache::set(keyExpression));
+        to.push_back(Z3Cache::set(IR::Constant::get(keyType, key)));
+        EXPECT_TRUE(z3::eq(selectedAction.substitute(from, to).simplify(),
+                           Z3Cache::set(actionLiteral(actionName))))
+            << "key " << key;
+    };
+    expectAction(0x1234, "ingress.set_port");
+    expectAction(0x1235, "ingress.drop");
+    expectAction(0x1300, "NoAction");
+}
+
+/// Produce an entry of the table under test which matches the 16-bit @p key under @p mask.
+TableMatchEntry *makeTernaryEntry(uint64_t key, uint64_t mask, const char *actionName,
+                                  int32_t priority) {
+    const auto *keyType = IR::Type_Bits::get(16);
+    ControlPlaneAssignmentSet actionAssignment;
+    actionAssignment.emplace(*actionChoiceVariable(), *actionLiteral(actionName));
+    ControlPlaneAssignmentSet matches;
+    matches.emplace(*ControlPlaneState::getTableKey(kTableName, "hdr.eth.type", keyType),
+                    *IR::Constant::get(keyType, key));
+    matches.emplace(*ControlPlaneState::getTableTernaryMask(kTableName, "hdr.eth.type", keyType),
+                    *IR::Constant::get(keyType, mask));
+    return new TableMatchEntry(actionAssignment, priority, matches);
+}
+
+TEST_F(P4FlayTest, TableConfigurationExcludesShadowedEntries) {
+    const auto *keyType = IR::Type_Bits::get(16);
+    const auto *actionChoice = actionChoiceVariable();
+    ControlPlaneAssignmentSet defaultAssignment;
+    defaultAssignment.emplace(*actionChoice, *actionLiteral("NoAction"));
+    TableConfiguration tableConfiguration(kTableName, TableDefaultAction(defaultAssignment), {});
+    const auto *keyExpression = ToolsVariables::getSymbolicVariable(keyType, "hdr.eth.type");
+    tableConfiguration.setTableKeyMatch(
+        {new TernaryTableMatchKey(kTableName, "hdr.eth.type", keyExpression)});
+    auto *wildcardEntry = makeTernaryEntry(0x0800, 0xFF00, "ingress.drop", 10);
+    ASSERT_EQ(tableConfiguration.addTableEntry(*wildcardEntry, false), EXIT_SUCCESS);
+    ASSERT_EQ(
+        tableConfiguration.addTableEntry(*makeTernaryEntry(0x0806, 0xFFFF, "ingress.set_port", 5),
+                                         false),
+        EXIT_SUCCESS);
+    ASSERT_EQ(
+        tableConfiguration.addTableEntry(*makeTernaryEntry(0x86DD, 0xFFFF, "ingress.drop", 5),
+                                         false),
+        EXIT_SUCCESS);
+    EXPECT_EQ(tableConfiguration.shadowedEntryCount(), 1U);
+    tableConfiguration.consumeSummaryChange();
+
+    auto canSelect = [&](const char *actionName) {
+        auto assignments = tableConfiguration.computeZ3ControlPlaneAssignments();
+        auto selectedAction = assignments.substitute(Z3Cache::set(actionChoice));
+        z3::solver solver(Z3Cache::context());
+        solver.add(selectedAction == Z3Cache::set(actionLiteral(actionName)));
+        return solver.check() == z3::sat;
+    };
+    // The only entry executing set_port is shadowed by the wildcard entry.
+    EXPECT_FALSE(canSelect("ingress.set_port"));
+    EXPECT_TRUE(canSelect("ingress.drop"));
+    EXPECT_TRUE(canSelect("NoAction"));
+
+    // Removing the wildcard entry makes the shadowed entry reachable. This changes the summary,
+    // even though the installed actions stay the same.
+    ASSERT_EQ(tableConfiguration.deleteTableEntry(*wildcardEntry), 1U);
+    ASSERT_EQ(tableConfiguration.addTableEntry(*makeTernaryEntry(0x0800, 0xFFFF, "ingress.drop", 1),
+                                               false),
+              EXIT_SUCCESS);
+    EXPECT_TRUE(tableConfiguration.consumeSummaryChange());
+    EXPECT_EQ(tableConfiguration.shadowedEntryCount(), 0U);
+    EXPECT_TRUE(canSelect("ingress.set_port"));
+}
+
+TEST_F(P4FlayTest, TableEntrySetLooksUpEntriesByIndexedField) {
+    const auto *keyType = IR::Type_Bits::get(16);
+    TableEntrySet tableEntries;
+    tableEntries.insert(*makeEntry(1, "ingress.set_port"));
+    tableEntries.insert(*makeEntry(2, "ingress.set_port", 5));
+    tableEntries.indexField(ControlPlaneState::getTableKey(kTableName, "hdr.eth.type", keyType));
+    // Entries inserted after indexing are indexed as well.
+    tableEntries.insert(*makeEntry(2, "ingress.drop", 1));
+
+    auto matchingEntries = tableEntries.orderedEntriesMatching(2);
+    ASSERT_EQ(matchingEntries.size(), 2U);
+    EXPECT_EQ(matchingEntries[0].get().matchKey(), makeEntry(2, "ingress.drop", 1)->matchKey());
+    EXPECT_EQ(matchingEntries[1].get().matchKey(), makeEntry(2, "ingress.drop", 5)->matchKey());
+    EXPECT_EQ(tableEntries.orderedEntriesMatching(1).size(), 1U);
+    EXPECT_TRUE(tableEntries.orderedEntriesMatching(3).empty());
+
+    tableEntries.erase(*makeEntry(2, "ingress.drop", 5));
+    EXPECT_EQ(tableEntries.orderedEntriesMatching(2).size(), 1U);
+}
+
+TEST_F(P4FlayTest, TableEntrySetIdentifiesEntriesByMatchKey) {
+    TableEntrySet tableEntries;
+    EXPECT_TRUE(tableEntries.insert(*makeEntry(1, "ingress.set_port")));
+    EXPECT_TRUE(tableEntries.insert(*makeEntry(2, "ingress.set_port")));
+    // The action is not part of the identity of an entry, the priority is.
+    EXPECT_FALSE(tableEntries.insert(*makeEntry(1, "ingress.drop")));
+    EXPECT_TRUE(tableEntries.insert(*makeEntry(1, "ingress.drop", 10)));
+    EXPECT_EQ(tableEntries.size(), 3U);
+
+    const auto *entry = tableEntries.find(*makeEntry(1, "ingress.drop"));
+    ASSERT_NE(entry, nullptr);
+    EXPECT_TRUE(entry->actionChoice(kTableName)->equiv(*actionLiteral("ingress.set_port")));
+    EXPECT_EQ(tableEntries.find(*makeEntry(3, "ingress.drop")), nullptr);
+
+    EXPECT_EQ(tableEntries.erase(*makeEntry(2, "ingress.drop")), 1U);
+    EXPECT_EQ(tableEntries.erase(*makeEntry(2, "ingress.drop")), 0U);
+    EXPECT_EQ(tableEntries.size(), 2U);
+}
+
+TEST_F(P4FlayTest, TableEntrySetOrdersEntriesByPriority) {
+    TableEntrySet tableEntries;
+    tableEntries.insert(*makeEntry(1, "ingress.set_port", 5));
+    tableEntries.insert(*makeEntry(2, "ingress.set_port", 1));
+    tableEntries.insert(*makeEntry(3, "ingress.drop", 5));
+    tableEntries.insert(*makeEntry(4, "ingress.drop", 1));
+
+    // Entries of equal priority keep their insertion order.
+    auto orderedEntries = tableEntries.orderedEntries();
+    ASSERT_EQ(orderedEntries.size(), 4U);
+    EXPECT_EQ(orderedEntries[0].get().matchKey(), makeEntry(2, "ingress.drop", 1)->matchKey());
+    EXPECT_EQ(orderedEntries[1].get().matchKey(), makeEntry(4, "ingress.drop", 1)->matchKey());
+    EXPECT_EQ(orderedEntries[2].get().matchKey(), makeEntry(1, "ingress.drop", 5)->matchKey());
+    EXPECT_EQ(orderedEntries[3].get().matchKey(), makeEntry(3, "ingress.drop", 5)->matchKey());
+}
+
+TEST_F(P4FlayTest, TableEntrySetOrdersLpmEntriesByPrefixLength) {
+    const auto *keyExpression =
+        ToolsVariables::getSymbolicVariable(IR::Type_Bits::get(16), "hdr.eth.type");
+    const auto *lpmKey = new LpmTableMatchKey(kTableName, "hdr.eth.type", keyExpression);
+    TableEntrySet tableEntries;
+    auto *hostEntry = makeLpmEntry(0x1234, 16, "ingress.set_port");
+    auto *subnetEntry = makeLpmEntry(0x1200, 8, "ingress.drop");
+    auto *defaultRoute = makeLpmEntry(0, 0, "ingress.drop");
+    for (auto *entry : {hostEntry, subnetEntry, defaultRoute}) {
+        tableEntries.insert(*entry);
+    }
+    // Without a prefix key, entries of equal priority keep their insertion order.
+    EXPECT_TRUE(tableEntries.precedes(*hostEntry, *subnetEntry));
+
+    // The longest prefix takes precedence, regardless of the insertion order.
+    tableEntries.orderByPrefix(lpmKey);
+    auto orderedEntries = tableEntries.orderedEntries();
+    ASSERT_EQ(orderedEntries.size(), 3U);
+    EXPECT_EQ(orderedEntries[0].get().matchKey(), defaultRoute->matchKey());
+    EXPECT_EQ(orderedEntries[1].get().matchKey(), subnetEntry->matchKey());
+    EXPECT_EQ(orderedEntries[2].get().matchKey(), hostEntry->matchKey());
+    EXPECT_TRUE(tableEntries.precedes(*subnetEntry, *hostEntry));
+    EXPECT_FALSE(tableEntries.precedes(*hostEntry, *subnetEntry));
+
+    // The priority still comes first.
+    auto *priorityEntry = makeLpmEntry(0x1000, 4, "ingress.set_port", 1);
+    tableEntries.insert(*priorityEntry);
+    EXPECT_EQ(tableEntries.orderedEntries().back().get().matchKey(), priorityEntry->matchKey());
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
@@ -0,0 +1,171 @@
+#include "backends/p4tools/modules/flay/core/control_plane/table_key_index.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "backends/p4tools/common/lib/variables.h"
+#include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
+#include "backends/p4tools/modules/flay/core/control_plane/p4info_index.h"
+#include "backends/p4tools/modules/flay/test/helpers.h"
+#include "backends/p4tools/modules/flay/test/p4runtime_helpers.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::P4Tools::Flay;
+
+/// @returns @p count distinct entries. The indexes only compare entries by identity.
+std::vector<const TableMatchEntry *> makeEntries(size_t count) {
+    std::vector<const TableMatchEntry *> entries;
+    for (size_t idx = 0; idx < count; ++idx) {
+        entries.push_back(new TableMatchEntry({}, static_cast<int32_t>(idx), {}));
+    }
+    return entries;
+}
+
+/// @returns @p entries in ascending order of their address, for comparison.
+std::vector<const TableMatchEntry *> sorted(std::vector<const TableMatchEntry *> entries) {
+    std::sort(entries.begin(), entries.end());
+    return entries;
+}
+
+/// @returns the match of the @p length bit prefix of the 8-bit @p value.
+FieldMatch prefix(uint64_t value, unsigned length) {
+    return FieldMatch::masked(value, (big_int(0xFF) << (8 - length)) & 0xFF);
+}
+
+TEST_F(P4FlayTest, FieldMatchComparesMasksAndIntervals) {
+    EXPECT_TRUE(FieldMatch::masked(0x12, 0xF0).contains(0x1F));
+    EXPECT_FALSE(FieldMatch::masked(0x12, 0xF0).contains(0x2F));
+    EXPECT_TRUE(FieldMatch::masked(0x10, 0xF0).covers(FieldMatch::masked(0x12, 0xFF)));
+    EXPECT_FALSE(FieldMatch::masked(0x12, 0xFF).covers(FieldMatch::masked(0x10, 0xF0)));
+    EXPECT_FALSE(FieldMatch::masked(0x10, 0xF0).covers(FieldMatch::masked(0x22, 0xFF)));
+
+    EXPECT_TRUE(FieldMatch::interval(10, 20).contains(20));
+    EXPECT_FALSE(FieldMatch::interval(10, 20).contains(21));
+    EXPECT_TRUE(FieldMatch::interval(10, 20).covers(FieldMatch::interval(12, 20)));
+    EXPECT_FALSE(FieldMatch::interval(10, 20).covers(FieldMatch::interval(5, 15)));
+    // An empty interval matches nothing, so it is covered by everything.
+    EXPECT_TRUE(FieldMatch::interval(10, 20).covers(FieldMatch::interval(1, 0)));
+    // Masks and intervals are not compared.
+    EXPECT_FALSE(FieldMatch::interval(0, 255).covers(FieldMatch::masked(0, 0)));
+}
+
+TEST_F(P4FlayTest, LpmTrieFindsMatchingAndCoveringPrefixes) {
+    auto entries = makeEntries(4);
+    LpmTrie trie(8);
+    ASSERT_TRUE(trie.insert(entries[0], prefix(0, 0)));
+    ASSERT_TRUE(trie.insert(entries[1], prefix(0x80, 1)));
+    ASSERT_TRUE(trie.insert(entries[2], prefix(0xA0, 4)));
+    ASSERT_TRUE(trie.insert(entries[3], prefix(0xA5, 8)));
+    // Masks which are not prefixes can not be indexed.
+    EXPECT_FALSE(trie.insert(entries[0], FieldMatch::masked(0x0F, 0x0F)));
+
+    EXPECT_EQ(sorted(trie.matching(0xA5)), sorted(entries));
+    EXPECT_EQ(sorted(trie.matching(0xA6)), sorted({entries[0], entries[1], entries[2]}));
+    EXPECT_EQ(sorted(trie.matching(0x05)), sorted({entries[0]}));
+
+    EXPECT_EQ(sorted(trie.covering(prefix(0xA0, 4))), sorted({entries[0], entries[1], entries[2]}));
+    EXPECT_EQ(sorted(trie.covering(prefix(0x80, 2))), sorted({entries[0], entries[1]}));
+
+    trie.erase(entries[1], prefix(0x80, 1));
+    EXPECT_EQ(sorted(trie.matching(0xA6)), sorted({entries[0], entries[2]}));
+    trie.clear();
+    EXPECT_TRUE(trie.matching(0xA5).empty());
+}
+
+TEST_F(P4FlayTest, LpmTrieIndexesPrefixesOfTheP4RuntimeConverter) {
+    auto p4Info = P4Runtime::makeRoutingP4Info();
+    P4InfoIndex p4InfoIndex(p4Info);
+    auto *tableConfiguration = P4Runtime::makeRoutingTableConfiguration();
+    // 10.1.2.0/24 and 10.0.0.0/8.
+    ASSERT_EQ(P4Runtime::insertRoute(p4InfoIndex, *tableConfiguration, 0x0A010200, 24,
+                                     P4Runtime::kSetPortActionId),
+              EXIT_SUCCESS);
+    ASSERT_EQ(P4Runtime::insertRoute(p4InfoIndex, *tableConfiguration, 0x0A000000, 8,
+                                     P4Runtime::kDropActionId),
+              EXIT_SUCCESS);
+    const auto *subnetRoute =
+        P4Runtime::findRoute(p4InfoIndex, *tableConfiguration, P4Runtime::kSetPortActionId);
+    const auto *networkRoute =
+        P4Runtime::findRoute(p4InfoIndex, *tableConfiguration, P4Runtime::kDropActionId);
+    ASSERT_NE(subnetRoute, nullptr);
+    ASSERT_NE(networkRoute, nullptr);
+
+    const auto *keyExpression = ToolsVariables::getSymbolicVariable(
+        IR::Type_Bits::get(32), P4Runtime::kRoutingKeyName);
+    LpmTableMatchKey lpmKey(P4Runtime::kRoutingTableName, P4Runtime::kRoutingKeyName,
+                            keyExpression);
+    auto subnetMatch = computeFieldMatch(lpmKey, subnetRoute->matches());
+    auto networkMatch = computeFieldMatch(lpmKey, networkRoute->matches());
+    ASSERT_TRUE(subnetMatch.has_value());
+    ASSERT_TRUE(networkMatch.has_value());
+    EXPECT_EQ(subnetMatch.value().mask, big_int(0xFFFFFF00));
+    EXPECT_EQ(networkMatch.value().mask, big_int(0xFF000000));
+
+    LpmTrie trie(32);
+    ASSERT_TRUE(trie.insert(subnetRoute, subnetMatch.value()));
+    ASSERT_TRUE(trie.insert(networkRoute, networkMatch.value()));
+    // An address in the /24 hits both routes, one elsewhere in the /8 only the /8.
+    EXPECT_EQ(sorted(trie.matching(0x0A010203)), sorted({subnetRoute, networkRoute}));
+    EXPECT_EQ(trie.matching(0x0A020304), std::vector{networkRoute});
+    EXPECT_TRUE(trie.matching(0x0B010203).empty());
+    // The /8 covers the /24, but not the other way around.
+    EXPECT_EQ(sorted(trie.covering(subnetMatch.value())), sorted({subnetRoute, networkRoute}));
+    EXPECT_EQ(trie.covering(networkMatch.value()), std::vector{networkRoute});
+}
+
+TEST_F(P4FlayTest, IntervalTreeFindsMatchingAndCoveringIntervals) {
+    auto entries = makeEntries(4);
+    IntervalTree tree;
+    ASSERT_TRUE(tree.insert(entries[0], FieldMatch::interval(0, 100)));
+    ASSERT_TRUE(tree.insert(entries[1], FieldMatch::interval(10, 20)));
+    ASSERT_TRUE(tree.insert(entries[2], FieldMatch::interval(15, 50)));
+    ASSERT_TRUE(tree.insert(entries[3], FieldMatch::interval(60, 70)));
+    EXPECT_FALSE(tree.insert(entries[0], FieldMatch::masked(0, 0)));
+
+    EXPECT_EQ(sorted(tree.matching(15)), sorted({entries[0], entries[1], entries[2]}));
+    EXPECT_EQ(sorted(tree.matching(55)), sorted({entries[0]}));
+    EXPECT_EQ(sorted(tree.matching(65)), sorted({entries[0], entries[3]}));
+    EXPECT_TRUE(tree.matching(101).empty());
+
+    EXPECT_EQ(sorted(tree.covering(FieldMatch::interval(16, 20))),
+              sorted({entries[0], entries[1], entries[2]}));
+    EXPECT_EQ(sorted(tree.covering(FieldMatch::interval(16, 30))),
+              sorted({entries[0], entries[2]}));
+
+    // Modifications are visible to the next query.
+    tree.erase(entries[0], FieldMatch::interval(0, 100));
+    EXPECT_TRUE(tree.matching(55).empty());
+    ASSERT_TRUE(tree.insert(entries[0], FieldMatch::interval(50, 55)));
+    EXPECT_EQ(sorted(tree.matching(55)), sorted({entries[0]}));
+}
+
+TEST_F(P4FlayTest, TernaryMaskIndexFindsMatchingAndCoveringEntries) {
+    auto entries = makeEntries(4);
+    TernaryMaskIndex index;
+    ASSERT_TRUE(index.insert(entries[0], FieldMatch::masked(0, 0)));
+    ASSERT_TRUE(index.insert(entries[1], FieldMatch::masked(0x01, 0x0F)));
+    ASSERT_TRUE(index.insert(entries[2], FieldMatch::masked(0x11, 0xFF)));
+    ASSERT_TRUE(index.insert(entries[3], FieldMatch::masked(0x02, 0x0F)));
+    EXPECT_FALSE(index.insert(entries[0], FieldMatch::interval(0, 1)));
+
+    EXPECT_EQ(sorted(index.matching(0x11)), sorted({entries[0], entries[1], entries[2]}));
+    EXPECT_EQ(sorted(index.matching(0x22)), sorted({entries[0], entries[3]}));
+
+    EXPECT_EQ(sorted(index.covering(FieldMatch::masked(0x11, 0xFF))),
+              sorted({entries[0], entries[1], entries[2]}));
+    // A match which does not fix the low bits is only covered by the wildcard.
+    EXPECT_EQ(sorted(index.covering(FieldMatch::masked(0x10, 0xF0))), sorted({entries[0]}));
+
+    index.erase(entries[1], FieldMatch::masked(0x01, 0x0F));
+    EXPECT_EQ(sorted(index.matching(0x11)), sorted({entries[0], entries[2]}));
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
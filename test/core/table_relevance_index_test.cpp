@@ -0,0 +1,102 @@
+#include "backends/p4tools/modules/flay/core/control_plane/table_relevance_index.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <utility>
+
+#include "backends/p4tools/common/control_plane/symbolic_variables.h"
+#include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
+#include "backends/p4tools/modules/flay/test/helpers.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::P4Tools::Flay;
+
+/// Produce a P4Info with the tables "ingress.forward" (id 10) and "ingress.telemetry" (id 11),
+/// which both match on a single exact field.
+p4::config::v1::P4Info makeP4Info() {
+    p4::config::v1::P4Info p4Info;
+    for (auto [tableId, tableName] : {std::pair<uint32_t, const char *>{10, "ingress.forward"},
+                                      std::pair<uint32_t, const char *>{11, "ingress.telemetry"}}) {
+        auto *table = p4Info.add_tables();
+        table->mutable_preamble()->set_id(tableId);
+        table->mutable_preamble()->set_name(tableName);
+        auto *exactField = table->add_match_fields();
+        exactField->set_id(1);
+        exactField->set_name("hdr.eth.dst");
+        exactField->set_bitwidth(48);
+        exactField->set_match_type(p4::config::v1::MatchField::EXACT);
+    }
+    return p4Info;
+}
+
+TEST_F(P4FlayTest, TableRelevanceIndexMarksReferencedTables) {
+    auto p4Info = makeP4Info();
+    P4InfoIndex p4InfoIndex(p4Info);
+    SymbolSet referencedSymbols;
+    referencedSymbols.insert(*ControlPlaneState::getTableKey("ingress.forward", "hdr.eth.dst",
+                                                             IR::Type_Bits::get(48)));
+    TableRelevanceIndex relevanceIndex(p4InfoIndex, referencedSymbols, {});
+    EXPECT_TRUE(relevanceIndex.isRelevant(10));
+    EXPECT_FALSE(relevanceIndex.isRelevant(11));
+    EXPECT_EQ(relevanceIndex.relevantTableCount(), 1U);
+}
+
+TEST_F(P4FlayTest, TableRelevanceIndexTracksSkippedEntries) {
+    auto p4Info = makeP4Info();
+    P4InfoIndex p4InfoIndex(p4Info);
+    TableRelevanceIndex relevanceIndex(p4InfoIndex, {}, {});
+
+    const auto *keyType = IR::Type_Bits::get(48);
+    ControlPlaneAssignmentSet matches;
+    matches.emplace(*ControlPlaneState::getTableKey("ingress.telemetry", "hdr.eth.dst", keyType),
+                    *IR::Constant::get(keyType, 1));
+    auto matchKey = TableMatchEntry::computeMatchKey(matches, 0);
+
+    EXPECT_EQ(relevanceIndex.insertEntry(11, matchKey), EXIT_SUCCESS);
+    EXPECT_EQ(relevanceIndex.insertEntry(11, matchKey), EXIT_FAILURE);
+    EXPECT_EQ(relevanceIndex.deleteEntry(11, matchKey), EXIT_SUCCESS);
+    EXPECT_EQ(relevanceIndex.deleteEntry(11, matchKey), EXIT_FAILURE);
+    relevanceIndex.modifyEntry(11, matchKey);
+    relevanceIndex.clearEntries(11);
+    EXPECT_EQ(relevanceIndex.deleteEntry(11, matchKey), EXIT_FAILURE);
+    EXPECT_EQ(relevanceIndex.skippedUpdateCount(), 7U);
+
+    // Like in the table configuration, the priority is part of the identity of an entry.
+    EXPECT_EQ(relevanceIndex.insertEntry(11, matchKey), EXIT_SUCCESS);
+    EXPECT_EQ(relevanceIndex.insertEntry(11, TableMatchEntry::computeMatchKey(matches, 5)),
+              EXIT_SUCCESS);
+    EXPECT_EQ(relevanceIndex.deleteEntry(11, TableMatchEntry({}, 5, matches).matchKey()),
+              EXIT_SUCCESS);
+    EXPECT_EQ(relevanceIndex.deleteEntry(11, matchKey), EXIT_SUCCESS);
+}
+
+TEST_F(P4FlayTest, TableRelevanceIndexTracksInitialEntries) {
+    auto p4Info = makeP4Info();
+    P4InfoIndex p4InfoIndex(p4Info);
+    const auto *keyType = IR::Type_Bits::get(48);
+    ControlPlaneAssignmentSet matches;
+    matches.emplace(*ControlPlaneState::getTableKey("ingress.telemetry", "hdr.eth.dst", keyType),
+                    *IR::Constant::get(keyType, 1));
+    auto *initialEntry = new TableMatchEntry({}, 0, matches);
+    TableEntrySet tableEntries;
+    tableEntries.insert(*initialEntry);
+    TableConfiguration tableConfiguration("ingress.telemetry", TableDefaultAction({}),
+                                          tableEntries);
+    ControlPlaneConstraints controlPlaneConstraints;
+    controlPlaneConstraints.emplace("ingress.telemetry", tableConfiguration);
+    TableRelevanceIndex relevanceIndex(p4InfoIndex, {}, controlPlaneConstraints);
+
+    // The entry of the initial configuration is known, so it can be deleted but not inserted.
+    EXPECT_EQ(relevanceIndex.insertEntry(11, initialEntry->matchKey()), EXIT_FAILURE);
+    EXPECT_EQ(relevanceIndex.deleteEntry(11, initialEntry->matchKey()), EXIT_SUCCESS);
+    EXPECT_EQ(relevanceIndex.deleteEntry(11, initialEntry->matchKey()), EXIT_FAILURE);
+    EXPECT_EQ(relevanceIndex.insertEntry(11, initialEntry->matchKey()), EXIT_SUCCESS);
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
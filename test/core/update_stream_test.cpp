@@ -0,0 +1,144 @@
+#include "backends/p4tools/modules/flay/core/specialization/update_stream.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "backends/p4tools/modules/flay/test/helpers.h"
+#include "lib/error.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wpedantic"
+#include "p4/v1/p4runtime.pb.h"
+#pragma GCC diagnostic pop
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::P4Tools::Flay;
+
+/// Produce a write request which inserts a single table entry with id @p tableId.
+p4::v1::WriteRequest makeWriteRequest(uint32_t tableId) {
+    p4::v1::WriteRequest request;
+    auto *update = request.add_updates();
+    update->set_type(p4::v1::Update::INSERT);
+    update->mutable_entity()->mutable_table_entry()->set_table_id(tableId);
+    return request;
+}
+
+/// Write @p request to @p file in binary wire format.
+void writeBinaryRequest(const std::filesystem::path &file, const p4::v1::WriteRequest &request) {
+    std::ofstream output(file, std::ios::binary | std::ios::trunc);
+    ASSERT_TRUE(request.SerializeToOstream(&output));
+}
+
+TEST_F(P4FlayTest, UpdateStreamSourceParse) {
+    auto source = UpdateStreamSource::parse("dir:/tmp/updates");
+    ASSERT_TRUE(source.has_value());
+    EXPECT_EQ(source.value().kind, UpdateStreamSource::Kind::kDirectory);
+    EXPECT_EQ(source.value().path, "/tmp/updates");
+    EXPECT_EQ(UpdateStreamSource::parse("fifo:/tmp/fifo").value().kind,
+              UpdateStreamSource::Kind::kFifo);
+    EXPECT_EQ(UpdateStreamSource::parse("unix:/tmp/socket").value().kind,
+              UpdateStreamSource::Kind::kUnixSocket);
+    EXPECT_EQ(UpdateStreamSource::parse("stdin").value().kind, UpdateStreamSource::Kind::kStdin);
+    EXPECT_FALSE(UpdateStreamSource::parse("tcp:localhost").has_value());
+    EXPECT_FALSE(UpdateStreamSource::parse("dir:").has_value());
+}
+
+TEST_F(P4FlayTest, BoundedQueueBlocksProducer) {
+    static constexpr int kItemCount = 1000;
+    BoundedQueue<int> queue(4);
+    std::thread producer([&queue]() {
+        for (int item = 0; item < kItemCount; item++) {
+            ASSERT_TRUE(queue.push(item));
+            EXPECT_LE(queue.size(), 4U);
+        }
+        queue.close();
+    });
+    int expected = 0;
+    while (auto item = queue.pop()) {
+        EXPECT_EQ(item.value(), expected++);
+    }
+    producer.join();
+    EXPECT_EQ(expected, kItemCount);
+    EXPECT_FALSE(queue.push(0));
+}
+
+TEST_F(P4FlayTest, UpdateStreamFromDirectory) {
+    auto directory = std::filesystem::temp_directory_path() / "flay_update_stream_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directory(directory);
+
+    // Files which exist before the stream starts are processed in natural order.
+    writeBinaryRequest(directory / "update_10.binpb", makeWriteRequest(10));
+    writeBinaryRequest(directory / "update_2.binpb", makeWriteRequest(2));
+    std::vector<p4::v1::WriteRequest> trace = {makeWriteRequest(20), makeWriteRequest(21)};
+    ASSERT_EQ(Protobuf::serializeDelimitedObjectsToFile(trace, directory / "trace.binpbs"),
+              EXIT_SUCCESS);
+
+    UpdateStream<p4::v1::WriteRequest> updateStream(
+        UpdateStreamSource{UpdateStreamSource::Kind::kDirectory, directory}, 2);
+    updateStream.start();
+
+    std::vector<std::string> names;
+    std::vector<uint32_t> tableIds;
+    auto consume = [&]() {
+        auto update = updateStream.next();
+        ASSERT_TRUE(update.has_value());
+        names.emplace_back(update.value().name);
+        tableIds.emplace_back(
+            update.value().request.updates(0).entity().table_entry().table_id());
+    };
+    for (int updateIdx = 0; updateIdx < 4; updateIdx++) {
+        consume();
+    }
+
+    // Files which appear later are picked up once they are complete.
+    writeBinaryRequest(directory / ".update_3.binpb", makeWriteRequest(3));
+    std::filesystem::rename(directory / ".update_3.binpb", directory / "update_3.binpb");
+    consume();
+    { std::ofstream end(directory / "END"); }
+    EXPECT_FALSE(updateStream.next().has_value());
+    EXPECT_FALSE(updateStream.failed());
+
+    EXPECT_EQ(names, (std::vector<std::string>{"trace_0.binpbs", "trace_1.binpbs",
+                                               "update_2.binpb", "update_10.binpb",
+                                               "update_3.binpb"}));
+    EXPECT_EQ(tableIds, (std::vector<uint32_t>{20, 21, 2, 10, 3}));
+    std::filesystem::remove_all(directory);
+}
+
+TEST_F(P4FlayTest, UpdateStreamDefersFailures) {
+    auto directory = std::filesystem::temp_directory_path() / "flay_update_stream_failure_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directory(directory);
+    writeBinaryRequest(directory / "update_1.binpb", makeWriteRequest(1));
+    {
+        std::ofstream corrupt(directory / "update_2.binpb", std::ios::binary | std::ios::trunc);
+        corrupt << "\xff\xff\xff";
+    }
+
+    auto errorCount = P4::errorCount();
+    UpdateStream<p4::v1::WriteRequest> updateStream(
+        UpdateStreamSource{UpdateStreamSource::Kind::kDirectory, directory}, 2);
+    updateStream.start();
+    EXPECT_TRUE(updateStream.next().has_value());
+    EXPECT_FALSE(updateStream.next().has_value());
+
+    // The failure is recorded for the consumer, the producer does not report it.
+    ASSERT_TRUE(updateStream.failed());
+    EXPECT_NE(updateStream.failure().value().find("update_2.binpb"), std::string::npos);
+    EXPECT_EQ(P4::errorCount(), errorCount);
+    std::filesystem::remove_all(directory);
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
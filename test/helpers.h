@@ -4,6 +4,7 @@
 #include <gtest/gtest.h>
 
 #include "backends/p4tools/common/compiler/context.h"
+#include "backends/p4tools/common/lib/variables.h"
 #include "backends/p4tools/modules/flay/core/interpreter/target.h"
 #include "backends/p4tools/modules/flay/register.h"
 #include "backends/p4tools/modules/flay/toolname.h"
@@ -35,6 +36,15 @@ class P4FlayTest : public testing::Test {
     }
 };
 
+namespace Test {
+
+/// @returns a boolean symbolic variable named @p label.
+inline const IR::SymbolicVariable *makeVariable(const char *label) {
+    return ToolsVariables::getSymbolicVariable(IR::Type_Boolean::get(), label);
+}
+
+}  // namespace Test
+
 }  // namespace P4::P4Tools
 
 #endif /* BACKENDS_P4TOOLS_MODULES_FLAY_TEST_HELPERS_H_ */
@@ -0,0 +1,115 @@
+#ifndef BACKENDS_P4TOOLS_MODULES_FLAY_TEST_P4RUNTIME_HELPERS_H_
+#define BACKENDS_P4TOOLS_MODULES_FLAY_TEST_P4RUNTIME_HELPERS_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "backends/p4tools/common/lib/variables.h"
+#include "backends/p4tools/modules/flay/core/control_plane/control_plane_item.h"
+#include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
+#include "backends/p4tools/modules/flay/core/control_plane/p4info_index.h"
+#include "backends/p4tools/modules/flay/core/control_plane/p4runtime/protobuf.h"
+#include "backends/p4tools/modules/flay/core/control_plane/symbols.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wpedantic"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#pragma GCC diagnostic pop
+
+/// Helpers which produce control-plane state through the P4Runtime converter, so tests see the
+/// same symbols and values as the service.
+namespace P4::P4Tools::Test::P4Runtime {
+
+/// The control-plane name of the routing table of makeRoutingP4Info.
+constexpr const char *kRoutingTableName = "ingress.route";
+
+/// The control-plane name of the LPM key of the routing table.
+constexpr const char *kRoutingKeyName = "hdr.ipv4.dst";
+
+/// The ids of the actions of the routing table.
+constexpr uint32_t kSetPortActionId = 20;
+constexpr uint32_t kDropActionId = 21;
+
+/// Produce a P4Info with the routing table (id 10), which matches on the 32-bit LPM field
+/// kRoutingKeyName (id 1) and references the actions "ingress.set_port" and "ingress.drop".
+inline p4::config::v1::P4Info makeRoutingP4Info() {
+    p4::config::v1::P4Info p4Info;
+    auto *setPortAction = p4Info.add_actions();
+    setPortAction->mutable_preamble()->set_id(kSetPortActionId);
+    setPortAction->mutable_preamble()->set_name("ingress.set_port");
+    auto *dropAction = p4Info.add_actions();
+    dropAction->mutable_preamble()->set_id(kDropActionId);
+    dropAction->mutable_preamble()->set_name("ingress.drop");
+    auto *table = p4Info.add_tables();
+    table->mutable_preamble()->set_id(10);
+    table->mutable_preamble()->set_name(kRoutingTableName);
+    auto *lpmField = table->add_match_fields();
+    lpmField->set_id(1);
+    lpmField->set_name(kRoutingKeyName);
+    lpmField->set_bitwidth(32);
+    lpmField->set_match_type(p4::config::v1::MatchField::LPM);
+    table->add_action_refs()->set_id(kSetPortActionId);
+    table->add_action_refs()->set_id(kDropActionId);
+    return p4Info;
+}
+
+/// Produce an empty configuration of the routing table, which matches its key by longest prefix.
+inline Flay::TableConfiguration *makeRoutingTableConfiguration() {
+    auto *tableConfiguration =
+        new Flay::TableConfiguration(kRoutingTableName, Flay::TableDefaultAction({}), {});
+    const auto *keyExpression =
+        ToolsVariables::getSymbolicVariable(IR::Type_Bits::get(32), kRoutingKeyName);
+    tableConfiguration->setTableKeyMatch(
+        {new Flay::LpmTableMatchKey(kRoutingTableName, kRoutingKeyName, keyExpression)});
+    return tableConfiguration;
+}
+
+/// Insert the route @p address/@p prefixLength with action @p actionId into @p tableConfiguration
+/// through the P4Runtime converter.
+/// @returns EXIT_SUCCESS if the converter accepted the entry.
+inline int insertRoute(const Flay::P4InfoIndex &p4InfoIndex,
+                       Flay::TableConfiguration &tableConfiguration, uint32_t address,
+                       int prefixLength, uint32_t actionId) {
+    p4::v1::Entity entity;
+    auto *tableEntry = entity.mutable_table_entry();
+    tableEntry->set_table_id(10);
+    auto *match = tableEntry->add_match();
+    match->set_field_id(1);
+    std::string value(4, '\0');
+    for (size_t idx = 0; idx < value.size(); ++idx) {
+        value[idx] = static_cast<char>(address >> (8 * (value.size() - 1 - idx)));
+    }
+    match->mutable_lpm()->set_value(value);
+    match->mutable_lpm()->set_prefix_len(prefixLength);
+    tableEntry->mutable_action()->mutable_action()->set_action_id(actionId);
+
+    Flay::ControlPlaneConstraints controlPlaneConstraints;
+    controlPlaneConstraints.emplace(kRoutingTableName, tableConfiguration);
+    Flay::SymbolSet symbolSet;
+    return Flay::P4Runtime::updateControlPlaneConstraintsWithEntityMessage(
+        entity, p4InfoIndex, controlPlaneConstraints, p4::v1::Update::INSERT, symbolSet);
+}
+
+/// @returns the entry of @p tableConfiguration which executes the action @p actionId, or nullptr
+/// if there is none.
+inline const Flay::TableMatchEntry *findRoute(const Flay::P4InfoIndex &p4InfoIndex,
+                                              const Flay::TableConfiguration &tableConfiguration,
+                                              uint32_t actionId) {
+    const auto *choiceLiteral =
+        p4InfoIndex.findTable(cstring(kRoutingTableName))->findAction(actionId)->choiceLiteral;
+    const Flay::TableMatchEntry *route = nullptr;
+    tableConfiguration.tableEntries().forEach([&](const Flay::TableMatchEntry &entry) {
+        const auto *actionChoice = entry.actionChoice(kRoutingTableName);
+        if (actionChoice != nullptr && actionChoice->equiv(*choiceLiteral)) {
+            route = &entry;
+        }
+    });
+    return route;
+}
+
+}  // namespace P4::P4Tools::Test::P4Runtime
+
+#endif /* BACKENDS_P4TOOLS_MODULES_FLAY_TEST_P4RUNTIME_HELPERS_H_ */
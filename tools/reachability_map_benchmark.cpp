@@ -0,0 +1,258 @@
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "backends/p4tools/common/compiler/context.h"
+#include "backends/p4tools/common/control_plane/symbolic_variables.h"
+#include "backends/p4tools/common/lib/variables.h"
+#include "backends/p4tools/modules/flay/core/control_plane/action_enumeration.h"
+#include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
+#include "backends/p4tools/modules/flay/core/interpreter/node_map.h"
+#include "backends/p4tools/modules/flay/core/specialization/bdd/reachability_map.h"
+#include "backends/p4tools/modules/flay/core/specialization/reachability_map.h"
+#include "backends/p4tools/modules/flay/core/specialization/z3/reachability_map.h"
+#include "backends/p4tools/modules/flay/options.h"
+#include "lib/compile_context.h"
+
+namespace P4::P4Tools::Flay {
+
+namespace {
+
+/// The number of distinct actions of every table.
+constexpr uint64_t kActionCount = 4;
+
+/// The number of control plane updates measured for every map.
+constexpr size_t kUpdateCount = 20;
+
+/// The time budget per node of the solver of the Z3 map.
+constexpr uint64_t kSolverBudgetMilliseconds = 100;
+
+/// The width of the key of every table.
+constexpr int kKeyWidth = 32;
+
+/// @returns the name of action @p actionIdx.
+std::string actionName(uint64_t actionIdx) {
+    return "ingress.action_" + std::to_string(actionIdx);
+}
+
+/// @returns the enumeration of the kActionCount actions of every table.
+const ActionEnumeration &tableActions() {
+    static const ActionEnumeration kTableActions = []() {
+        std::vector<cstring> actionNames;
+        for (uint64_t actionIdx = 0; actionIdx < kActionCount; ++actionIdx) {
+            actionNames.emplace_back(actionName(actionIdx));
+        }
+        return ActionEnumeration(actionNames);
+    }();
+    return kTableActions;
+}
+
+/// Measures the time taken by @p function in milliseconds.
+template <typename Function>
+double measureMilliseconds(Function &&function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/// @returns the assignment which makes @p tableName execute action @p actionIdx.
+ControlPlaneAssignmentSet actionAssignment(cstring tableName, uint64_t actionIdx) {
+    ControlPlaneAssignmentSet assignment;
+    const auto *actionChoice =
+        ControlPlaneState::getActionChoiceVariable(tableName, tableActions().type());
+    assignment.emplace(*actionChoice, *tableActions().literal(actionName(actionIdx)));
+    return assignment;
+}
+
+/// A synthetic program: a chain of tables, each of which is only applied if the previous table
+/// executed its first action and a data-plane check passes. Every action of a table is a node.
+class SyntheticProgram {
+    /// The names of the tables of the program.
+    std::vector<cstring> _tableNames;
+
+    /// The tables of the program.
+    std::vector<TableConfiguration *> _tables;
+
+    /// The reachability conditions of the nodes.
+    NodeAnnotationMap _nodeAnnotationMap;
+
+    /// All nodes of the program.
+    std::vector<const IR::Node *> _nodes;
+
+ public:
+    SyntheticProgram(size_t tableCount, size_t entryCount) {
+        const IR::Expression *guard = new IR::BoolLiteral(true);
+        const auto *keyType = IR::Type_Bits::get(kKeyWidth);
+        for (size_t tableIdx = 0; tableIdx < tableCount; ++tableIdx) {
+            cstring tableName = "ingress.table_" + std::to_string(tableIdx);
+            const auto *keyVariable = ToolsVariables::getSymbolicVariable(
+                keyType, "hdr.key_" + std::to_string(tableIdx));
+            const auto *actionChoice =
+                ControlPlaneState::getActionChoiceVariable(tableName, tableActions().type());
+
+            auto *table = new TableConfiguration(
+                tableName, TableDefaultAction(actionAssignment(tableName, 0)), {});
+            table->setTableKeyMatch({new ExactTableMatchKey(tableName, "key", keyVariable)});
+            for (uint64_t entryIdx = 0; entryIdx < entryCount; ++entryIdx) {
+                ControlPlaneAssignmentSet matches;
+                matches.emplace(*ControlPlaneState::getTableKey(tableName, "key", keyType),
+                                *IR::Constant::get(keyType, entryIdx));
+                auto *entry = new TableMatchEntry(
+                    actionAssignment(tableName, 1 + entryIdx % (kActionCount - 1)), 0, matches);
+                table->addTableEntry(*entry, false);
+            }
+            _tableNames.push_back(tableName);
+            _tables.push_back(table);
+
+            for (uint64_t actionIdx = 0; actionIdx < kActionCount; ++actionIdx) {
+                const auto *node = new IR::EmptyStatement();
+                const auto *actionLiteral = tableActions().literal(actionName(actionIdx));
+                const auto *condition =
+                    new IR::LAnd(guard, new IR::Equ(actionChoice, actionLiteral));
+                _nodeAnnotationMap.initializeReachabilityMapping(node, condition);
+                _nodes.push_back(node);
+                if (actionIdx == 0) {
+                    guard = new IR::LAnd(
+                        condition,
+                        new IR::Neq(keyVariable, IR::Constant::get(keyType, tableIdx)));
+                }
+            }
+        }
+    }
+
+    /// Change the default action of a table. Update @p updateIdx cycles through all tables and
+    /// actions.
+    void applyUpdate(size_t updateIdx) {
+        auto tableIdx = updateIdx % _tables.size();
+        auto actionIdx = (updateIdx / _tables.size() + 1) % kActionCount;
+        _tables[tableIdx]->setDefaultTableAction(
+            TableDefaultAction(actionAssignment(_tableNames[tableIdx], actionIdx)));
+    }
+
+    /// @returns the constraints imposed by all tables.
+    [[nodiscard]] ControlPlaneConstraints constraints() const {
+        ControlPlaneConstraints controlPlaneConstraints;
+        for (size_t tableIdx = 0; tableIdx < _tables.size(); ++tableIdx) {
+            controlPlaneConstraints.emplace(_tableNames[tableIdx], *_tables[tableIdx]);
+        }
+        return controlPlaneConstraints;
+    }
+
+    [[nodiscard]] const NodeAnnotationMap &nodeAnnotationMap() const { return _nodeAnnotationMap; }
+
+    [[nodiscard]] const std::vector<const IR::Node *> &nodes() const { return _nodes; }
+};
+
+/// Creates a reachability map for the nodes of a program.
+using MapFactory =
+    std::function<AbstractReachabilityMap *(const NodeAnnotationMap &, const IR::P4Program &)>;
+
+/// The reachability maps which are compared. The Z3 map comes first, since the verdicts of the
+/// other maps are compared to it.
+const std::vector<std::pair<std::string, MapFactory>> &mapFactories() {
+    static const std::vector<std::pair<std::string, MapFactory>> kMapFactories = {
+        {"z3",
+         [](const NodeAnnotationMap &map, const IR::P4Program &program) {
+             return new Z3SolverReachabilityMap(map, program);
+         }},
+        {"z3_solver",
+         [](const NodeAnnotationMap &map, const IR::P4Program &program) {
+             return new Z3SolverReachabilityMap(map, program, kSolverBudgetMilliseconds);
+         }},
+        {"bdd",
+         [](const NodeAnnotationMap &map, const IR::P4Program &program) {
+             return new BddReachabilityMap(map, program);
+         }},
+        {"ir",
+         [](const NodeAnnotationMap &map, const IR::P4Program &program) {
+             return new IRReachabilityMap(map, program);
+         }},
+    };
+    return kMapFactories;
+}
+
+int run(const std::vector<size_t> &tableCounts, size_t entryCount) {
+    IR::P4Program program{IR::Vector<IR::Node>()};
+    std::cout << "tables,nodes,map,construction_ms,update_ms,memory_bytes,unreachable,"
+                 "differences_to_z3\n";
+    for (auto tableCount : tableCounts) {
+        // The reachability of every node after every update, keyed by map.
+        std::map<std::string, std::vector<std::optional<bool>>> verdicts;
+        for (const auto &[mapName, mapFactory] : mapFactories()) {
+            SyntheticProgram syntheticProgram(tableCount, entryCount);
+            AbstractReachabilityMap *reachabilityMap = nullptr;
+            auto constructionMilliseconds = measureMilliseconds([&]() {
+                reachabilityMap = mapFactory(syntheticProgram.nodeAnnotationMap(), program);
+            });
+
+            double updateMilliseconds = 0;
+            size_t unreachableCount = 0;
+            auto &mapVerdicts = verdicts[mapName];
+            for (size_t updateIdx = 0; updateIdx < kUpdateCount; ++updateIdx) {
+                syntheticProgram.applyUpdate(updateIdx);
+                auto controlPlaneConstraints = syntheticProgram.constraints();
+                updateMilliseconds += measureMilliseconds([&]() {
+                    static_cast<void>(
+                        reachabilityMap->recomputeReachability(controlPlaneConstraints));
+                });
+                for (const auto *node : syntheticProgram.nodes()) {
+                    auto reachability = reachabilityMap->isNodeReachable(node);
+                    unreachableCount += reachability == false ? 1 : 0;
+                    mapVerdicts.push_back(reachability);
+                }
+            }
+
+            size_t differenceCount = 0;
+            const auto &z3Verdicts = verdicts.at("z3");
+            for (size_t idx = 0; idx < mapVerdicts.size(); ++idx) {
+                differenceCount += mapVerdicts[idx] != z3Verdicts[idx] ? 1 : 0;
+            }
+            std::cout << tableCount << "," << syntheticProgram.nodes().size() << "," << mapName
+                      << "," << constructionMilliseconds << ","
+                      << updateMilliseconds / kUpdateCount << ","
+                      << reachabilityMap->estimateMemoryUsage() << "," << unreachableCount << ","
+                      << differenceCount << "\n";
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Flay
+
+/// Compares the reachability maps on a synthetic chain of tables. Takes the number of entries per
+/// table followed by the table counts to measure as arguments. Prints the time to build each map,
+/// the mean time to recompute all nodes after an update and the number of verdicts which differ
+/// from the Z3 map as CSV. Differences are expected for the BDD map, which treats undecided atoms
+/// as independent, and for the Z3 map with a solver, which decides more conditions.
+int main(int argc, char *argv[]) {
+    P4::AutoCompileContext autoContext(
+        new P4::P4Tools::CompileContext<P4::P4Tools::Flay::FlayOptions>());
+    size_t entryCount = 0;
+    std::vector<size_t> tableCounts;
+    for (int idx = 1; idx < argc; ++idx) {
+        char *end = nullptr;
+        auto count = std::strtoul(argv[idx], &end, 10);
+        if (*end != '\0' || (idx > 1 && count == 0)) {
+            std::cerr << "Invalid count " << argv[idx] << ". Expected a positive number.\n";
+            return EXIT_FAILURE;
+        }
+        if (idx == 1) {
+            entryCount = count;
+        } else {
+            tableCounts.push_back(count);
+        }
+    }
+    if (tableCounts.empty()) {
+        tableCounts = {10, 100, 1000};
+    }
+    return P4::P4Tools::Flay::run(tableCounts, entryCount);
+}
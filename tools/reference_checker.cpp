@@ -30,6 +30,9 @@ class ReferenceCheckerOptions : public FlayOptions {
     /// Write a performance report.
     bool _writePerformanceReport = false;
 
+    /// Write a memory report.
+    bool _writeMemoryReport = false;
+
     /// @returns the arguments to pass to the compiler. A little hacky because of an API mismatch.
     [[nodiscard]] std::vector<char *> getCompilerArgs(char *binaryName) const {
         std::vector<char *> args;
@@ -94,6 +97,15 @@ class ReferenceCheckerOptions : public FlayOptions {
             },
             "Write a performance report for the file. The report will be written to either the "
             "location of the reference file or the location of the folder.");
+        registerOption(
+            "--write-memory-report", nullptr,
+            [this](const char *) {
+                _writeMemoryReport = true;
+                return true;
+            },
+            "Write a report of the memory used per subsystem and the peak memory per phase. The "
+            "report will be written to either the location of the reference file or the location "
+            "of the folder.");
     }
 
     ~ReferenceCheckerOptions() override = default;
@@ -153,6 +165,8 @@ class ReferenceCheckerOptions : public FlayOptions {
     [[nodiscard]] const FlayOptions &toFlayOptions() const { return *this; }
 
     [[nodiscard]] bool writePerformanceReport() const { return _writePerformanceReport; }
+
+    [[nodiscard]] bool writeMemoryReport() const { return _writeMemoryReport; }
 };
 
 /// Compare the output of Flay with the reference file.
@@ -225,6 +239,21 @@ int run(const ReferenceCheckerOptions &options, const FlayOptions &flayOptions)
         printPerformanceReport(referencePath);
     }
 
+    if (options.writeMemoryReport()) {
+        auto referencePath = getFilePath(options, options.getInputFile().stem(), ".mem");
+        if (!referencePath.has_value()) {
+            return EXIT_FAILURE;
+        }
+        const auto *serviceStatistics =
+            flayServiceStatistics.at("main")->checkedTo<FlayServiceStatistics>();
+        if (serviceStatistics->memoryStatistics != nullptr) {
+            std::ofstream ofs(referencePath.value());
+            ofs << *serviceStatistics->memoryStatistics;
+            ofs.close();
+            printInfo("Wrote memory report to %s", referencePath.value().c_str());
+        }
+    }
+
     std::stringstream flayOptimizationOutput;
     for (const auto &[analysisName, statistic] : flayServiceStatistics) {
         flayOptimizationOutput << *statistic;
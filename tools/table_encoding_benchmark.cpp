@@ -0,0 +1,145 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "backends/p4tools/common/compiler/context.h"
+#include "backends/p4tools/common/control_plane/symbolic_variables.h"
+#include "backends/p4tools/common/lib/variables.h"
+#include "backends/p4tools/modules/flay/core/control_plane/action_enumeration.h"
+#include "backends/p4tools/modules/flay/core/control_plane/control_plane_objects.h"
+#include "backends/p4tools/modules/flay/core/lib/z3_cache.h"
+#include "backends/p4tools/modules/flay/options.h"
+#include "lib/compile_context.h"
+
+namespace P4::P4Tools::Flay {
+
+namespace {
+
+/// The name of the benchmarked table.
+constexpr const char *kTableName = "ingress.route";
+
+/// The name of the key of the benchmarked table.
+constexpr const char *kKeyName = "hdr.ipv4.dst_addr";
+
+/// The number of distinct actions installed in the table.
+constexpr uint64_t kActionCount = 4;
+
+/// The largest table for which the linear encoding is measured. It grows quadratically.
+constexpr size_t kMaxLinearEntries = 1000;
+
+/// Measures the time taken by @p function in milliseconds.
+template <typename Function>
+double measureMilliseconds(Function &&function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/// @returns the name of action @p actionIdx of the benchmarked table.
+std::string actionName(uint64_t actionIdx) {
+    return "ingress.forward_" + std::to_string(actionIdx);
+}
+
+/// @returns the enumeration of the kActionCount actions of the benchmarked table.
+const ActionEnumeration &tableActions() {
+    static const ActionEnumeration kTableActions = []() {
+        std::vector<cstring> actionNames;
+        for (uint64_t actionIdx = 0; actionIdx < kActionCount; ++actionIdx) {
+            actionNames.emplace_back(actionName(actionIdx));
+        }
+        return ActionEnumeration(actionNames);
+    }();
+    return kTableActions;
+}
+
+/// Produce an entry which matches @p key exactly and executes one of kActionCount actions.
+TableMatchEntry *makeEntry(uint64_t key) {
+    const auto *keyType = IR::Type_Bits::get(32);
+    cstring entryActionName = actionName(key % kActionCount);
+    ControlPlaneAssignmentSet actionAssignment;
+    actionAssignment.emplace(
+        *ControlPlaneState::getActionChoiceVariable(kTableName, tableActions().type()),
+        *tableActions().literal(entryActionName));
+    actionAssignment.emplace(
+        *ControlPlaneState::getTableActionArgument(kTableName, entryActionName, "port", keyType),
+        *IR::Constant::get(keyType, key % 512));
+    ControlPlaneAssignmentSet matches;
+    matches.emplace(*ControlPlaneState::getTableKey(kTableName, kKeyName, keyType),
+                    *IR::Constant::get(keyType, key));
+    return new TableMatchEntry(actionAssignment, 0, matches);
+}
+
+/// Encode @p entries as a chain of conditional assignments, one per entry, which is how tables
+/// used to be encoded.
+void encodeLinearly(const std::vector<TableMatchEntry *> &entries) {
+    Z3ControlPlaneAssignmentSet assignments;
+    for (const auto *entry : entries) {
+        auto constraint = entry->_z3Condition();
+        if (!constraint.has_value()) {
+            return;
+        }
+        assignments.mergeConditionally(constraint.value(), entry->z3ActionAssignment());
+    }
+}
+
+int run(const std::vector<size_t> &entryCounts) {
+    const auto *keyExpression =
+        ToolsVariables::getSymbolicVariable(IR::Type_Bits::get(32), kKeyName);
+    std::cout << "entries,linear_ms,balanced_ms,summarized_ms\n";
+    for (auto entryCount : entryCounts) {
+        TableConfiguration tableConfiguration(kTableName, TableDefaultAction({}), {});
+        tableConfiguration.setTableKeyMatch(
+            {new ExactTableMatchKey(kTableName, kKeyName, keyExpression)});
+        std::vector<TableMatchEntry *> entries;
+        for (uint64_t idx = 0; idx < entryCount; ++idx) {
+            // Spread the keys, so consecutive entries do not form a single range.
+            entries.push_back(makeEntry(idx * 3));
+            tableConfiguration.addTableEntry(*entries.back(), false);
+        }
+
+        std::string linearMilliseconds = "-";
+        if (entryCount <= kMaxLinearEntries) {
+            linearMilliseconds =
+                std::to_string(measureMilliseconds([&]() { encodeLinearly(entries); }));
+        }
+
+        tableConfiguration.setEntryBudget(entryCount);
+        auto balancedMilliseconds = measureMilliseconds(
+            [&]() { static_cast<void>(tableConfiguration.computeZ3ControlPlaneAssignments()); });
+
+        tableConfiguration.setEntryBudget(0);
+        auto summarizedMilliseconds = measureMilliseconds(
+            [&]() { static_cast<void>(tableConfiguration.computeZ3ControlPlaneAssignments()); });
+
+        std::cout << entryCount << "," << linearMilliseconds << "," << balancedMilliseconds << ","
+                  << summarizedMilliseconds << "\n";
+    }
+    return EXIT_SUCCESS;
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Flay
+
+/// Measures how the time to encode a table grows with its number of entries. Optionally takes the
+/// entry counts to measure as arguments. Prints the results as CSV.
+int main(int argc, char *argv[]) {
+    P4::AutoCompileContext autoContext(
+        new P4::P4Tools::CompileContext<P4::P4Tools::Flay::FlayOptions>());
+    std::vector<size_t> entryCounts;
+    for (int idx = 1; idx < argc; ++idx) {
+        auto entryCount = std::strtoul(argv[idx], nullptr, 10);
+        if (entryCount == 0) {
+            std::cerr << "Invalid entry count " << argv[idx] << ". Expected a positive number.\n";
+            return EXIT_FAILURE;
+        }
+        entryCounts.push_back(entryCount);
+    }
+    if (entryCounts.empty()) {
+        entryCounts = {10, 100, 1000, 10000};
+    }
+    return P4::P4Tools::Flay::run(entryCounts);
+}